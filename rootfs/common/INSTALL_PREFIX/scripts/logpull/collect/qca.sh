@@ -54,24 +54,10 @@ collect_qcawl()
 
     # Collect OL radio firmware stats
     #
-    # This dmesg is intentional. txrx_fw_stats output to kernel log, so in order
-    # to keep it fairly tidy, clean up all messages until now.
-    collect_cmd sh -c "echo ol stats dump klog flush; dmesg -c"
-    for radio in $(cat /proc/net/wireless | grep -o wifi.)
-    do
-        # txrx_fw_stats iwpriv is reachable via vap netdevs, not radio netdevs even though stats are radio-wise
-        ifname=$(find /sys -name parent \
-            | xargs grep -H $radio \
-            | sed 1q \
-            | xargs -n1 dirname \
-            | xargs -n1 basename)
-        # FIXME: wave2 hw / 10.4 supports more, e.g. for fetch requests/peer flow control
-        for arg in 1 2 3 5 6 7 8; do
-            # There's no guarantee that requests stats will be available in
-            # kernel log after iwpriv returns hence the crude sleep.
-            collect_cmd sh -c "iwpriv $ifname txrx_fw_stats $arg; sleep 1 ; dmesg -c"
-        done
-    done
+    # txrx_fw_stats output goes to kernel log. The collector requests the
+    # stats itself and follows /dev/kmsg until the output settles so the
+    # kernel log does not need to be flushed.
+    collect_cmd ${INSTALL_PREFIX}/bin/qca_fwstats
 
     # Collect mcs tx/rx stats
     if [ -x "$(command -v plume)" ]; then
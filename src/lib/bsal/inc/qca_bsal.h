@@ -47,10 +47,16 @@ int     qca_bsal_rrm_beacon_report_request(const char *ifname, const uint8_t *ma
 
 int     qca_bsal_rrm_set_neighbor(const char *ifname, const bsal_neigh_info_t *nr);
 int     qca_bsal_rrm_remove_neighbor(const char *ifname, const bsal_neigh_info_t *nr);
+int     qca_bsal_rrm_sync_neighbors(const char *ifname, const bsal_neigh_info_t *nr, int num_nr);
 int     qca_bsal_send_action(const char *ifname, const uint8_t *mac_addr, const uint8_t *data, unsigned int data_len);
 
 #ifdef CONFIG_PLATFORM_QCA_QSDK110
 int     qca_bsal_client_get_datarate_info(const char *ifname, const uint8_t *mac_addr, bsal_datarate_info_t *datarate);
 #endif
 
+#ifndef CONFIG_PLATFORM_QCA_QSDK110
+/* Client configs waiting to be applied to the driver */
+unsigned int qca_bsal_client_backlog(void);
+#endif
+
 #endif /* QCA_BSAL_H_INCLUDED */
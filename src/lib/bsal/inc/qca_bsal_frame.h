@@ -0,0 +1,52 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef QCA_BSAL_FRAME_H_INCLUDED
+#define QCA_BSAL_FRAME_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define QCA_BSAL_FRAME_LEN_MAX      1024
+
+/*
+ * Action frame bodies (starting with Category) of requests sent to
+ * clients. Builders return frame length, or -1 if it doesn't fit in buf
+ * or the request can't be expressed natively.
+ *
+ * req_ies lists the element IDs asked for in the Request subelement of a
+ * beacon request with req_ie set and a Reporting Detail of 1.
+ */
+int     qca_bsal_frame_btm_req(uint8_t *buf, size_t len, uint8_t dialog_token,
+                               const bsal_btm_params_t *btm_params);
+int     qca_bsal_frame_bcn_rpt_req(uint8_t *buf, size_t len, uint8_t dialog_token,
+                                   const bsal_rrm_params_t *rrm_params, const char *ssid,
+                                   const uint8_t *req_ies, size_t req_ies_num);
+
+/* Next dialog token, never 0 */
+uint8_t qca_bsal_frame_token(void);
+
+#endif /* QCA_BSAL_FRAME_H_INCLUDED */
@@ -47,6 +47,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <getopt.h>
 #include <stdarg.h>
+#include <time.h>
 #include <linux/types.h>
 #include <linux/netlink.h>
 #include <linux/wireless.h>
@@ -70,11 +71,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "os_nif.h"
 #include "evsched.h"
 #include "ioctl80211.h"
+#include "ioctl80211_nlfilter.h"
 #include "ds_tree.h"
+#include "ds_dlist.h"
 #include "memutil.h"
 
 #include "target.h"
 #include "qca_bsal.h"
+#include "qca_bsal_frame.h"
+#include "qca_bsal_neigh.h"
 #include "hostapd_util.h"
 
 /***************************************************************************************/
@@ -84,6 +89,33 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define BSAL_HANDLE(x)      (bsal_t *)x
 #define BSAL_PAIR(x)        (bsal_pair_t *)x
 
+#define BSAL_EVENT_POOL_SIZE    32      /* Events handed to BM per batch */
+#define BSAL_EVENT_RECV_VLEN    16      /* Datagrams per recvmmsg() */
+#define BSAL_EVENT_RECV_LEN     2048
+#define BSAL_EVENT_RECV_ROUNDS  8       /* recvmmsg() calls per wakeup */
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW
+#define CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW       100     /* ms, 0 disables */
+#endif
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA
+#define CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA   3       /* dB */
+#endif
+
+#define BSAL_PROBE_AGGR_SLOTS   64      /* power of 2 */
+
+#ifndef CONFIG_QCA_BSAL_STA_INFO_MAX_AGE
+#define CONFIG_QCA_BSAL_STA_INFO_MAX_AGE    1000    /* ms */
+#endif
+
+#define BSAL_STA_INFO_DUMP_LEN  (24*1024)   /* Initial STA_INFO buffer */
+#define BSAL_STA_INFO_DUMP_TRIES 4          /* Clients may join while growing */
+#define BSAL_STA_SLOTS_MIN      16
+
+#define BSAL_CLIENT_APPLY_BUDGET    32  /* Client config ioctls per loop iteration */
+#define BSAL_CLIENT_APPLY_RETRIES   3
+#define BSAL_CLIENT_RETRY_DELAY     1.0 /* s, when nothing could be applied */
+
 /***************************************************************************************/
 
 /*
@@ -103,11 +135,94 @@ struct client {
     uint8_t lwm;
     uint8_t bowm;
 
-    uint8_t ref_cnt;
+    ds_tree_t vaps;                 /* struct client_vap */
+    unsigned int vaps_cnt;
+    ds_tree_node_t node;
+};
+
+/* Steering config of a client on a VAP, applied to the driver lazily */
+struct client_vap {
+    char ifname[IF_NAMESIZE];
+    struct client *client;
+    bsal_client_config_t applied;
+    bsal_client_config_t pending;
+    bool acl_applied;
+    bool conf_applied;
+    bool queued;
+    int retries;
+    ds_dlist_node_t queue_node;
+    ds_tree_node_t node;
+};
+
+struct client_apply_stats {
+    unsigned int queued;
+    unsigned int merged;            /* Update of a queued config */
+    unsigned int skipped;           /* Same as applied config */
+    unsigned int applied;
+    unsigned int failed;
+    unsigned int given_up;          /* Failed BSAL_CLIENT_APPLY_RETRIES times */
+    unsigned int backlog;
+    unsigned int backlog_hwm;
+};
+
+struct ifname_entry {
+    int ifindex;
+    char ifname[IF_NAMESIZE];
+    ds_tree_node_t node;
+};
+
+struct event_stats {
+    unsigned int received;
+    unsigned int delivered;
+    unsigned int batches;
+    unsigned int dropped;
+    unsigned int overruns;
+    unsigned int pool_full;
+    unsigned int ifname_lookups;
+    unsigned int probes_merged;
+};
+
+/* Probe Request burst of a client on a VAP */
+struct probe_aggr {
+    uint8_t mac[6];
+    bool ssid_null;
+    bool blocked;
+    uint32_t ifindex;
+    uint64_t start_ms;
+    unsigned int count;             /* 0 when unused */
+    int rssi_min;
+    int rssi_max;
+    int rssi_sent;
+};
+
+/* Station of a VAP snapshot, looked up by MAC */
+struct sta_slot {
+    uint8_t mac[IEEE80211_ADDR_LEN];
+    uint8_t flags;
+    uint32_t offset;                /* of ieee80211req_sta_info in dump */
+    bsal_datarate_info_t datarate;  /* STA_SLOT_DATARATE */
+    uint64_t tx_bytes;              /* STA_SLOT_STATS */
+    uint64_t rx_bytes;
+};
+
+#define STA_SLOT_USED       (1 << 0)
+#define STA_SLOT_DATARATE   (1 << 1)
+#define STA_SLOT_STATS      (1 << 2)
+
+/* STA_INFO dump of a VAP, refreshed at most once per freshness window */
+struct sta_cache {
+    char ifname[IF_NAMESIZE];
+    uint8_t *buf;
+    uint32_t buf_len;
+    uint32_t len;
+    struct sta_slot *slots;
+    uint32_t slots_cnt;             /* power of 2 */
+    uint64_t refreshed_ms;          /* 0 when stale */
     ds_tree_node_t node;
 };
 
 static int mac_cmp(const void *a, const void *b);
+static int ifindex_cmp(const void *a, const void *b);
 
 /***************************************************************************************/
 
@@ -117,10 +232,40 @@ static int                  _bsal_rt_netlink_fd = -1;
 static int                  _bsal_ioctl_fd      = -1;
 static ds_tree_t            _bsal_clients       = DS_TREE_INIT(mac_cmp,
                                                                struct client, node);
+static ds_tree_t            _bsal_ifnames       = DS_TREE_INIT(ifindex_cmp,
+                                                               struct ifname_entry, node);
+static ds_tree_t            _bsal_sta_caches    = DS_TREE_INIT(ds_str_cmp,
+                                                               struct sta_cache, node);
+
+/*
+ * BM pushes client configs of all VAPs in bursts on start and reload.
+ * Identical ones are dropped, changed ones are queued and applied from
+ * a zero delay timer, a bounded number of ioctls per loop iteration (an
+ * idle watcher would starve while steering events keep coming). Failed
+ * ones are retried a few times and then reported.
+ */
+static ds_dlist_t           _bsal_client_queue  = DS_DLIST_INIT(struct client_vap,
+                                                                queue_node);
+static struct client_apply_stats _bsal_client_stats;
+
+/*
+ * Driver events are drained in bulk, parsed into pooled events and
+ * handed to BM in batches once the socket is empty (or the pool runs
+ * out). BM copies every event it is given so they are released right
+ * after the callback.
+ */
+static bsal_event_t         _bsal_event_pool[BSAL_EVENT_POOL_SIZE];
+static bsal_event_t         *_bsal_event_free[BSAL_EVENT_POOL_SIZE];
+static unsigned int         _bsal_event_free_cnt = 0;
+static bsal_event_t         *_bsal_event_batch[BSAL_EVENT_POOL_SIZE];
+static unsigned int         _bsal_event_batch_cnt = 0;
+static struct event_stats   _bsal_event_stats;
+static struct probe_aggr    _bsal_probe_aggr[BSAL_PROBE_AGGR_SLOTS];
 
 static struct ev_loop       *_ev_loop           = NULL;
 static struct ev_io         _evio;
 static struct ev_io         _rt_evio;
+static struct ev_timer      _client_timer;
 
 static c_item_t map_disc_source[] = {
     C_ITEM_VAL(BSTEERING_SOURCE_LOCAL,          BSAL_DISC_SOURCE_LOCAL),
@@ -141,6 +286,8 @@ static c_item_t map_rssi_xing[] = {
 /***************************************************************************************/
 
 static void qca_bsal_event_process();
+static void qca_bsal_sta_cache_invalidate(const char *ifname);
+static void qca_bsal_sta_cache_remove(const char *ifname);
 static int qca_bsal_rt_netlink_init(void);
 static void qca_bsal_rt_netlink_cleanup(void);
 
@@ -151,6 +298,216 @@ static int mac_cmp(const void *a, const void *b)
     return memcmp(a, b, BSAL_MAC_ADDR_LEN);
 }
 
+static int ifindex_cmp(const void *a, const void *b)
+{
+    const int *x = a;
+    const int *y = b;
+
+    return *x - *y;
+}
+
+static const char *qca_bsal_ifname_set(int ifindex, const char *ifname)
+{
+    struct ifname_entry *entry;
+
+    if (!(entry = ds_tree_find(&_bsal_ifnames, &ifindex))) {
+        entry = CALLOC(1, sizeof(*entry));
+        entry->ifindex = ifindex;
+        ds_tree_insert(&_bsal_ifnames, entry, &entry->ifindex);
+    }
+
+    STRSCPY(entry->ifname, ifname);
+    return entry->ifname;
+}
+
+static void qca_bsal_ifname_del(int ifindex)
+{
+    struct ifname_entry *entry;
+
+    if (!(entry = ds_tree_find(&_bsal_ifnames, &ifindex)))
+        return;
+
+    ds_tree_remove(&_bsal_ifnames, entry);
+    FREE(entry);
+}
+
+static void qca_bsal_ifname_flush(void)
+{
+    struct ifname_entry *entry;
+    ds_tree_iter_t iter;
+
+    for (entry = ds_tree_ifirst(&iter, &_bsal_ifnames);
+         entry != NULL;
+         entry = ds_tree_inext(&iter)) {
+        ds_tree_iremove(&iter);
+        FREE(entry);
+    }
+}
+
+/* Link events keep the cache current, ioctl only on a miss */
+static const char *qca_bsal_ifname_get(int ifindex)
+{
+    struct ifname_entry *entry;
+    char ifname[IF_NAMESIZE];
+
+    if ((entry = ds_tree_find(&_bsal_ifnames, &ifindex)))
+        return entry->ifname;
+
+    _bsal_event_stats.ifname_lookups++;
+    if (!if_indextoname(ifindex, ifname))
+        return NULL;
+
+    return qca_bsal_ifname_set(ifindex, ifname);
+}
+
+static uint64_t qca_bsal_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void qca_bsal_probe_aggr_close(const struct probe_aggr *aggr)
+{
+    os_macaddr_t temp;
+
+    if (aggr->count < 2)
+        return;
+
+    memcpy(&temp, aggr->mac, sizeof(temp));
+    LOGT("probe burst from "PRI(os_macaddr_lower_t)" on ifindex %u: %u probes "
+         "rssi %d..%d", FMT(os_macaddr_t, temp), aggr->ifindex, aggr->count,
+         aggr->rssi_min, aggr->rssi_max);
+}
+
+/*
+ * A scanning client sends bursts of near identical Probe Requests. The
+ * first one of a burst is delivered right away, the rest within the
+ * window only when the strongest RSSI seen grew by the configured delta.
+ * Returns false for probes that were merged, rssi is the one to report.
+ */
+static bool qca_bsal_probe_aggr(
+        const ath_netlink_bsteering_event_t *bsev,
+        int *rssi)
+{
+    const uint8_t *mac = (const uint8_t *)bsev->data.bs_probe.sender_addr;
+    const bool ssid_null = bsev->data.bs_probe.ssid_null ? true : false;
+    const bool blocked = bsev->data.bs_probe.blocked ? true : false;
+    struct probe_aggr *aggr;
+    uint64_t now;
+    uint32_t key;
+
+    *rssi = bsev->data.bs_probe.rssi;
+
+    if (CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW == 0)
+        return true;
+
+    now = qca_bsal_time_ms();
+    key = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    key = (key ^ (bsev->sys_index << 24) ^ ssid_null) * 2654435761u;
+    aggr = &_bsal_probe_aggr[(key >> 16) & (BSAL_PROBE_AGGR_SLOTS - 1)];
+
+    if (aggr->count == 0 ||
+        now - aggr->start_ms >= CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW ||
+        aggr->ifindex != bsev->sys_index ||
+        aggr->ssid_null != ssid_null ||
+        aggr->blocked != blocked ||
+        memcmp(aggr->mac, mac, sizeof(aggr->mac)) != 0) {
+        /* First probe of a burst, slot is taken over by it */
+        qca_bsal_probe_aggr_close(aggr);
+
+        memcpy(aggr->mac, mac, sizeof(aggr->mac));
+        aggr->ifindex   = bsev->sys_index;
+        aggr->ssid_null = ssid_null;
+        aggr->blocked   = blocked;
+        aggr->start_ms  = now;
+        aggr->count     = 1;
+        aggr->rssi_min  = *rssi;
+        aggr->rssi_max  = *rssi;
+        aggr->rssi_sent = *rssi;
+        return true;
+    }
+
+    aggr->count++;
+    if (*rssi < aggr->rssi_min)
+        aggr->rssi_min = *rssi;
+    if (*rssi > aggr->rssi_max)
+        aggr->rssi_max = *rssi;
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_BLOCKED_RSSI
+    /* BM only needs to learn the client is being blocked */
+    if (blocked) {
+        _bsal_event_stats.probes_merged++;
+        return false;
+    }
+#endif
+
+    if (aggr->rssi_max < aggr->rssi_sent + CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA) {
+        _bsal_event_stats.probes_merged++;
+        return false;
+    }
+
+    aggr->rssi_sent = aggr->rssi_max;
+    *rssi = aggr->rssi_max;
+    return true;
+}
+
+static void qca_bsal_event_pool_init(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < BSAL_EVENT_POOL_SIZE; i++)
+        _bsal_event_free[i] = &_bsal_event_pool[i];
+
+    _bsal_event_free_cnt = BSAL_EVENT_POOL_SIZE;
+    _bsal_event_batch_cnt = 0;
+}
+
+static void qca_bsal_event_release(bsal_event_t *event)
+{
+    _bsal_event_free[_bsal_event_free_cnt++] = event;
+}
+
+static void qca_bsal_event_flush(void)
+{
+    unsigned int i;
+
+    if (_bsal_event_batch_cnt == 0)
+        return;
+
+    for (i = 0; i < _bsal_event_batch_cnt; i++) {
+        if (_bsal_event_cb)
+            _bsal_event_cb(_bsal_event_batch[i]);
+        qca_bsal_event_release(_bsal_event_batch[i]);
+    }
+
+    _bsal_event_stats.delivered += _bsal_event_batch_cnt;
+    _bsal_event_stats.batches++;
+    _bsal_event_batch_cnt = 0;
+}
+
+static bsal_event_t *qca_bsal_event_get(void)
+{
+    bsal_event_t *event;
+
+    if (_bsal_event_free_cnt == 0) {
+        /* Whole pool is queued, deliver it to make room */
+        _bsal_event_stats.pool_full++;
+        qca_bsal_event_flush();
+    }
+
+    event = _bsal_event_free[--_bsal_event_free_cnt];
+    memset(event, 0, sizeof(*event));
+
+    return event;
+}
+
+static void qca_bsal_event_queue(bsal_event_t *event)
+{
+    _bsal_event_batch[_bsal_event_batch_cnt++] = event;
+}
+
 static void process_bs_sta_stats_ind(const char *ifname,
                                      const struct bs_sta_stats_ind *stats)
 {
@@ -159,8 +516,8 @@ static void process_bs_sta_stats_ind(const char *ifname,
 
     for(i = 0; i < stats->peer_count; i++) {
         const struct bs_sta_stats_per_peer* peer_stats = &stats->peer_stats[i];
-        bsal_event_t event;
-        bsal_ev_rssi_xing_t *xing_event = &event.data.rssi_change;
+        bsal_event_t *event;
+        bsal_ev_rssi_xing_t *xing_event;
         bsal_rssi_change_t old_hwm_xing;
         bsal_rssi_change_t new_hwm_xing;
         bsal_rssi_change_t old_lwm_xing;
@@ -185,16 +542,17 @@ static void process_bs_sta_stats_ind(const char *ifname,
         new_lwm_xing = client->rssi < client->lwm ? BSAL_RSSI_LOWER : BSAL_RSSI_HIGHER;
         new_bowm_xing = client->rssi < client->bowm ? BSAL_RSSI_LOWER : BSAL_RSSI_HIGHER;
 
-        memset(&event, 0, sizeof(event));
-        event.type = BSAL_EVENT_RSSI_XING;
-        STRSCPY(event.ifname, ifname);
+        event = qca_bsal_event_get();
+        xing_event = &event->data.rssi_change;
+        event->type = BSAL_EVENT_RSSI_XING;
+        STRSCPY(event->ifname, ifname);
         memcpy(xing_event->client_addr, peer_stats->client_addr, sizeof(xing_event->client_addr));
         xing_event->rssi = client->rssi;
         xing_event->high_xing = old_hwm_xing == new_hwm_xing ? BSAL_RSSI_UNCHANGED : new_hwm_xing;
         xing_event->low_xing = old_lwm_xing == new_lwm_xing ? BSAL_RSSI_UNCHANGED : new_lwm_xing;
         xing_event->busy_override_xing = old_bowm_xing == new_bowm_xing ? BSAL_RSSI_UNCHANGED : new_bowm_xing;
 
-        _bsal_event_cb(&event);
+        qca_bsal_event_queue(event);
     }
 }
 
@@ -311,6 +669,7 @@ static void util_nl_parse_iwevcustom(
 
 static void util_nl_parse(const void *buf, unsigned int len)
 {
+    const struct ifinfomsg *ifi;
     const struct iw_event *iwe;
     const struct nlmsghdr *hdr;
     const struct rtattr *attr;
@@ -318,7 +677,23 @@ static void util_nl_parse(const void *buf, unsigned int len)
     int attrlen;
     int iwelen;
 
-    util_nl_each_msg_type(buf, hdr, len, RTM_NEWLINK) {
+    util_nl_each_msg(buf, hdr, len) {
+        ifi = NLMSG_DATA(hdr);
+
+        if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK)
+            continue;
+
+        if (NLMSG_PAYLOAD(hdr, 0) < sizeof(*ifi)) {
+            LOGW("Malformed link event received, length (%u < %zu)",
+                 hdr->nlmsg_len, NLMSG_SPACE(sizeof(*ifi)));
+            continue;
+        }
+
+        if (hdr->nlmsg_type == RTM_DELLINK) {
+            qca_bsal_ifname_del(ifi->ifi_index);
+            continue;
+        }
+
         memset(ifname, 0, sizeof(ifname));
 
         util_nl_each_attr_type(hdr, attr, attrlen, IFLA_IFNAME)
@@ -327,6 +702,8 @@ static void util_nl_parse(const void *buf, unsigned int len)
         if (strlen(ifname) == 0)
             continue;
 
+        qca_bsal_ifname_set(ifi->ifi_index, ifname);
+
         util_nl_each_attr_type(hdr, attr, attrlen, IFLA_WIRELESS)
             util_nl_each_iwe_type(attr, iwe, iwelen, IWEVASSOCREQIE)
                 util_nl_parse_iwevcustom(ifname,
@@ -432,6 +809,19 @@ static void qca_bsal_netlink_cleanup(void)
     _bsal_netlink_fd = -1;
 }
 
+/*
+ * Only management frames (IWEVASSOCREQIE) are handled off the rt netlink
+ * socket. Link removal, creation and renames are kept to maintain ifname
+ * cache.
+ */
+static const ioctl80211_nlfilter_t _bsal_rt_nlfilter = {
+    .dellink        = true,
+    .newlink_create = true,
+    .newlink_rename = true,
+    .iwe_cmd        = { IWEVASSOCREQIE },
+    .iwe_qty        = 1,
+};
+
 static int qca_bsal_rt_netlink_init(void)
 {
     struct sockaddr_nl  addr;
@@ -467,6 +857,9 @@ static int qca_bsal_rt_netlink_init(void)
         return -1;
     }
 
+    /* Best effort, util_nl_parse() still skips what it doesn't handle */
+    ioctl80211_nlfilter_attach(fd, &_bsal_rt_nlfilter, "bsal");
+
     _bsal_rt_netlink_fd = fd;
 
     ev_io_init(&_rt_evio, qca_bsal_events_rt_evio_cb, fd, EV_READ);
@@ -535,55 +928,45 @@ static int qca_bsal_if_netlink_init(const bsal_ifconfig_t *ifcfg, bool enable)
     return ret;
 }
 
-static void qca_bsal_event_process(void)
+static void qca_bsal_event_parse(void *buf, size_t len)
 {
     ath_netlink_bsteering_event_t   *bsev;
     struct nlmsghdr *               nlmsg;
     bsal_event_t                    *event;
     struct client                   *client;
-    char                            ifname[IF_NAMESIZE];
+    const char                      *ifname;
     uint32_t                        val;
-    ssize_t                         rlen;
-    char                            buf[2048];
-
-    if (_bsal_netlink_fd < 0) {
-        LOGW("_bsal_netlink_fd not initialized");
-        return;
-    }
-
-    /* Read in netlink messages */
-    rlen = read(_bsal_netlink_fd, &buf, sizeof(buf));
-    if (rlen < 0) {
-        LOGE("Failed to read in netlink message, errno = %d,(%s)",
-             errno, strerror(errno));
-        return;
-    }
-    else if (rlen == sizeof(buf)) {
-        LOGW("Netlink message buffer overrun!");
-    }
+    int                             rssi;
 
     nlmsg = (struct nlmsghdr *)buf;
-    if (NLMSG_PAYLOAD(nlmsg, 0) < sizeof(*bsev)) {
-        LOGW("Malformed netlink event received, length (%d < %d)",
-             NLMSG_PAYLOAD(nlmsg, 0), sizeof(*bsev));
+    if (len < sizeof(*nlmsg) || NLMSG_PAYLOAD(nlmsg, 0) < sizeof(*bsev)) {
+        LOGW("Malformed netlink event received, length (%zu < %zu)",
+             len, NLMSG_SPACE(sizeof(*bsev)));
+        _bsal_event_stats.dropped++;
         return;
     }
     bsev = NLMSG_DATA(nlmsg);
 
-    // NB: This check should always be done after the read() call. If select() says
-    //     there is data on the socket but there's no callback, then it will service
-    //     the socket by reading the data and then discarding it.
+    // NB: Events are drained from the socket even without a callback,
+    //     they are discarded here.
     if (_bsal_event_cb == NULL) {
         LOGW("_bsal_event_cb not initialized, discarding event");
+        _bsal_event_stats.dropped++;
         return;
     }
 
-    if (!if_indextoname(bsev->sys_index, ifname)) {
+    if (!(ifname = qca_bsal_ifname_get(bsev->sys_index))) {
         LOGE("Failed to find ifname base on index %u", bsev->sys_index);
+        _bsal_event_stats.dropped++;
         return;
     }
 
-    event = CALLOC(1, sizeof(*event));
+    if (bsev->type == ATH_EVENT_BSTEERING_PROBE_REQ &&
+        !qca_bsal_probe_aggr(bsev, &rssi)) {
+        return;
+    }
+
+    event = qca_bsal_event_get();
 
     STRSCPY(event->ifname, ifname);
 
@@ -594,7 +977,7 @@ static void qca_bsal_event_process(void)
         memcpy(&event->data.probe_req.client_addr,
                                          &bsev->data.bs_probe.sender_addr,
                                          sizeof(event->data.probe_req.client_addr));
-        event->data.probe_req.rssi      = bsev->data.bs_probe.rssi;
+        event->data.probe_req.rssi      = rssi;
         event->data.probe_req.ssid_null = bsev->data.bs_probe.ssid_null ? true : false;
         event->data.probe_req.blocked   = bsev->data.bs_probe.blocked   ? true : false;
         break;
@@ -630,6 +1013,7 @@ static void qca_bsal_event_process(void)
         break;
 
     case ATH_EVENT_BSTEERING_NODE_ASSOCIATED:
+        qca_bsal_sta_cache_invalidate(ifname);
         event->type = BSAL_EVENT_CLIENT_CONNECT;
         memcpy(&event->data.connect.client_addr,
                                               &bsev->data.bs_node_associated.client_addr,
@@ -675,6 +1059,7 @@ static void qca_bsal_event_process(void)
         break;
 
     case ATH_EVENT_BSTEERING_CLIENT_DISCONNECTED:
+        qca_bsal_sta_cache_invalidate(ifname);
         event->type = BSAL_EVENT_CLIENT_DISCONNECT;
         memcpy(&event->data.disconnect.client_addr,
                                                 &bsev->data.bs_disconnect_ind.client_addr,
@@ -687,7 +1072,8 @@ static void qca_bsal_event_process(void)
         if (!c_get_value_by_key(map_disc_source, bsev->data.bs_disconnect_ind.source, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_DISCONNECTED): Unknown source %d",
                                                  bsev->data.bs_disconnect_ind.source);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.disconnect.source = val;
@@ -695,7 +1081,8 @@ static void qca_bsal_event_process(void)
         if (!c_get_value_by_key(map_disc_type, bsev->data.bs_disconnect_ind.type, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_DISCONNECTED): Unknown type %d",
                                                bsev->data.bs_disconnect_ind.type);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.disconnect.type = val;
@@ -727,7 +1114,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.inact_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown inact %d",
                                 bsev->data.bs_rssi_xing.inact_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.inact_xing = val;
@@ -736,7 +1124,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.rate_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown rate %d",
                                 bsev->data.bs_rssi_xing.rate_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.high_xing = val;
@@ -745,7 +1134,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.low_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown low %d",
                                 bsev->data.bs_rssi_xing.low_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.low_xing = val;
@@ -773,23 +1163,95 @@ static void qca_bsal_event_process(void)
         break;
 
     case ATH_EVENT_BSTEERING_STA_STATS:
+        /* Callee below queues BSAL events on its own */
+        qca_bsal_event_release(event);
         process_bs_sta_stats_ind(ifname, &bsev->data.bs_sta_stats);
-        /* Callee above generates BSAL events, passtrough */
+        return;
     default:
         /* ignore this event */
-        FREE(event);
+        qca_bsal_event_release(event);
         return;
     }
 
-    _bsal_event_cb(event);
+    qca_bsal_event_queue(event);
+}
+
+static void qca_bsal_event_process(void)
+{
+    static char                     bufs[BSAL_EVENT_RECV_VLEN][BSAL_EVENT_RECV_LEN];
+    struct mmsghdr                  msgs[BSAL_EVENT_RECV_VLEN];
+    struct iovec                    iovs[BSAL_EVENT_RECV_VLEN];
+    unsigned int                    received = 0;
+    int                             round;
+    int                             cnt;
+    int                             i;
 
-    // Free the memory allocated for event here, as _bsal_event_cb will
-    // allocate the memory and copy the contents
-    if (event) {
-        FREE(event);
+    if (_bsal_netlink_fd < 0) {
+        LOGW("_bsal_netlink_fd not initialized");
+        return;
     }
 
-    return;
+    /* Drain the socket, bounded so other watchers still get their turn */
+    for (round = 0; round < BSAL_EVENT_RECV_ROUNDS; round++) {
+        memset(msgs, 0, sizeof(msgs));
+        for (i = 0; i < BSAL_EVENT_RECV_VLEN; i++) {
+            iovs[i].iov_base = bufs[i];
+            iovs[i].iov_len = sizeof(bufs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        cnt = recvmmsg(_bsal_netlink_fd, msgs, BSAL_EVENT_RECV_VLEN, MSG_DONTWAIT, NULL);
+        if (cnt < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == ENOBUFS) {
+                /* Driver outpaced us, events in between are lost */
+                _bsal_event_stats.overruns++;
+                LOGW("Netlink event socket overrun (%u overruns)",
+                     _bsal_event_stats.overruns);
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOGE("Failed to read in netlink message, errno = %d,(%s)",
+                     errno, strerror(errno));
+            }
+            break;
+        }
+
+        for (i = 0; i < cnt; i++) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                LOGW("Netlink message buffer overrun!");
+                _bsal_event_stats.dropped++;
+                continue;
+            }
+
+            qca_bsal_event_parse(bufs[i], msgs[i].msg_len);
+        }
+
+        received += cnt;
+
+        if (cnt < BSAL_EVENT_RECV_VLEN)
+            break;
+    }
+
+    _bsal_event_stats.received += received;
+
+    qca_bsal_event_flush();
+
+    LOGT("%s: received %u events (total received %u delivered %u batches %u "
+         "dropped %u overruns %u pool full %u ifname lookups %u probes merged %u)",
+         __func__, received,
+         _bsal_event_stats.received,
+         _bsal_event_stats.delivered,
+         _bsal_event_stats.batches,
+         _bsal_event_stats.dropped,
+         _bsal_event_stats.overruns,
+         _bsal_event_stats.pool_full,
+         _bsal_event_stats.ifname_lookups,
+         _bsal_event_stats.probes_merged);
 }
 
 static int qca_bsal_bs_enable(
@@ -973,6 +1435,8 @@ int qca_bsal_iface_remove(const bsal_ifconfig_t *ifcfg)
     }
 
     qca_bsal_bs_config(_bsal_ioctl_fd, ifcfg, false);
+    qca_bsal_neigh_flush(ifcfg->ifname);
+    qca_bsal_sta_cache_remove(ifcfg->ifname);
     return 0;
 }
 
@@ -1043,36 +1507,220 @@ static int qca_bsal_bs_client_config(
     return ret;
 }
 
+static struct client_vap *qca_bsal_client_vap_get(
+        struct client *client,
+        const char *ifname)
+{
+    struct client_vap *vap;
+
+    if ((vap = ds_tree_find(&client->vaps, (void *)ifname)))
+        return vap;
+
+    vap = CALLOC(1, sizeof(*vap));
+    STRSCPY(vap->ifname, ifname);
+    vap->client = client;
+    ds_tree_insert(&client->vaps, vap, vap->ifname);
+    client->vaps_cnt++;
+
+    return vap;
+}
+
+static void qca_bsal_client_vap_dequeue(struct client_vap *vap)
+{
+    if (!vap->queued)
+        return;
+
+    ds_dlist_remove(&_bsal_client_queue, vap);
+    vap->queued = false;
+    _bsal_client_stats.backlog--;
+}
+
+static void qca_bsal_client_vap_free(struct client_vap *vap)
+{
+    qca_bsal_client_vap_dequeue(vap);
+    ds_tree_remove(&vap->client->vaps, vap);
+    vap->client->vaps_cnt--;
+    FREE(vap);
+}
+
+/* Zero delay timer runs on the next loop iteration however busy it is */
+static void qca_bsal_client_timer_arm(double delay)
+{
+    ev_timer_stop(_ev_loop, &_client_timer);
+    ev_timer_set(&_client_timer, delay, 0.);
+    ev_timer_start(_ev_loop, &_client_timer);
+}
+
+static void qca_bsal_client_vap_enqueue(struct client_vap *vap)
+{
+    ds_dlist_insert_tail(&_bsal_client_queue, vap);
+    vap->queued = true;
+
+    _bsal_client_stats.backlog++;
+    if (_bsal_client_stats.backlog > _bsal_client_stats.backlog_hwm)
+        _bsal_client_stats.backlog_hwm = _bsal_client_stats.backlog;
+}
+
+static void qca_bsal_client_vap_queue(
+        struct client_vap *vap,
+        const bsal_client_config_t *conf)
+{
+    if (!vap->queued && vap->conf_applied &&
+        memcmp(&vap->applied, conf, sizeof(*conf)) == 0) {
+        _bsal_client_stats.skipped++;
+        return;
+    }
+
+    vap->pending = *conf;
+    vap->retries = 0;
+
+    if (vap->queued) {
+        _bsal_client_stats.merged++;
+        return;
+    }
+
+    _bsal_client_stats.queued++;
+    qca_bsal_client_vap_enqueue(vap);
+
+    /* New configs don't wait out a retry back off */
+    qca_bsal_client_timer_arm(0.);
+}
+
+/* Returns 0 once ACL entry and config are in the driver, ioctls are taken from budget */
+static int qca_bsal_client_vap_apply(struct client_vap *vap, int *budget)
+{
+    if (!vap->acl_applied) {
+        (*budget)--;
+        if (qca_bsal_acl_mac(_bsal_ioctl_fd, vap->ifname, vap->client->mac, true) < 0)
+            return -1;
+        vap->acl_applied = true;
+    }
+
+    (*budget)--;
+    if (qca_bsal_bs_client_config(_bsal_ioctl_fd, vap->ifname, vap->client->mac,
+                                  &vap->pending) < 0)
+        return -1;
+
+    vap->applied = vap->pending;
+    vap->conf_applied = true;
+    vap->retries = 0;
+    _bsal_client_stats.applied++;
+
+    return 0;
+}
+
+static void qca_bsal_client_apply_cb(struct ev_loop *loop, struct ev_timer *timer, int revents)
+{
+    struct client_vap *vap;
+    ds_dlist_t retry = DS_DLIST_INIT(struct client_vap, queue_node);
+    os_macaddr_t temp;
+    int budget = BSAL_CLIENT_APPLY_BUDGET;
+    int applied = 0;
+
+    while (budget > 0 && (vap = ds_dlist_head(&_bsal_client_queue))) {
+        qca_bsal_client_vap_dequeue(vap);
+        if (qca_bsal_client_vap_apply(vap, &budget) == 0) {
+            applied++;
+            continue;
+        }
+
+        _bsal_client_stats.failed++;
+        memcpy(&temp, vap->client->mac, sizeof(temp));
+
+        if (++vap->retries >= BSAL_CLIENT_APPLY_RETRIES) {
+            LOGE("%s: client "PRI(os_macaddr_lower_t)" steering config not applied "
+                 "after %d attempts, giving up", vap->ifname, FMT(os_macaddr_t, temp),
+                 vap->retries);
+            _bsal_client_stats.given_up++;
+            vap->retries = 0;
+            continue;
+        }
+
+        LOGW("%s: client "PRI(os_macaddr_lower_t)" steering config failed, retrying (%d/%d)",
+             vap->ifname, FMT(os_macaddr_t, temp), vap->retries, BSAL_CLIENT_APPLY_RETRIES);
+        ds_dlist_insert_tail(&retry, vap);
+    }
+
+    /* Retries go after what was queued meanwhile */
+    while ((vap = ds_dlist_head(&retry))) {
+        ds_dlist_remove(&retry, vap);
+        qca_bsal_client_vap_enqueue(vap);
+    }
+
+    /* Back off when the driver refuses everything, e.g. VAP going down */
+    if (_bsal_client_stats.backlog > 0)
+        qca_bsal_client_timer_arm(applied > 0 ? 0. : BSAL_CLIENT_RETRY_DELAY);
+
+    LOGT("%s: client config backlog %u (queued %u merged %u skipped %u applied %u "
+         "failed %u given up %u backlog hwm %u)",
+         __func__, _bsal_client_stats.backlog,
+         _bsal_client_stats.queued,
+         _bsal_client_stats.merged,
+         _bsal_client_stats.skipped,
+         _bsal_client_stats.applied,
+         _bsal_client_stats.failed,
+         _bsal_client_stats.given_up,
+         _bsal_client_stats.backlog_hwm);
+}
+
+static void qca_bsal_client_queue_flush(void)
+{
+    struct client_vap *vap;
+
+    if (_ev_loop)
+        ev_timer_stop(_ev_loop, &_client_timer);
+
+    while ((vap = ds_dlist_head(&_bsal_client_queue)))
+        qca_bsal_client_vap_dequeue(vap);
+}
+
+unsigned int qca_bsal_client_backlog(void)
+{
+    return _bsal_client_stats.backlog;
+}
+
+/* Rejects requests the apply queue could never satisfy */
+static int qca_bsal_client_check(const char *ifname)
+{
+    if (!_ev_loop) {
+        LOGE("%s: BSAL not initialized", ifname);
+        return -1;
+    }
+
+    if (if_nametoindex(ifname) == 0) {
+        LOGE("%s: no such interface, errno = %d (%s)", ifname, errno, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
 int qca_bsal_client_add(
         const char *ifname,
         const uint8_t *mac_addr,
         const bsal_client_config_t *conf)
 {
-    int             ret;
     struct client   *client = NULL;
 
-    if ((ret = qca_bsal_acl_mac(_bsal_ioctl_fd, ifname, mac_addr, true)) < 0) {
-        return ret;
-    }
-
-    if ((ret = qca_bsal_bs_client_config(_bsal_ioctl_fd, ifname, mac_addr, conf)) < 0) {
-        return ret;
+    if (qca_bsal_client_check(ifname) < 0) {
+        return -1;
     }
 
-    if ((client = ds_tree_find(&_bsal_clients, mac_addr))) {
-        client->ref_cnt++;
-    }
-    else {
+    if (!(client = ds_tree_find(&_bsal_clients, mac_addr))) {
         client = CALLOC(1, sizeof(*client));
         memcpy(client->mac, mac_addr, sizeof(client->mac));
         client->hwm = conf->rssi_high_xing;
         client->lwm = conf->rssi_low_xing;
         client->bowm = conf->rssi_busy_override_xing;
+        ds_tree_init(&client->vaps, ds_str_cmp, struct client_vap, node);
 
         ds_tree_insert(&_bsal_clients, client, client->mac);
     }
 
-    return ret;
+    /* ACL entry and config are pushed from the apply queue */
+    qca_bsal_client_vap_queue(qca_bsal_client_vap_get(client, ifname), conf);
+
+    return 0;
 }
 
 int qca_bsal_client_update(
@@ -1081,14 +1729,26 @@ int qca_bsal_client_update(
         const bsal_client_config_t *conf)
 {
     struct client *client = NULL;
+    struct client_vap *vap = NULL;
+
+    if (qca_bsal_client_check(ifname) < 0) {
+        return -1;
+    }
 
     if ((client = ds_tree_find(&_bsal_clients, mac_addr))) {
         client->hwm = conf->rssi_high_xing;
         client->lwm = conf->rssi_low_xing;
         client->bowm = conf->rssi_busy_override_xing;
+
+        vap = ds_tree_find(&client->vaps, (void *)ifname);
+    }
+
+    if (!vap) {
+        return qca_bsal_bs_client_config(_bsal_ioctl_fd, ifname, mac_addr, conf);
     }
 
-    return qca_bsal_bs_client_config(_bsal_ioctl_fd, ifname, mac_addr, conf);
+    qca_bsal_client_vap_queue(vap, conf);
+    return 0;
 }
 
 int qca_bsal_client_remove(
@@ -1096,15 +1756,27 @@ int qca_bsal_client_remove(
         const uint8_t *mac_addr)
 {
     struct client *client = NULL;
+    struct client_vap *vap;
+    bool acl_applied = true;
 
     if ((client = ds_tree_find(&_bsal_clients, mac_addr))) {
-        client->ref_cnt--;
-        if (client->ref_cnt == 0) {
+        if ((vap = ds_tree_find(&client->vaps, (void *)ifname))) {
+            acl_applied = vap->acl_applied;
+            qca_bsal_client_vap_free(vap);
+        }
+
+        /* Client is kept as long as it is configured on some VAP */
+        if (client->vaps_cnt == 0) {
             ds_tree_remove(&_bsal_clients, client);
-            free(client);
+            FREE(client);
         }
     }
 
+    /* Config never reached the driver */
+    if (!acl_applied) {
+        return 0;
+    }
+
     return qca_bsal_acl_mac(_bsal_ioctl_fd, ifname, mac_addr, false);
 }
 
@@ -1177,12 +1849,19 @@ static int
 qca_bsal_client_stats(
         const char *ifname,
         const uint8_t *mac_addr,
+        struct sta_slot *slot,
         bsal_client_info_t *info)
 {
     struct iwreq iwr;
     struct ieee80211req_sta_stats stats = {0};
     const struct ieee80211_nodestats *ns = &stats.is_stats;
 
+    if (slot->flags & STA_SLOT_STATS) {
+        info->tx_bytes = slot->tx_bytes;
+        info->rx_bytes = slot->rx_bytes;
+        return 0;
+    }
+
     memset(&iwr, 0, sizeof(iwr));
     STRSCPY(iwr.ifr_name, ifname);
     iwr.u.data.pointer = (void *)&stats;
@@ -1197,102 +1876,323 @@ qca_bsal_client_stats(
     info->tx_bytes = ns->ns_tx_bytes;
     info->rx_bytes = ns->ns_rx_bytes;
 
+    slot->tx_bytes = info->tx_bytes;
+    slot->rx_bytes = info->rx_bytes;
+    slot->flags |= STA_SLOT_STATS;
+
     return 0;
 }
 
-int qca_bsal_client_info(
-        const char *ifname,
-        const uint8_t *mac_addr,
-        bsal_client_info_t *info)
+static uint32_t qca_bsal_sta_slot_hash(const uint8_t *mac)
 {
-    struct ieee80211req_sta_info    *sta;
-    struct iwreq                    iwreq;
-    uint32_t                        len;
-    uint8_t                         *buf, *p;
-    uint8_t                         *assoc_ies;
-    uint16_t                        assoc_ies_len;
-    bool                            found = false;
-    int                             ret;
+    uint32_t key;
 
-    memset(info, 0, sizeof(*info));
+    /* OUI bytes are shared by many clients, the NIC part is not */
+    key = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) |
+          ((uint32_t)mac[4] << 8) | mac[5];
+    return (key ^ mac[0] ^ ((uint32_t)mac[1] << 8)) * 2654435761u;
+}
 
-    len = 24*1024;
-    buf = MALLOC(len);
+static struct sta_slot *qca_bsal_sta_cache_lookup(
+        struct sta_cache *cache,
+        const uint8_t *mac_addr)
+{
+    const uint32_t mask = cache->slots_cnt - 1;
+    struct sta_slot *slot;
+    uint32_t i;
 
-    memset(&iwreq, 0, sizeof(iwreq));
-    STRSCPY(iwreq.ifr_name, ifname);
-    iwreq.u.data.pointer = (void *)buf;
-    iwreq.u.data.length  = len;
-    iwreq.u.data.flags   = 0;
+    if (cache->slots_cnt == 0)
+        return NULL;
 
-    ret = ioctl(_bsal_ioctl_fd, IEEE80211_IOCTL_STA_INFO, &iwreq);
-    if (ret < 0) {
-        LOGE("%s: Failed to get station list, errno = %d (%s)",
-                                            ifname, errno, strerror(errno));
-        FREE(buf);
-        return -1;
+    for (i = qca_bsal_sta_slot_hash(mac_addr) & mask; ; i = (i + 1) & mask) {
+        slot = &cache->slots[i];
+        if (!(slot->flags & STA_SLOT_USED))
+            return NULL;
+        if (memcmp(slot->mac, mac_addr, sizeof(slot->mac)) == 0)
+            return slot;
+    }
+}
+
+static int qca_bsal_sta_cache_dump(struct sta_cache *cache)
+{
+    struct iwreq iwreq;
+    int tries;
+    int ret;
+
+    if (cache->buf_len == 0) {
+        cache->buf_len = BSAL_STA_INFO_DUMP_LEN;
+        cache->buf = MALLOC(cache->buf_len);
     }
-    else if (ret > 0) {
-        // Wasn't enough space, let's realloc
-        len = ret;
-        FREE(buf);
-        buf = MALLOC(len);
 
+    for (tries = 0; tries < BSAL_STA_INFO_DUMP_TRIES; tries++) {
         memset(&iwreq, 0, sizeof(iwreq));
-        STRSCPY(iwreq.ifr_name, ifname);
-        iwreq.u.data.pointer = (void *)buf;
-        iwreq.u.data.length  = len;
+        STRSCPY(iwreq.ifr_name, cache->ifname);
+        iwreq.u.data.pointer = (void *)cache->buf;
+        iwreq.u.data.length  = cache->buf_len;
         iwreq.u.data.flags   = 0;
 
         ret = ioctl(_bsal_ioctl_fd, IEEE80211_IOCTL_STA_INFO, &iwreq);
         if (ret < 0) {
             LOGE("%s: Failed to get station list, errno = %d (%s)",
-                                            ifname, errno, strerror(errno));
-            FREE(buf);
+                                        cache->ifname, errno, strerror(errno));
             return -1;
         }
+
+        if (ret == 0) {
+            cache->len = iwreq.u.data.length;
+            return 0;
+        }
+
+        // Wasn't enough space, grow the buffer and keep it
+        cache->buf_len = ret;
+        cache->buf = REALLOC(cache->buf, cache->buf_len);
+    }
+
+    LOGE("%s: Failed to get station list, table kept growing past %u bytes",
+         cache->ifname, cache->buf_len);
+    return -1;
+}
+
+static void qca_bsal_sta_cache_index(struct sta_cache *cache)
+{
+    const struct ieee80211req_sta_info *sta;
+    struct sta_slot *slot;
+    uint32_t slots_cnt = BSAL_STA_SLOTS_MIN;
+    uint32_t count = 0;
+    uint32_t mask;
+    uint32_t off;
+    uint32_t i;
+
+    for (off = 0; cache->len - off >= sizeof(*sta); off += sta->isi_len) {
+        sta = (const struct ieee80211req_sta_info *)(cache->buf + off);
+        if (sta->isi_len < sizeof(*sta) || sta->isi_len > cache->len - off)
+            break;
+        count++;
+    }
+
+    /* Keep the table at most half full */
+    while (slots_cnt < count * 2)
+        slots_cnt <<= 1;
+
+    if (slots_cnt != cache->slots_cnt) {
+        FREE(cache->slots);
+        cache->slots = CALLOC(slots_cnt, sizeof(*cache->slots));
+        cache->slots_cnt = slots_cnt;
     }
     else {
-        len = iwreq.u.data.length;
+        memset(cache->slots, 0, slots_cnt * sizeof(*cache->slots));
     }
 
-    p = buf;
-    while (len >= sizeof(*sta)) {
-        sta = (struct ieee80211req_sta_info *)p;
+    mask = slots_cnt - 1;
+    for (off = 0; count > 0; off += sta->isi_len, count--) {
+        sta = (const struct ieee80211req_sta_info *)(cache->buf + off);
 
-        if (memcmp(sta->isi_macaddr, mac_addr, sizeof(sta->isi_macaddr)) == 0) {
-            found = true;
-            break;
+        for (i = qca_bsal_sta_slot_hash(sta->isi_macaddr) & mask; ; i = (i + 1) & mask) {
+            slot = &cache->slots[i];
+            if (!(slot->flags & STA_SLOT_USED))
+                break;
+            if (memcmp(slot->mac, sta->isi_macaddr, sizeof(slot->mac)) == 0)
+                break;
         }
 
-        len -= sta->isi_len;
-        p   += sta->isi_len;
+        /* Duplicate MAC in a dump, first entry wins */
+        if (slot->flags & STA_SLOT_USED)
+            continue;
+
+        memcpy(slot->mac, sta->isi_macaddr, sizeof(slot->mac));
+        slot->offset = off;
+        slot->flags = STA_SLOT_USED;
     }
+}
 
-    if (found) {
-        /* fill station info */
-        qca_bsal_fill_sta_info(info, sta);
-        qca_bsal_client_get_datarate_info(ifname, mac_addr, &info->datarate_info);
-        info->connected = true;
+static struct sta_cache *qca_bsal_sta_cache_get(const char *ifname)
+{
+    struct sta_cache *cache;
+    uint64_t now = qca_bsal_time_ms();
 
-        assoc_ies_len = sta->isi_len - sizeof(*sta);
-        assoc_ies = (uint8_t *) (sta+1);
-        if (assoc_ies_len <= sizeof(info->assoc_ies)) {
-            memcpy(info->assoc_ies, assoc_ies, assoc_ies_len);
-            info->assoc_ies_len = assoc_ies_len;
-        } else {
-            LOGW("%s ies_len (%u) higher than ies table (%u)", ifname, assoc_ies_len, sizeof(info->assoc_ies));
-        }
+    if (!(cache = ds_tree_find(&_bsal_sta_caches, (void *)ifname))) {
+        cache = CALLOC(1, sizeof(*cache));
+        STRSCPY(cache->ifname, ifname);
+        ds_tree_insert(&_bsal_sta_caches, cache, cache->ifname);
     }
 
-    FREE(buf);
+    if (cache->refreshed_ms != 0 &&
+        now - cache->refreshed_ms < CONFIG_QCA_BSAL_STA_INFO_MAX_AGE)
+        return cache;
 
-    if (info->connected)
-        qca_bsal_client_stats(ifname, mac_addr, info);
+    cache->refreshed_ms = 0;
+    cache->len = 0;
+
+    if (qca_bsal_sta_cache_dump(cache) < 0)
+        return NULL;
+
+    qca_bsal_sta_cache_index(cache);
+    cache->refreshed_ms = now;
+
+    return cache;
+}
+
+static void qca_bsal_sta_cache_invalidate(const char *ifname)
+{
+    struct sta_cache *cache;
+
+    if ((cache = ds_tree_find(&_bsal_sta_caches, (void *)ifname)))
+        cache->refreshed_ms = 0;
+}
+
+static void qca_bsal_sta_cache_free(struct sta_cache *cache)
+{
+    FREE(cache->slots);
+    FREE(cache->buf);
+    FREE(cache);
+}
+
+static void qca_bsal_sta_cache_remove(const char *ifname)
+{
+    struct sta_cache *cache;
+
+    if (!(cache = ds_tree_find(&_bsal_sta_caches, (void *)ifname)))
+        return;
+
+    ds_tree_remove(&_bsal_sta_caches, cache);
+    qca_bsal_sta_cache_free(cache);
+}
+
+static void qca_bsal_sta_cache_flush(void)
+{
+    struct sta_cache *cache;
+    ds_tree_iter_t iter;
+
+    for (cache = ds_tree_ifirst(&iter, &_bsal_sta_caches);
+         cache != NULL;
+         cache = ds_tree_inext(&iter)) {
+        ds_tree_iremove(&iter);
+        qca_bsal_sta_cache_free(cache);
+    }
+}
+
+int qca_bsal_client_info(
+        const char *ifname,
+        const uint8_t *mac_addr,
+        bsal_client_info_t *info)
+{
+    struct ieee80211req_sta_info    *sta;
+    struct sta_cache                *cache;
+    struct sta_slot                 *slot;
+    uint8_t                         *assoc_ies;
+    uint16_t                        assoc_ies_len;
+
+    memset(info, 0, sizeof(*info));
+
+    if (!(cache = qca_bsal_sta_cache_get(ifname)))
+        return -1;
+
+    if (!(slot = qca_bsal_sta_cache_lookup(cache, mac_addr)))
+        return 0;
+
+    sta = (struct ieee80211req_sta_info *)(cache->buf + slot->offset);
+
+    /* fill station info */
+    qca_bsal_fill_sta_info(info, sta);
+    if (slot->flags & STA_SLOT_DATARATE) {
+        info->datarate_info = slot->datarate;
+    }
+    else if (qca_bsal_client_get_datarate_info(ifname, mac_addr, &info->datarate_info) >= 0) {
+        slot->datarate = info->datarate_info;
+        slot->flags |= STA_SLOT_DATARATE;
+    }
+    info->connected = true;
+
+    assoc_ies_len = sta->isi_len - sizeof(*sta);
+    assoc_ies = (uint8_t *) (sta+1);
+    if (assoc_ies_len <= sizeof(info->assoc_ies)) {
+        memcpy(info->assoc_ies, assoc_ies, assoc_ies_len);
+        info->assoc_ies_len = assoc_ies_len;
+    } else {
+        LOGW("%s ies_len (%u) higher than ies table (%u)", ifname, assoc_ies_len, sizeof(info->assoc_ies));
+    }
+
+    qca_bsal_client_stats(ifname, mac_addr, slot, info);
 
     return 0;
 }
 
+/*
+ * Requests to clients are encoded natively and sent as action frames,
+ * hostapd_cli and wifitool are only forked if that fails.
+ */
+static bool qca_bsal_vap_freq(const char *ifname, uint32_t *freq)
+{
+    struct iwreq iwr;
+    uint64_t hz;
+    int e;
+
+    memset(&iwr, 0, sizeof(iwr));
+    STRSCPY(iwr.ifr_name, ifname);
+
+    if (ioctl(_bsal_ioctl_fd, SIOCGIWFREQ, &iwr) < 0)
+        return false;
+
+    /* Channel number instead of frequency */
+    if (iwr.u.freq.e == 0 && iwr.u.freq.m < 1000)
+        return false;
+
+    hz = iwr.u.freq.m;
+    for (e = iwr.u.freq.e; e > 0; e--)
+        hz *= 10;
+
+    *freq = hz / 1000000;
+    return true;
+}
+
+static bool qca_bsal_vap_ssid(const char *ifname, char *ssid, size_t ssid_len)
+{
+    struct iwreq iwr;
+
+    memset(ssid, 0, ssid_len);
+    memset(&iwr, 0, sizeof(iwr));
+    STRSCPY(iwr.ifr_name, ifname);
+    iwr.u.essid.pointer = ssid;
+    iwr.u.essid.length  = ssid_len - 1;
+
+    return ioctl(_bsal_ioctl_fd, SIOCGIWESSID, &iwr) == 0;
+}
+
+static int qca_bsal_action_send(
+        const char *ifname,
+        const uint8_t *mac_addr,
+        const uint8_t *frame,
+        int frame_len)
+{
+    struct ieee80211_p2p_send_action    *act;
+    uint8_t                             buf[sizeof(*act) + QCA_BSAL_FRAME_LEN_MAX];
+    os_macaddr_t                        bssid;
+    uint32_t                            freq;
+
+    if (frame_len < 0 || frame_len > QCA_BSAL_FRAME_LEN_MAX)
+        return -1;
+
+    if (!os_nif_macaddr(ifname, &bssid)) {
+        LOGD("%s: Failed to get BSSID", ifname);
+        return -1;
+    }
+
+    if (!qca_bsal_vap_freq(ifname, &freq)) {
+        LOGD("%s: Failed to get operating frequency", ifname);
+        return -1;
+    }
+
+    act = (struct ieee80211_p2p_send_action *)buf;
+    memset(act, 0, sizeof(*act));
+    act->freq = freq;
+    memcpy(act->dst_addr, mac_addr, sizeof(act->dst_addr));
+    memcpy(act->src_addr, &bssid, sizeof(act->src_addr));
+    memcpy(act->bssid, &bssid, sizeof(act->bssid));
+    memcpy(act + 1, frame, frame_len);
+
+    return qca_bsal_send_action(ifname, mac_addr, buf, sizeof(*act) + frame_len);
+}
+
 static bool qca_bss_tm_request(
         const char *client_mac,
         const char *interface,
@@ -1422,10 +2322,19 @@ int qca_bsal_bss_tm_request(
     char                    client_mac[18]  = { 0 };
     os_macaddr_t            temp;
     bool                    ret             = false;
+    uint8_t                 frame[QCA_BSAL_FRAME_LEN_MAX];
+    int                     frame_len;
 
     memcpy(&temp, mac_addr, sizeof(temp));
     sprintf(client_mac, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
 
+    frame_len = qca_bsal_frame_btm_req(frame, sizeof(frame), qca_bsal_frame_token(), btm_params);
+    if (qca_bsal_action_send(ifname, mac_addr, frame, frame_len) == 0) {
+        LOGD("Client %s - BTM request sent (%d neighbors)", client_mac, btm_params->num_neigh);
+        return 0;
+    }
+
+    LOGD("Client %s - BTM request falling back to hostapd_cli", client_mac);
     ret = qca_bss_tm_request(client_mac, ifname, btm_params);
     if (!ret) {
         LOGW("qca_bss_tm_request failed");
@@ -1443,10 +2352,27 @@ int qca_bsal_rrm_beacon_report_request(
     char                    client_mac[18]  = { 0 };
     os_macaddr_t            temp;
     bool                    ret             = false;
+    char                    ssid[IW_ESSID_MAX_SIZE + 1] = { 0 };
+    uint8_t                 frame[QCA_BSAL_FRAME_LEN_MAX];
+    int                     frame_len;
 
     memcpy(&temp, mac_addr, sizeof(temp));
     sprintf(client_mac, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
 
+    /*
+     * bsal_rrm_params_t only flags the Request subelement, so requests with
+     * req_ie set go through wifitool and the driver picks the elements.
+     */
+    if (rrm_params->req_ssid != 1 || qca_bsal_vap_ssid(ifname, ssid, sizeof(ssid))) {
+        frame_len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), qca_bsal_frame_token(),
+                                               rrm_params, ssid, NULL, 0);
+        if (qca_bsal_action_send(ifname, mac_addr, frame, frame_len) == 0) {
+            LOGD("Client %s - beacon report request sent", client_mac);
+            return 0;
+        }
+    }
+
+    LOGD("Client %s - beacon report request falling back to wifitool", client_mac);
     ret = qca_rrm_bcn_rpt_request(client_mac, ifname, rrm_params);
     if (!ret) {
         LOGW("qca_rrm_bcn_rpt_request failed");
@@ -1456,54 +2382,6 @@ int qca_bsal_rrm_beacon_report_request(
     return 0;
 }
 
-
-int qca_bsal_rrm_set_neighbor(
-        const char *ifname,
-        const bsal_neigh_info_t *neigh)
-{
-    os_macaddr_t temp;
-    char bssid[18] = { 0 };
-    char nr[256] = { 0 };
-
-    memcpy(&temp, neigh->bssid, sizeof(temp));
-    sprintf(bssid, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
-
-    snprintf(nr, sizeof(nr),
-             "%02hhx%02hhx%02hhx%02hhx%02hhx%02hhx"  // bssid
-             "%02hhx%02hhx%02hhx%02hhx"              // bssid_info
-             "%02hhx"                                // operclass
-             "%02hhx"                                // channel
-             "%02hhx",                               // phy_mode
-             neigh->bssid[0], neigh->bssid[1], neigh->bssid[2], neigh->bssid[3], neigh->bssid[4], neigh->bssid[5],
-             neigh->bssid_info & 0xff, (neigh->bssid_info >> 8) & 0xff,
-             (neigh->bssid_info >> 16) & 0xff, (neigh->bssid_info >> 24) & 0xff,
-             neigh->op_class,
-             neigh->channel,
-             neigh->phy_type);
-
-    if (!hostapd_rrm_set_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT, ifname, bssid, nr)) {
-        return -1;
-    }
-
-    return 0;
-}
-
-int qca_bsal_rrm_remove_neighbor(
-        const char *ifname,
-        const bsal_neigh_info_t *neigh)
-{
-    os_macaddr_t temp;
-    char bssid[18] = { 0 };
-
-    memcpy(&temp, neigh->bssid, sizeof(temp));
-    sprintf(bssid, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
-    if (!hostapd_rrm_remove_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT, ifname, bssid)) {
-        return -1;
-    }
-
-    return 0;
-}
-
 int qca_bsal_send_action(
         const char *ifname,
         const uint8_t *mac_addr,
@@ -1545,6 +2423,12 @@ int qca_bsal_init(
     _ev_loop = loop;
     _bsal_event_cb = event_cb;
 
+    qca_bsal_event_pool_init();
+    memset(&_bsal_event_stats, 0, sizeof(_bsal_event_stats));
+    memset(&_bsal_client_stats, 0, sizeof(_bsal_client_stats));
+    ev_timer_init(&_client_timer, qca_bsal_client_apply_cb, 0., 0.);
+    memset(&_bsal_probe_aggr, 0, sizeof(_bsal_probe_aggr));
+
     // Create fd to issue ioctl's
     if (qca_bsal_ioctl_init() < 0) {
         LOGE("Failed to create socket");
@@ -1572,11 +2456,32 @@ error:
 
 int qca_bsal_cleanup(void)
 {
-    LOGI("BSAL cleaning up");
+    LOGI("BSAL cleaning up (events received %u delivered %u dropped %u "
+         "overruns %u pool full %u probes merged %u)",
+         _bsal_event_stats.received,
+         _bsal_event_stats.delivered,
+         _bsal_event_stats.dropped,
+         _bsal_event_stats.overruns,
+         _bsal_event_stats.pool_full,
+         _bsal_event_stats.probes_merged);
 
     qca_bsal_rt_netlink_cleanup();
     qca_bsal_netlink_cleanup();
     qca_bsal_ioctl_cleanup();
+    qca_bsal_ifname_flush();
+    qca_bsal_neigh_flush(NULL);
+    qca_bsal_sta_cache_flush();
+
+    LOGI("BSAL client configs (applied %u skipped %u merged %u failed %u given up %u "
+         "dropped from backlog %u backlog hwm %u)",
+         _bsal_client_stats.applied,
+         _bsal_client_stats.skipped,
+         _bsal_client_stats.merged,
+         _bsal_client_stats.failed,
+         _bsal_client_stats.given_up,
+         _bsal_client_stats.backlog,
+         _bsal_client_stats.backlog_hwm);
+    qca_bsal_client_queue_flush();
 
     _ev_loop = NULL;
     _bsal_event_cb = NULL;
@@ -47,6 +47,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <getopt.h>
 #include <stdarg.h>
+#include <time.h>
 #include <linux/types.h>
 #include <linux/netlink.h>
 #include <linux/wireless.h>
@@ -72,11 +73,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "os_nif.h"
 #include "evsched.h"
 #include "ioctl80211.h"
+#include "ioctl80211_nlfilter.h"
 #include "ds_tree.h"
 #include "memutil.h"
 
 #include "target.h"
 #include "qca_bsal.h"
+#include "qca_bsal_frame.h"
+#include "qca_bsal_neigh.h"
 #include "hostapd_util.h"
 
 /***************************************************************************************/
@@ -84,6 +88,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MODULE_ID           LOG_MODULE_ID_BSAL
 
 #define OSYNC_IOCTL_LIB 0
+
+#define BSAL_EVENT_POOL_SIZE    32      /* Events handed to BM per batch */
+#define BSAL_EVENT_RECV_VLEN    16      /* Datagrams per recvmmsg() */
+#define BSAL_EVENT_RECV_LEN     2048
+#define BSAL_EVENT_RECV_ROUNDS  8       /* recvmmsg() calls per wakeup */
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW
+#define CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW       100     /* ms, 0 disables */
+#endif
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA
+#define CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA   3       /* dB */
+#endif
+
+#define BSAL_PROBE_AGGR_SLOTS   64      /* power of 2 */
+
 /***************************************************************************************/
 
 /*
@@ -96,6 +116,38 @@ typedef enum {
     IEEE80211_INVALID_BAND
 } IEEE80211_STA_BAND;
 
+struct ifname_entry {
+    int ifindex;
+    char ifname[IF_NAMESIZE];
+    ds_tree_node_t node;
+};
+
+struct event_stats {
+    unsigned int received;
+    unsigned int delivered;
+    unsigned int batches;
+    unsigned int dropped;
+    unsigned int overruns;
+    unsigned int pool_full;
+    unsigned int ifname_lookups;
+    unsigned int probes_merged;
+};
+
+/* Probe Request burst of a client on a VAP */
+struct probe_aggr {
+    uint8_t mac[6];
+    bool ssid_null;
+    bool blocked;
+    uint32_t ifindex;
+    uint64_t start_ms;
+    unsigned int count;             /* 0 when unused */
+    int rssi_min;
+    int rssi_max;
+    int rssi_sent;
+};
+
+static int ifindex_cmp(const void *a, const void *b);
+
 /***************************************************************************************/
 struct socket_context sock_ctx;
 #define LIST_STATION_CFG_ALLOC_SIZE 3*1024
@@ -105,6 +157,22 @@ static bsal_event_cb_t      _bsal_event_cb      = NULL;
 static int                  _bsal_netlink_fd    = -1;
 static int                  _bsal_rt_netlink_fd = -1;
 int                         _bsal_ioctl_fd      = -1;
+static ds_tree_t            _bsal_ifnames       = DS_TREE_INIT(ifindex_cmp,
+                                                               struct ifname_entry, node);
+
+/*
+ * Driver events are drained in bulk, parsed into pooled events and
+ * handed to BM in batches once the socket is empty (or the pool runs
+ * out). BM copies every event it is given so they are released right
+ * after the callback.
+ */
+static bsal_event_t         _bsal_event_pool[BSAL_EVENT_POOL_SIZE];
+static bsal_event_t         *_bsal_event_free[BSAL_EVENT_POOL_SIZE];
+static unsigned int         _bsal_event_free_cnt = 0;
+static bsal_event_t         *_bsal_event_batch[BSAL_EVENT_POOL_SIZE];
+static unsigned int         _bsal_event_batch_cnt = 0;
+static struct event_stats   _bsal_event_stats;
+static struct probe_aggr    _bsal_probe_aggr[BSAL_PROBE_AGGR_SLOTS];
 
 static struct ev_loop       *_ev_loop           = NULL;
 static struct ev_io         _evio;
@@ -134,6 +202,216 @@ static void qca_bsal_rt_netlink_cleanup(void);
 
 /***************************************************************************************/
 
+static int ifindex_cmp(const void *a, const void *b)
+{
+    const int *x = a;
+    const int *y = b;
+
+    return *x - *y;
+}
+
+static const char *qca_bsal_ifname_set(int ifindex, const char *ifname)
+{
+    struct ifname_entry *entry;
+
+    if (!(entry = ds_tree_find(&_bsal_ifnames, &ifindex))) {
+        entry = CALLOC(1, sizeof(*entry));
+        entry->ifindex = ifindex;
+        ds_tree_insert(&_bsal_ifnames, entry, &entry->ifindex);
+    }
+
+    STRSCPY(entry->ifname, ifname);
+    return entry->ifname;
+}
+
+static void qca_bsal_ifname_del(int ifindex)
+{
+    struct ifname_entry *entry;
+
+    if (!(entry = ds_tree_find(&_bsal_ifnames, &ifindex)))
+        return;
+
+    ds_tree_remove(&_bsal_ifnames, entry);
+    FREE(entry);
+}
+
+static void qca_bsal_ifname_flush(void)
+{
+    struct ifname_entry *entry;
+    ds_tree_iter_t iter;
+
+    for (entry = ds_tree_ifirst(&iter, &_bsal_ifnames);
+         entry != NULL;
+         entry = ds_tree_inext(&iter)) {
+        ds_tree_iremove(&iter);
+        FREE(entry);
+    }
+}
+
+/* Link events keep the cache current, ioctl only on a miss */
+static const char *qca_bsal_ifname_get(int ifindex)
+{
+    struct ifname_entry *entry;
+    char ifname[IF_NAMESIZE];
+
+    if ((entry = ds_tree_find(&_bsal_ifnames, &ifindex)))
+        return entry->ifname;
+
+    _bsal_event_stats.ifname_lookups++;
+    if (!if_indextoname(ifindex, ifname))
+        return NULL;
+
+    return qca_bsal_ifname_set(ifindex, ifname);
+}
+
+static uint64_t qca_bsal_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void qca_bsal_probe_aggr_close(const struct probe_aggr *aggr)
+{
+    os_macaddr_t temp;
+
+    if (aggr->count < 2)
+        return;
+
+    memcpy(&temp, aggr->mac, sizeof(temp));
+    LOGT("probe burst from "PRI(os_macaddr_lower_t)" on ifindex %u: %u probes "
+         "rssi %d..%d", FMT(os_macaddr_t, temp), aggr->ifindex, aggr->count,
+         aggr->rssi_min, aggr->rssi_max);
+}
+
+/*
+ * A scanning client sends bursts of near identical Probe Requests. The
+ * first one of a burst is delivered right away, the rest within the
+ * window only when the strongest RSSI seen grew by the configured delta.
+ * Returns false for probes that were merged, rssi is the one to report.
+ */
+static bool qca_bsal_probe_aggr(
+        const ath_netlink_bsteering_event_t *bsev,
+        int *rssi)
+{
+    const uint8_t *mac = (const uint8_t *)bsev->data.bs_probe.sender_addr;
+    const bool ssid_null = bsev->data.bs_probe.ssid_null ? true : false;
+    const bool blocked = bsev->data.bs_probe.blocked ? true : false;
+    struct probe_aggr *aggr;
+    uint64_t now;
+    uint32_t key;
+
+    *rssi = bsev->data.bs_probe.rssi;
+
+    if (CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW == 0)
+        return true;
+
+    now = qca_bsal_time_ms();
+    key = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    key = (key ^ (bsev->sys_index << 24) ^ ssid_null) * 2654435761u;
+    aggr = &_bsal_probe_aggr[(key >> 16) & (BSAL_PROBE_AGGR_SLOTS - 1)];
+
+    if (aggr->count == 0 ||
+        now - aggr->start_ms >= CONFIG_QCA_BSAL_PROBE_AGGR_WINDOW ||
+        aggr->ifindex != bsev->sys_index ||
+        aggr->ssid_null != ssid_null ||
+        aggr->blocked != blocked ||
+        memcmp(aggr->mac, mac, sizeof(aggr->mac)) != 0) {
+        /* First probe of a burst, slot is taken over by it */
+        qca_bsal_probe_aggr_close(aggr);
+
+        memcpy(aggr->mac, mac, sizeof(aggr->mac));
+        aggr->ifindex   = bsev->sys_index;
+        aggr->ssid_null = ssid_null;
+        aggr->blocked   = blocked;
+        aggr->start_ms  = now;
+        aggr->count     = 1;
+        aggr->rssi_min  = *rssi;
+        aggr->rssi_max  = *rssi;
+        aggr->rssi_sent = *rssi;
+        return true;
+    }
+
+    aggr->count++;
+    if (*rssi < aggr->rssi_min)
+        aggr->rssi_min = *rssi;
+    if (*rssi > aggr->rssi_max)
+        aggr->rssi_max = *rssi;
+
+#ifndef CONFIG_QCA_BSAL_PROBE_AGGR_BLOCKED_RSSI
+    /* BM only needs to learn the client is being blocked */
+    if (blocked) {
+        _bsal_event_stats.probes_merged++;
+        return false;
+    }
+#endif
+
+    if (aggr->rssi_max < aggr->rssi_sent + CONFIG_QCA_BSAL_PROBE_AGGR_RSSI_DELTA) {
+        _bsal_event_stats.probes_merged++;
+        return false;
+    }
+
+    aggr->rssi_sent = aggr->rssi_max;
+    *rssi = aggr->rssi_max;
+    return true;
+}
+
+static void qca_bsal_event_pool_init(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < BSAL_EVENT_POOL_SIZE; i++)
+        _bsal_event_free[i] = &_bsal_event_pool[i];
+
+    _bsal_event_free_cnt = BSAL_EVENT_POOL_SIZE;
+    _bsal_event_batch_cnt = 0;
+}
+
+static void qca_bsal_event_release(bsal_event_t *event)
+{
+    _bsal_event_free[_bsal_event_free_cnt++] = event;
+}
+
+static void qca_bsal_event_flush(void)
+{
+    unsigned int i;
+
+    if (_bsal_event_batch_cnt == 0)
+        return;
+
+    for (i = 0; i < _bsal_event_batch_cnt; i++) {
+        if (_bsal_event_cb)
+            _bsal_event_cb(_bsal_event_batch[i]);
+        qca_bsal_event_release(_bsal_event_batch[i]);
+    }
+
+    _bsal_event_stats.delivered += _bsal_event_batch_cnt;
+    _bsal_event_stats.batches++;
+    _bsal_event_batch_cnt = 0;
+}
+
+static bsal_event_t *qca_bsal_event_get(void)
+{
+    bsal_event_t *event;
+
+    if (_bsal_event_free_cnt == 0) {
+        /* Whole pool is queued, deliver it to make room */
+        _bsal_event_stats.pool_full++;
+        qca_bsal_event_flush();
+    }
+
+    event = _bsal_event_free[--_bsal_event_free_cnt];
+    memset(event, 0, sizeof(*event));
+
+    return event;
+}
+
+static void qca_bsal_event_queue(bsal_event_t *event)
+{
+    _bsal_event_batch[_bsal_event_batch_cnt++] = event;
+}
+
 static void qca_bsal_events_evio_cb(struct ev_loop *loop, struct ev_io *evio, int revents)
 {
     if (revents & EV_ERROR) {
@@ -247,6 +525,7 @@ static void util_nl_parse_iwevcustom(
 
 static void util_nl_parse(const void *buf, unsigned int len)
 {
+    const struct ifinfomsg *ifi;
     const struct iw_event *iwe;
     const struct nlmsghdr *hdr;
     const struct rtattr *attr;
@@ -254,7 +533,23 @@ static void util_nl_parse(const void *buf, unsigned int len)
     int attrlen;
     int iwelen;
 
-    util_nl_each_msg_type(buf, hdr, len, RTM_NEWLINK) {
+    util_nl_each_msg(buf, hdr, len) {
+        ifi = NLMSG_DATA(hdr);
+
+        if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK)
+            continue;
+
+        if (NLMSG_PAYLOAD(hdr, 0) < sizeof(*ifi)) {
+            LOGW("Malformed link event received, length (%u < %zu)",
+                 hdr->nlmsg_len, NLMSG_SPACE(sizeof(*ifi)));
+            continue;
+        }
+
+        if (hdr->nlmsg_type == RTM_DELLINK) {
+            qca_bsal_ifname_del(ifi->ifi_index);
+            continue;
+        }
+
         memset(ifname, 0, sizeof(ifname));
 
         util_nl_each_attr_type(hdr, attr, attrlen, IFLA_IFNAME)
@@ -263,6 +558,8 @@ static void util_nl_parse(const void *buf, unsigned int len)
         if (strlen(ifname) == 0)
             continue;
 
+        qca_bsal_ifname_set(ifi->ifi_index, ifname);
+
         util_nl_each_attr_type(hdr, attr, attrlen, IFLA_WIRELESS)
             util_nl_each_iwe_type(attr, iwe, iwelen, IWEVASSOCREQIE)
                 util_nl_parse_iwevcustom(ifname,
@@ -368,6 +665,19 @@ static void qca_bsal_netlink_cleanup(void)
     _bsal_netlink_fd = -1;
 }
 
+/*
+ * Only management frames (IWEVASSOCREQIE) are handled off the rt netlink
+ * socket. Link removal, creation and renames are kept to maintain ifname
+ * cache.
+ */
+static const ioctl80211_nlfilter_t _bsal_rt_nlfilter = {
+    .dellink        = true,
+    .newlink_create = true,
+    .newlink_rename = true,
+    .iwe_cmd        = { IWEVASSOCREQIE },
+    .iwe_qty        = 1,
+};
+
 static int qca_bsal_rt_netlink_init(void)
 {
     struct sockaddr_nl  addr;
@@ -403,6 +713,9 @@ static int qca_bsal_rt_netlink_init(void)
         return -1;
     }
 
+    /* Best effort, util_nl_parse() still skips what it doesn't handle */
+    ioctl80211_nlfilter_attach(fd, &_bsal_rt_nlfilter, "bsal");
+
     _bsal_rt_netlink_fd = fd;
 
     ev_io_init(&_rt_evio, qca_bsal_events_rt_evio_cb, fd, EV_READ);
@@ -471,54 +784,44 @@ static int qca_bsal_if_netlink_init(const bsal_ifconfig_t *ifcfg, bool enable)
     return ret;
 }
 
-static void qca_bsal_event_process(void)
+static void qca_bsal_event_parse(void *buf, size_t len)
 {
     ath_netlink_bsteering_event_t   *bsev;
     struct nlmsghdr *               nlmsg;
     bsal_event_t                    *event;
-    char                            ifname[IF_NAMESIZE];
+    const char                      *ifname;
     uint32_t                        val;
-    ssize_t                         rlen;
-    char                            buf[2048];
-
-    if (_bsal_netlink_fd < 0) {
-        LOGW("_bsal_netlink_fd not initialized");
-        return;
-    }
-
-    /* Read in netlink messages */
-    rlen = read(_bsal_netlink_fd, &buf, sizeof(buf));
-    if (rlen < 0) {
-        LOGE("Failed to read in netlink message, errno = %d,(%s)",
-             errno, strerror(errno));
-        return;
-    }
-    else if (rlen == sizeof(buf)) {
-        LOGW("Netlink message buffer overrun!");
-    }
+    int                             rssi;
 
     nlmsg = (struct nlmsghdr *)buf;
-    if (NLMSG_PAYLOAD(nlmsg, 0) < sizeof(*bsev)) {
-        LOGW("Malformed netlink event received, length (%d < %zu)",
-             NLMSG_PAYLOAD(nlmsg, 0), sizeof(*bsev));
+    if (len < sizeof(*nlmsg) || NLMSG_PAYLOAD(nlmsg, 0) < sizeof(*bsev)) {
+        LOGW("Malformed netlink event received, length (%zu < %zu)",
+             len, NLMSG_SPACE(sizeof(*bsev)));
+        _bsal_event_stats.dropped++;
         return;
     }
     bsev = NLMSG_DATA(nlmsg);
 
-    // NB: This check should always be done after the read() call. If select() says
-    //     there is data on the socket but there's no callback, then it will service
-    //     the socket by reading the data and then discarding it.
+    // NB: Events are drained from the socket even without a callback,
+    //     they are discarded here.
     if (_bsal_event_cb == NULL) {
         LOGW("_bsal_event_cb not initialized, discarding event");
+        _bsal_event_stats.dropped++;
         return;
     }
 
-    if (!if_indextoname(bsev->sys_index, ifname)) {
+    if (!(ifname = qca_bsal_ifname_get(bsev->sys_index))) {
         LOGE("Failed to find ifname base on index %u", bsev->sys_index);
+        _bsal_event_stats.dropped++;
         return;
     }
 
-    event = CALLOC(1, sizeof(*event));
+    if (bsev->type == ATH_EVENT_BSTEERING_PROBE_REQ &&
+        !qca_bsal_probe_aggr(bsev, &rssi)) {
+        return;
+    }
+
+    event = qca_bsal_event_get();
 
     STRSCPY(event->ifname, ifname);
 
@@ -529,7 +832,7 @@ static void qca_bsal_event_process(void)
         memcpy(&event->data.probe_req.client_addr,
                                          &bsev->data.bs_probe.sender_addr,
                                          sizeof(event->data.probe_req.client_addr));
-        event->data.probe_req.rssi      = bsev->data.bs_probe.rssi;
+        event->data.probe_req.rssi      = rssi;
         event->data.probe_req.ssid_null = bsev->data.bs_probe.ssid_null ? true : false;
         event->data.probe_req.blocked   = bsev->data.bs_probe.blocked   ? true : false;
         break;
@@ -618,7 +921,8 @@ static void qca_bsal_event_process(void)
         if (!c_get_value_by_key(map_disc_source, bsev->data.bs_disconnect_ind.source, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_DISCONNECTED): Unknown source %d",
                                                  bsev->data.bs_disconnect_ind.source);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.disconnect.source = val;
@@ -626,7 +930,8 @@ static void qca_bsal_event_process(void)
         if (!c_get_value_by_key(map_disc_type, bsev->data.bs_disconnect_ind.type, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_DISCONNECTED): Unknown type %d",
                                                bsev->data.bs_disconnect_ind.type);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.disconnect.type = val;
@@ -658,7 +963,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.inact_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown inact %d",
                                 bsev->data.bs_rssi_xing.inact_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.inact_xing = val;
@@ -667,7 +973,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.rate_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown rate %d",
                                 bsev->data.bs_rssi_xing.rate_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.high_xing = val;
@@ -676,7 +983,8 @@ static void qca_bsal_event_process(void)
                                 bsev->data.bs_rssi_xing.low_rssi_xing, &val)) {
             LOGE("qca_bsal_event_process(ATH_EVENT_BSTEERING_CLIENT_RSSI_CROSSING): Unknown low %d",
                                 bsev->data.bs_rssi_xing.low_rssi_xing);
-            FREE(event);
+            qca_bsal_event_release(event);
+            _bsal_event_stats.dropped++;
             return;
         }
         event->data.rssi_change.low_xing = val;
@@ -705,19 +1013,89 @@ static void qca_bsal_event_process(void)
 
     default:
         /* ignore this event */
-        FREE(event);
+        qca_bsal_event_release(event);
         return;
     }
 
-    _bsal_event_cb(event);
+    qca_bsal_event_queue(event);
+}
 
-    // Free the memory allocated for event here, as _bsal_event_cb will
-    // allocate the memory and copy the contents
-    if (event) {
-        FREE(event);
+static void qca_bsal_event_process(void)
+{
+    static char                     bufs[BSAL_EVENT_RECV_VLEN][BSAL_EVENT_RECV_LEN];
+    struct mmsghdr                  msgs[BSAL_EVENT_RECV_VLEN];
+    struct iovec                    iovs[BSAL_EVENT_RECV_VLEN];
+    unsigned int                    received = 0;
+    int                             round;
+    int                             cnt;
+    int                             i;
+
+    if (_bsal_netlink_fd < 0) {
+        LOGW("_bsal_netlink_fd not initialized");
+        return;
     }
 
-    return;
+    /* Drain the socket, bounded so other watchers still get their turn */
+    for (round = 0; round < BSAL_EVENT_RECV_ROUNDS; round++) {
+        memset(msgs, 0, sizeof(msgs));
+        for (i = 0; i < BSAL_EVENT_RECV_VLEN; i++) {
+            iovs[i].iov_base = bufs[i];
+            iovs[i].iov_len = sizeof(bufs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        cnt = recvmmsg(_bsal_netlink_fd, msgs, BSAL_EVENT_RECV_VLEN, MSG_DONTWAIT, NULL);
+        if (cnt < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == ENOBUFS) {
+                /* Driver outpaced us, events in between are lost */
+                _bsal_event_stats.overruns++;
+                LOGW("Netlink event socket overrun (%u overruns)",
+                     _bsal_event_stats.overruns);
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOGE("Failed to read in netlink message, errno = %d,(%s)",
+                     errno, strerror(errno));
+            }
+            break;
+        }
+
+        for (i = 0; i < cnt; i++) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                LOGW("Netlink message buffer overrun!");
+                _bsal_event_stats.dropped++;
+                continue;
+            }
+
+            qca_bsal_event_parse(bufs[i], msgs[i].msg_len);
+        }
+
+        received += cnt;
+
+        if (cnt < BSAL_EVENT_RECV_VLEN)
+            break;
+    }
+
+    _bsal_event_stats.received += received;
+
+    qca_bsal_event_flush();
+
+    LOGT("%s: received %u events (total received %u delivered %u batches %u "
+         "dropped %u overruns %u pool full %u ifname lookups %u probes merged %u)",
+         __func__, received,
+         _bsal_event_stats.received,
+         _bsal_event_stats.delivered,
+         _bsal_event_stats.batches,
+         _bsal_event_stats.dropped,
+         _bsal_event_stats.overruns,
+         _bsal_event_stats.pool_full,
+         _bsal_event_stats.ifname_lookups,
+         _bsal_event_stats.probes_merged);
 }
 
 static int qca_bsal_bs_enable(
@@ -807,6 +1185,7 @@ int qca_bsal_iface_remove(const bsal_ifconfig_t *ifcfg)
     }
 
     qca_bsal_bs_config(_bsal_ioctl_fd, ifcfg, false);
+    qca_bsal_neigh_flush(ifcfg->ifname);
     return 0;
 }
 
@@ -917,6 +1296,82 @@ int qca_bsal_client_info(
     return osync_nl80211_sta_info(ifname,mac_addr,info);
 }
 
+/*
+ * Requests to clients are encoded natively and sent as action frames,
+ * hostapd_cli and wifitool are only forked if that fails.
+ */
+static bool qca_bsal_vap_freq(const char *ifname, uint32_t *freq)
+{
+    struct iwreq iwr;
+    uint64_t hz;
+    int e;
+
+    memset(&iwr, 0, sizeof(iwr));
+    STRSCPY(iwr.ifr_name, ifname);
+
+    if (ioctl(_bsal_ioctl_fd, SIOCGIWFREQ, &iwr) < 0)
+        return false;
+
+    /* Channel number instead of frequency */
+    if (iwr.u.freq.e == 0 && iwr.u.freq.m < 1000)
+        return false;
+
+    hz = iwr.u.freq.m;
+    for (e = iwr.u.freq.e; e > 0; e--)
+        hz *= 10;
+
+    *freq = hz / 1000000;
+    return true;
+}
+
+static bool qca_bsal_vap_ssid(const char *ifname, char *ssid, size_t ssid_len)
+{
+    struct iwreq iwr;
+
+    memset(ssid, 0, ssid_len);
+    memset(&iwr, 0, sizeof(iwr));
+    STRSCPY(iwr.ifr_name, ifname);
+    iwr.u.essid.pointer = ssid;
+    iwr.u.essid.length  = ssid_len - 1;
+
+    return ioctl(_bsal_ioctl_fd, SIOCGIWESSID, &iwr) == 0;
+}
+
+static int qca_bsal_action_send(
+        const char *ifname,
+        const uint8_t *mac_addr,
+        const uint8_t *frame,
+        int frame_len)
+{
+    struct ieee80211_p2p_send_action    *act;
+    uint8_t                             buf[sizeof(*act) + QCA_BSAL_FRAME_LEN_MAX];
+    os_macaddr_t                        bssid;
+    uint32_t                            freq;
+
+    if (frame_len < 0 || frame_len > QCA_BSAL_FRAME_LEN_MAX)
+        return -1;
+
+    if (!os_nif_macaddr(ifname, &bssid)) {
+        LOGD("%s: Failed to get BSSID", ifname);
+        return -1;
+    }
+
+    if (!qca_bsal_vap_freq(ifname, &freq)) {
+        LOGD("%s: Failed to get operating frequency", ifname);
+        return -1;
+    }
+
+    act = (struct ieee80211_p2p_send_action *)buf;
+    memset(act, 0, sizeof(*act));
+    act->freq = freq;
+    memcpy(act->dst_addr, mac_addr, sizeof(act->dst_addr));
+    memcpy(act->src_addr, &bssid, sizeof(act->src_addr));
+    memcpy(act->bssid, &bssid, sizeof(act->bssid));
+    memcpy(act + 1, frame, frame_len);
+
+    return qca_bsal_send_action(ifname, mac_addr, buf, sizeof(*act) + frame_len);
+}
+
 static bool qca_bss_tm_request(
         const char *client_mac,
         const char *interface,
@@ -1046,10 +1501,19 @@ int qca_bsal_bss_tm_request(
     char                    client_mac[18]  = { 0 };
     os_macaddr_t            temp;
     bool                    ret             = false;
+    uint8_t                 frame[QCA_BSAL_FRAME_LEN_MAX];
+    int                     frame_len;
 
     memcpy(&temp, mac_addr, sizeof(temp));
     sprintf(client_mac, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
 
+    frame_len = qca_bsal_frame_btm_req(frame, sizeof(frame), qca_bsal_frame_token(), btm_params);
+    if (qca_bsal_action_send(ifname, mac_addr, frame, frame_len) == 0) {
+        LOGD("Client %s - BTM request sent (%d neighbors)", client_mac, btm_params->num_neigh);
+        return 0;
+    }
+
+    LOGD("Client %s - BTM request falling back to hostapd_cli", client_mac);
     ret = qca_bss_tm_request(client_mac, ifname, btm_params);
     if (!ret) {
         LOGW("qca_bss_tm_request failed");
@@ -1067,10 +1531,27 @@ int qca_bsal_rrm_beacon_report_request(
     char                    client_mac[18]  = { 0 };
     os_macaddr_t            temp;
     bool                    ret             = false;
+    char                    ssid[IW_ESSID_MAX_SIZE + 1] = { 0 };
+    uint8_t                 frame[QCA_BSAL_FRAME_LEN_MAX];
+    int                     frame_len;
 
     memcpy(&temp, mac_addr, sizeof(temp));
     sprintf(client_mac, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
 
+    /*
+     * bsal_rrm_params_t only flags the Request subelement, so requests with
+     * req_ie set go through wifitool and the driver picks the elements.
+     */
+    if (rrm_params->req_ssid != 1 || qca_bsal_vap_ssid(ifname, ssid, sizeof(ssid))) {
+        frame_len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), qca_bsal_frame_token(),
+                                               rrm_params, ssid, NULL, 0);
+        if (qca_bsal_action_send(ifname, mac_addr, frame, frame_len) == 0) {
+            LOGD("Client %s - beacon report request sent", client_mac);
+            return 0;
+        }
+    }
+
+    LOGD("Client %s - beacon report request falling back to wifitool", client_mac);
     ret = qca_rrm_bcn_rpt_request(client_mac, ifname, rrm_params);
     if (!ret) {
         LOGW("qca_rrm_bcn_rpt_request failed");
@@ -1080,54 +1561,6 @@ int qca_bsal_rrm_beacon_report_request(
     return 0;
 }
 
-
-int qca_bsal_rrm_set_neighbor(
-        const char *ifname,
-        const bsal_neigh_info_t *neigh)
-{
-    os_macaddr_t temp;
-    char bssid[18] = { 0 };
-    char nr[256] = { 0 };
-
-    memcpy(&temp, neigh->bssid, sizeof(temp));
-    sprintf(bssid, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
-
-    snprintf(nr, sizeof(nr),
-             "%02hhx%02hhx%02hhx%02hhx%02hhx%02hhx"  // bssid
-             "%02hhx%02hhx%02hhx%02hhx"              // bssid_info
-             "%02hhx"                                // operclass
-             "%02hhx"                                // channel
-             "%02hhx",                               // phy_mode
-             neigh->bssid[0], neigh->bssid[1], neigh->bssid[2], neigh->bssid[3], neigh->bssid[4], neigh->bssid[5],
-             neigh->bssid_info & 0xff, (neigh->bssid_info >> 8) & 0xff,
-             (neigh->bssid_info >> 16) & 0xff, (neigh->bssid_info >> 24) & 0xff,
-             neigh->op_class,
-             neigh->channel,
-             neigh->phy_type);
-
-    if (!hostapd_rrm_set_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT, ifname, bssid, nr)) {
-        return -1;
-    }
-
-    return 0;
-}
-
-int qca_bsal_rrm_remove_neighbor(
-        const char *ifname,
-        const bsal_neigh_info_t *neigh)
-{
-    os_macaddr_t temp;
-    char bssid[18] = { 0 };
-
-    memcpy(&temp, neigh->bssid, sizeof(temp));
-    sprintf(bssid, PRI(os_macaddr_lower_t), FMT(os_macaddr_t, temp));
-    if (!hostapd_rrm_remove_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT, ifname, bssid)) {
-        return -1;
-    }
-
-    return 0;
-}
-
 int qca_bsal_send_action(
         const char *ifname,
         const uint8_t *mac_addr,
@@ -1169,6 +1602,10 @@ int qca_bsal_init(
     _ev_loop = loop;
     _bsal_event_cb = event_cb;
 
+    qca_bsal_event_pool_init();
+    memset(&_bsal_event_stats, 0, sizeof(_bsal_event_stats));
+    memset(&_bsal_probe_aggr, 0, sizeof(_bsal_probe_aggr));
+
     // Create fd to issue ioctl's
     if (qca_bsal_ioctl_init() < 0) {
         LOGE("Failed to create socket");
@@ -1196,11 +1633,20 @@ error:
 
 int qca_bsal_cleanup(void)
 {
-    LOGI("BSAL cleaning up");
+    LOGI("BSAL cleaning up (events received %u delivered %u dropped %u "
+         "overruns %u pool full %u probes merged %u)",
+         _bsal_event_stats.received,
+         _bsal_event_stats.delivered,
+         _bsal_event_stats.dropped,
+         _bsal_event_stats.overruns,
+         _bsal_event_stats.pool_full,
+         _bsal_event_stats.probes_merged);
 
     qca_bsal_rt_netlink_cleanup();
     qca_bsal_netlink_cleanup();
     qca_bsal_ioctl_cleanup();
+    qca_bsal_ifname_flush();
+    qca_bsal_neigh_flush(NULL);
 
     _ev_loop = NULL;
     _bsal_event_cb = NULL;
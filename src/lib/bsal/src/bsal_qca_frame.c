@@ -0,0 +1,270 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * 802.11k/v action frames
+ *
+ * BSS Transition Management and Beacon Report requests are encoded here
+ * and sent through the driver action frame path instead of forking
+ * hostapd_cli or wifitool for every request. Layouts follow IEEE Std
+ * 802.11-2016, 9.6.14.9 and 9.6.7.2.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "log.h"
+#include "target.h"
+#include "qca_bsal_frame.h"
+
+#define BSAL_FRAME_CATEGORY_RADIO_MEASUREMENT   5
+#define BSAL_FRAME_CATEGORY_WNM                 10
+
+#define BSAL_FRAME_ACTION_RADIO_MEAS_REQ        0
+#define BSAL_FRAME_ACTION_BSS_TM_REQ            7
+
+#define BSAL_FRAME_EID_MEASURE_REQUEST          38
+#define BSAL_FRAME_EID_NEIGHBOR_REPORT          52
+
+#define BSAL_FRAME_MEAS_TYPE_BEACON             5
+
+/* Beacon request subelements */
+#define BSAL_FRAME_BCN_SUB_SSID                 0
+#define BSAL_FRAME_BCN_SUB_REPORTING_INFO       1
+#define BSAL_FRAME_BCN_SUB_REPORTING_DETAIL     2
+#define BSAL_FRAME_BCN_SUB_REQUEST              10
+
+/* Neighbor report subelements */
+#define BSAL_FRAME_NR_SUB_CAND_PREF             3
+
+/* BTM request mode */
+#define BSAL_FRAME_BTM_PREF_CAND_LIST           (1 << 0)
+#define BSAL_FRAME_BTM_ABRIDGED                 (1 << 1)
+#define BSAL_FRAME_BTM_DISASSOC_IMMINENT        (1 << 2)
+
+#define BSAL_FRAME_SSID_LEN_MAX                 32
+
+typedef struct {
+    uint8_t     *buf;
+    size_t      len;
+    size_t      pos;
+    bool        err;
+} bsal_frame_t;
+
+static uint8_t _bsal_frame_token = 0;
+
+/***************************************************************************************/
+
+static void bsal_frame_put(bsal_frame_t *f, const void *data, size_t len)
+{
+    if (f->err || f->len - f->pos < len) {
+        f->err = true;
+        return;
+    }
+
+    memcpy(f->buf + f->pos, data, len);
+    f->pos += len;
+}
+
+static void bsal_frame_u8(bsal_frame_t *f, uint8_t val)
+{
+    bsal_frame_put(f, &val, sizeof(val));
+}
+
+static void bsal_frame_le16(bsal_frame_t *f, uint16_t val)
+{
+    uint8_t le[2] = { val & 0xff, val >> 8 };
+
+    bsal_frame_put(f, le, sizeof(le));
+}
+
+static void bsal_frame_le32(bsal_frame_t *f, uint32_t val)
+{
+    uint8_t le[4] = { val & 0xff, (val >> 8) & 0xff, (val >> 16) & 0xff, val >> 24 };
+
+    bsal_frame_put(f, le, sizeof(le));
+}
+
+/* Opens an element, length is filled in by bsal_frame_elem_end() */
+static size_t bsal_frame_elem_start(bsal_frame_t *f, uint8_t id)
+{
+    bsal_frame_u8(f, id);
+    bsal_frame_u8(f, 0);
+    return f->pos;
+}
+
+static void bsal_frame_elem_end(bsal_frame_t *f, size_t start)
+{
+    if (f->err)
+        return;
+
+    if (f->pos - start > 255) {
+        f->err = true;
+        return;
+    }
+
+    f->buf[start - 1] = f->pos - start;
+}
+
+static int bsal_frame_len(const bsal_frame_t *f)
+{
+    return f->err ? -1 : (int)f->pos;
+}
+
+/***************************************************************************************/
+
+uint8_t qca_bsal_frame_token(void)
+{
+    if (++_bsal_frame_token == 0)
+        _bsal_frame_token = 1;
+
+    return _bsal_frame_token;
+}
+
+int qca_bsal_frame_btm_req(
+        uint8_t *buf,
+        size_t len,
+        uint8_t dialog_token,
+        const bsal_btm_params_t *btm_params)
+{
+    const bsal_neigh_info_t *neigh;
+    bsal_frame_t f = { .buf = buf, .len = len };
+    uint8_t mode = 0;
+    size_t elem;
+    int i;
+
+    if (btm_params->pref)
+        mode |= BSAL_FRAME_BTM_PREF_CAND_LIST;
+    if (btm_params->abridged)
+        mode |= BSAL_FRAME_BTM_ABRIDGED;
+    if (btm_params->disassoc_imminent)
+        mode |= BSAL_FRAME_BTM_DISASSOC_IMMINENT;
+
+    bsal_frame_u8(&f, BSAL_FRAME_CATEGORY_WNM);
+    bsal_frame_u8(&f, BSAL_FRAME_ACTION_BSS_TM_REQ);
+    bsal_frame_u8(&f, dialog_token);
+    bsal_frame_u8(&f, mode);
+    bsal_frame_le16(&f, 0);             /* Disassociation Timer */
+    bsal_frame_u8(&f, btm_params->valid_int);
+
+    /* Candidate list, most preferred first */
+    for (i = 0; i < btm_params->num_neigh; i++) {
+        neigh = &btm_params->neigh[i];
+
+        elem = bsal_frame_elem_start(&f, BSAL_FRAME_EID_NEIGHBOR_REPORT);
+        bsal_frame_put(&f, neigh->bssid, 6);
+        bsal_frame_le32(&f, neigh->bssid_info);
+        bsal_frame_u8(&f, neigh->op_class);
+        bsal_frame_u8(&f, neigh->channel);
+        bsal_frame_u8(&f, neigh->phy_type);
+
+        if (btm_params->pref) {
+            bsal_frame_u8(&f, BSAL_FRAME_NR_SUB_CAND_PREF);
+            bsal_frame_u8(&f, 1);
+            bsal_frame_u8(&f, i < 255 ? 255 - i : 1);
+        }
+
+        bsal_frame_elem_end(&f, elem);
+    }
+
+    return bsal_frame_len(&f);
+}
+
+int qca_bsal_frame_bcn_rpt_req(
+        uint8_t *buf,
+        size_t len,
+        uint8_t dialog_token,
+        const bsal_rrm_params_t *rrm_params,
+        const char *ssid,
+        const uint8_t *req_ies,
+        size_t req_ies_num)
+{
+    static const uint8_t wildcard[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    bsal_frame_t f = { .buf = buf, .len = len };
+    size_t ssid_len = 0;
+    size_t elem;
+
+    /* AP Channel Report needs the driver channel tables */
+    if (rrm_params->chanrpt_mode)
+        return -1;
+
+    /* Request subelement without the caller's element list */
+    if (rrm_params->req_ie && rrm_params->rpt_detail == 1) {
+        if (!req_ies || req_ies_num == 0 || req_ies_num > 255)
+            return -1;
+    }
+
+    if (rrm_params->req_ssid == 1) {
+        if (!ssid || (ssid_len = strlen(ssid)) > BSAL_FRAME_SSID_LEN_MAX)
+            return -1;
+    }
+
+    bsal_frame_u8(&f, BSAL_FRAME_CATEGORY_RADIO_MEASUREMENT);
+    bsal_frame_u8(&f, BSAL_FRAME_ACTION_RADIO_MEAS_REQ);
+    bsal_frame_u8(&f, dialog_token);
+    bsal_frame_le16(&f, 0);             /* Number of Repetitions */
+
+    elem = bsal_frame_elem_start(&f, BSAL_FRAME_EID_MEASURE_REQUEST);
+    bsal_frame_u8(&f, dialog_token);    /* Measurement Token */
+    bsal_frame_u8(&f, 0);               /* Measurement Request Mode */
+    bsal_frame_u8(&f, BSAL_FRAME_MEAS_TYPE_BEACON);
+    bsal_frame_u8(&f, rrm_params->op_class);
+    bsal_frame_u8(&f, rrm_params->channel);
+    bsal_frame_le16(&f, rrm_params->rand_ivl);
+    bsal_frame_le16(&f, rrm_params->meas_dur);
+    bsal_frame_u8(&f, rrm_params->meas_mode);
+    bsal_frame_put(&f, wildcard, sizeof(wildcard));
+
+    /* No SSID subelement means wildcard SSID */
+    if (rrm_params->req_ssid == 1) {
+        bsal_frame_u8(&f, BSAL_FRAME_BCN_SUB_SSID);
+        bsal_frame_u8(&f, ssid_len);
+        bsal_frame_put(&f, ssid, ssid_len);
+    }
+
+    if (rrm_params->rep_cond) {
+        bsal_frame_u8(&f, BSAL_FRAME_BCN_SUB_REPORTING_INFO);
+        bsal_frame_u8(&f, 2);
+        bsal_frame_u8(&f, rrm_params->rep_cond);
+        bsal_frame_u8(&f, 0);           /* Threshold/Offset */
+    }
+
+    bsal_frame_u8(&f, BSAL_FRAME_BCN_SUB_REPORTING_DETAIL);
+    bsal_frame_u8(&f, 1);
+    bsal_frame_u8(&f, rrm_params->rpt_detail);
+
+    if (rrm_params->req_ie && rrm_params->rpt_detail == 1) {
+        bsal_frame_u8(&f, BSAL_FRAME_BCN_SUB_REQUEST);
+        bsal_frame_u8(&f, req_ies_num);
+        bsal_frame_put(&f, req_ies, req_ies_num);
+    }
+
+    bsal_frame_elem_end(&f, elem);
+
+    return bsal_frame_len(&f);
+}
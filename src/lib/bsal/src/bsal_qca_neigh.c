@@ -0,0 +1,348 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * 802.11k neighbor table of hostapd
+ *
+ * Each VAP keeps one table keyed by BSSID holding both the neighbor
+ * report BM wants and the one hostapd is known to have. Only entries where
+ * the two differ are sent. Commands go over a persistent hostapd control
+ * connection and are pipelined; hostapd_cli is only forked when it can't
+ * be reached. What hostapd has is forgotten whenever the connection had
+ * to be reopened since hostapd loses its table when restarted, and the
+ * whole table is pushed again.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "os.h"
+#include "ds_tree.h"
+#include "memutil.h"
+#include "target.h"
+#include "qca_bsal.h"
+#include "qca_bsal_neigh.h"
+#include "hostapd_util.h"
+
+#define BSAL_NEIGH_NR_LEN       32      /* 13 bytes in hex */
+#define BSAL_NEIGH_CMD_LEN      96
+
+struct neigh_entry {
+    uint8_t bssid[6];
+    char nr[BSAL_NEIGH_NR_LEN];         /* wanted, empty when removed */
+    char applied[BSAL_NEIGH_NR_LEN];    /* in hostapd, empty when not */
+    ds_tree_node_t node;
+};
+
+struct neigh_vap {
+    char ifname[32];
+    ds_tree_t neighs;
+    unsigned int neighs_cnt;
+    ds_tree_node_t node;
+};
+
+struct neigh_op {
+    struct neigh_entry *entry;
+    bool remove;
+    char bssid_str[18];
+    char cmd[BSAL_NEIGH_CMD_LEN];
+};
+
+static int bssid_cmp(const void *a, const void *b);
+
+static ds_tree_t _bsal_neigh_vaps = DS_TREE_INIT(ds_str_cmp, struct neigh_vap, node);
+
+/***************************************************************************************/
+
+static int bssid_cmp(const void *a, const void *b)
+{
+    return memcmp(a, b, 6);
+}
+
+static void qca_bsal_neigh_vap_flush(struct neigh_vap *vap)
+{
+    struct neigh_entry *entry;
+    ds_tree_iter_t iter;
+
+    for (entry = ds_tree_ifirst(&iter, &vap->neighs); entry; entry = ds_tree_inext(&iter)) {
+        ds_tree_iremove(&iter);
+        FREE(entry);
+    }
+
+    vap->neighs_cnt = 0;
+}
+
+/* hostapd lost its table, everything wanted has to be sent again */
+static void qca_bsal_neigh_vap_forget(struct neigh_vap *vap)
+{
+    struct neigh_entry *entry;
+
+    ds_tree_foreach(&vap->neighs, entry)
+        entry->applied[0] = '\0';
+}
+
+/* Drops entries neither wanted nor in hostapd */
+static void qca_bsal_neigh_vap_gc(struct neigh_vap *vap)
+{
+    struct neigh_entry *entry;
+    ds_tree_iter_t iter;
+
+    for (entry = ds_tree_ifirst(&iter, &vap->neighs); entry; entry = ds_tree_inext(&iter)) {
+        if (entry->nr[0] != '\0' || entry->applied[0] != '\0')
+            continue;
+
+        ds_tree_iremove(&iter);
+        FREE(entry);
+        vap->neighs_cnt--;
+    }
+}
+
+static struct neigh_vap *qca_bsal_neigh_vap_get(const char *ifname)
+{
+    struct neigh_vap *vap;
+    bool fresh;
+
+    if (!(vap = ds_tree_find(&_bsal_neigh_vaps, (void *)ifname))) {
+        vap = CALLOC(1, sizeof(*vap));
+        snprintf(vap->ifname, sizeof(vap->ifname), "%s", ifname);
+        ds_tree_init(&vap->neighs, bssid_cmp, struct neigh_entry, node);
+        ds_tree_insert(&_bsal_neigh_vaps, vap, vap->ifname);
+    }
+
+    /* Whatever was applied before can't be trusted anymore */
+    if (!hostapd_ctrl_connect(HOSTAPD_CONTROL_PATH_DEFAULT, ifname, &fresh) || fresh)
+        qca_bsal_neigh_vap_forget(vap);
+
+    return vap;
+}
+
+static struct neigh_entry *qca_bsal_neigh_entry_get(struct neigh_vap *vap, const uint8_t *bssid)
+{
+    struct neigh_entry *entry;
+
+    if (!(entry = ds_tree_find(&vap->neighs, (void *)bssid))) {
+        entry = CALLOC(1, sizeof(*entry));
+        memcpy(entry->bssid, bssid, sizeof(entry->bssid));
+        ds_tree_insert(&vap->neighs, entry, entry->bssid);
+        vap->neighs_cnt++;
+    }
+
+    return entry;
+}
+
+static void qca_bsal_neigh_entry_set(struct neigh_entry *entry, const bsal_neigh_info_t *neigh)
+{
+    const uint8_t *b = neigh->bssid;
+
+    snprintf(entry->nr, sizeof(entry->nr),
+             "%02hhx%02hhx%02hhx%02hhx%02hhx%02hhx"  // bssid
+             "%02hhx%02hhx%02hhx%02hhx"              // bssid_info
+             "%02hhx"                                // operclass
+             "%02hhx"                                // channel
+             "%02hhx",                               // phy_mode
+             b[0], b[1], b[2], b[3], b[4], b[5],
+             neigh->bssid_info & 0xff, (neigh->bssid_info >> 8) & 0xff,
+             (neigh->bssid_info >> 16) & 0xff, (neigh->bssid_info >> 24) & 0xff,
+             neigh->op_class,
+             neigh->channel,
+             neigh->phy_type);
+}
+
+/* Fills ops with what brings hostapd to the wanted table */
+static int qca_bsal_neigh_diff(struct neigh_vap *vap, struct neigh_op *ops)
+{
+    struct neigh_entry *entry;
+    struct neigh_op *op;
+    const uint8_t *b;
+    int n = 0;
+
+    ds_tree_foreach(&vap->neighs, entry) {
+        if (strcmp(entry->nr, entry->applied) == 0)
+            continue;
+
+        op = &ops[n++];
+        b = entry->bssid;
+        memset(op, 0, sizeof(*op));
+        op->entry = entry;
+        op->remove = entry->nr[0] == '\0';
+        snprintf(op->bssid_str, sizeof(op->bssid_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 b[0], b[1], b[2], b[3], b[4], b[5]);
+
+        if (op->remove)
+            snprintf(op->cmd, sizeof(op->cmd), "REMOVE_NEIGHBOR %s", op->bssid_str);
+        else
+            snprintf(op->cmd, sizeof(op->cmd), "SET_NEIGHBOR %s nr=%s", op->bssid_str, entry->nr);
+    }
+
+    return n;
+}
+
+static int qca_bsal_neigh_run(struct neigh_vap *vap, const struct neigh_op *ops, int n, bool *fresh)
+{
+    struct neigh_entry *entry;
+    const char **cmds;
+    bool *ok;
+    int failed = 0;
+    int i;
+
+    cmds = CALLOC(n, sizeof(*cmds));
+    ok = CALLOC(n, sizeof(*ok));
+
+    for (i = 0; i < n; i++)
+        cmds[i] = ops[i].cmd;
+
+    if (hostapd_ctrl_pipeline(vap->ifname, cmds, ok, n, fresh) < 0) {
+        LOGD("%s: applying %d neighbor changes through hostapd_cli", vap->ifname, n);
+        for (i = 0; i < n; i++) {
+            if (ops[i].remove)
+                ok[i] = hostapd_rrm_remove_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT,
+                                                    vap->ifname, ops[i].bssid_str);
+            else
+                ok[i] = hostapd_rrm_set_neighbor(HOSTAPD_CONTROL_PATH_DEFAULT,
+                                                 vap->ifname, ops[i].bssid_str,
+                                                 ops[i].entry->nr);
+        }
+    }
+
+    /* Only what was just sent is known to be in hostapd */
+    if (*fresh)
+        qca_bsal_neigh_vap_forget(vap);
+
+    for (i = 0; i < n; i++) {
+        entry = ops[i].entry;
+
+        /* Removing unknown neighbor fails but leaves hostapd as desired */
+        if (ops[i].remove) {
+            entry->applied[0] = '\0';
+            continue;
+        }
+
+        if (!ok[i]) {
+            failed++;
+            continue;
+        }
+
+        snprintf(entry->applied, sizeof(entry->applied), "%s", entry->nr);
+    }
+
+    FREE(cmds);
+    FREE(ok);
+
+    return failed ? -1 : 0;
+}
+
+static int qca_bsal_neigh_sync(struct neigh_vap *vap)
+{
+    struct neigh_op *ops;
+    bool fresh;
+    int ret = 0;
+    int n;
+
+    ops = CALLOC(vap->neighs_cnt + 1, sizeof(*ops));
+
+    n = qca_bsal_neigh_diff(vap, ops);
+    LOGD("%s: syncing %u neighbors, %d changes", vap->ifname, vap->neighs_cnt, n);
+
+    if (n > 0) {
+        ret = qca_bsal_neigh_run(vap, ops, n, &fresh);
+
+        /* hostapd was restarted, push what the diff assumed it had */
+        if (fresh && (n = qca_bsal_neigh_diff(vap, ops)) > 0) {
+            LOGD("%s: hostapd restarted, syncing %d more neighbors", vap->ifname, n);
+            if (qca_bsal_neigh_run(vap, ops, n, &fresh) < 0)
+                ret = -1;
+        }
+    }
+
+    FREE(ops);
+    qca_bsal_neigh_vap_gc(vap);
+
+    return ret;
+}
+
+/***************************************************************************************/
+
+void qca_bsal_neigh_flush(const char *ifname)
+{
+    struct neigh_vap *vap;
+    ds_tree_iter_t iter;
+
+    for (vap = ds_tree_ifirst(&iter, &_bsal_neigh_vaps); vap; vap = ds_tree_inext(&iter)) {
+        if (ifname && strcmp(vap->ifname, ifname) != 0)
+            continue;
+
+        ds_tree_iremove(&iter);
+        qca_bsal_neigh_vap_flush(vap);
+        FREE(vap);
+    }
+
+    hostapd_ctrl_close(ifname);
+}
+
+int qca_bsal_rrm_set_neighbor(const char *ifname, const bsal_neigh_info_t *nr)
+{
+    struct neigh_vap *vap;
+
+    vap = qca_bsal_neigh_vap_get(ifname);
+    qca_bsal_neigh_entry_set(qca_bsal_neigh_entry_get(vap, nr->bssid), nr);
+
+    return qca_bsal_neigh_sync(vap);
+}
+
+int qca_bsal_rrm_remove_neighbor(const char *ifname, const bsal_neigh_info_t *nr)
+{
+    struct neigh_vap *vap;
+    struct neigh_entry *entry;
+
+    vap = qca_bsal_neigh_vap_get(ifname);
+    if ((entry = ds_tree_find(&vap->neighs, (void *)nr->bssid)))
+        entry->nr[0] = '\0';
+
+    return qca_bsal_neigh_sync(vap);
+}
+
+int qca_bsal_rrm_sync_neighbors(
+        const char *ifname,
+        const bsal_neigh_info_t *neigh,
+        int num_neigh)
+{
+    struct neigh_vap *vap;
+    struct neigh_entry *entry;
+    int i;
+
+    vap = qca_bsal_neigh_vap_get(ifname);
+
+    ds_tree_foreach(&vap->neighs, entry)
+        entry->nr[0] = '\0';
+
+    for (i = 0; i < num_neigh; i++)
+        qca_bsal_neigh_entry_set(qca_bsal_neigh_entry_get(vap, neigh[i].bssid), &neigh[i]);
+
+    return qca_bsal_neigh_sync(vap);
+}
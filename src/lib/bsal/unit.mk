@@ -36,6 +36,8 @@ UNIT_SRC += src/bsal_qca10_2_4_csu3_11ax.c
 else
 UNIT_SRC += src/bsal_qca10_2_4_csu3.c
 endif
+UNIT_SRC += src/bsal_qca_frame.c
+UNIT_SRC += src/bsal_qca_neigh.c
 
 UNIT_CFLAGS := -I$(UNIT_PATH)/inc
 ifeq ($(CONFIG_PLATFORM_QCA_QSDK110),y)
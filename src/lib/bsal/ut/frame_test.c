@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Action frame encoder tests
+ *
+ * Expected frames are written out by hand from IEEE Std 802.11-2016,
+ * 9.6.14.9 (BSS Transition Management Request) and 9.6.7.2 (Radio
+ * Measurement Request with a Beacon request), multi-octet fields little
+ * endian.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "target.h"
+#include "qca_bsal_frame.h"
+
+static int g_failed;
+static int g_tests;
+
+static void frame_expect(
+        const char *name,
+        const uint8_t *frame,
+        int frame_len,
+        const uint8_t *expected,
+        int expected_len)
+{
+    int i;
+
+    g_tests++;
+
+    if (frame_len != expected_len) {
+        printf("FAIL %s: length %d, expected %d\n", name, frame_len, expected_len);
+        g_failed++;
+        return;
+    }
+
+    for (i = 0; i < expected_len; i++) {
+        if (frame[i] != expected[i]) {
+            printf("FAIL %s: byte %d is 0x%02x, expected 0x%02x\n",
+                   name, i, frame[i], expected[i]);
+            g_failed++;
+            return;
+        }
+    }
+}
+
+static void frame_expect_err(const char *name, int frame_len)
+{
+    g_tests++;
+
+    if (frame_len != -1) {
+        printf("FAIL %s: length %d, expected -1\n", name, frame_len);
+        g_failed++;
+    }
+}
+
+static void frame_test_btm(void)
+{
+    static const uint8_t pref[] = {
+        0x0a, 0x07, 0x05,                   /* WNM, BTM Request, token */
+        0x03,                               /* Pref Cand List | Abridged */
+        0x00, 0x00,                         /* Disassociation Timer */
+        0x64,                               /* Validity Interval */
+        0x34, 0x10,                         /* Neighbor Report */
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55,
+        0x8f, 0x00, 0x00, 0x00,             /* BSSID Information */
+        0x73, 0x24, 0x09,                   /* Op class, channel, PHY */
+        0x03, 0x01, 0xff,                   /* Candidate Preference */
+        0x34, 0x10,
+        0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb,
+        0x78, 0x56, 0x34, 0x12,
+        0x51, 0x06, 0x07,
+        0x03, 0x01, 0xfe,
+    };
+    static const uint8_t imminent[] = {
+        0x0a, 0x07, 0x80,
+        0x04,                               /* Disassociation Imminent */
+        0x00, 0x00,
+        0x0a,
+        0x34, 0x0d,
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55,
+        0x8f, 0x00, 0x00, 0x00,
+        0x73, 0x24, 0x09,
+    };
+    bsal_btm_params_t btm;
+    uint8_t frame[QCA_BSAL_FRAME_LEN_MAX];
+    int len;
+
+    memset(&btm, 0, sizeof(btm));
+    btm.num_neigh = 2;
+    btm.valid_int = 100;
+    btm.abridged = 1;
+    btm.pref = 1;
+    memcpy(btm.neigh[0].bssid, "\x00\x11\x22\x33\x44\x55", 6);
+    btm.neigh[0].bssid_info = 0x8f;
+    btm.neigh[0].op_class = 115;
+    btm.neigh[0].channel = 36;
+    btm.neigh[0].phy_type = 9;
+    memcpy(btm.neigh[1].bssid, "\x66\x77\x88\x99\xaa\xbb", 6);
+    btm.neigh[1].bssid_info = 0x12345678;
+    btm.neigh[1].op_class = 81;
+    btm.neigh[1].channel = 6;
+    btm.neigh[1].phy_type = 7;
+
+    len = qca_bsal_frame_btm_req(frame, sizeof(frame), 0x05, &btm);
+    frame_expect("btm pref", frame, len, pref, sizeof(pref));
+
+    len = qca_bsal_frame_btm_req(frame, sizeof(pref) - 1, 0x05, &btm);
+    frame_expect_err("btm short buffer", len);
+
+    btm.num_neigh = 1;
+    btm.valid_int = 10;
+    btm.abridged = 0;
+    btm.pref = 0;
+    btm.disassoc_imminent = 1;
+
+    len = qca_bsal_frame_btm_req(frame, sizeof(frame), 0x80, &btm);
+    frame_expect("btm imminent", frame, len, imminent, sizeof(imminent));
+}
+
+static void frame_test_bcn_rpt(void)
+{
+    static const uint8_t req_ies[] = { 0, 48, 221 };
+    static const uint8_t active[] = {
+        0x05, 0x00, 0x09,                   /* Radio Meas, Request, token */
+        0x00, 0x00,                         /* Number of Repetitions */
+        0x26, 0x1e,                         /* Measurement Request */
+        0x09, 0x00, 0x05,                   /* Token, mode, Beacon */
+        0x73, 0x24,                         /* Op class, channel */
+        0x0a, 0x00,                         /* Randomization Interval */
+        0x32, 0x00,                         /* Measurement Duration */
+        0x01,                               /* Active */
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0x00, 0x04, 'h', 'o', 'm', 'e',     /* SSID */
+        0x02, 0x01, 0x01,                   /* Reporting Detail */
+        0x0a, 0x03, 0x00, 0x30, 0xdd,       /* Request */
+    };
+    static const uint8_t passive[] = {
+        0x05, 0x00, 0x07,
+        0x00, 0x00,
+        0x26, 0x17,
+        0x07, 0x00, 0x05,
+        0x51, 0x06,
+        0x00, 0x00,
+        0x14, 0x00,
+        0x00,                               /* Passive */
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0x01, 0x02, 0x01, 0x00,             /* Reporting Information */
+        0x02, 0x01, 0x02,
+    };
+    bsal_rrm_params_t rrm;
+    uint8_t frame[QCA_BSAL_FRAME_LEN_MAX];
+    int len;
+
+    memset(&rrm, 0, sizeof(rrm));
+    rrm.op_class = 115;
+    rrm.channel = 36;
+    rrm.rand_ivl = 10;
+    rrm.meas_dur = 50;
+    rrm.meas_mode = 1;
+    rrm.req_ssid = 1;
+    rrm.rpt_detail = 1;
+    rrm.req_ie = 1;
+
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), 0x09, &rrm, "home",
+                                     req_ies, sizeof(req_ies));
+    frame_expect("bcn active", frame, len, active, sizeof(active));
+
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), 0x09, &rrm, "home", NULL, 0);
+    frame_expect_err("bcn req_ie without elements", len);
+
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), 0x09, &rrm,
+                                     "0123456789abcdef0123456789abcdef0",
+                                     req_ies, sizeof(req_ies));
+    frame_expect_err("bcn ssid too long", len);
+
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(active) - 1, 0x09, &rrm, "home",
+                                     req_ies, sizeof(req_ies));
+    frame_expect_err("bcn short buffer", len);
+
+    memset(&rrm, 0, sizeof(rrm));
+    rrm.op_class = 81;
+    rrm.channel = 6;
+    rrm.meas_dur = 20;
+    rrm.rep_cond = 1;
+    rrm.rpt_detail = 2;
+    rrm.req_ie = 1;                     /* Ignored without Reporting Detail 1 */
+
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), 0x07, &rrm, NULL, NULL, 0);
+    frame_expect("bcn passive", frame, len, passive, sizeof(passive));
+
+    rrm.chanrpt_mode = 1;
+    len = qca_bsal_frame_bcn_rpt_req(frame, sizeof(frame), 0x07, &rrm, NULL, NULL, 0);
+    frame_expect_err("bcn channel report", len);
+}
+
+static void frame_test_token(void)
+{
+    int i;
+
+    g_tests++;
+
+    for (i = 0; i < 512; i++) {
+        if (qca_bsal_frame_token() == 0) {
+            printf("FAIL token: 0 after %d tokens\n", i);
+            g_failed++;
+            return;
+        }
+    }
+}
+
+int main(void)
+{
+    frame_test_btm();
+    frame_test_bcn_rpt();
+    frame_test_token();
+
+    printf("frame: %d tests, %d failed\n", g_tests, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync target API, BSAL request types only. */
+
+#ifndef TARGET_H_STUB_INCLUDED
+#define TARGET_H_STUB_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BSAL_MAC_ADDR_LEN           6
+#define BSAL_MAX_TM_NEIGHBORS       3
+
+typedef struct {
+    uint8_t         bssid[BSAL_MAC_ADDR_LEN];
+    uint32_t        bssid_info;
+    uint8_t         op_class;
+    uint8_t         channel;
+    uint8_t         phy_type;
+} bsal_neigh_info_t;
+
+typedef struct {
+    bsal_neigh_info_t   neigh[BSAL_MAX_TM_NEIGHBORS];
+    int                 num_neigh;
+    uint8_t             valid_int;
+    uint8_t             abridged;
+    uint8_t             pref;
+    uint8_t             disassoc_imminent;
+    uint16_t            bss_term;
+    int                 max_tries;
+    int                 retry_interval;
+    bool                inc_neigh;
+} bsal_btm_params_t;
+
+typedef struct {
+    uint8_t         op_class;
+    uint8_t         channel;
+    uint8_t         rand_ivl;
+    uint8_t         meas_dur;
+    uint8_t         meas_mode;
+    uint8_t         req_ssid;
+    uint8_t         rep_cond;
+    uint8_t         rpt_detail;
+    uint8_t         req_ie;
+    uint8_t         chanrpt_mode;
+} bsal_rrm_params_t;
+
+#endif /* TARGET_H_STUB_INCLUDED */
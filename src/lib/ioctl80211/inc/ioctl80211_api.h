@@ -109,16 +109,20 @@ typedef int16_t  s16;
 typedef struct
 {
     ifname_t                            ifname;
+    int                                 ifindex;
+    ifname_t                            phy;
     mac_address_t                       mac;
     radio_essid_t                       essid;
     radio_type_t                        radio_type;
     bool                                sta;
 } ioctl80211_interface_t;
 
+/* Grows on demand, IOCTL80211_IFNAME_QTY entries at a time */
 typedef struct
 {
-    ioctl80211_interface_t              phy[IOCTL80211_IFNAME_QTY];
+    ioctl80211_interface_t             *phy;
     uint32_t                            qty;
+    uint32_t                            size;
 } ioctl80211_interfaces_t;
 
 typedef enum
@@ -156,6 +160,37 @@ void ioctl80211_interfaces_find(
         char                   *args[],
         radio_type_t            type);
 
+ioctl80211_interface_t *ioctl80211_interfaces_alloc(
+        ioctl80211_interfaces_t *interfaces);
+
+void ioctl80211_interfaces_free(
+        ioctl80211_interfaces_t *interfaces);
+
+/* Cached equivalent of ioctl80211_interfaces_find() with
+ * ioctl80211_interfaces_get(), caller frees the result.
+ *
+ * All fetchers that walk the VAPs of a radio (client list, capacity)
+ * go through it. Survey and scan do not enumerate interfaces, they
+ * address the radio (phy_name) or the VAP the caller passes in
+ * if_name directly, so there is nothing for them to look up. */
+ioctl_status_t ioctl80211_interfaces_lookup(
+        radio_type_t            type,
+        ioctl80211_interfaces_t *interfaces);
+
+/* Inventory entry of ifname as of the last lookup, NULL if the
+ * interface is not known. Does not refresh the inventory. */
+const ioctl80211_interface_t *ioctl80211_inventory_find(
+        const char              *ifname);
+
+/* Radio (parent) of a vap, the interface itself for radios */
+void ioctl80211_interface_phy_get(
+        const char              *ifname,
+        char                    *phy,
+        int                      len);
+
+ioctl_status_t ioctl80211_inventory_init(struct ev_loop *loop);
+ioctl_status_t ioctl80211_inventory_close(struct ev_loop *loop);
+
 int ioctl80211_request_send(
         int                     sock_fd,
         const char             *ifname,
@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "dpp_client.h"
 
 #include "ioctl80211_api.h"
+#include "ioctl80211_pool.h"
 
 /* Max size we support is 100 clients */
 #define IOCTL80211_CLIENTS_SIZE \
@@ -91,23 +92,18 @@ typedef struct
     ds_dlist_node_t                 node;
 } ioctl80211_client_record_t;
 
+extern ioctl80211_pool_t            g_ioctl80211_client_pool;
+
 static inline
 ioctl80211_client_record_t *ioctl80211_client_record_alloc()
 {
-    ioctl80211_client_record_t *record = NULL;
-
-    record = MALLOC(sizeof(ioctl80211_client_record_t));
-    memset(record, 0, sizeof(ioctl80211_client_record_t));
-
-    return record;
+    return ioctl80211_pool_alloc(&g_ioctl80211_client_pool);
 }
 
 static inline
 void ioctl80211_client_record_free(ioctl80211_client_record_t *record)
 {
-    if (NULL != record) {
-        FREE(record);
-    }
+    ioctl80211_pool_free(&g_ioctl80211_client_pool, record);
 }
 
 ioctl_status_t ioctl80211_client_list_get(
@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_CLIENT_DELTA_H_INCLUDED
+#define IOCTL80211_CLIENT_DELTA_H_INCLUDED
+
+#include <stdint.h>
+
+#include "ioctl80211_api.h"
+#include "ioctl80211_phyrate.h"
+
+/* Per bucket rate histogram deltas of one peer sample. The driver hands
+ * out packed array of structs, so the deltas are computed once per sample
+ * into these arrays in a single pass and the record pass then only walks
+ * the buckets listed in active[].
+ */
+typedef struct
+{
+    uint64_t                        bytes[PS_MAX_ALL];
+    uint32_t                        msdus[PS_MAX_ALL];
+    uint32_t                        mpdus[PS_MAX_ALL];
+    uint32_t                        ppdus[PS_MAX_ALL];
+    uint32_t                        retries[PS_MAX_ALL];
+    uint32_t                        sgi[PS_MAX_ALL];
+    uint16_t                        active[PS_MAX_ALL];
+    uint32_t                        active_qty;
+} ioctl80211_client_rx_delta_t;
+
+typedef struct
+{
+    uint32_t                        attempts[PS_MAX_ALL];
+    uint32_t                        success[PS_MAX_ALL];
+    uint32_t                        ppdus[PS_MAX_ALL];
+    uint32_t                        retries[PS_MAX_ALL];
+    uint16_t                        active[PS_MAX_ALL];
+    uint32_t                        active_qty;
+} ioctl80211_client_tx_delta_t;
+
+void ioctl80211_client_rx_delta_calc(
+        const struct ps_uapi_ioctl     *n,
+        const struct ps_uapi_ioctl     *o,
+        ioctl80211_client_rx_delta_t   *d);
+
+void ioctl80211_client_tx_delta_calc(
+        const struct ps_uapi_ioctl     *n,
+        const struct ps_uapi_ioctl     *o,
+        ioctl80211_client_tx_delta_t   *d);
+
+/* Peer stats buckets carry no phy. HT defines MCS 0-7 at 20 and 40 MHz,
+ * anything above is VHT. Legacy buckets are not looked up in the table.
+ */
+static inline void ioctl80211_client_bucket_decode(
+        uint32_t                        stats_index,
+        ioctl80211_phy_t               *phy,
+        uint32_t                       *mcs,
+        uint32_t                       *nss,
+        uint32_t                       *bw)
+{
+    if (stats_index < PS_MAX_LEGACY) {
+        *mcs = stats_index;
+        *nss = 0;
+        *bw  = 0;
+    }
+    else {
+        *bw  = ((stats_index - PS_MAX_LEGACY) / (PS_MAX_MCS * PS_MAX_NSS));
+        *nss = (((stats_index - PS_MAX_LEGACY) / PS_MAX_MCS) % PS_MAX_NSS) + 1;
+        *mcs = (stats_index - PS_MAX_LEGACY) % PS_MAX_MCS;
+    }
+
+    *phy = (*mcs > 7 || *bw > 1) ? IOCTL80211_PHY_VHT : IOCTL80211_PHY_HT;
+}
+
+#endif /* IOCTL80211_CLIENT_DELTA_H_INCLUDED */
@@ -0,0 +1,49 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_LINKSTATS_H_INCLUDED
+#define IOCTL80211_LINKSTATS_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Link counters younger than this are served from the last dump */
+#define IOCTL80211_LINKSTATS_MAX_AGE        1000    /* ms */
+
+/* Reads netdev tx bytes of an interface. All links of the system are
+ * fetched by a single RTM_GETLINK dump which is then shared by every
+ * lookup done within max_age_ms. Returns false only if the dump fails,
+ * an interface missing from it reads 0 bytes.
+ */
+bool ioctl80211_linkstats_tx_bytes_get(
+        const char                     *ifname,
+        uint64_t                        max_age_ms,
+        uint64_t                       *tx_bytes);
+
+/* Closes netlink socket and drops the snapshot */
+void ioctl80211_linkstats_cleanup(void);
+
+#endif /* IOCTL80211_LINKSTATS_H_INCLUDED */
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_NEIGHBOR_H_INCLUDED
+#define IOCTL80211_NEIGHBOR_H_INCLUDED
+
+#include "dpp_neighbor.h"
+
+#include "ioctl80211_api.h"
+
+/* Neighbor report selection, see ioctl80211_neighbor_report() */
+#define IOCTL80211_NEIGHBOR_REPORT_NEW      (1 << 0)    /* first seen */
+#define IOCTL80211_NEIGHBOR_REPORT_CHANGED  (1 << 1)    /* signal moved */
+#define IOCTL80211_NEIGHBOR_REPORT_EXPIRED  (1 << 2)    /* gone, sig 0 */
+#define IOCTL80211_NEIGHBOR_REPORT_FULL     (1 << 3)    /* all seen */
+
+#define IOCTL80211_NEIGHBOR_REPORT_DELTA    (IOCTL80211_NEIGHBOR_REPORT_NEW | \
+                                             IOCTL80211_NEIGHBOR_REPORT_CHANGED | \
+                                             IOCTL80211_NEIGHBOR_REPORT_EXPIRED)
+
+uint64_t ioctl80211_neighbor_key(
+        const dpp_neighbor_record_t *rec);
+
+uint32_t ioctl80211_neighbor_dedup(
+        dpp_neighbor_record_t      *recs,
+        uint32_t                    qty,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num);
+
+ioctl_status_t ioctl80211_neighbor_report(
+        radio_entry_t              *radio_cfg,
+        uint32_t                   *chan_list,
+        uint32_t                    chan_num,
+        uint32_t                    report,
+        dpp_neighbor_list_t        *neighbor_list);
+
+#endif /* IOCTL80211_NEIGHBOR_H_INCLUDED */
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_NLFILTER_H_INCLUDED
+#define IOCTL80211_NLFILTER_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <linux/filter.h>
+
+#define IOCTL80211_NLFILTER_IWE_MAX         4
+#define IOCTL80211_NLFILTER_PROG_MAX        32
+
+/* Selects RTMGRP_LINK messages a consumer handles. Anything else is
+ * dropped by the kernel before it is queued on the socket.
+ *
+ * Wireless events are matched on the command of the iw_event carried in
+ * IFLA_WIRELESS (the driver sends one per message). With iwe_drop set
+ * the listed commands are dropped and all other wireless events pass.
+ */
+typedef struct
+{
+    bool                            dellink;        /* RTM_DELLINK */
+    bool                            newlink;        /* RTM_NEWLINK w/o IFLA_WIRELESS */
+    bool                            newlink_create; /* ... only announcing a new link */
+    bool                            newlink_rename; /* ... only w/o flag changes, renames */
+    uint16_t                        iwe_cmd[IOCTL80211_NLFILTER_IWE_MAX];
+    int                             iwe_qty;
+    bool                            iwe_drop;
+} ioctl80211_nlfilter_t;
+
+/* Generates classic BPF program, returns instruction count or -1 */
+int ioctl80211_nlfilter_build(
+        const ioctl80211_nlfilter_t    *filter,
+        struct sock_filter             *prog,
+        int                             prog_max);
+
+/* Attaches generated program to a NETLINK_ROUTE socket. On failure
+ * socket is left unfiltered, consumers must still check messages.
+ */
+int ioctl80211_nlfilter_attach(
+        int                             fd,
+        const ioctl80211_nlfilter_t    *filter,
+        const char                     *name);
+
+#endif /* IOCTL80211_NLFILTER_H_INCLUDED */
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_PHYRATE_H_INCLUDED
+#define IOCTL80211_PHYRATE_H_INCLUDED
+
+#include <stdint.h>
+
+typedef enum
+{
+    IOCTL80211_PHY_HT = 0,
+    IOCTL80211_PHY_VHT,
+    IOCTL80211_PHY_HE,
+    IOCTL80211_PHY_QTY
+} ioctl80211_phy_t;
+
+/* Guard interval. HT/VHT use 0.4 (short) and 0.8 us (long), HE uses
+ * 0.8, 1.6 and 3.2 us.
+ */
+typedef enum
+{
+    IOCTL80211_GI_400 = 0,
+    IOCTL80211_GI_800,
+    IOCTL80211_GI_1600,
+    IOCTL80211_GI_3200,
+    IOCTL80211_GI_QTY
+} ioctl80211_gi_t;
+
+#define IOCTL80211_PHYRATE_MAX_BW       4       /* 20, 40, 80, 160 MHz */
+#define IOCTL80211_PHYRATE_MAX_NSS      8
+#define IOCTL80211_PHYRATE_MAX_MCS      12
+
+uint32_t ioctl80211_phyrate_kbps(
+        ioctl80211_phy_t            phy,
+        int                         bw,
+        int                         nss,
+        int                         mcs,
+        ioctl80211_gi_t             gi);
+
+#endif /* IOCTL80211_PHYRATE_H_INCLUDED */
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_POOL_H_INCLUDED
+#define IOCTL80211_POOL_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Fixed size object pool. Objects are carved out of slabs which are kept
+ * for the lifetime of the process, freed objects go to a free list and
+ * are handed out again. First slab holds prealloc objects, every next
+ * one holds grow objects.
+ */
+typedef struct ioctl80211_pool
+{
+    const char                     *name;
+    size_t                          obj_size;
+    uint32_t                        prealloc;
+    uint32_t                        grow;
+
+    void                           *free_list;
+    void                           *slabs;
+    uint32_t                        slab_qty;
+    uint32_t                        obj_qty;
+    uint32_t                        used;
+    uint32_t                        hwm;
+    uint64_t                        allocs;
+
+    struct ioctl80211_pool         *next;
+} ioctl80211_pool_t;
+
+#define IOCTL80211_POOL_INIT(_name, _type, _prealloc, _grow) \
+    { .name = (_name), .obj_size = sizeof(_type), \
+      .prealloc = (_prealloc), .grow = (_grow) }
+
+/* Returns zeroed object, grows the pool when needed */
+void *ioctl80211_pool_alloc(
+        ioctl80211_pool_t          *pool);
+
+void ioctl80211_pool_free(
+        ioctl80211_pool_t          *pool,
+        void                       *obj);
+
+/* Logs occupancy and high-water mark of all pools in use */
+void ioctl80211_pool_report(void);
+
+/* Objects handed out by all pools so far */
+uint64_t ioctl80211_pool_alloc_count(void);
+
+#endif /* IOCTL80211_POOL_H_INCLUDED */
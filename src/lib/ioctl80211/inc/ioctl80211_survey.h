@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "memutil.h"
 
 #include "ioctl80211_api.h"
+#include "ioctl80211_pool.h"
 
 // on-channel survey
 typedef struct
@@ -71,25 +72,23 @@ typedef struct
     ds_dlist_node_t                 node;
 } ioctl80211_survey_record_t;
 
+extern ioctl80211_pool_t            g_ioctl80211_survey_pool;
+
 static inline
 ioctl80211_survey_record_t *ioctl80211_survey_record_alloc()
 {
-    ioctl80211_survey_record_t *record = NULL;
-
-    record = MALLOC(sizeof(ioctl80211_survey_record_t));
-    memset(record, 0, sizeof(ioctl80211_survey_record_t));
-
-    return record;
+    return ioctl80211_pool_alloc(&g_ioctl80211_survey_pool);
 }
 
 static inline
 void ioctl80211_survey_record_free(ioctl80211_survey_record_t *record)
 {
-    if (NULL != record) {
-        FREE(record);
-    }
+    ioctl80211_pool_free(&g_ioctl80211_survey_pool, record);
 }
 
+/* Survey tables younger than this are served from the radio snapshot */
+#define IOCTL80211_SURVEY_SNAPSHOT_MAX_AGE  1000    /* ms */
+
 ioctl_status_t ioctl80211_survey_results_get(
         radio_entry_t              *radio_cfg,
         uint32_t                   *chan_list,
@@ -97,6 +96,14 @@ ioctl_status_t ioctl80211_survey_results_get(
         radio_scan_type_t           scan_type,
         ds_dlist_t                 *survey_list);
 
+const struct ps_uapi_ioctl *ioctl80211_survey_snapshot_data_get(
+        radio_entry_t              *radio_cfg,
+        radio_scan_type_t           scan_type,
+        uint64_t                    max_age_ms);
+
+void ioctl80211_survey_snapshot_invalidate(
+        radio_entry_t              *radio_cfg);
+
 ioctl_status_t ioctl80211_survey_results_convert(
         radio_entry_t              *radio_cfg,
         radio_scan_type_t           scan_type,
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IOCTL80211_TRACE_H_INCLUDED
+#define IOCTL80211_TRACE_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct iwreq;
+struct ifreq;
+
+#define IOCTL80211_TRACE_MAGIC              0x52543849  /* "I8TR" */
+#define IOCTL80211_TRACE_VERSION            1
+
+/* Environment variable naming a trace to serve requests from */
+#define IOCTL80211_TRACE_REPLAY_ENV         "IOCTL80211_TRACE_REPLAY"
+
+typedef enum
+{
+    IOCTL80211_TRACE_IOCTL = 1,             /* wireless extensions */
+    IOCTL80211_TRACE_NL,                    /* nl80211 vendor command or
+                                               rtnetlink dump */
+    IOCTL80211_TRACE_CB,                    /* reply passed to the callback of
+                                               the request recorded before */
+    IOCTL80211_TRACE_EVENT                  /* unsolicited driver event */
+} ioctl80211_trace_kind_t;
+
+/* Trace file layout, host byte order:
+ *
+ *   ioctl80211_trace_file_t
+ *   ioctl80211_trace_rec_t, inline request, inline response,
+ *                           request buffer, response buffer
+ *   ...
+ *
+ * Each record is padded to 8 bytes. Trailing zeros of both buffers are
+ * not stored, buf_len keeps the size of the caller buffer. Callback and
+ * event payloads are kept whole in the response buffer.
+ */
+typedef struct
+{
+    uint32_t                        magic;
+    uint16_t                        version;
+    uint16_t                        rec_size;
+} ioctl80211_trace_file_t;
+
+typedef struct
+{
+    uint64_t                        timestamp_us;   /* CLOCK_MONOTONIC */
+    uint32_t                        rec_len;        /* incl. padding */
+    uint32_t                        duration_us;
+    uint32_t                        cmd;
+    int32_t                         rc;
+    int32_t                         err;            /* errno if rc < 0 */
+    uint16_t                        kind;
+    uint16_t                        inl_len;
+    uint32_t                        buf_len;
+    uint32_t                        req_len;
+    uint32_t                        resp_len;
+    char                            ifname[16];
+} ioctl80211_trace_rec_t;
+
+typedef int ioctl80211_trace_call_t(void *ctx);
+typedef void ioctl80211_trace_cb_t(void *ctx, void *data, size_t len);
+typedef void ioctl80211_trace_event_cb_t(const char *ifname, uint32_t cmd,
+                                         void *data, size_t len);
+
+/* Runs call() and records it, or serves it from the replayed trace.
+ *
+ * inl is a small fixed size argument exchanged by value, buf a caller
+ * buffer the driver may read and fill. Both are updated with the
+ * response. Returns result of call(), errno is preserved.
+ */
+int ioctl80211_trace_call(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        void                           *inl,
+        size_t                          inl_len,
+        void                           *buf,
+        size_t                          buf_len,
+        ioctl80211_trace_call_t        *call,
+        void                           *ctx);
+
+/* Same as ioctl80211_trace_call() for requests answered through a
+ * callback. call() reports each reply with ioctl80211_trace_cb_record(),
+ * replay hands the recorded ones to cb().
+ */
+int ioctl80211_trace_call_cb(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        void                           *inl,
+        size_t                          inl_len,
+        void                           *buf,
+        size_t                          buf_len,
+        ioctl80211_trace_call_t        *call,
+        ioctl80211_trace_cb_t          *cb,
+        void                           *ctx);
+
+void ioctl80211_trace_cb_record(
+        const void                     *data,
+        size_t                          len);
+
+/* Records an event as it is received. On replay, events recorded before
+ * a request are passed to handler before the request is answered.
+ */
+void ioctl80211_trace_event(
+        const char                     *ifname,
+        uint32_t                        cmd,
+        const void                     *data,
+        size_t                          len);
+
+void ioctl80211_trace_event_handler_set(
+        ioctl80211_trace_event_cb_t    *handler);
+
+/* Traced ioctl() of an already named wireless extensions request */
+int ioctl80211_trace_request_send(
+        int                             sock_fd,
+        int                             command,
+        struct iwreq                   *request);
+
+/* Same for requests of any command whose u.data.pointer refers to a len
+ * bytes buffer, e.g. private ioctls. Zero len means u is used inline.
+ */
+int ioctl80211_trace_iw_point_send(
+        int                             sock_fd,
+        int                             command,
+        struct iwreq                   *request,
+        size_t                          len);
+
+/* Traced ioctl() of a named ifreq whose ifr_data is a len bytes buffer */
+int ioctl80211_trace_ifreq_send(
+        int                             sock_fd,
+        int                             command,
+        struct ifreq                   *request,
+        size_t                          len);
+
+void ioctl80211_trace_close(void);
+
+#endif /* IOCTL80211_TRACE_H_INCLUDED */
@@ -64,6 +64,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ieee80211_external.h"
 #include "ioctl80211_client.h"
+#include "ioctl80211_trace.h"
 #include "memutil.h"
 
 #ifndef _LITTLE_ENDIAN
@@ -112,8 +113,13 @@ struct ioctl80211_vap_stats
 #define MAC_STRING_LENGTH 17
 
 #define streq(a,b) ((strlen(a) == strlen(b)) && (strncasecmp(a,b,sizeof(b)-1) == 0))
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+#define send_nl_command(sk_ctx, ifname, buf, len, cb, cmd) \
+            osync_nl80211_trace_send(sk_ctx, ifname, buf, len, cb, cmd);
+#else
 #define send_nl_command(sk_ctx, ifname, buf, len, cb, cmd) \
             send_command(sk_ctx, ifname, buf, len, cb, cmd, 0);
+#endif
 
 #if defined(CONFIG_PLATFORM_QCA_QSDK110) && !defined(CONFIG_PLATFORM_QCA_QSDK120)
 #define send_setparam_command(sock_ctx, subcmd, cmd, ifname, buf, len) \
@@ -152,7 +158,73 @@ void destroy_socket_context (struct socket_context *sock_ctx);
 enum config_mode_type get_config_mode_type();
 int send_command (struct socket_context *sock_ctx, const char *ifname, void *buf,
         size_t buflen, void (*callback) (struct cfg80211_data *arg), int cmd, int ioctl_cmd);
+
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+struct osync_nl80211_trace_cmd
+{
+    struct socket_context  *sock_ctx;
+    const char             *ifname;
+    void                   *buf;
+    size_t                  len;
+    void                  (*cb)(struct cfg80211_data *arg);
+    int                     cmd;
+};
+
+/* Command in flight, callbacks come back before send_command() returns */
+static struct osync_nl80211_trace_cmd *osync_nl80211_trace_cur;
+
+static inline void osync_nl80211_trace_cb(struct cfg80211_data *arg)
+{
+    ioctl80211_trace_cb_record(arg->data, arg->length);
+    osync_nl80211_trace_cur->cb(arg);
+}
+
+static inline void osync_nl80211_trace_cb_replay(void *ctx, void *data, size_t len)
+{
+    struct osync_nl80211_trace_cmd *c = ctx;
+    struct cfg80211_data arg;
+
+    memset(&arg, 0, sizeof(arg));
+    arg.data = data;
+    arg.length = len;
+    c->cb(&arg);
+}
+
+static inline int osync_nl80211_trace_cmd_send(void *ctx)
+{
+    struct osync_nl80211_trace_cmd *c = ctx;
+    int rc;
+
+    if (c->cb == NULL)
+        return send_command(c->sock_ctx, c->ifname, c->buf, c->len, NULL, c->cmd, 0);
+
+    osync_nl80211_trace_cur = c;
+    rc = send_command(c->sock_ctx, c->ifname, c->buf, c->len, osync_nl80211_trace_cb, c->cmd, 0);
+    osync_nl80211_trace_cur = NULL;
+
+    return rc;
+}
+
+/* Vendor command buffers are in/out, the trace keeps both directions
+ * along with what was passed to the callback.
+ */
+static inline int osync_nl80211_trace_send(struct socket_context *sock_ctx,
+        const char *ifname, void *buf, size_t len,
+        void (*cb)(struct cfg80211_data *arg), int cmd)
+{
+    struct osync_nl80211_trace_cmd c = { sock_ctx, ifname, buf, len, cb, cmd };
+
+    return ioctl80211_trace_call_cb(IOCTL80211_TRACE_NL, ifname, cmd,
+                                    NULL, 0, buf, len,
+                                    osync_nl80211_trace_cmd_send,
+                                    cb ? osync_nl80211_trace_cb_replay : NULL, &c);
+}
+#endif
 void osync_peer_stats_event_callback(char *ifname, uint32_t cmdid, uint8_t *data, size_t len);
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+void osync_peer_stats_event_replay(const char *ifname, uint32_t cmdid, void *data, size_t len);
+#endif
+void osync_peer_stats_event_drain(struct nl_sock *sock);
 int forkexec(const char *file, const char **argv, void (*xfrm)(char *), char *buf, int len);
 
 #if defined (OSYNC_IOCTL_LIB) && (OSYNC_IOCTL_LIB == 0)
@@ -659,10 +731,7 @@ static void
 nl_io_read_cb(EV_P_ ev_io *io, int events)
 {
     LOGT("nl_io_read_cb io->fd = %d", io->fd);
-    if (nl_recvmsgs_default(sock_ctx.cfg80211_ctxt.event_sock) < 0) {
-        LOGE("Failed to receive nl message, errno = %d (%s)",
-             errno, strerror(errno));
-    }
+    osync_peer_stats_event_drain(sock_ctx.cfg80211_ctxt.event_sock);
 }
 #endif
 
@@ -675,6 +744,9 @@ osync_nl80211_init(struct ev_loop *loop, bool init_callback)
 
     if (init_callback) {
         sock_ctx.cfg80211_ctxt.event_callback = osync_peer_stats_event_callback;
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+        ioctl80211_trace_event_handler_set(osync_peer_stats_event_replay);
+#endif
     }
 
     if (WARN_ON(init_socket_context(&sock_ctx, WIFI_NL80211_CMD_SOCK_ID, WIFI_NL80211_EVENT_SOCK_ID))) {
@@ -787,7 +859,7 @@ osync_nl80211_interfaces_get(int	sock_fd,
     ioctl80211_interfaces_t        *interfaces =
         (ioctl80211_interfaces_t *) args[IOCTL80211_IFNAME_ARG];
 
-    interface = &interfaces->phy[interfaces->qty];
+    interface = ioctl80211_interfaces_alloc(interfaces);
     STRSCPY(interface->ifname, ifname);
     memset (&request, 0, sizeof(request));
 
@@ -960,7 +1032,9 @@ osync_nl80211_interfaces_get(int	sock_fd,
         return IOCTL_STATUS_ERROR;
     }
 
-    if ((radio_type_t)radio_type != interface->radio_type)
+    if (    ((radio_type_t)radio_type != RADIO_TYPE_NONE)
+         && ((radio_type_t)radio_type != interface->radio_type)
+       )
     {
         LOG(TRACE,
             "Skip processing %s radio interface %s",
@@ -971,7 +1045,7 @@ osync_nl80211_interfaces_get(int	sock_fd,
 
     LOG(TRACE,
         "Parsed %s radio %s interface %s MAC='"MAC_ADDRESS_FORMAT"' SSID='%s'",
-        radio_get_name_from_type(radio_type),
+        radio_get_name_from_type(interface->radio_type),
         interface->sta ? "STA" : "AP",
         interface->ifname,
         MAC_ADDRESS_PRINT(interface->mac),
@@ -1579,18 +1653,7 @@ extern struct socket_context sock_ctx;
 #ifdef OPENSYNC_NL_SUPPORT
 static void  bss_info_handler(struct cfg80211_data *buffer)
 {
-    if ((res_len + buffer->length) >= g_iw_scan_results_capacity)
-    {
-        LOG(ERR,
-                "No space left in scan results buffer to store the scan data (%u bytes of scan data, %zu bytes left in buffer)",
-                buffer->length,
-                g_iw_scan_results_capacity - res_len);
-        return;
-    }
-
-    memcpy(g_iw_scan_results + res_len, buffer->data,buffer->length);
-    res_len += buffer->length;
-    g_iw_scan_results_size += buffer->length;
+    ioctl80211_scan_arena_feed(g_scan_arena, buffer->data, buffer->length);
 }
 #endif
 static inline int
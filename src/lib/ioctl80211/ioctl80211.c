@@ -48,6 +48,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ioctl80211.h"
 #include "ioctl80211_scan.h"
+#include "ioctl80211_pool.h"
+#include "ioctl80211_linkstats.h"
+#include "ioctl80211_trace.h"
 
 #ifndef PROC_NET_WIRELESS
 #define PROC_NET_WIRELESS       "/proc/net/wireless"
@@ -106,11 +109,17 @@ ioctl_status_t ioctl80211_init(struct ev_loop *loop, bool init_callback)
         return IOCTL_STATUS_ERROR;
     }
 
-    return IOCTL_STATUS_OK;
+    return ioctl80211_inventory_init(loop);
 }
 
 ioctl_status_t ioctl80211_close(struct ev_loop *loop)
 {
+    ioctl80211_inventory_close(loop);
+    ioctl80211_linkstats_cleanup();
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    ioctl80211_trace_close();
+#endif
+    ioctl80211_pool_report();
     close(g_ioctl80211_sock_fd);
 
     return IOCTL_STATUS_OK;
@@ -135,7 +144,11 @@ int ioctl80211_request_send(
 
     STRSCPY(request->ifr_name, ifname);
 
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    return ioctl80211_trace_request_send(sock_fd, command, request);
+#else
     return (ioctl(sock_fd, command, request));
+#endif
 };
 
 
@@ -281,6 +294,63 @@ static ioctl_status_t ioctl80211_radio_type_get(
     return IOCTL_STATUS_OK;
 }
 
+static bool ioctl80211_sysfs_read(
+        const char                 *ifname,
+        const char                 *attr,
+        char                       *dest,
+        int                         dest_len)
+{
+    char                            path[64];
+    FILE                           *f;
+    bool                            ok;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/%s", ifname, attr);
+    if (!(f = fopen(path, "r")))
+        return false;
+
+    ok = fgets(dest, dest_len, f) != NULL;
+    fclose(f);
+
+    if (ok)
+        dest[strcspn(dest, "\r\n ")] = '\0';
+
+    return ok && strlen(dest) > 0;
+}
+
+/* ifindex and parent radio only change when the netdev is recreated,
+ * which invalidates the inventory, so they are read once per rebuild */
+static void ioctl80211_interface_sysfs_get(
+        ioctl80211_interface_t     *interface)
+{
+    char                            buf[32];
+
+    interface->ifindex = 0;
+    if (ioctl80211_sysfs_read(interface->ifname, "ifindex", buf, sizeof(buf)))
+        interface->ifindex = atoi(buf);
+
+    /* vaps report their radio, radios have no parent */
+    if (!ioctl80211_sysfs_read(interface->ifname, "parent",
+                               interface->phy, sizeof(interface->phy)))
+        STRSCPY(interface->phy, interface->ifname);
+}
+
+void ioctl80211_interface_phy_get(
+        const char                 *ifname,
+        char                       *phy,
+        int                         len)
+{
+    const ioctl80211_interface_t   *interface;
+
+    if ((interface = ioctl80211_inventory_find(ifname)))
+    {
+        strscpy(phy, interface->phy, len);
+        return;
+    }
+
+    if (!ioctl80211_sysfs_read(ifname, "parent", phy, len))
+        strscpy(phy, ifname, len);
+}
+
 ioctl_status_t ioctl80211_interfaces_get(
         int                         sock_fd,
         char                       *ifname,
@@ -294,7 +364,7 @@ ioctl_status_t ioctl80211_interfaces_get(
     ioctl80211_interfaces_t        *interfaces = 
         (ioctl80211_interfaces_t *) args[IOCTL80211_IFNAME_ARG];
 
-    interface = &interfaces->phy[interfaces->qty];
+    interface = ioctl80211_interfaces_alloc(interfaces);
 
     STRSCPY(interface->ifname, ifname);
 
@@ -424,7 +494,9 @@ ioctl_status_t ioctl80211_interfaces_get(
         return IOCTL_STATUS_ERROR;
     }
 
-    if ((radio_type_t)radio_type != interface->radio_type)
+    if (    ((radio_type_t)radio_type != RADIO_TYPE_NONE)
+         && ((radio_type_t)radio_type != interface->radio_type)
+       )
     {
         LOG(TRACE,
             "Skip processing %s radio interface %s",
@@ -433,11 +505,15 @@ ioctl_status_t ioctl80211_interfaces_get(
         return IOCTL_STATUS_OK;
     }
 
+    ioctl80211_interface_sysfs_get(interface);
+
     LOG(TRACE,
-        "Parsed %s radio %s interface %s MAC='"MAC_ADDRESS_FORMAT"' SSID='%s'",
-        radio_get_name_from_type(radio_type),
+        "Parsed %s radio %s interface %s (%d) on %s MAC='"MAC_ADDRESS_FORMAT"' SSID='%s'",
+        radio_get_name_from_type(interface->radio_type),
         interface->sta ? "STA" : "AP",
         interface->ifname,
+        interface->ifindex,
+        interface->phy,
         MAC_ADDRESS_PRINT(interface->mac),
         interface->essid);
 
@@ -48,6 +48,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ioctl80211.h"
 #include "ioctl80211_scan.h"
+#include "ioctl80211_pool.h"
+#include "ioctl80211_linkstats.h"
+#include "ioctl80211_trace.h"
 
 #ifndef PROC_NET_WIRELESS
 #define PROC_NET_WIRELESS       "/proc/net/wireless"
@@ -109,12 +112,24 @@ static ioctl_status_t ioctl80211_get_ifname(
 
 ioctl_status_t ioctl80211_init(struct ev_loop *loop, bool init_callback)
 {
-	return osync_nl80211_init(loop, init_callback);
+    ioctl_status_t status;
+
+    status = osync_nl80211_init(loop, init_callback);
+    if (status != IOCTL_STATUS_OK)
+        return status;
+
+    return ioctl80211_inventory_init(loop);
 }
 
 ioctl_status_t ioctl80211_close(struct ev_loop *loop)
 {
-	return osync_nl80211_close(loop);
+    ioctl80211_inventory_close(loop);
+    ioctl80211_linkstats_cleanup();
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    ioctl80211_trace_close();
+#endif
+    ioctl80211_pool_report();
+    return osync_nl80211_close(loop);
 }
 
 int ioctl80211_fd_get()
@@ -136,7 +151,11 @@ int ioctl80211_request_send(
 
     STRSCPY(request->ifr_name, ifname);
 
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    return ioctl80211_trace_request_send(sock_fd, command, request);
+#else
     return (ioctl(sock_fd, command, request));
+#endif
 };
 
 
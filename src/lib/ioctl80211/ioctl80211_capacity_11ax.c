@@ -49,6 +49,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ioctl80211.h"
 #include "ioctl80211_capacity.h"
+#include "ioctl80211_linkstats.h"
 #include "ioctl80211_survey.h"
 
 #define MODULE_ID LOG_MODULE_ID_IOCTL
@@ -77,29 +78,15 @@ static radio_queue_type_t ioctl80211_queue_entry_index_get[PS_MAX_Q_UTIL] = {
  *  PROTECTED definitions
  *****************************************************************************/
 
-struct vap_user_stats
-{
-    struct ieee80211_stats          vap_stats;
-    struct ieee80211_mac_stats      vap_unicast_stats;
-    struct ieee80211_mac_stats      vap_multicast_stats;
-};
-
 static
 ioctl_status_t ioctl80211_capacity_radio_stats_get(
         radio_entry_t              *radio_cfg,
         ioctl80211_capacity_data_t *capacity_result)
 {
-    int32_t                         rc;
-
-    char                           *args[IOCTL80211_IFNAME_ARG_QTY];
     ioctl80211_interface_t         *interface = NULL;
     ioctl80211_interfaces_t         interfaces;
     uint32_t                        interface_index;
-
-    struct ifreq                    if_req;
-    struct vap_user_stats           vap_stats;
-    struct ieee80211_mac_stats     *vap_stats_ucast;
-    struct ieee80211_mac_stats     *vap_stats_mcast;
+    uint64_t                        tx_bytes;
 
     if (NULL == capacity_result)
     {
@@ -107,69 +94,29 @@ ioctl_status_t ioctl80211_capacity_radio_stats_get(
     }
 
     memset (&interfaces, 0, sizeof(interfaces));
-    args[IOCTL80211_IFNAME_ARG] = (char *) &interfaces;
-
-    ioctl80211_interfaces_find(
-            ioctl80211_fd_get(),
-            &ioctl80211_interfaces_get,
-            args,
-            radio_cfg->type);
+    ioctl80211_interfaces_lookup(radio_cfg->type, &interfaces);
 
     for (interface_index = 0; interface_index < interfaces.qty; interface_index++)
     {
         interface = &interfaces.phy[interface_index];
 
         /* On one radio there could be multiple wireless interfaces - VAP's.
-           The VAP stats seems to hold the values that we are interested in
-           therefore sum all active VAP interfaces and get RADIO stats
-
-           /proc/net/dev are network stats - essid stats?
-         */
-        memset (&vap_stats, 0, sizeof(vap_stats));
-
-#ifdef OPENSYNC_NL_SUPPORT
-	rc = osync_nl80211_peer_stats_fetch(radio_cfg->if_name,&vap_stats);
-#else
-        memset (&if_req, 0, sizeof(if_req));
-        STRSCPY(if_req.ifr_name, interface->ifname);
-        if_req.ifr_data = (caddr_t) &vap_stats;
-
-        /* Initiate Atheros stats fetch */
-        rc =
-            ioctl(
-                    ioctl80211_fd_get(),
-                    SIOCG80211STATS,
-                    &if_req);
-#endif
-        if (0 > rc)
+           Sum netdev tx bytes of all of them, the counters of every VAP
+           of every radio come from one shared link dump */
+        if (!ioctl80211_linkstats_tx_bytes_get(
+                    interface->ifname,
+                    IOCTL80211_LINKSTATS_MAX_AGE,
+                    &tx_bytes))
         {
             LOG(ERR,
-                "Processing %s capacity for "
-                " (Failed to get stats '%s')",
+                "Processing %s capacity for %s (link dump failed)",
                 radio_get_name_from_type(radio_cfg->type),
-                strerror(errno));
+                interface->ifname);
+            ioctl80211_interfaces_free(&interfaces);
             return IOCTL_STATUS_ERROR;
         }
 
-        /* ieee80211_stats  has even number of 32 elements
-           and since ieee80211_mac_stats has 64 bit elements
-           the compiler shifts the ucast for */
-        vap_stats_ucast = (struct ieee80211_mac_stats*)
-#if 0
-            (((unsigned char *)&vap_stats.vap_unicast_stats));
-#else
-            (((unsigned char *)&vap_stats.vap_unicast_stats) - sizeof(uint32_t));
-#endif
-        vap_stats_mcast = (struct ieee80211_mac_stats*)
-#if 0
-            (((unsigned char *)&vap_stats.vap_multicast_stats));
-#else
-            (((unsigned char *)&vap_stats.vap_multicast_stats) - sizeof(uint32_t));
-#endif
-
-
-        capacity_result->bytes_tx +=
-            vap_stats_ucast->ims_tx_data_bytes + vap_stats_mcast->ims_tx_data_bytes;
+        capacity_result->bytes_tx += tx_bytes;
     }
 
     LOG(TRACE,
@@ -177,6 +124,7 @@ ioctl_status_t ioctl80211_capacity_radio_stats_get(
         radio_get_name_from_type(radio_cfg->type),
         capacity_result->bytes_tx);
 
+    ioctl80211_interfaces_free(&interfaces);
     return IOCTL_STATUS_OK;
 }
 
@@ -185,24 +133,20 @@ ioctl_status_t ioctl80211_capacity_survey_stats_get(
         radio_entry_t              *radio_cfg,
         ioctl80211_capacity_data_t *capacity_result)
 {
-    ioctl_status_t                  status;
-    ioctl80211_survey_data_t        results;
+    const struct ps_uapi_ioctl     *data;
 
-    /* Set buffer and callback function to be called after results are ready */
-    memset(&results, 0, sizeof (results));
-    status =
-        ioctl80211_survey_results_get(
+    /* Shares the on-channel survey snapshot with the survey sampling */
+    data =
+        ioctl80211_survey_snapshot_data_get(
                 radio_cfg,
-                &radio_cfg->chan,
-                1,
                 RADIO_SCAN_TYPE_ONCHAN,
-                &results);
-    if (IOCTL_STATUS_OK != status) {
+                IOCTL80211_SURVEY_SNAPSHOT_MAX_AGE);
+    if (NULL == data) {
         return IOCTL_STATUS_ERROR;
     }
 
-    capacity_result->chan_active = results.data.u.survey_bss.get.total;
-    capacity_result->chan_tx = results.data.u.survey_bss.get.tx;
+    capacity_result->chan_active = data->u.survey_bss.get.total;
+    capacity_result->chan_tx = data->u.survey_bss.get.tx;
 
     LOG(TRACE,
         "Parsed %s capacity stats survey active %"PRIu64" tx %"PRIu64"",
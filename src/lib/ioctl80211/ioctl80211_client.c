@@ -52,6 +52,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ioctl80211.h"
 #include "ioctl80211_client.h"
+#include "ioctl80211_phyrate.h"
+#include "ioctl80211_client_delta.h"
+#include "ioctl80211_trace.h"
 
 #define MODULE_ID LOG_MODULE_ID_IOCTL
 
@@ -63,6 +66,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IEEE80211_NODE_ERP              0x00000004          /* ERP enabled */
 #define IEEE80211_NODE_HT               0x00000008          /* HT enabled */
 
+#ifndef CONFIG_QCA_STATS_POOL_CLIENTS
+#define CONFIG_QCA_STATS_POOL_CLIENTS 16
+#endif
+
+/* Client records are sampled in pairs (old/new), grow in small steps */
+ioctl80211_pool_t                   g_ioctl80211_client_pool =
+    IOCTL80211_POOL_INIT("client",
+                         ioctl80211_client_record_t,
+                         CONFIG_QCA_STATS_POOL_CLIENTS,
+                         8);
+
 typedef struct
 {
     struct ieee80211req_sta_info        sta_info;
@@ -93,55 +107,31 @@ static inline uint64_t weight_avg_get(const struct weight_avg *avg)
     return avg->cnt > 0 ? avg->sum / avg->cnt : 0;
 }
 
-static uint32_t mcs_to_mbps(const int mcs, const int bw,
-                            const int nss, const enum guard_int gi)
+static uint32_t mcs_to_mbps(const ioctl80211_phy_t phy, const int mcs,
+                            const int bw, const int nss,
+                            const enum guard_int gi)
 {
-    /* The following table is precomputed from:
-     *
-     * bpsk -> 1bit
-     * qpsk -> 2bit
-     * 16-qam -> 4bit
-     * 64-qam -> 6bit
-     * 256-qam -> 8bit
-     *
-     * 20mhz -> 52 tones
-     * 40mhz -> 108 tones
-     * 80mhz -> 234 tones
-     * 160mhz -> 486 tones
-     *
-     * Once divided by 4 will get an long GI phyrate in mbps.
-     */
-    static const unsigned short bps[10][4] = {
-        /* 20mhz 40mhz 80mhz  160mhz */
-        {  26,   54,   117,   234   }, /* BPSK 1/2 */
-        {  52,   108,  234,   468   }, /* QPSK 1/2 */
-        {  78,   162,  351,   702   }, /* QPSK 3/4 */
-        {  104,  216,  468,   936   }, /* 16-QAM 1/2 */
-        {  156,  324,  702,   1404  }, /* 16-QAM 3/4 */
-        {  208,  432,  936,   1248  }, /* 16-QAM 2/3 */
-        {  234,  486,  1053,  2106  }, /* 64-QAM 3/4 */
-        {  260,  540,  1170,  2340  }, /* 64-QAM 5/6 */
-        {  312,  648,  1404,  2808  }, /* 256-QAM 3/4 */
-        {  346,  720,  1560,  3120  }, /* 256-QAM 5/6 */
-    };
     static const unsigned short legacy[] = {
         6, 9, 12, 18, 24, 36, 48, 54, /* OFDM */
         1, 2, 5, 11, 2, 5, 11, /* CCK */
     };
-    const int i = mcs < 10 ? mcs : 9;
-    const int j = bw < 4 ? bw : 3;
 
     if (nss == 0) {
         return mcs < (int)ARRAY_SIZE(legacy) ? legacy[mcs] : legacy[0];
     }
-    else {
-        if (gi == SHORT_GUARD_INT) /* SGI gives about 11% tput gain*/
-            return (bps[i][j] * nss * 25) / 90; /* (bsp * nss / 4) * 111 / 100 */
-        else
-            return (bps[i][j] * nss) / 4;
-    }
+
+    return ioctl80211_phyrate_kbps(phy, bw, nss, mcs,
+                                   gi == SHORT_GUARD_INT
+                                   ? IOCTL80211_GI_400
+                                   : IOCTL80211_GI_800) / 1000;
 }
 
+/* Histogram delta scratch, reused by every peer sample. Kept off the
+ * stack, together they are about 8 KB.
+ */
+static ioctl80211_client_rx_delta_t g_ioctl80211_client_rx_delta;
+static ioctl80211_client_tx_delta_t g_ioctl80211_client_tx_delta;
+
 static
 ioctl_status_t ioctl80211_client_stats_rx_calculate(
         radio_entry_t              *radio_cfg,
@@ -149,19 +139,20 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
         ioctl80211_client_record_t *data_old,
         dpp_client_record_t        *client_record)
 {
-    struct ps_uapi_ioctl           *new_stats_rx = NULL;
-    struct ps_uapi_ioctl           *old_stats_rx = NULL;
+    struct ps_uapi_ioctl           *new_stats_rx = &data_new->stats_rx;
+    struct ps_uapi_ioctl           *old_stats_rx = &data_old->stats_rx;
     dpp_client_stats_rx_t          *client_stats_rx = NULL;
+    ioctl80211_client_rx_delta_t   *delta = &g_ioctl80211_client_rx_delta;
     struct weight_avg               avgmbps = { .sum = 0, .cnt = 0 };
 
+    ioctl80211_phy_t                phy;
     uint32_t                        mcs;
     uint32_t                        nss;
     uint32_t                        bw;
 
     uint32_t                        stats_index = 0;
+    uint32_t                        i;
 
-    uint32_t                        num_ppdus_delta;
-    uint32_t                        num_sgi_delta;
     uint32_t                        num_mpdus = 0;
     uint32_t                        num_retries = 0;
 
@@ -199,75 +190,32 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
        |      |            |            |  8 - VHT
        |      |            |            |  9 - VHT
        ----------------------------------------------
-       NOTE: The size of this table on 4x4 can be big - we could send only non zero elements!
+       NOTE: Only buckets that changed since the previous sample are reported
      */
-    for (stats_index = 0; stats_index < PS_MAX_ALL; stats_index++)
-    {
-        new_stats_rx = &data_new->stats_rx;
-        old_stats_rx = &data_old->stats_rx;
-
-        /* Skip unchanged entries*/
-        if (    !(STATS_DELTA(
-                        new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes,
-                        old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes))
-                && !(STATS_DELTA(
-                        new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus,
-                        old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus))
-                && !(STATS_DELTA(
-                        new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus,
-                        old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus))
-                && !(STATS_DELTA(
-                        new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus,
-                        old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus))
-                && !(STATS_DELTA(
-                        new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries,
-                        old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries))
-           ) {
-            continue;
-        }
+    ioctl80211_client_rx_delta_calc(new_stats_rx, old_stats_rx, delta);
 
-        num_mpdus +=
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus);
+    for (i = 0; i < delta->active_qty; i++)
+    {
+        stats_index = delta->active[i];
 
-        num_retries +=
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries);
+        num_mpdus += delta->mpdus[stats_index];
+        num_retries += delta->retries[stats_index];
 
-        if (stats_index < PS_MAX_LEGACY) {
-            mcs = stats_index;
-            nss = 0;
-            bw  = 0;
-        }
-        else {
-            bw  = ((stats_index - PS_MAX_LEGACY) / (PS_MAX_MCS * PS_MAX_NSS));
-            nss = (((stats_index - PS_MAX_LEGACY) / PS_MAX_MCS) % PS_MAX_NSS) + 1;
-            mcs = (stats_index - PS_MAX_LEGACY) % PS_MAX_MCS;
-        }
+        ioctl80211_client_bucket_decode(stats_index, &phy, &mcs, &nss, &bw);
 
         if (kconfig_enabled(CONFIG_QCA_RATE_HISTO_TO_EXPECTED_TPUT)) {
-            num_ppdus_delta = STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus);
-
-            num_sgi_delta = STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_sgi,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_sgi);
-
-            if (num_sgi_delta > 0) {
+            if (delta->sgi[stats_index] > 0) {
                 weight_avg_add(
                     &avgmbps,
-                    mcs_to_mbps(mcs, bw, nss, SHORT_GUARD_INT),
-                    num_sgi_delta);
+                    mcs_to_mbps(phy, mcs, bw, nss, SHORT_GUARD_INT),
+                    delta->sgi[stats_index]);
             }
 
-            if (num_sgi_delta < num_ppdus_delta) {
+            if (delta->sgi[stats_index] < delta->ppdus[stats_index]) {
                 weight_avg_add(
                     &avgmbps,
-                    mcs_to_mbps(mcs, bw, nss, LONG_GUARD_INT),
-                    (num_ppdus_delta - num_sgi_delta));
+                    mcs_to_mbps(phy, mcs, bw, nss, LONG_GUARD_INT),
+                    (delta->ppdus[stats_index] - delta->sgi[stats_index]));
             }
 
             continue;
@@ -283,94 +231,14 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
             return IOCTL_STATUS_ERROR;
         }
 
-        client_stats_rx->mcs = mcs;
-        client_stats_rx->nss = nss;
-        client_stats_rx->bw  = bw;
-
-        client_stats_rx->bytes =
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes);
-        LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] bytes=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->bytes,
-            STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes),
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_bytes);
-
-        client_stats_rx->msdu =
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus);
-        LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] msdu=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->msdu,
-            STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus),
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_msdus);
-
-        client_stats_rx->mpdu =
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus);
-        LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] mpdu=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->mpdu,
-            STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus),
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_mpdus);
-
-        client_stats_rx->ppdu =
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus);
-        LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] ppdu=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->ppdu,
-            STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus),
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_ppdus);
-
-        client_stats_rx->retries =
-            STATS_DELTA(
-                    new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries,
-                    old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries);
-        LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] retries=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->retries,
-            STATS_DELTA(
-                new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries,
-                old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries),
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].num_retries);
+        client_stats_rx->mcs     = mcs;
+        client_stats_rx->nss     = nss;
+        client_stats_rx->bw      = bw;
+        client_stats_rx->bytes   = delta->bytes[stats_index];
+        client_stats_rx->msdu    = delta->msdus[stats_index];
+        client_stats_rx->mpdu    = delta->mpdus[stats_index];
+        client_stats_rx->ppdu    = delta->ppdus[stats_index];
+        client_stats_rx->retries = delta->retries[stats_index];
 
         /* We are not collecting them currently */
         client_stats_rx->errors = 0;
@@ -387,14 +255,18 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
         }
 
         LOG(TRACE,
-            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT
-            " index=%d [%d, %d, %d] rssi=%d (new=%u-old=%u)",
+            "Calculated %s client delta stats_rx for "MAC_ADDRESS_FORMAT" "
+            "index=%d [%d, %d, %d] bytes=%"PRIu64" msdu=%"PRIu64" mpdu=%"PRIu64" "
+            "ppdu=%"PRIu64" retries=%"PRIu64" rssi=%d",
             radio_get_name_from_type(radio_type),
             MAC_ADDRESS_PRINT(data_new->info.mac),
             stats_index, client_stats_rx->bw, client_stats_rx->nss, client_stats_rx->mcs,
-            client_stats_rx->rssi,
-            new_stats_rx->u.peer_rx_stats.get.stats[stats_index].ave_rssi,
-            old_stats_rx->u.peer_rx_stats.get.stats[stats_index].ave_rssi);
+            client_stats_rx->bytes,
+            client_stats_rx->msdu,
+            client_stats_rx->mpdu,
+            client_stats_rx->ppdu,
+            client_stats_rx->retries,
+            client_stats_rx->rssi);
 
         ds_dlist_insert_tail(&client_record->stats_rx, client_stats_rx);
     }
@@ -405,7 +277,7 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
             client_record->stats.rate_rx = weight_avg_get(&avgmbps);
             LOG(TRACE,
                  "Calculated %s client delta rx phyrate "MAC_ADDRESS_FORMAT
-                 " mbps=%f mpdus=%llu",
+                 " mbps=%f mpdus=%"PRIu64"",
                  radio_get_name_from_type(radio_type),
                  MAC_ADDRESS_PRINT(data_new->info.mac),
                  client_record->stats.rate_rx,
@@ -509,16 +381,19 @@ ioctl_status_t ioctl80211_client_stats_tx_calculate(
         ioctl80211_client_record_t *data_old,
         dpp_client_record_t        *client_record)
 {
-    struct ps_uapi_ioctl           *new_stats_tx = NULL;
-    struct ps_uapi_ioctl           *old_stats_tx = NULL;
+    struct ps_uapi_ioctl           *new_stats_tx = &data_new->stats_tx;
+    struct ps_uapi_ioctl           *old_stats_tx = &data_old->stats_tx;
     dpp_client_stats_tx_t          *client_stats_tx = NULL;
+    ioctl80211_client_tx_delta_t   *delta = &g_ioctl80211_client_tx_delta;
     struct weight_avg               avgmbps = { .sum = 0, .cnt = 0 };
 
+    ioctl80211_phy_t                phy;
     uint32_t                        mcs;
     uint32_t                        nss;
     uint32_t                        bw;
 
     uint32_t                        stats_index = 0;
+    uint32_t                        i;
     uint32_t                        num_mpdus = 0;
     uint32_t                        num_retries = 0;
 
@@ -556,55 +431,24 @@ ioctl_status_t ioctl80211_client_stats_tx_calculate(
        |      |            |            |  8 - VHT
        |      |            |            |  9 - VHT
        ----------------------------------------------
-       NOTE: The size of this table on 4x4 can be big - we could send only non zero elements!
+       NOTE: Only buckets that changed since the previous sample are reported
      */
-    for (stats_index = 0; stats_index < PS_MAX_ALL; stats_index++)
-    {
-        new_stats_tx = &data_new->stats_tx;
-        old_stats_tx = &data_old->stats_tx;
+    ioctl80211_client_tx_delta_calc(new_stats_tx, old_stats_tx, delta);
 
-        /* Skip unchanged entries*/
-        if (    !(STATS_DELTA(
-                        new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts,
-                        old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts))
-                && !(STATS_DELTA(
-                        new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success,
-                        old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success))
-           )
-        {
-            continue;
-        }
+    for (i = 0; i < delta->active_qty; i++)
+    {
+        stats_index = delta->active[i];
 
-        num_mpdus +=
-            STATS_DELTA(
-                    new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success,
-                    old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success);
+        num_mpdus += delta->success[stats_index];
+        num_retries += delta->retries[stats_index];
 
-        num_retries +=
-            STATS_DELTA(
-                    (new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                     new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success),
-                    (old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                     old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success));
-
-        if (stats_index < PS_MAX_LEGACY) {
-            mcs = stats_index;
-            nss = 0;
-            bw  = 0;
-        }
-        else {
-            bw  = ((stats_index - PS_MAX_LEGACY) / (PS_MAX_MCS * PS_MAX_NSS));
-            nss = (((stats_index - PS_MAX_LEGACY) / PS_MAX_MCS) % PS_MAX_NSS) + 1;
-            mcs = (stats_index - PS_MAX_LEGACY) % PS_MAX_MCS;
-        }
+        ioctl80211_client_bucket_decode(stats_index, &phy, &mcs, &nss, &bw);
 
         if (kconfig_enabled(CONFIG_QCA_RATE_HISTO_TO_EXPECTED_TPUT)) {
             weight_avg_add(
                     &avgmbps,
-                    mcs_to_mbps(mcs, bw, nss, LONG_GUARD_INT),
-                    STATS_DELTA(
-                        new_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus,
-                        old_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus));
+                    mcs_to_mbps(phy, mcs, bw, nss, LONG_GUARD_INT),
+                    delta->ppdus[stats_index]);
 
             continue;
         }
@@ -669,64 +513,19 @@ ioctl_status_t ioctl80211_client_stats_tx_calculate(
         client_stats_tx->msdu = 0;
         client_stats_tx->errors = 0;
 
-        client_stats_tx->mpdu =
-            STATS_DELTA(
-                    new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts,
-                    old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts);
-        LOG(TRACE,
-            "Calculated %s client delta stats_tx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] mpdu=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_tx->bw, client_stats_tx->nss, client_stats_tx->mcs,
-            client_stats_tx->mpdu,
-            STATS_DELTA(
-                new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts,
-                old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts),
-            new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts,
-            old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts);
+        client_stats_tx->mpdu    = delta->attempts[stats_index];
+        client_stats_tx->ppdu    = delta->ppdus[stats_index];
+        client_stats_tx->retries = delta->retries[stats_index];
 
-        client_stats_tx->ppdu =
-            STATS_DELTA(
-                    new_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus,
-                    old_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus);
         LOG(TRACE,
             "Calculated %s client delta stats_tx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] ppdu=%"PRIu64" (delta=%u=new=%u-old=%u)",
+            "index=%d [%d, %d, %d] mpdu=%"PRIu64" ppdu=%"PRIu64" retries=%"PRIu64,
             radio_get_name_from_type(radio_type),
             MAC_ADDRESS_PRINT(data_new->info.mac),
             stats_index, client_stats_tx->bw, client_stats_tx->nss, client_stats_tx->mcs,
+            client_stats_tx->mpdu,
             client_stats_tx->ppdu,
-            STATS_DELTA(
-                new_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus,
-                old_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus),
-            new_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus,
-            old_stats_tx->u.peer_tx_stats.get.stats[stats_index].ppdus);
-
-        /* Retry is worst case estimation between each attempts and successes */
-        client_stats_tx->retries =
-            STATS_DELTA(
-                    (new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                     new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success),
-                    (old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                     old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success));
-
-        LOG(TRACE,
-            "Calculated %s client delta stats_tx for "MAC_ADDRESS_FORMAT" "
-            "index=%d [%d, %d, %d] retries=%"PRIu64" (delta=%u=new=%u-old=%u)",
-            radio_get_name_from_type(radio_type),
-            MAC_ADDRESS_PRINT(data_new->info.mac),
-            stats_index, client_stats_tx->bw, client_stats_tx->nss, client_stats_tx->mcs,
-            client_stats_tx->retries,
-            STATS_DELTA(
-                (new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                 new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success),
-                (old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-                 old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success)),
-            (new_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-             new_stats_tx->u.peer_tx_stats.get.stats[stats_index].success),
-            (old_stats_tx->u.peer_tx_stats.get.stats[stats_index].attempts -
-             old_stats_tx->u.peer_tx_stats.get.stats[stats_index].success));
+            client_stats_tx->retries);
 
         ds_dlist_insert_tail(&client_record->stats_tx, client_stats_tx);
     }
@@ -825,7 +624,7 @@ ioctl_status_t ioctl80211_client_stats_tx_calculate(
             client_record->stats.rate_tx = weight_avg_get(&avgmbps);
             LOG(TRACE,
                  "Calculated %s client delta tx phyrate "MAC_ADDRESS_FORMAT
-                 " mbps=%f ppdus=%llu",
+                 " mbps=%f ppdus=%"PRIu64"",
                  radio_get_name_from_type(radio_type),
                  MAC_ADDRESS_PRINT(data_new->info.mac),
                  client_record->stats.rate_tx,
@@ -1522,11 +1321,20 @@ ioctl_status_t ioctl80211_peer_stats_fetch(
     if_req.ifr_data = (caddr_t) &vap_stats;
 
     /* Initiate Atheros stats fetch */
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    rc =
+        ioctl80211_trace_ifreq_send(
+                ioctl80211_fd_get(),
+                SIOCG80211STATS,
+                &if_req,
+                sizeof(vap_stats));
+#else
     rc =
         ioctl(
                 ioctl80211_fd_get(),
                 SIOCG80211STATS,
                 &if_req);
+#endif
     if (0 > rc)
     {
         LOG(ERR,
@@ -1760,7 +1568,6 @@ ioctl_status_t ioctl80211_clients_list_get(
         ds_dlist_t                 *client_list)
 {
     ioctl_status_t                  status;
-    char                           *args[IOCTL80211_IFNAME_ARG_QTY];
     ioctl80211_interface_t         *interface = NULL;
     ioctl80211_interfaces_t         interfaces;
     uint32_t                        interface_index;
@@ -1771,13 +1578,7 @@ ioctl_status_t ioctl80211_clients_list_get(
     }
 
     memset (&interfaces, 0, sizeof(interfaces));
-    args[IOCTL80211_IFNAME_ARG] = (char *) &interfaces;
-
-    ioctl80211_interfaces_find(
-            ioctl80211_fd_get(),
-            &ioctl80211_interfaces_get,
-            args,
-            radio_cfg->type);
+    ioctl80211_interfaces_lookup(radio_cfg->type, &interfaces);
 
     for (interface_index = 0; interface_index < interfaces.qty; interface_index++)
     {
@@ -1818,7 +1619,8 @@ ioctl_status_t ioctl80211_clients_list_get(
                     "Parsing %s interface %s peer stats",
                     radio_get_name_from_type(radio_cfg->type),
                     interface->ifname);
-                return IOCTL_STATUS_ERROR;
+                status = IOCTL_STATUS_ERROR;
+                goto exit;
             }
         }
         else
@@ -1840,12 +1642,17 @@ ioctl_status_t ioctl80211_clients_list_get(
                     "Parsing %s interface %s client list",
                     radio_get_name_from_type(radio_cfg->type),
                     interface->ifname);
-                return IOCTL_STATUS_ERROR;
+                status = IOCTL_STATUS_ERROR;
+                goto exit;
             }
         }
     }
 
-    return IOCTL_STATUS_OK;
+    status = IOCTL_STATUS_OK;
+
+exit:
+    ioctl80211_interfaces_free(&interfaces);
+    return status;
 }
 
 
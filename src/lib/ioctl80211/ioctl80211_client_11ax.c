@@ -46,6 +46,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <math.h>
 #include <ctype.h>
 #include <arpa/inet.h>
+#include <time.h>
 #include <dp_rate_stats_pub.h>
 
 #include "const.h"
@@ -56,6 +57,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ioctl80211.h"
 #include "ioctl80211_client.h"
+#include "ioctl80211_phyrate.h"
 
 #define MODULE_ID LOG_MODULE_ID_IOCTL
 
@@ -74,7 +76,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /*global structure to maintain stats*/
 #define PEER_STATS_FLAG 0x0001
-#define PEER_CLI_MAX 32
+
+#ifndef CONFIG_QCA_PEER_RATE_MAX_PER_RADIO
+#define CONFIG_QCA_PEER_RATE_MAX_PER_RADIO 256
+#endif
+
+#ifndef CONFIG_QCA_STATS_POOL_CLIENTS
+#define CONFIG_QCA_STATS_POOL_CLIENTS 16
+#endif
+
+/* Client records are sampled in pairs (old/new), grow in small steps */
+ioctl80211_pool_t                   g_ioctl80211_client_pool =
+    IOCTL80211_POOL_INIT("client",
+                         ioctl80211_client_record_t,
+                         CONFIG_QCA_STATS_POOL_CLIENTS,
+                         8);
 
 #ifdef CONFIG_PLATFORM_QCA_QSDK11_SUB_VER4
 #define DP_PEER_AVG_RATE_STATS_SUPPORTED
@@ -104,9 +120,47 @@ struct avg_phyrate {
     struct wlan_avg_rate_stats stats;
 };
 
-static weighted_phyrate g_peer_rx_phyrate[PEER_CLI_MAX];
-static weighted_phyrate g_peer_tx_phyrate[PEER_CLI_MAX];
-static struct avg_phyrate g_peer_avg_phyrate[PEER_CLI_MAX];
+/* Rate accumulators of a single peer. They are filled from peer stats
+ * cache flush events and consumed (reset) on each client stats sample.
+ *
+ * Peers are indexed per radio. Every client list pass of a radio starts
+ * a new generation: peers listed in it are stamped with it, the rate
+ * windows of a peer are restarted on the first sample of a new
+ * generation and windows older than the previous generation are not
+ * reported. Peers no longer listed on their vap are dropped, see
+ * peer_phyrate_evict().
+ */
+#define PEER_PHYRATE_STALE_GENS 8
+
+struct peer_phyrate_radio {
+    char phy[IOCTL80211_IFNAME_LEN];
+    uint32_t gen;
+    unsigned int num;
+    ds_dlist_t peers;
+    ds_tree_node_t node;
+};
+
+struct peer_phyrate {
+    mac_address_t mac_addr;
+    struct peer_phyrate_radio *radio;
+    char vif[IOCTL80211_IFNAME_LEN];
+    uint32_t gen;
+    uint32_t win_gen;
+    weighted_phyrate rx;
+    weighted_phyrate tx;
+    struct avg_phyrate avg;
+    ds_tree_node_t node;
+    ds_dlist_node_t radio_node;
+};
+
+static int peer_phyrate_cmp(const void *a, const void *b)
+{
+    return memcmp(a, b, sizeof(mac_address_t));
+}
+
+static ds_tree_t g_peer_phyrate = DS_TREE_INIT(peer_phyrate_cmp, struct peer_phyrate, node);
+static ds_tree_t g_peer_phyrate_radios = DS_TREE_INIT(ds_str_cmp, struct peer_phyrate_radio, node);
+static uint32_t g_peer_phyrate_dropped;
 
 #include "osync_nl80211_11ax.h"
 
@@ -155,110 +209,291 @@ static inline uint64_t weight_avg_get(const struct weight_avg *avg)
     return avg->cnt > 0 ? avg->sum / avg->cnt : 0;
 }
 
-#ifdef OPENSYNC_NL_SUPPORT
-int get_cli_mac_index(mac_address_t mac_addr, int peer_stats_flag)
+static struct peer_phyrate *peer_phyrate_get(const uint8_t *peer_mac)
 {
-    int i;
-    int index = 0;
-    if (peer_stats_flag == PEER_RX_STATS)
-    {
-        for (i = 0; i < PEER_CLI_MAX; i++)
-        {
-            if (g_peer_rx_phyrate[i].flags & PEER_STATS_FLAG)
-            {
-                if ((g_peer_rx_phyrate[i].mac_addr[0] == (u8)mac_addr[0]) && (g_peer_rx_phyrate[i].mac_addr[1] == (u8)mac_addr[1]) &&
-                    (g_peer_rx_phyrate[i].mac_addr[2] == (u8)mac_addr[2]) && (g_peer_rx_phyrate[i].mac_addr[3] == (u8)mac_addr[3]) &&
-                    (g_peer_rx_phyrate[i].mac_addr[4] == (u8)mac_addr[4]) && (g_peer_rx_phyrate[i].mac_addr[5] == (u8)mac_addr[5]))
-                {
-                    index = i;
-                    break;
-                }
-            } else {
-                index = i;
-                break;
-            }
-        }
+    return ds_tree_find(&g_peer_phyrate, (void *)peer_mac);
+}
+
+static struct peer_phyrate_radio *peer_phyrate_radio_get(const char *phy)
+{
+    struct peer_phyrate_radio *radio;
+
+    if ((radio = ds_tree_find(&g_peer_phyrate_radios, (void *)phy)))
+        return radio;
+
+    radio = CALLOC(1, sizeof(*radio));
+    STRSCPY(radio->phy, phy);
+    ds_dlist_init(&radio->peers, struct peer_phyrate, radio_node);
+    ds_tree_insert(&g_peer_phyrate_radios, radio, radio->phy);
+    return radio;
+}
+
+static void peer_phyrate_reset(struct peer_phyrate *peer)
+{
+    memset(&peer->rx, 0, sizeof(peer->rx));
+    memset(&peer->tx, 0, sizeof(peer->tx));
+    memset(&peer->avg, 0, sizeof(peer->avg));
+    peer->win_gen = peer->radio->gen;
+}
+
+static void peer_phyrate_move(struct peer_phyrate *peer, struct peer_phyrate_radio *radio)
+{
+    if (peer->radio == radio)
+        return;
+
+    if (peer->radio) {
+        ds_dlist_remove(&peer->radio->peers, peer);
+        peer->radio->num--;
     }
-    else if (peer_stats_flag == PEER_TX_STATS)
-    {
-        for (i = 0; i < PEER_CLI_MAX; i++)
-        {
-            if (g_peer_tx_phyrate[i].flags & PEER_STATS_FLAG)
-            {
-                if ((g_peer_tx_phyrate[i].mac_addr[0] == (u8)mac_addr[0]) && (g_peer_tx_phyrate[i].mac_addr[1] == (u8)mac_addr[1]) &&
-                    (g_peer_tx_phyrate[i].mac_addr[2] == (u8)mac_addr[2]) && (g_peer_tx_phyrate[i].mac_addr[3] == (u8)mac_addr[3]) &&
-                    (g_peer_tx_phyrate[i].mac_addr[4] == (u8)mac_addr[4]) && (g_peer_tx_phyrate[i].mac_addr[5] == (u8)mac_addr[5]))
-                {
-                    index = i;
-                    break;
-                }
-            } else {
-                index = i;
-                break;
-            }
-        }
+
+    peer->radio = radio;
+    peer->gen = radio->gen;
+    ds_dlist_insert_tail(&radio->peers, peer);
+    radio->num++;
+    peer_phyrate_reset(peer);
+}
+
+/* Peer whose rate windows are due for the current sample. Windows
+ * which were neither sampled nor restarted since the previous
+ * generation hold stale rates and are dropped.
+ */
+static struct peer_phyrate *peer_phyrate_window_get(const uint8_t *peer_mac)
+{
+    struct peer_phyrate *peer;
+
+    if (!(peer = peer_phyrate_get(peer_mac)))
+        return NULL;
+
+    if (peer->radio->gen - peer->win_gen > 1)
+        peer_phyrate_reset(peer);
+
+    return peer;
+}
+
+static struct peer_phyrate *peer_phyrate_add(const char *ifname, const uint8_t *peer_mac)
+{
+    struct peer_phyrate_radio *radio;
+    struct peer_phyrate *peer;
+    char phy[IOCTL80211_IFNAME_LEN];
+
+    peer = peer_phyrate_get(peer_mac);
+    if (peer) {
+        /* First sample of a new generation opens a new window */
+        if (peer->win_gen != peer->radio->gen)
+            peer_phyrate_reset(peer);
+        return peer;
     }
-    else if (peer_stats_flag == PEER_AVG_STATS)
-    {
-        for (i = 0; i < PEER_CLI_MAX; i++)
-        {
-            if (g_peer_avg_phyrate[i].flags & PEER_STATS_FLAG)
-            {
-                if ((g_peer_avg_phyrate[i].mac_addr[0] == (u8)mac_addr[0]) && (g_peer_avg_phyrate[i].mac_addr[1] == (u8)mac_addr[1]) &&
-                    (g_peer_avg_phyrate[i].mac_addr[2] == (u8)mac_addr[2]) && (g_peer_avg_phyrate[i].mac_addr[3] == (u8)mac_addr[3]) &&
-                    (g_peer_avg_phyrate[i].mac_addr[4] == (u8)mac_addr[4]) && (g_peer_avg_phyrate[i].mac_addr[5] == (u8)mac_addr[5]))
-                {
-                    index = i;
-                    break;
-                }
-            } else {
-                index = i;
-                break;
-            }
-        }
+
+    /* Events may be reported against a vap, account them to its radio */
+    ioctl80211_interface_phy_get(ifname, phy, sizeof(phy));
+    radio = peer_phyrate_radio_get(phy);
+
+    if (radio->num >= CONFIG_QCA_PEER_RATE_MAX_PER_RADIO) {
+        g_peer_phyrate_dropped++;
+        LOG(DEBUG,
+            "%s: Peer rate table full (%u), dropping stats for "MAC_ADDRESS_FORMAT" (dropped %u)",
+            phy, radio->num, MAC_ADDRESS_PRINT(peer_mac), g_peer_phyrate_dropped);
+        return NULL;
+    }
+
+    peer = CALLOC(1, sizeof(*peer));
+    memcpy(peer->mac_addr, peer_mac, sizeof(peer->mac_addr));
+    ds_tree_insert(&g_peer_phyrate, peer, peer->mac_addr);
+    peer_phyrate_move(peer, radio);
+
+    LOG(TRACE,
+        "%s: Tracking rates of "MAC_ADDRESS_FORMAT" (%u peers)",
+        phy, MAC_ADDRESS_PRINT(peer_mac), radio->num);
+
+    return peer;
+}
+
+static bool peer_phyrate_vif_listed(
+        const struct peer_phyrate  *peer,
+        ioctl80211_interfaces_t    *interfaces,
+        radio_essid_t              *essid)
+{
+    uint32_t i;
+
+    if (!essid)
+        return true;
+
+    for (i = 0; i < interfaces->qty; i++) {
+        if (strcmp(interfaces->phy[i].ifname, peer->vif))
+            continue;
+        return !memcmp(interfaces->phy[i].essid, essid, sizeof(*essid));
+    }
+
+    return false;
+}
+
+/* Called after the client list of a radio was fetched, this starts a
+ * new generation of the radio. Peers which were seen in the list are
+ * stamped with it. The remaining peers of vaps covered by the list are
+ * gone and their rates are dropped, peers of other vaps go once they
+ * were not listed for PEER_PHYRATE_STALE_GENS generations.
+ */
+static void peer_phyrate_evict(
+        const char                 *phy,
+        ds_dlist_t                 *client_list,
+        ioctl80211_interfaces_t    *interfaces,
+        radio_essid_t              *essid)
+{
+    ioctl80211_client_record_t *client;
+    struct peer_phyrate_radio *radio;
+    struct peer_phyrate *peer;
+    ds_dlist_iter_t iter;
+
+    radio = peer_phyrate_radio_get(phy);
+    radio->gen++;
+
+    ds_dlist_foreach(client_list, client) {
+        if (!(peer = peer_phyrate_get((uint8_t *)client->info.mac)))
+            continue;
+        peer_phyrate_move(peer, radio);
+        peer->gen = radio->gen;
+        STRSCPY(peer->vif, client->info.ifname);
+    }
+
+    for (peer = ds_dlist_ifirst(&iter, &radio->peers); peer; peer = ds_dlist_inext(&iter)) {
+        if (peer->gen == radio->gen)
+            continue;
+
+        if (!peer_phyrate_vif_listed(peer, interfaces, essid) &&
+            radio->gen - peer->gen < PEER_PHYRATE_STALE_GENS)
+            continue;
+
+        LOG(TRACE,
+            "%s: Evicting rates of "MAC_ADDRESS_FORMAT,
+            phy, MAC_ADDRESS_PRINT(peer->mac_addr));
+
+        ds_dlist_iremove(&iter);
+        ds_tree_remove(&g_peer_phyrate, peer);
+        radio->num--;
+        FREE(peer);
+    }
+}
+
+/* Peer stats cache flush events come in bursts, one per peer and cache
+ * type on every flush interval. While the event socket is drained they
+ * are only reduced into compact records queued here. The records are
+ * then folded into the per peer accumulators in one pass, see
+ * osync_peer_stats_event_drain().
+ */
+#define PEER_STATS_BATCH_LEN        256
+#define PEER_STATS_DRAIN_MAX_READS  1024
+
+struct peer_stats_rec {
+    mac_address_t mac_addr;
+    char ifname[IOCTL80211_IFNAME_LEN];
+    uint32_t cache_type;
+    uint64_t cookie;
+    union {
+        struct {
+            uint64_t sum;
+            uint64_t cnt;
+            uint32_t frames;        /* rx: mpdus, tx: mpdu_success */
+            uint32_t tries;         /* rx: retries, tx: mpdu_attempts */
+        } rate;
+        struct wlan_avg_rate_stats avg;
+    } u;
+};
+
+static struct peer_stats_rec g_peer_stats_batch[PEER_STATS_BATCH_LEN];
+static unsigned int g_peer_stats_batch_len;
+
+static struct {
+    uint64_t events;
+    uint64_t overflows;
+    uint64_t batches;
+    uint64_t last_batch_us;
+    uint64_t max_batch_us;
+} g_peer_stats_cnt;
+
+#ifdef OPENSYNC_NL_SUPPORT
+#if defined(CONFIG_PLATFORM_QCA_QSDK110) && !defined(CONFIG_PLATFORM_QCA_QSDK120)
+#define DP_PEER_STATS_CODE(stats)   ((stats)->rix)
+#else
+#define DP_PEER_STATS_CODE(stats)   ((stats)->ratecode)
+#endif
+
+/* Cache entries are keyed by a stats code, see ASSEMBLE_STATS_CODE().
+ * Only drivers whose headers decode it get the table lookup.
+ */
+#if (defined(CONFIG_PLATFORM_QCA_QSDK110) && !defined(CONFIG_PLATFORM_QCA_QSDK120)) || \
+    !defined(GET_DP_PEER_STATS_RATE)
+#define DP_PEER_STATS_RATE_DRIVER
+#endif
+
+#define DP_PEER_STATS_PREAM_HT      2
+#define DP_PEER_STATS_PREAM_VHT     3
+#define DP_PEER_STATS_PREAM_HE      4
+
+/* Phyrate of a cache entry in kbps. HT/VHT/HE codes are looked up in the
+ * phyrate table at the long (0.8 us) guard interval, the code carries no
+ * GI. OFDM/CCK codes, codes the table rejects and QSDK 11.0 rate
+ * indexes, which point into a driver internal table, keep the rate the
+ * driver reported.
+ */
+static uint32_t dp_peer_stats_rate_kbps(uint32_t code, uint32_t rate)
+{
+#ifdef DP_PEER_STATS_RATE_DRIVER
+    (void)code;
+    return rate;
+#else
+    ioctl80211_phy_t phy;
+    uint32_t kbps;
+
+    switch (GET_DP_PEER_STATS_PREAM(code)) {
+    case DP_PEER_STATS_PREAM_HT:
+        phy = IOCTL80211_PHY_HT;
+        break;
+    case DP_PEER_STATS_PREAM_VHT:
+        phy = IOCTL80211_PHY_VHT;
+        break;
+    case DP_PEER_STATS_PREAM_HE:
+        phy = IOCTL80211_PHY_HE;
+        break;
+    default:
+        return rate;
     }
 
-    return index;
+    kbps = ioctl80211_phyrate_kbps(phy,
+                                   GET_DP_PEER_STATS_BW(code),
+                                   GET_DP_PEER_STATS_NSS(code),
+                                   GET_DP_PEER_STATS_RATE(code),
+                                   IOCTL80211_GI_800);
+    return kbps ? kbps : rate;
+#endif
 }
 
-static void dp_peer_rx_rate_stats(uint8_t *peer_mac,
-                    uint64_t peer_cookie,
+static void dp_peer_rx_rate_stats(struct peer_stats_rec *rec,
                     void *buffer,
                     uint32_t buffer_len)
 {
-    int index;
     int i;
     struct wlan_rx_rate_stats *rx_stats;
 
     rx_stats = (struct wlan_rx_rate_stats *)buffer;
 
-    index = get_cli_mac_index(peer_mac, PEER_RX_STATS);
-    memcpy(g_peer_rx_phyrate[index].mac_addr, peer_mac, sizeof(g_peer_rx_phyrate[index].mac_addr));
-    g_peer_rx_phyrate[index].flags |= PEER_STATS_FLAG;
-    g_peer_rx_phyrate[index].cookie = (peer_cookie & 0xFFFFFFFF00000000) >> WLANSTATS_PEER_COOKIE_LSB;
-
     for (i = 0; i < WLANSTATS_CACHE_SIZE; i++)
     {
-#if defined(CONFIG_PLATFORM_QCA_QSDK110) && !defined(CONFIG_PLATFORM_QCA_QSDK120)
-        if ((int)(rx_stats->rix) != INVALID_CACHE_IDX) {
-#else
-        if ((int)(rx_stats->ratecode) != INVALID_CACHE_IDX) {
-#endif
-            g_peer_rx_phyrate[index].sum += rx_stats->rate * rx_stats->num_ppdus;
-            g_peer_rx_phyrate[index].cnt += rx_stats->num_ppdus;
-            g_peer_rx_phyrate[index].mpdus += rx_stats->num_mpdus;
-            g_peer_rx_phyrate[index].retries += rx_stats->num_retries;
+        if ((int)DP_PEER_STATS_CODE(rx_stats) != INVALID_CACHE_IDX) {
+            rec->u.rate.sum += (uint64_t)dp_peer_stats_rate_kbps(
+                                   DP_PEER_STATS_CODE(rx_stats),
+                                   rx_stats->rate) * rx_stats->num_ppdus;
+            rec->u.rate.cnt += rx_stats->num_ppdus;
+            rec->u.rate.frames += rx_stats->num_mpdus;
+            rec->u.rate.tries += rx_stats->num_retries;
         }
         rx_stats = rx_stats + 1;
     }
 }
 
-static void dp_peer_tx_rate_stats(uint8_t *peer_mac,
-                    uint64_t peer_cookie,
+static bool dp_peer_tx_rate_stats(struct peer_stats_rec *rec,
                     void *buffer,
                     uint32_t buffer_len)
 {
-    int index;
     int i = 0;
 
     struct wlan_tx_rate_stats *tx_stats;
@@ -267,98 +502,127 @@ static void dp_peer_tx_rate_stats(uint8_t *peer_mac,
               sizeof(struct wlan_tx_rate_stats))
               + sizeof(struct wlan_tx_sojourn_stats)) {
         LOGI("invalid buffer len, return");
-        return;
+        return false;
     }
     tx_stats = (struct wlan_tx_rate_stats *)buffer;
 
-    index = get_cli_mac_index(peer_mac, PEER_TX_STATS);
-
-    memcpy(g_peer_tx_phyrate[index].mac_addr, peer_mac, sizeof(g_peer_tx_phyrate[index].mac_addr));
-    g_peer_tx_phyrate[index].flags |= PEER_STATS_FLAG;
-    g_peer_tx_phyrate[index].cookie = (peer_cookie & 0xFFFFFFFF00000000) >> WLANSTATS_PEER_COOKIE_LSB;
-
     for (i = 0; i < WLANSTATS_CACHE_SIZE; i++)
     {
-#if defined(CONFIG_PLATFORM_QCA_QSDK110) && !defined(CONFIG_PLATFORM_QCA_QSDK120)
-        if ((int)(tx_stats->rix) != INVALID_CACHE_IDX) {
-#else
-        if ((int)(tx_stats->ratecode) != INVALID_CACHE_IDX) {
-#endif
-            g_peer_tx_phyrate[index].sum += tx_stats->rate * tx_stats->num_ppdus;
-            g_peer_tx_phyrate[index].cnt += tx_stats->num_ppdus;
-            g_peer_tx_phyrate[index].success += tx_stats->mpdu_success;
-            g_peer_tx_phyrate[index].attempts += tx_stats->mpdu_attempts;
+        if ((int)DP_PEER_STATS_CODE(tx_stats) != INVALID_CACHE_IDX) {
+            rec->u.rate.sum += (uint64_t)dp_peer_stats_rate_kbps(
+                                   DP_PEER_STATS_CODE(tx_stats),
+                                   tx_stats->rate) * tx_stats->num_ppdus;
+            rec->u.rate.cnt += tx_stats->num_ppdus;
+            rec->u.rate.frames += tx_stats->mpdu_success;
+            rec->u.rate.tries += tx_stats->mpdu_attempts;
         }
         tx_stats = tx_stats + 1;
     }
 
-    return;
+    return true;
 }
 
 #endif
 
-static void dp_peer_avg_rate_stats(uint8_t *peer_mac,
-                    uint64_t peer_cookie,
+static bool dp_peer_avg_rate_stats(struct peer_stats_rec *rec,
                     void *buffer,
                     uint32_t buffer_len)
 {
 #ifdef DP_PEER_AVG_RATE_STATS_SUPPORTED
-    struct avg_phyrate *buf;
-    uint32_t *src;
-    uint32_t *dst;
-    int index;
-    int n;
-
     if (WARN_ON(buffer_len < sizeof(struct wlan_avg_rate_stats)))
-        return;
+        return false;
     if (WARN_ON(buffer_len > sizeof(struct wlan_avg_rate_stats)))
-        return;
-
-    index = get_cli_mac_index(peer_mac, PEER_AVG_STATS);
-    buf = &g_peer_avg_phyrate[index];
-    memcpy(buf->mac_addr, peer_mac, sizeof(buf->mac_addr));
-    buf->flags |= PEER_STATS_FLAG;
+        return false;
 
-    /* The entire buffer is ultimately a set of 32
-     * bit unsigned integers all around. That's
-     * why it is possible to accumulate all
-     * constituents by treating it as an array.
-     */
-    n = buffer_len / sizeof(*src);
-    src = buffer;
-    dst = (uint32_t *)&buf->stats;
-
-    for (; n; n--, src++, dst++)
-        *dst += *src;
-
-    LOG(TRACE,
-        "Accumulating avg rate stats for "MAC_ADDRESS_FORMAT,
-        MAC_ADDRESS_PRINT(peer_mac));
+    memcpy(&rec->u.avg, buffer, sizeof(rec->u.avg));
+    return true;
+#else
+    return false;
 #endif
 }
 
-static void dp_peer_stats_handler(uint32_t cache_type,
-                 uint8_t *peer_mac,
-                 uint64_t peer_cookie,
+static bool dp_peer_stats_handler(struct peer_stats_rec *rec,
                  void *buffer,
                  uint32_t buffer_len)
 {
-    switch (cache_type) {
+    switch (rec->cache_type) {
     case DP_PEER_RX_RATE_STATS:
-        dp_peer_rx_rate_stats(peer_mac, peer_cookie,
-                        buffer, buffer_len);
-        break;
+        dp_peer_rx_rate_stats(rec, buffer, buffer_len);
+        return true;
     case DP_PEER_TX_RATE_STATS:
-        dp_peer_tx_rate_stats(peer_mac, peer_cookie,
-                        buffer, buffer_len);
+        return dp_peer_tx_rate_stats(rec, buffer, buffer_len);
+    case DP_PEER_AVG_RATE_STATS:
+        return dp_peer_avg_rate_stats(rec, buffer, buffer_len);
+    }
+
+    return false;
+}
+
+static void dp_peer_stats_fold(const struct peer_stats_rec *rec)
+{
+    struct peer_phyrate *peer;
+    weighted_phyrate *rate;
+#ifdef DP_PEER_AVG_RATE_STATS_SUPPORTED
+    const uint32_t *src;
+    uint32_t *dst;
+    int n;
+#endif
+
+    if (!(peer = peer_phyrate_add(rec->ifname, rec->mac_addr)))
+        return;
+
+    switch (rec->cache_type) {
+    case DP_PEER_RX_RATE_STATS:
+    case DP_PEER_TX_RATE_STATS:
+        rate = (rec->cache_type == DP_PEER_RX_RATE_STATS) ? &peer->rx : &peer->tx;
+        memcpy(rate->mac_addr, rec->mac_addr, sizeof(rate->mac_addr));
+        rate->flags |= PEER_STATS_FLAG;
+        rate->cookie = rec->cookie;
+        rate->sum += rec->u.rate.sum;
+        rate->cnt += rec->u.rate.cnt;
+        if (rec->cache_type == DP_PEER_RX_RATE_STATS) {
+            rate->mpdus += rec->u.rate.frames;
+            rate->retries += rec->u.rate.tries;
+        } else {
+            rate->success += rec->u.rate.frames;
+            rate->attempts += rec->u.rate.tries;
+        }
         break;
+#ifdef DP_PEER_AVG_RATE_STATS_SUPPORTED
     case DP_PEER_AVG_RATE_STATS:
-        dp_peer_avg_rate_stats(peer_mac, peer_cookie,
-                        buffer, buffer_len);
+        memcpy(peer->avg.mac_addr, rec->mac_addr, sizeof(peer->avg.mac_addr));
+        peer->avg.flags |= PEER_STATS_FLAG;
+
+        /* The entire buffer is ultimately a set of 32
+         * bit unsigned integers all around. That's
+         * why it is possible to accumulate all
+         * constituents by treating it as an array.
+         */
+        n = sizeof(rec->u.avg) / sizeof(*src);
+        src = (const uint32_t *)&rec->u.avg;
+        dst = (uint32_t *)&peer->avg.stats;
+
+        for (; n; n--, src++, dst++)
+            *dst += *src;
+
+        LOG(TRACE,
+            "Accumulating avg rate stats for "MAC_ADDRESS_FORMAT,
+            MAC_ADDRESS_PRINT(rec->mac_addr));
         break;
+#endif
     }
 }
 
+static void osync_peer_stats_event_fold(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < g_peer_stats_batch_len; i++)
+        dp_peer_stats_fold(&g_peer_stats_batch[i]);
+
+    g_peer_stats_batch_len = 0;
+}
+
 void osync_peer_stats_event_callback(char *ifname,
 							uint32_t cmdid,
 							uint8_t *data,
@@ -366,6 +630,7 @@ void osync_peer_stats_event_callback(char *ifname,
 {
     struct nlattr *tb_array[QCA_WLAN_VENDOR_ATTR_PEER_STATS_CACHE_MAX + 1];
     struct nlattr *tb;
+    struct peer_stats_rec *rec;
     void *buffer = NULL;
     uint32_t buffer_len = 0;
     uint8_t *peer_mac;
@@ -377,6 +642,10 @@ void osync_peer_stats_event_callback(char *ifname,
         return;
     }
 
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    ioctl80211_trace_event(ifname, cmdid, data, len);
+#endif
+
     if (nla_parse(tb_array, QCA_WLAN_VENDOR_ATTR_PEER_STATS_CACHE_MAX,
                 (struct nlattr *)data, len, NULL)) {
         return;
@@ -409,9 +678,106 @@ void osync_peer_stats_event_callback(char *ifname,
         return;
     }
 
-    dp_peer_stats_handler(cache_type, peer_mac, peer_cookie,
-            buffer, buffer_len);
+    g_peer_stats_cnt.events++;
+
+    /* Batch is full, fold what was queued so far and keep going */
+    if (g_peer_stats_batch_len == PEER_STATS_BATCH_LEN)
+        osync_peer_stats_event_fold();
+
+    rec = &g_peer_stats_batch[g_peer_stats_batch_len];
+    memset(rec, 0, sizeof(*rec));
+    memcpy(rec->mac_addr, peer_mac, sizeof(rec->mac_addr));
+    STRSCPY(rec->ifname, ifname ?: "");
+    rec->cache_type = cache_type;
+    rec->cookie = (peer_cookie & 0xFFFFFFFF00000000) >> WLANSTATS_PEER_COOKIE_LSB;
+
+    if (dp_peer_stats_handler(rec, buffer, buffer_len))
+        g_peer_stats_batch_len++;
+}
+
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+/* Replayed events don't go through the drain, fold them right away */
+void osync_peer_stats_event_replay(const char *ifname,
+                                   uint32_t cmdid,
+                                   void *data,
+                                   size_t len)
+{
+    osync_peer_stats_event_callback((char *)ifname, cmdid, data, len);
+    osync_peer_stats_event_fold();
+}
+#endif
+
+static bool osync_peer_stats_event_pending(int fd)
+{
+    if (recv(fd, NULL, 0, MSG_PEEK | MSG_DONTWAIT | MSG_TRUNC) >= 0)
+        return true;
+
+    /* Pending socket error is reported (and cleared) by the peek */
+    if (errno == ENOBUFS) {
+        g_peer_stats_cnt.overflows++;
+        return true;
+    }
+
+    return false;
+}
+
+void osync_peer_stats_event_drain(struct nl_sock *sock)
+{
+    struct timespec started;
+    struct timespec now;
+    uint64_t events = g_peer_stats_cnt.events;
+    uint64_t overflows = g_peer_stats_cnt.overflows;
+    int reads = 0;
+    int fd;
+    int rc;
+
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    fd = nl_socket_get_fd(sock);
+
+    /* The socket is non-blocking, read until it runs dry. The number of
+     * reads is bounded so that a storm can't starve the loop, ev will
+     * call back as long as data is left.
+     */
+    while (reads < PEER_STATS_DRAIN_MAX_READS) {
+        rc = nl_recvmsgs_default(sock);
+        if (rc == -NLE_AGAIN)
+            break;
+
+        reads++;
+
+        if (rc == -NLE_NOMEM && errno == ENOBUFS) {
+            g_peer_stats_cnt.overflows++;
+        } else if (rc < 0) {
+            LOGE("Failed to receive nl message, errno = %d (%s)",
+                 errno, strerror(errno));
+            break;
+        }
+
+        if (!osync_peer_stats_event_pending(fd))
+            break;
+    }
 
+    osync_peer_stats_event_fold();
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    g_peer_stats_cnt.batches++;
+    g_peer_stats_cnt.last_batch_us = (now.tv_sec - started.tv_sec) * 1000000 +
+                                     (now.tv_nsec - started.tv_nsec) / 1000;
+    if (g_peer_stats_cnt.last_batch_us > g_peer_stats_cnt.max_batch_us)
+        g_peer_stats_cnt.max_batch_us = g_peer_stats_cnt.last_batch_us;
+
+    LOG(TRACE,
+        "Peer stats batch: %"PRIu64" events in %d reads, %"PRIu64" us"
+        " (total events %"PRIu64" batches %"PRIu64" max %"PRIu64" us)",
+        g_peer_stats_cnt.events - events, reads,
+        g_peer_stats_cnt.last_batch_us, g_peer_stats_cnt.events,
+        g_peer_stats_cnt.batches, g_peer_stats_cnt.max_batch_us);
+
+    if (g_peer_stats_cnt.overflows != overflows)
+        LOG(WARNING,
+            "Peer stats event socket overflowed, events were lost"
+            " (overflows %"PRIu64" events %"PRIu64")",
+            g_peer_stats_cnt.overflows, g_peer_stats_cnt.events);
 }
 
 static void
@@ -422,13 +788,15 @@ ioctl80211_client_stats_avg_rx_calc(
         dpp_client_record_t        *client_record)
 {
 #ifdef DP_PEER_AVG_RATE_STATS_SUPPORTED
+    struct peer_phyrate *peer;
     struct avg_phyrate *avg;
     double mbps;
     double num;
-    int index;
 
-    index = get_cli_mac_index(data_new->info.mac, PEER_AVG_STATS);
-    avg = &g_peer_avg_phyrate[index];
+    if (!(peer = peer_phyrate_window_get((uint8_t *)data_new->info.mac)))
+        return;
+
+    avg = &peer->avg;
     if (avg->flags & PEER_STATS_FLAG) {
         if (avg->stats.rx[WLAN_RATE_SU].num_ppdu) {
             mbps = avg->stats.rx[WLAN_RATE_SU].sum_mbps;
@@ -477,14 +845,21 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
         ioctl80211_client_record_t *data_old,
         dpp_client_record_t        *client_record)
 {
-    int index;
+    struct peer_phyrate *peer;
+    weighted_phyrate *rx;
     radio_type_t radio_type = radio_cfg->type;
 
-    index = get_cli_mac_index(data_new->info.mac, PEER_RX_STATS);
-    if (g_peer_rx_phyrate[index].cnt != 0)
+    client_record->stats.frames_rx = 0;
+    client_record->stats.retries_rx = 0;
+
+    if (!(peer = peer_phyrate_window_get((uint8_t *)data_new->info.mac)))
+        return IOCTL_STATUS_OK;
+
+    rx = &peer->rx;
+    if (rx->cnt != 0)
     {
         /* This overrides the "last rx rate" */
-        client_record->stats.rate_rx = ((g_peer_rx_phyrate[index].sum / g_peer_rx_phyrate[index].cnt) / 1000);
+        client_record->stats.rate_rx = ((rx->sum / rx->cnt) / 1000);
 
         LOG(TRACE,
             "Calculated %s client delta rx phyrate "MAC_ADDRESS_FORMAT
@@ -492,15 +867,15 @@ ioctl_status_t ioctl80211_client_stats_rx_calculate(
             radio_get_name_from_type(radio_type),
             MAC_ADDRESS_PRINT(data_new->info.mac),
             client_record->stats.rate_rx,
-            g_peer_rx_phyrate[index].cnt);
-        g_peer_rx_phyrate[index].sum = 0;
-        g_peer_rx_phyrate[index].cnt = 0;
+            rx->cnt);
+        rx->sum = 0;
+        rx->cnt = 0;
 
     }
-    client_record->stats.frames_rx = g_peer_rx_phyrate[index].mpdus;
-    client_record->stats.retries_rx = g_peer_rx_phyrate[index].retries;
-    g_peer_rx_phyrate[index].mpdus = 0;
-    g_peer_rx_phyrate[index].retries = 0;
+    client_record->stats.frames_rx = rx->mpdus;
+    client_record->stats.retries_rx = rx->retries;
+    rx->mpdus = 0;
+    rx->retries = 0;
 
     ioctl80211_client_stats_avg_rx_calc(radio_cfg, data_new, data_old,
                                         client_record);
@@ -516,11 +891,11 @@ ioctl_status_t ioctl80211_clients_stats_rx_fetch(
 {
 
 #ifdef OPENSYNC_NL_SUPPORT
-    int index;
+    struct peer_phyrate *peer;
 
-    index = get_cli_mac_index(client_entry->info.mac, PEER_RX_STATS);
-    if (g_peer_rx_phyrate[index].flags)
-        client_entry->stats_cookie = g_peer_rx_phyrate[index].cookie;
+    peer = peer_phyrate_get((uint8_t *)client_entry->info.mac);
+    if (peer && peer->rx.flags)
+        client_entry->stats_cookie = peer->rx.cookie;
 #else
     int32_t                             rc;
     struct iwreq                        request;
@@ -584,16 +959,18 @@ ioctl80211_client_stats_avg_tx_calc(
         dpp_client_record_t        *client_record)
 {
 #ifdef DP_PEER_AVG_RATE_STATS_SUPPORTED
+    struct peer_phyrate            *peer;
     struct avg_phyrate             *avg;
 #if 0
     int32_t                         snr;
 #endif
     double                          mbps;
     double                          num;
-    int                             index;
 
-    index = get_cli_mac_index(data_new->info.mac, PEER_AVG_STATS);
-    avg = &g_peer_avg_phyrate[index];
+    if (!(peer = peer_phyrate_window_get((uint8_t *)data_new->info.mac)))
+        return;
+
+    avg = &peer->avg;
     if (avg->flags & PEER_STATS_FLAG) {
         if (avg->stats.tx[WLAN_RATE_SU].num_ppdu) {
             mbps = avg->stats.tx[WLAN_RATE_SU].sum_mbps;
@@ -663,28 +1040,35 @@ ioctl_status_t ioctl80211_client_stats_tx_calculate(
         ioctl80211_client_record_t *data_old,
         dpp_client_record_t        *client_record)
 {
-    int                             index;
+    struct peer_phyrate            *peer;
+    weighted_phyrate               *tx;
     radio_type_t                    radio_type = radio_cfg->type;
 
-    index = get_cli_mac_index(data_new->info.mac, PEER_TX_STATS);
-    if (g_peer_tx_phyrate[index].cnt != 0)
+    client_record->stats.frames_tx = 0;
+    client_record->stats.retries_tx = 0;
+
+    if (!(peer = peer_phyrate_window_get((uint8_t *)data_new->info.mac)))
+        return IOCTL_STATUS_OK;
+
+    tx = &peer->tx;
+    if (tx->cnt != 0)
     {
         /* This overrides the "last tx rate" */
-        client_record->stats.rate_tx = ((g_peer_tx_phyrate[index].sum / g_peer_tx_phyrate[index].cnt) / 1000);
+        client_record->stats.rate_tx = ((tx->sum / tx->cnt) / 1000);
         LOG(TRACE,
             "Calculated %s client delta tx phyrate "MAC_ADDRESS_FORMAT
             " mbps=%f ppdus=%"PRIu64"",
             radio_get_name_from_type(radio_type),
             MAC_ADDRESS_PRINT(data_new->info.mac),
             client_record->stats.rate_tx,
-            g_peer_tx_phyrate[index].cnt);
-        g_peer_tx_phyrate[index].sum = 0;
-        g_peer_tx_phyrate[index].cnt = 0;
+            tx->cnt);
+        tx->sum = 0;
+        tx->cnt = 0;
     }
-    client_record->stats.frames_tx = g_peer_tx_phyrate[index].success;
-    client_record->stats.retries_tx = (g_peer_tx_phyrate[index].attempts - g_peer_tx_phyrate[index].success);
-    g_peer_tx_phyrate[index].success = 0;
-    g_peer_tx_phyrate[index].attempts = 0;
+    client_record->stats.frames_tx = tx->success;
+    client_record->stats.retries_tx = (tx->attempts - tx->success);
+    tx->success = 0;
+    tx->attempts = 0;
 
     ioctl80211_client_stats_avg_tx_calc(radio_cfg, data_new, data_old,
                                         client_record);
@@ -1752,7 +2136,6 @@ ioctl_status_t ioctl80211_clients_list_get(
         ds_dlist_t                 *client_list)
 {
     ioctl_status_t                  status;
-    char                           *args[IOCTL80211_IFNAME_ARG_QTY];
     ioctl80211_interface_t         *interface = NULL;
     ioctl80211_interfaces_t         interfaces;
     uint32_t                        interface_index;
@@ -1763,13 +2146,7 @@ ioctl_status_t ioctl80211_clients_list_get(
     }
 
     memset (&interfaces, 0, sizeof(interfaces));
-    args[IOCTL80211_IFNAME_ARG] = (char *) &interfaces;
-
-    ioctl80211_interfaces_find(
-            ioctl80211_fd_get(),
-            &ioctl80211_interfaces_get,
-            args,
-            radio_cfg->type);
+    ioctl80211_interfaces_lookup(radio_cfg->type, &interfaces);
 
     for (interface_index = 0; interface_index < interfaces.qty; interface_index++)
     {
@@ -1808,11 +2185,18 @@ ioctl_status_t ioctl80211_clients_list_get(
                 "Parsing %s interface %s client list",
                 radio_get_name_from_type(radio_cfg->type),
                 interface->ifname);
-            return IOCTL_STATUS_ERROR;
+            status = IOCTL_STATUS_ERROR;
+            goto exit;
         }
     }
 
-    return IOCTL_STATUS_OK;
+    peer_phyrate_evict(radio_cfg->phy_name, client_list, &interfaces, essid);
+
+    status = IOCTL_STATUS_OK;
+
+exit:
+    ioctl80211_interfaces_free(&interfaces);
+    return status;
 }
 
 
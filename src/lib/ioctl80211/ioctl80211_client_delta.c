@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Peer stats histogram deltas
+ *
+ * Rate histograms of a peer are sampled as a whole and the driver hands
+ * them out as packed arrays of structs. Each sample is reduced into
+ * structure of arrays scratch in one branch free pass, followed by a
+ * compaction that lists the buckets that changed.
+ */
+
+#include <stdint.h>
+
+#include "ioctl80211_client_delta.h"
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+void ioctl80211_client_rx_delta_calc(
+        const struct ps_uapi_ioctl     *n,
+        const struct ps_uapi_ioctl     *o,
+        ioctl80211_client_rx_delta_t   *d)
+{
+    uint32_t                        i;
+    uint32_t                        qty = 0;
+
+    for (i = 0; i < PS_MAX_ALL; i++) {
+        d->bytes[i]   = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_bytes,
+                                    o->u.peer_rx_stats.get.stats[i].num_bytes);
+        d->msdus[i]   = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_msdus,
+                                    o->u.peer_rx_stats.get.stats[i].num_msdus);
+        d->mpdus[i]   = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_mpdus,
+                                    o->u.peer_rx_stats.get.stats[i].num_mpdus);
+        d->ppdus[i]   = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_ppdus,
+                                    o->u.peer_rx_stats.get.stats[i].num_ppdus);
+        d->retries[i] = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_retries,
+                                    o->u.peer_rx_stats.get.stats[i].num_retries);
+        d->sgi[i]     = STATS_DELTA(n->u.peer_rx_stats.get.stats[i].num_sgi,
+                                    o->u.peer_rx_stats.get.stats[i].num_sgi);
+    }
+
+    /* Branch free compaction of changed buckets */
+    for (i = 0; i < PS_MAX_ALL; i++) {
+        d->active[qty] = i;
+        qty += (d->bytes[i] | d->msdus[i] | d->mpdus[i] |
+                d->ppdus[i] | d->retries[i]) != 0;
+    }
+    d->active_qty = qty;
+}
+
+void ioctl80211_client_tx_delta_calc(
+        const struct ps_uapi_ioctl     *n,
+        const struct ps_uapi_ioctl     *o,
+        ioctl80211_client_tx_delta_t   *d)
+{
+    uint32_t                        i;
+    uint32_t                        qty = 0;
+
+    for (i = 0; i < PS_MAX_ALL; i++) {
+        d->attempts[i] = STATS_DELTA(n->u.peer_tx_stats.get.stats[i].attempts,
+                                     o->u.peer_tx_stats.get.stats[i].attempts);
+        d->success[i]  = STATS_DELTA(n->u.peer_tx_stats.get.stats[i].success,
+                                     o->u.peer_tx_stats.get.stats[i].success);
+        d->ppdus[i]    = STATS_DELTA(n->u.peer_tx_stats.get.stats[i].ppdus,
+                                     o->u.peer_tx_stats.get.stats[i].ppdus);
+        /* Retry is worst case estimation between each attempts and successes */
+        d->retries[i]  = STATS_DELTA(
+                (n->u.peer_tx_stats.get.stats[i].attempts -
+                 n->u.peer_tx_stats.get.stats[i].success),
+                (o->u.peer_tx_stats.get.stats[i].attempts -
+                 o->u.peer_tx_stats.get.stats[i].success));
+    }
+
+    for (i = 0; i < PS_MAX_ALL; i++) {
+        d->active[qty] = i;
+        qty += (d->attempts[i] | d->success[i]) != 0;
+    }
+    d->active_qty = qty;
+}
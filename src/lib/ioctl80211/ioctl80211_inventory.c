@@ -0,0 +1,340 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Wireless interface inventory
+ *
+ * Stats fetchers need the list of AP/STA vaps per radio on every
+ * sampling tick. Probing /proc/net/wireless and querying mode, bssid,
+ * essid and radio type of every interface each time is wasteful, so
+ * the probed list is kept here and rebuilt only after the kernel
+ * reported a link or relevant wireless change over netlink.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <ev.h>
+#include <sys/socket.h>
+#include <linux/types.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/wireless.h>
+
+#include "log.h"
+#include "util.h"
+#include "memutil.h"
+
+#include "ioctl80211.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+static ioctl80211_interfaces_t  g_ioctl80211_inventory;
+static bool                     g_ioctl80211_inventory_valid;
+static int                      g_ioctl80211_inventory_nl_fd = -1;
+static ev_io                    g_ioctl80211_inventory_nl_io;
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static bool ioctl80211_inventory_known(
+        int                     ifindex)
+{
+    uint32_t                    i;
+
+    for (i = 0; i < g_ioctl80211_inventory.qty; i++)
+    {
+        if (g_ioctl80211_inventory.phy[i].ifindex == ifindex)
+            return true;
+    }
+
+    return false;
+}
+
+/* Links outside the inventory only matter when they are wireless,
+ * bridge and ethernet churn must not force a rebuild */
+static bool ioctl80211_inventory_wireless(
+        const char             *ifname)
+{
+    char                        path[64];
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/wireless", ifname);
+    if (access(path, F_OK) == 0)
+        return true;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/parent", ifname);
+    return access(path, F_OK) == 0;
+}
+
+static bool ioctl80211_inventory_nl_relevant(
+        struct nlmsghdr        *hdr)
+{
+    struct ifinfomsg           *ifm;
+    struct rtattr              *attr;
+    struct iw_event            *iwe;
+    const char                 *ifname = NULL;
+    bool                        known;
+    int                         len;
+
+    if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK)
+        return false;
+
+    if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifm)))
+        return false;
+
+    ifm = NLMSG_DATA(hdr);
+    known = ioctl80211_inventory_known(ifm->ifi_index);
+
+    if (hdr->nlmsg_type == RTM_DELLINK)
+        return known;
+
+    len = IFLA_PAYLOAD(hdr);
+    for (attr = IFLA_RTA(ifm); RTA_OK(attr, len); attr = RTA_NEXT(attr, len))
+    {
+        if (attr->rta_type == IFLA_IFNAME)
+        {
+            if (RTA_PAYLOAD(attr) > 0 &&
+                memchr(RTA_DATA(attr), 0, RTA_PAYLOAD(attr)))
+                ifname = RTA_DATA(attr);
+            continue;
+        }
+
+        if (attr->rta_type != IFLA_WIRELESS)
+            continue;
+
+        /* Wireless events are frequent (e.g. driver custom events), only
+         * those which can change what the inventory holds matter */
+        if (RTA_PAYLOAD(attr) < IW_EV_LCP_LEN)
+            return false;
+
+        iwe = RTA_DATA(attr);
+        switch (iwe->cmd)
+        {
+            case SIOCGIWAP:
+            case SIOCSIWESSID:
+            case SIOCSIWMODE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    if (known)
+        return true;
+
+    return ifname && ioctl80211_inventory_wireless(ifname);
+}
+
+static void ioctl80211_inventory_nl_cb(
+        struct ev_loop         *loop,
+        ev_io                  *watcher,
+        int                     revents)
+{
+    char                        buf[8192];
+    struct nlmsghdr            *hdr;
+    int                         len;
+
+    for (;;)
+    {
+        len = recv(watcher->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0)
+        {
+            if (errno == ENOBUFS)
+            {
+                /* Events were lost, assume the worst */
+                g_ioctl80211_inventory_valid = false;
+                continue;
+            }
+            break;
+        }
+
+        /* Already stale, nothing more to learn from this batch */
+        if (!g_ioctl80211_inventory_valid)
+            continue;
+
+        for (hdr = (struct nlmsghdr *)buf;
+             NLMSG_OK(hdr, (unsigned int)len);
+             hdr = NLMSG_NEXT(hdr, len))
+        {
+            if (!ioctl80211_inventory_nl_relevant(hdr))
+                continue;
+
+            if (g_ioctl80211_inventory_valid)
+                LOG(TRACE, "Invalidating wireless interface inventory");
+            g_ioctl80211_inventory_valid = false;
+        }
+    }
+}
+
+static ioctl_status_t ioctl80211_inventory_refresh(void)
+{
+    char                       *args[IOCTL80211_IFNAME_ARG_QTY];
+
+    /* Without netlink there is nothing to tell the list is stale */
+    if (g_ioctl80211_inventory_valid && g_ioctl80211_inventory_nl_fd >= 0)
+        return IOCTL_STATUS_OK;
+
+    g_ioctl80211_inventory.qty = 0;
+    args[IOCTL80211_IFNAME_ARG] = (char *) &g_ioctl80211_inventory;
+
+    ioctl80211_interfaces_find(
+            ioctl80211_fd_get(),
+            &ioctl80211_interfaces_get,
+            args,
+            RADIO_TYPE_NONE);
+
+    g_ioctl80211_inventory_valid = true;
+
+    LOG(DEBUG,
+        "Rebuilt wireless interface inventory (%u interfaces)",
+        g_ioctl80211_inventory.qty);
+
+    return IOCTL_STATUS_OK;
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+ioctl80211_interface_t *ioctl80211_interfaces_alloc(
+        ioctl80211_interfaces_t    *interfaces)
+{
+    ioctl80211_interface_t         *phy;
+    uint32_t                        size;
+
+    if (interfaces->qty < interfaces->size)
+        return &interfaces->phy[interfaces->qty];
+
+    size = interfaces->size ? interfaces->size * 2 : IOCTL80211_IFNAME_QTY;
+    phy = REALLOC(interfaces->phy, size * sizeof(*phy));
+
+    memset(&phy[interfaces->size], 0, (size - interfaces->size) * sizeof(*phy));
+    interfaces->phy = phy;
+    interfaces->size = size;
+
+    return &interfaces->phy[interfaces->qty];
+}
+
+void ioctl80211_interfaces_free(
+        ioctl80211_interfaces_t    *interfaces)
+{
+    FREE(interfaces->phy);
+    memset(interfaces, 0, sizeof(*interfaces));
+}
+
+ioctl_status_t ioctl80211_interfaces_lookup(
+        radio_type_t                type,
+        ioctl80211_interfaces_t    *interfaces)
+{
+    ioctl80211_interface_t         *interface;
+    uint32_t                        i;
+
+    ioctl80211_inventory_refresh();
+
+    for (i = 0; i < g_ioctl80211_inventory.qty; i++)
+    {
+        interface = &g_ioctl80211_inventory.phy[i];
+        if (interface->radio_type != type)
+            continue;
+
+        *ioctl80211_interfaces_alloc(interfaces) = *interface;
+        interfaces->qty++;
+    }
+
+    return IOCTL_STATUS_OK;
+}
+
+const ioctl80211_interface_t *ioctl80211_inventory_find(
+        const char                 *ifname)
+{
+    uint32_t                        i;
+
+    for (i = 0; i < g_ioctl80211_inventory.qty; i++)
+    {
+        if (!strcmp(g_ioctl80211_inventory.phy[i].ifname, ifname))
+            return &g_ioctl80211_inventory.phy[i];
+    }
+
+    return NULL;
+}
+
+ioctl_status_t ioctl80211_inventory_init(struct ev_loop *loop)
+{
+    struct sockaddr_nl              addr;
+    int                             fd;
+
+    g_ioctl80211_inventory_valid = false;
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        LOG(WARNING,
+            "Initializing interface inventory "
+            "(Failed to open netlink socket '%s'), caching disabled",
+            strerror(errno));
+        return IOCTL_STATUS_OK;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        LOG(WARNING,
+            "Initializing interface inventory "
+            "(Failed to bind netlink socket '%s'), caching disabled",
+            strerror(errno));
+        close(fd);
+        return IOCTL_STATUS_OK;
+    }
+
+    g_ioctl80211_inventory_nl_fd = fd;
+    ev_io_init(&g_ioctl80211_inventory_nl_io, ioctl80211_inventory_nl_cb, fd, EV_READ);
+    ev_io_start(loop, &g_ioctl80211_inventory_nl_io);
+
+    return IOCTL_STATUS_OK;
+}
+
+ioctl_status_t ioctl80211_inventory_close(struct ev_loop *loop)
+{
+    if (g_ioctl80211_inventory_nl_fd >= 0)
+    {
+        ev_io_stop(loop, &g_ioctl80211_inventory_nl_io);
+        close(g_ioctl80211_inventory_nl_fd);
+        g_ioctl80211_inventory_nl_fd = -1;
+    }
+
+    ioctl80211_interfaces_free(&g_ioctl80211_inventory);
+    g_ioctl80211_inventory_valid = false;
+
+    return IOCTL_STATUS_OK;
+}
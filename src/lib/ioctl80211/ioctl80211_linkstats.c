@@ -0,0 +1,339 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Netdev link counters
+ *
+ * Tx bytes of all VAPs are read from the rtnl_link_stats64 block the
+ * kernel reports for every link. One RTM_GETLINK dump covers all radios,
+ * the snapshot is kept so consecutive radios sampled within the same
+ * interval do not issue their own dump.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#include "log.h"
+#include "util.h"
+#include "memutil.h"
+
+#include "ioctl80211_linkstats.h"
+#include "ioctl80211_trace.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+/* Large enough to take several link messages per recv() */
+#define LINKSTATS_RECV_BUF_SIZE         (32 * 1024)
+
+typedef struct
+{
+    char                            ifname[IFNAMSIZ];
+    uint64_t                        tx_bytes;
+} ioctl80211_linkstats_entry_t;
+
+typedef struct
+{
+    ioctl80211_linkstats_entry_t   *entry;
+    int                             qty;
+    int                             size;
+    uint64_t                        timestamp_ms;
+} ioctl80211_linkstats_t;
+
+static int                          g_linkstats_fd = -1;
+static uint32_t                     g_linkstats_seq;
+static ioctl80211_linkstats_t       g_linkstats;
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static int ioctl80211_linkstats_fd_get(void)
+{
+    struct sockaddr_nl              addr;
+
+    if (g_linkstats_fd >= 0) {
+        return g_linkstats_fd;
+    }
+
+    g_linkstats_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (g_linkstats_fd < 0) {
+        LOG(ERR, "Link stats: failed to open netlink socket (%s)",
+            strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(g_linkstats_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        LOG(ERR, "Link stats: failed to bind netlink socket (%s)",
+            strerror(errno));
+        close(g_linkstats_fd);
+        g_linkstats_fd = -1;
+        return -1;
+    }
+
+    return g_linkstats_fd;
+}
+
+static void ioctl80211_linkstats_add(
+        const char                     *ifname,
+        uint64_t                        tx_bytes)
+{
+    ioctl80211_linkstats_entry_t   *entry;
+
+    if (g_linkstats.qty == g_linkstats.size) {
+        g_linkstats.size = g_linkstats.size ? g_linkstats.size * 2 : 32;
+        g_linkstats.entry =
+            REALLOC(g_linkstats.entry,
+                    g_linkstats.size * sizeof(*g_linkstats.entry));
+    }
+
+    entry = &g_linkstats.entry[g_linkstats.qty++];
+    STRSCPY(entry->ifname, ifname);
+    entry->tx_bytes = tx_bytes;
+}
+
+static void ioctl80211_linkstats_parse(
+        struct nlmsghdr                *nlh)
+{
+    struct ifinfomsg               *ifi = NLMSG_DATA(nlh);
+    struct rtattr                  *rta;
+    int                             len;
+    const char                     *ifname = NULL;
+    bool                            have_stats64 = false;
+    uint64_t                        tx_bytes = 0;
+
+    len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+    if (len < 0) {
+        return;
+    }
+
+    for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        switch (rta->rta_type) {
+            case IFLA_IFNAME:
+                ifname = RTA_DATA(rta);
+                break;
+            case IFLA_STATS64:
+                if (RTA_PAYLOAD(rta) >= sizeof(struct rtnl_link_stats64)) {
+                    /* Attribute is only 4 byte aligned */
+                    struct rtnl_link_stats64 stats;
+                    memcpy(&stats, RTA_DATA(rta), sizeof(stats));
+                    tx_bytes = stats.tx_bytes;
+                    have_stats64 = true;
+                }
+                break;
+            case IFLA_STATS:
+                if (!have_stats64 &&
+                    RTA_PAYLOAD(rta) >= sizeof(struct rtnl_link_stats)) {
+                    tx_bytes = ((struct rtnl_link_stats *)RTA_DATA(rta))->tx_bytes;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (NULL == ifname) {
+        return;
+    }
+
+    ioctl80211_linkstats_add(ifname, tx_bytes);
+}
+
+static void ioctl80211_linkstats_msg(
+        struct nlmsghdr                *nlh)
+{
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    ioctl80211_trace_cb_record(nlh, nlh->nlmsg_len);
+#endif
+    ioctl80211_linkstats_parse(nlh);
+}
+
+static int ioctl80211_linkstats_dump_run(void *ctx)
+{
+    struct {
+        struct nlmsghdr             nlh;
+        struct ifinfomsg            ifi;
+    } req;
+    static char                     buf[LINKSTATS_RECV_BUF_SIZE];
+    struct nlmsghdr                *nlh;
+    uint32_t                        seq;
+    ssize_t                         rc;
+    int                             len;
+    int                             fd;
+
+    (void)ctx;
+
+    fd = ioctl80211_linkstats_fd_get();
+    if (fd < 0) {
+        return -1;
+    }
+
+    seq = ++g_linkstats_seq;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = seq;
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    if (send(fd, &req, req.nlh.nlmsg_len, 0) < 0) {
+        LOG(ERR, "Link stats: failed to request link dump (%s)",
+            strerror(errno));
+        return -1;
+    }
+
+    for (;;) {
+        rc = recv(fd, buf, sizeof(buf), 0);
+        if (rc < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            LOG(ERR, "Link stats: failed to receive link dump (%s)",
+                strerror(errno));
+            return -1;
+        }
+
+        len = rc;
+        for (nlh = (struct nlmsghdr *)buf;
+             NLMSG_OK(nlh, len);
+             nlh = NLMSG_NEXT(nlh, len)) {
+            /* Leftovers of an aborted dump */
+            if (nlh->nlmsg_seq != seq) {
+                continue;
+            }
+
+            switch (nlh->nlmsg_type) {
+                case NLMSG_DONE:
+                    return 0;
+                case NLMSG_ERROR:
+                    LOG(ERR, "Link stats: link dump failed (%s)",
+                        strerror(-((struct nlmsgerr *)NLMSG_DATA(nlh))->error));
+                    return -1;
+                case RTM_NEWLINK:
+                    ioctl80211_linkstats_msg(nlh);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+static void ioctl80211_linkstats_dump_replay(void *ctx, void *data, size_t len)
+{
+    (void)ctx;
+
+    if (len >= sizeof(struct nlmsghdr) &&
+        ((struct nlmsghdr *)data)->nlmsg_len <= len) {
+        ioctl80211_linkstats_parse(data);
+    }
+}
+#endif
+
+static bool ioctl80211_linkstats_dump(void)
+{
+    int                             rc;
+
+    g_linkstats.qty = 0;
+
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    /* Every link message of the dump is kept as a callback reply */
+    rc = ioctl80211_trace_call_cb(IOCTL80211_TRACE_NL, "", RTM_GETLINK,
+                                  NULL, 0, NULL, 0,
+                                  ioctl80211_linkstats_dump_run,
+                                  ioctl80211_linkstats_dump_replay, NULL);
+#else
+    rc = ioctl80211_linkstats_dump_run(NULL);
+#endif
+    if (rc < 0) {
+        /* Socket may hold a partial dump, start over on a fresh one */
+        ioctl80211_linkstats_cleanup();
+        return false;
+    }
+
+    LOG(TRACE, "Link stats: dumped %d links", g_linkstats.qty);
+    return true;
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+bool ioctl80211_linkstats_tx_bytes_get(
+        const char                     *ifname,
+        uint64_t                        max_age_ms,
+        uint64_t                       *tx_bytes)
+{
+    uint64_t                        now = get_timestamp();
+    int                             i;
+
+    if (g_linkstats.timestamp_ms == 0 ||
+        now - g_linkstats.timestamp_ms > max_age_ms) {
+        g_linkstats.timestamp_ms = 0;
+        if (!ioctl80211_linkstats_dump()) {
+            return false;
+        }
+        g_linkstats.timestamp_ms = now;
+    }
+
+    for (i = 0; i < g_linkstats.qty; i++) {
+        if (strcmp(g_linkstats.entry[i].ifname, ifname) == 0) {
+            *tx_bytes = g_linkstats.entry[i].tx_bytes;
+            return true;
+        }
+    }
+
+    /* Not a failure, e.g. VAP created after the dump */
+    LOG(DEBUG, "Link stats: %s not found in link dump", ifname);
+    *tx_bytes = 0;
+    return true;
+}
+
+void ioctl80211_linkstats_cleanup(void)
+{
+    if (g_linkstats_fd >= 0) {
+        close(g_linkstats_fd);
+        g_linkstats_fd = -1;
+    }
+
+    FREE(g_linkstats.entry);
+    memset(&g_linkstats, 0, sizeof(g_linkstats));
+}
@@ -0,0 +1,428 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Persistent neighbor table
+ *
+ * Most neighbors do not change between two scans of a channel, yet
+ * every scan used to be reported in full. The table remembers every
+ * neighbor of a radio keyed by (BSSID, channel) along with a smoothed
+ * signal and the generation it last changed in. Scan results can then
+ * be trimmed down to new, changed and expired entries.
+ *
+ * Scan results are deduplicated on the same key through an open
+ * addressing hash table of 64-bit keys. Both scan variants share it.
+ *
+ * Multiple SSIDs of one AP are not merged. Vendors derive the BSSIDs
+ * of their VAPs differently, some vary the first and some the last
+ * bytes, so no BSSID mask tells the VAPs of one AP from neighboring
+ * APs of the same vendor. Each BSSID is reported on its own.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "util.h"
+#include "memutil.h"
+#include "ds_tree.h"
+
+#include "ioctl80211.h"
+#include "ioctl80211_neighbor.h"
+#include "ioctl80211_pool.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+/* Signal is smoothed (EWMA, 1/4 weight) in 1/16 dB units */
+#define IOCTL80211_NEIGHBOR_SIG_SHIFT       4
+#define IOCTL80211_NEIGHBOR_SIG_WEIGHT      2
+#define IOCTL80211_NEIGHBOR_SIG_DELTA       5       /* dB */
+/* Missing from a scan of its channel for this long */
+#define IOCTL80211_NEIGHBOR_MAX_AGE         120     /* s */
+/* Its channel was not scanned for this long */
+#define IOCTL80211_NEIGHBOR_STALE_AGE       1800    /* s */
+/* Table entries are pooled, this many per slab */
+#define IOCTL80211_NEIGHBOR_POOL_SLAB       64
+
+typedef struct
+{
+    uint64_t                        key;
+    dpp_neighbor_record_t           record;
+    time_t                          lastseen;
+    int32_t                         sig_avg;
+    int32_t                         sig_reported;
+    uint32_t                        gen;        /* generation of last change */
+    uint32_t                        seen_gen;   /* generation of last scan */
+    ds_tree_node_t                  node;
+} ioctl80211_neighbor_t;
+
+typedef struct
+{
+    char                            if_name[IOCTL80211_IFNAME_LEN];
+    ds_tree_t                       neighbors;
+    uint32_t                        gen;
+    ds_tree_node_t                  node;
+} ioctl80211_neighbor_radio_t;
+
+static ds_tree_t                    g_ioctl80211_neighbor_radios =
+    DS_TREE_INIT(ds_str_cmp, ioctl80211_neighbor_radio_t, node);
+
+static ioctl80211_pool_t            g_ioctl80211_neighbor_pool =
+    IOCTL80211_POOL_INIT("neighbor",
+                         ioctl80211_neighbor_t,
+                         IOCTL80211_NEIGHBOR_POOL_SLAB,
+                         IOCTL80211_NEIGHBOR_POOL_SLAB);
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static int ioctl80211_neighbor_key_cmp(const void *a, const void *b)
+{
+    const uint64_t             *x = a;
+    const uint64_t             *y = b;
+
+    return (*x > *y) - (*x < *y);
+}
+
+static ioctl80211_neighbor_radio_t *ioctl80211_neighbor_radio_get(
+        const char                 *if_name)
+{
+    ioctl80211_neighbor_radio_t    *radio;
+
+    radio = ds_tree_find(&g_ioctl80211_neighbor_radios, (void *)if_name);
+    if (radio)
+        return radio;
+
+    radio = CALLOC(1, sizeof(*radio));
+    STRSCPY(radio->if_name, if_name);
+    ds_tree_init(&radio->neighbors,
+                 ioctl80211_neighbor_key_cmp,
+                 ioctl80211_neighbor_t,
+                 node);
+    ds_tree_insert(&g_ioctl80211_neighbor_radios, radio, radio->if_name);
+
+    return radio;
+}
+
+static bool ioctl80211_neighbor_chan_scanned(
+        uint32_t                    chan,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num)
+{
+    uint32_t                        i;
+
+    for (i = 0; i < chan_num; i++)
+        if (chan_list[i] == chan)
+            return true;
+
+    return false;
+}
+
+/* Signals are negative (dBm) on some drivers, scale by multiplication
+ * and round half away from zero instead of shifting */
+static int32_t ioctl80211_neighbor_sig_put(int32_t sig)
+{
+    return sig * (1 << IOCTL80211_NEIGHBOR_SIG_SHIFT);
+}
+
+static int32_t ioctl80211_neighbor_sig_get(int32_t sig_avg)
+{
+    const int32_t                   unit = 1 << IOCTL80211_NEIGHBOR_SIG_SHIFT;
+
+    if (sig_avg < 0)
+        return -((unit / 2 - sig_avg) / unit);
+
+    return (sig_avg + unit / 2) / unit;
+}
+
+/* Fold a scanned record into the table, returns which kind of report
+ * it deserves (0 if unchanged).
+ */
+static uint32_t ioctl80211_neighbor_update(
+        ioctl80211_neighbor_radio_t *radio,
+        dpp_neighbor_record_t      *rec,
+        time_t                      now)
+{
+    ioctl80211_neighbor_t          *neighbor;
+    uint64_t                        key;
+    int32_t                         sig;
+
+    key = ioctl80211_neighbor_key(rec);
+    sig = ioctl80211_neighbor_sig_put(rec->sig);
+
+    neighbor = ds_tree_find(&radio->neighbors, &key);
+    if (!neighbor)
+    {
+        neighbor = ioctl80211_pool_alloc(&g_ioctl80211_neighbor_pool);
+        neighbor->key = key;
+        neighbor->sig_avg = sig;
+        neighbor->sig_reported = sig;
+        neighbor->gen = radio->gen;
+        neighbor->seen_gen = radio->gen;
+        neighbor->lastseen = now;
+        neighbor->record = *rec;
+        ds_tree_insert(&radio->neighbors, neighbor, &neighbor->key);
+        return IOCTL80211_NEIGHBOR_REPORT_NEW;
+    }
+
+    neighbor->sig_avg += (sig - neighbor->sig_avg) / (1 << IOCTL80211_NEIGHBOR_SIG_WEIGHT);
+    neighbor->seen_gen = radio->gen;
+    neighbor->lastseen = now;
+    neighbor->record = *rec;
+
+    /* Report the smoothed signal rather than a single sample */
+    rec->sig = ioctl80211_neighbor_sig_get(neighbor->sig_avg);
+
+    if (abs(neighbor->sig_avg - neighbor->sig_reported) >=
+            ioctl80211_neighbor_sig_put(IOCTL80211_NEIGHBOR_SIG_DELTA))
+    {
+        neighbor->gen = radio->gen;
+        return IOCTL80211_NEIGHBOR_REPORT_CHANGED;
+    }
+
+    return 0;
+}
+
+static void ioctl80211_neighbor_reported(
+        ioctl80211_neighbor_radio_t *radio,
+        dpp_neighbor_record_t      *rec)
+{
+    ioctl80211_neighbor_t          *neighbor;
+    uint64_t                        key;
+
+    key = ioctl80211_neighbor_key(rec);
+    neighbor = ds_tree_find(&radio->neighbors, &key);
+    if (neighbor)
+        neighbor->sig_reported = neighbor->sig_avg;
+}
+
+/* Returns false if the key was already in the table */
+static bool ioctl80211_neighbor_key_add(
+        uint64_t                   *slots,
+        uint32_t                    mask,
+        uint64_t                    key)
+{
+    uint32_t                        i;
+
+    i = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (slots[i])
+    {
+        if (slots[i] == key)
+            return false;
+        i = (i + 1) & mask;
+    }
+
+    slots[i] = key;
+    return true;
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+/* The BSSID string is folded into its 48-bit value, the channel goes
+ * above it and bit 63 is always set so that a key is never 0.
+ */
+uint64_t ioctl80211_neighbor_key(
+        const dpp_neighbor_record_t *rec)
+{
+    const char                     *p;
+    uint64_t                        key = 0;
+    int                             nibbles = 0;
+    int                             c;
+
+    for (p = rec->bssid; *p && nibbles < 12; p++)
+    {
+        c = *p | 0x20;
+        if (c >= '0' && c <= '9')
+            key = (key << 4) | (c - '0');
+        else if (c >= 'a' && c <= 'f')
+            key = (key << 4) | (c - 'a' + 10);
+        else
+            continue;
+        nibbles++;
+    }
+
+    return key | ((uint64_t)(rec->chan & 0x7fff) << 48) | (1ULL << 63);
+}
+
+/* Drops records that were not seen, are not on one of the scanned
+ * channels or repeat the key of an earlier record by clearing their
+ * lastseen. The first record of a key is kept. Returns the number of
+ * records left.
+ */
+uint32_t ioctl80211_neighbor_dedup(
+        dpp_neighbor_record_t      *recs,
+        uint32_t                    qty,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num)
+{
+    dpp_neighbor_record_t          *rec;
+    uint64_t                       *slots;
+    uint32_t                        slots_qty = 64;
+    uint32_t                        kept = 0;
+    uint32_t                        i;
+
+    /* Keep the table at most half full */
+    while (slots_qty < 2 * qty)
+        slots_qty <<= 1;
+    slots = CALLOC(slots_qty, sizeof(*slots));
+
+    for (i = 0; i < qty; i++)
+    {
+        rec = &recs[i];
+
+        if (!rec->lastseen)
+            continue;
+
+        if (!ioctl80211_neighbor_chan_scanned(rec->chan, chan_list, chan_num) ||
+            !ioctl80211_neighbor_key_add(slots,
+                                         slots_qty - 1,
+                                         ioctl80211_neighbor_key(rec)))
+        {
+            rec->lastseen = 0;
+            continue;
+        }
+
+        kept++;
+    }
+
+    FREE(slots);
+    return kept;
+}
+
+/* Updates the radio's neighbor table with a scan result list and trims
+ * the list down to the requested report. Expired neighbors are
+ * appended with their last seen record and a signal of 0.
+ */
+ioctl_status_t ioctl80211_neighbor_report(
+        radio_entry_t              *radio_cfg,
+        uint32_t                   *chan_list,
+        uint32_t                    chan_num,
+        uint32_t                    report,
+        dpp_neighbor_list_t        *neighbor_list)
+{
+    ioctl80211_neighbor_radio_t    *radio;
+    ioctl80211_neighbor_t          *neighbor;
+    dpp_neighbor_record_list_t     *rec;
+    ds_dlist_iter_t                 rec_iter;
+    ds_tree_iter_t                  iter;
+    uint32_t                        kind;
+    uint32_t                        qty_new = 0;
+    uint32_t                        qty_changed = 0;
+    uint32_t                        qty_expired = 0;
+    uint32_t                        qty_skipped = 0;
+    time_t                          now = time(NULL);
+    time_t                          age;
+
+    if (NULL == neighbor_list)
+    {
+        return IOCTL_STATUS_ERROR;
+    }
+
+    radio = ioctl80211_neighbor_radio_get(radio_cfg->if_name);
+    radio->gen++;
+
+    for (   rec = ds_dlist_ifirst(&rec_iter, neighbor_list);
+            rec != NULL;
+            rec = ds_dlist_inext(&rec_iter))
+    {
+        kind = ioctl80211_neighbor_update(radio, &rec->entry, now);
+        if (kind & IOCTL80211_NEIGHBOR_REPORT_NEW)
+            qty_new++;
+        if (kind & IOCTL80211_NEIGHBOR_REPORT_CHANGED)
+            qty_changed++;
+
+        if ((report & IOCTL80211_NEIGHBOR_REPORT_FULL) || (report & kind))
+        {
+            ioctl80211_neighbor_reported(radio, &rec->entry);
+            continue;
+        }
+
+        ds_dlist_iremove(&rec_iter);
+        dpp_neighbor_record_free(rec);
+        qty_skipped++;
+    }
+
+    for (   neighbor = ds_tree_ifirst(&iter, &radio->neighbors);
+            neighbor != NULL;
+            neighbor = ds_tree_inext(&iter))
+    {
+        if (neighbor->seen_gen == radio->gen)
+            continue;
+
+        age = now - neighbor->lastseen;
+        if (ioctl80211_neighbor_chan_scanned(neighbor->record.chan, chan_list, chan_num))
+        {
+            if (age < IOCTL80211_NEIGHBOR_MAX_AGE)
+                continue;
+        }
+        else if (age < IOCTL80211_NEIGHBOR_STALE_AGE)
+        {
+            continue;
+        }
+
+        if (report & IOCTL80211_NEIGHBOR_REPORT_EXPIRED)
+        {
+            rec = dpp_neighbor_record_alloc();
+            if (rec)
+            {
+                rec->entry = neighbor->record;
+                rec->entry.sig = 0;
+                ds_dlist_insert_tail(neighbor_list, rec);
+            }
+        }
+
+        LOG(TRACE,
+            "Parsing %s neighbor %s chan %u (expired after %ld s)",
+            radio_get_name_from_type(radio_cfg->type),
+            neighbor->record.bssid,
+            neighbor->record.chan,
+            (long)age);
+
+        ds_tree_iremove(&iter);
+        ioctl80211_pool_free(&g_ioctl80211_neighbor_pool, neighbor);
+        qty_expired++;
+    }
+
+    LOG(DEBUG,
+        "Parsing %s neighbor report gen %u (new %u changed %u expired %u unchanged %u)",
+        radio_get_name_from_type(radio_cfg->type),
+        radio->gen,
+        qty_new,
+        qty_changed,
+        qty_expired,
+        qty_skipped);
+
+    return IOCTL_STATUS_OK;
+}
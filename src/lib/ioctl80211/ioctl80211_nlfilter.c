@@ -0,0 +1,253 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Socket filters for RTMGRP_LINK listeners
+ *
+ * RTMGRP_LINK delivers every link message of the system: bridge, ethernet
+ * and GRE churn as well as each wireless event, probe requests included
+ * once WPS is enabled. Listeners only care about a few of them, filters
+ * let the kernel drop the rest instead of waking up the main loop.
+ *
+ * Classic BPF loads 16 and 32 bit words in network byte order while
+ * netlink is host order, hence constants are compared through htons().
+ * Attribute lookup is done by the SKF_AD_NLATTR extension.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/filter.h>
+
+#include "log.h"
+
+#include "ioctl80211_nlfilter.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+/* Jump targets resolved once the program is complete */
+#define NLFILTER_PASS                   -1
+#define NLFILTER_DROP                   -2
+
+#define NLFILTER_RET_PASS               0xffffffff
+#define NLFILTER_RET_DROP               0
+
+/* First attribute of a link message */
+#define NLFILTER_ATTR_OFF               (NLMSG_HDRLEN + NLMSG_ALIGN(sizeof(struct ifinfomsg)))
+/* Command of first iw_event: skip rtattr header and iw_event length */
+#define NLFILTER_IWE_CMD_OFF            (RTA_LENGTH(0) + sizeof(uint16_t))
+
+typedef struct
+{
+    struct sock_filter             *prog;
+    int                             len;
+    int                             max;
+    /* Symbolic jump targets, NLFILTER_PASS/DROP or 0 when relative */
+    int8_t                          jt[IOCTL80211_NLFILTER_PROG_MAX];
+    int8_t                          jf[IOCTL80211_NLFILTER_PROG_MAX];
+} ioctl80211_nlfilter_prog_t;
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static void ioctl80211_nlfilter_emit(
+        ioctl80211_nlfilter_prog_t *p,
+        uint16_t                    code,
+        uint32_t                    k,
+        int                         jt,
+        int                         jf)
+{
+    struct sock_filter              insn = { code, 0, 0, k };
+
+    if (p->len >= p->max || p->len >= IOCTL80211_NLFILTER_PROG_MAX) {
+        p->len++;
+        return;
+    }
+
+    if (jt >= 0) insn.jt = jt;
+    if (jf >= 0) insn.jf = jf;
+
+    p->jt[p->len] = jt < 0 ? jt : 0;
+    p->jf[p->len] = jf < 0 ? jf : 0;
+    p->prog[p->len++] = insn;
+}
+
+static int ioctl80211_nlfilter_resolve(
+        ioctl80211_nlfilter_prog_t *p,
+        int                         target,
+        int                         i)
+{
+    int                             off;
+
+    off = (target == NLFILTER_PASS ? p->len - 2 : p->len - 1) - i - 1;
+    if (off > 255) {
+        return -1;
+    }
+
+    return off;
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+int ioctl80211_nlfilter_build(
+        const ioctl80211_nlfilter_t    *filter,
+        struct sock_filter             *prog,
+        int                             prog_max)
+{
+    ioctl80211_nlfilter_prog_t      p;
+    int                             off;
+    int                             i;
+
+    memset(&p, 0, sizeof(p));
+    p.prog = prog;
+    p.max  = prog_max;
+
+    if (filter->iwe_qty > IOCTL80211_NLFILTER_IWE_MAX) {
+        return -1;
+    }
+
+    ioctl80211_nlfilter_emit(&p, BPF_LD  | BPF_H | BPF_ABS,
+                             offsetof(struct nlmsghdr, nlmsg_type), 0, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_DELLINK),
+                             filter->dellink ? NLFILTER_PASS : NLFILTER_DROP, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_NEWLINK),
+                             0, NLFILTER_DROP);
+
+    /* A = offset of IFLA_WIRELESS or 0 */
+    ioctl80211_nlfilter_emit(&p, BPF_LD  | BPF_IMM, NLFILTER_ATTR_OFF, 0, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_LDX | BPF_IMM, IFLA_WIRELESS, 0, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_LD  | BPF_W | BPF_ABS,
+                             SKF_AD_OFF + SKF_AD_NLATTR, 0, 0);
+
+    if (filter->newlink) {
+        ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, 0, NLFILTER_PASS, 0);
+    }
+    else if (filter->newlink_create || filter->newlink_rename) {
+        /* Link creation is announced with all change bits set, renames
+         * and other netdev notifier events with none. Flag changes carry
+         * the flags that changed.
+         */
+        ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, 0, 0,
+                                 filter->newlink_create && filter->newlink_rename ? 3 : 2);
+        ioctl80211_nlfilter_emit(&p, BPF_LD  | BPF_W | BPF_ABS,
+                                 NLMSG_HDRLEN + offsetof(struct ifinfomsg, ifi_change),
+                                 0, 0);
+        if (filter->newlink_create) {
+            ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, 0xffffffff,
+                                     NLFILTER_PASS,
+                                     filter->newlink_rename ? 0 : NLFILTER_DROP);
+        }
+        if (filter->newlink_rename) {
+            ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, 0,
+                                     NLFILTER_PASS, NLFILTER_DROP);
+        }
+    }
+    else {
+        ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K, 0, NLFILTER_DROP, 0);
+    }
+
+    if (filter->iwe_qty > 0) {
+        ioctl80211_nlfilter_emit(&p, BPF_MISC | BPF_TAX, 0, 0, 0);
+        ioctl80211_nlfilter_emit(&p, BPF_LD   | BPF_H | BPF_IND,
+                                 NLFILTER_IWE_CMD_OFF, 0, 0);
+    }
+
+    for (i = 0; i < filter->iwe_qty; i++) {
+        ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JEQ | BPF_K,
+                                 htons(filter->iwe_cmd[i]),
+                                 filter->iwe_drop ? NLFILTER_DROP : NLFILTER_PASS,
+                                 0);
+    }
+
+    ioctl80211_nlfilter_emit(&p, BPF_JMP | BPF_JA, 0,
+                             filter->iwe_drop ? NLFILTER_PASS : NLFILTER_DROP, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_RET | BPF_K, NLFILTER_RET_PASS, 0, 0);
+    ioctl80211_nlfilter_emit(&p, BPF_RET | BPF_K, NLFILTER_RET_DROP, 0, 0);
+
+    if (p.len > p.max || p.len > IOCTL80211_NLFILTER_PROG_MAX) {
+        return -1;
+    }
+
+    for (i = 0; i < p.len; i++) {
+        if ((prog[i].code & (BPF_CLASS(~0) | BPF_OP(~0))) == (BPF_JMP | BPF_JA)) {
+            /* Unconditional jumps keep the target in jt until here */
+            prog[i].k  = ioctl80211_nlfilter_resolve(&p, p.jt[i], i);
+            prog[i].jt = 0;
+            continue;
+        }
+        if (p.jt[i] < 0) {
+            if ((off = ioctl80211_nlfilter_resolve(&p, p.jt[i], i)) < 0) return -1;
+            prog[i].jt = off;
+        }
+        if (p.jf[i] < 0) {
+            if ((off = ioctl80211_nlfilter_resolve(&p, p.jf[i], i)) < 0) return -1;
+            prog[i].jf = off;
+        }
+    }
+
+    return p.len;
+}
+
+int ioctl80211_nlfilter_attach(
+        int                             fd,
+        const ioctl80211_nlfilter_t    *filter,
+        const char                     *name)
+{
+    struct sock_filter              prog[IOCTL80211_NLFILTER_PROG_MAX];
+    struct sock_fprog               fprog;
+    int                             len;
+
+    len = ioctl80211_nlfilter_build(filter, prog, IOCTL80211_NLFILTER_PROG_MAX);
+    if (len < 0) {
+        LOG(ERR, "%s: Failed to build netlink filter", name);
+        return -1;
+    }
+
+    memset(&fprog, 0, sizeof(fprog));
+    fprog.len    = len;
+    fprog.filter = prog;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        LOG(WARNING, "%s: Failed to attach netlink filter, errno = %d (%s)",
+            name, errno, strerror(errno));
+        return -1;
+    }
+
+    LOG(DEBUG, "%s: Attached netlink filter (%d insns)", name, len);
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * HT/VHT/HE phyrate table
+ *
+ * Data rate of a single spatial stream is:
+ *
+ *   data subcarriers * coded bits per subcarrier * coding rate
+ *   ----------------------------------------------------------
+ *                symbol duration (incl. guard)
+ *
+ * HT/VHT symbols last 3.2 us, HE symbols 12.8 us, both plus the guard
+ * interval. The table is computed once for every combination of phy,
+ * bandwidth, spatial streams, MCS and guard interval so that lookups
+ * are a plain array access. Combinations a phy does not define are 0:
+ * HE with 0.4 us GI, HT/VHT with 1.6 or 3.2 us GI, HT above 40 MHz, 4
+ * streams or MCS 7, VHT above MCS 9 and the VHT MCS/stream/bandwidth
+ * combinations whose symbol would not carry a whole number of bits.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ioctl80211_phyrate.h"
+
+typedef struct
+{
+    uint8_t                         bits;   /* coded bits per subcarrier */
+    uint8_t                         num;    /* coding rate */
+    uint8_t                         den;
+} ioctl80211_phyrate_mcs_t;
+
+static const ioctl80211_phyrate_mcs_t g_ioctl80211_phyrate_mcs[IOCTL80211_PHYRATE_MAX_MCS] =
+{
+    {  1, 1, 2 },   /* BPSK 1/2 */
+    {  2, 1, 2 },   /* QPSK 1/2 */
+    {  2, 3, 4 },   /* QPSK 3/4 */
+    {  4, 1, 2 },   /* 16-QAM 1/2 */
+    {  4, 3, 4 },   /* 16-QAM 3/4 */
+    {  6, 2, 3 },   /* 64-QAM 2/3 */
+    {  6, 3, 4 },   /* 64-QAM 3/4 */
+    {  6, 5, 6 },   /* 64-QAM 5/6 */
+    {  8, 3, 4 },   /* 256-QAM 3/4 */
+    {  8, 5, 6 },   /* 256-QAM 5/6 */
+    { 10, 3, 4 },   /* 1024-QAM 3/4 */
+    { 10, 5, 6 },   /* 1024-QAM 5/6 */
+};
+
+/* Data subcarriers per bandwidth. HE ones are 242, 484, 996 and 2x996
+ * tone RUs less pilots.
+ */
+static const uint16_t g_ioctl80211_phyrate_tones[IOCTL80211_PHY_QTY][IOCTL80211_PHYRATE_MAX_BW] =
+{
+    /* 20mhz 40mhz 80mhz 160mhz */
+    {  52,   108,  234,  468  },   /* HT */
+    {  52,   108,  234,  468  },   /* VHT */
+    {  234,  468,  980,  1960 },   /* HE */
+};
+
+static const uint16_t g_ioctl80211_phyrate_gi_ns[IOCTL80211_GI_QTY] =
+{
+    400, 800, 1600, 3200
+};
+
+static uint32_t g_ioctl80211_phyrate_table
+    [IOCTL80211_PHY_QTY]
+    [IOCTL80211_PHYRATE_MAX_BW]
+    [IOCTL80211_PHYRATE_MAX_NSS]
+    [IOCTL80211_PHYRATE_MAX_MCS]
+    [IOCTL80211_GI_QTY];
+static bool g_ioctl80211_phyrate_table_ready;
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static bool ioctl80211_phyrate_gi_valid(
+        ioctl80211_phy_t            phy,
+        ioctl80211_gi_t             gi)
+{
+    if (phy == IOCTL80211_PHY_HE)
+        return gi != IOCTL80211_GI_400;
+
+    return gi == IOCTL80211_GI_400 || gi == IOCTL80211_GI_800;
+}
+
+static bool ioctl80211_phyrate_mcs_valid(
+        ioctl80211_phy_t            phy,
+        int                         bw,
+        int                         nss,
+        int                         mcs)
+{
+    switch (phy)
+    {
+        case IOCTL80211_PHY_HT:
+            return bw <= 1 && nss <= 4 && mcs <= 7;
+        case IOCTL80211_PHY_VHT:
+            if (mcs > 9)
+                return false;
+            /* 802.11ac-2013 table 22-30 and following */
+            if (bw == 0 && mcs == 9)
+                return nss == 3 || nss == 6;
+            if (bw == 2 && mcs == 6)
+                return nss != 3 && nss != 7;
+            if (bw == 3 && mcs == 9)
+                return nss != 3;
+            return true;
+        default:
+            return true;
+    }
+}
+
+static void ioctl80211_phyrate_table_init(void)
+{
+    const ioctl80211_phyrate_mcs_t *m;
+    uint64_t                        bits;
+    uint32_t                        sym_ns;
+    int                             phy;
+    int                             bw;
+    int                             nss;
+    int                             mcs;
+    int                             gi;
+
+    for (phy = 0; phy < IOCTL80211_PHY_QTY; phy++)
+    for (bw = 0; bw < IOCTL80211_PHYRATE_MAX_BW; bw++)
+    for (nss = 0; nss < IOCTL80211_PHYRATE_MAX_NSS; nss++)
+    for (mcs = 0; mcs < IOCTL80211_PHYRATE_MAX_MCS; mcs++)
+    for (gi = 0; gi < IOCTL80211_GI_QTY; gi++)
+    {
+        if (!ioctl80211_phyrate_gi_valid(phy, gi) ||
+            !ioctl80211_phyrate_mcs_valid(phy, bw, nss + 1, mcs))
+            continue;
+
+        m = &g_ioctl80211_phyrate_mcs[mcs];
+        sym_ns = (phy == IOCTL80211_PHY_HE) ? 12800 : 3200;
+        sym_ns += g_ioctl80211_phyrate_gi_ns[gi];
+
+        /* bits per symbol over all streams, kbps = bits / us * 1000 */
+        bits = (uint64_t)g_ioctl80211_phyrate_tones[phy][bw] * m->bits * m->num * (nss + 1);
+        g_ioctl80211_phyrate_table[phy][bw][nss][mcs][gi] =
+            (bits * 1000000 + (m->den * sym_ns) / 2) / (m->den * sym_ns);
+    }
+
+    g_ioctl80211_phyrate_table_ready = true;
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+/* Returns phyrate in kbps. Bandwidth is 0 (20 MHz) to 3 (160 MHz), nss
+ * starts at 1. Out of range bandwidth, nss and MCS are clamped to the
+ * table, combinations the phy does not define give 0.
+ */
+uint32_t ioctl80211_phyrate_kbps(
+        ioctl80211_phy_t            phy,
+        int                         bw,
+        int                         nss,
+        int                         mcs,
+        ioctl80211_gi_t             gi)
+{
+    if (!g_ioctl80211_phyrate_table_ready)
+        ioctl80211_phyrate_table_init();
+
+    if ((unsigned)phy >= IOCTL80211_PHY_QTY || (unsigned)gi >= IOCTL80211_GI_QTY)
+        return 0;
+
+    if (bw < 0) bw = 0;
+    if (bw >= IOCTL80211_PHYRATE_MAX_BW) bw = IOCTL80211_PHYRATE_MAX_BW - 1;
+    if (nss < 1) nss = 1;
+    if (nss > IOCTL80211_PHYRATE_MAX_NSS) nss = IOCTL80211_PHYRATE_MAX_NSS;
+    if (mcs < 0) mcs = 0;
+    if (mcs >= IOCTL80211_PHYRATE_MAX_MCS) mcs = IOCTL80211_PHYRATE_MAX_MCS - 1;
+
+    return g_ioctl80211_phyrate_table[phy][bw][nss - 1][mcs][gi];
+}
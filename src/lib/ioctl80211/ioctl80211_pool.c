@@ -0,0 +1,191 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Slab pools for stats records
+ *
+ * Client and survey records are allocated for every sample and released
+ * once they are converted, the neighbor table churns with every scan.
+ * On small devices running for days this interleaving of differently
+ * sized allocations fragments the heap. Pools keep the records of one
+ * type together and recycle them, so memory stays at the high-water
+ * mark instead of creeping up.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "memutil.h"
+
+#include "ioctl80211_pool.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+typedef union ioctl80211_pool_slab
+{
+    union ioctl80211_pool_slab     *next;
+    /* Keep objects following the header aligned */
+    uint64_t                        align_u64;
+    void                           *align_ptr;
+    double                          align_dbl;
+} ioctl80211_pool_slab_t;
+
+/* Pools that allocated at least one slab */
+static ioctl80211_pool_t           *g_ioctl80211_pools = NULL;
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static size_t ioctl80211_pool_obj_size(const ioctl80211_pool_t *pool)
+{
+    const size_t                    align = sizeof(ioctl80211_pool_slab_t);
+
+    return (pool->obj_size + align - 1) / align * align;
+}
+
+static void ioctl80211_pool_grow(ioctl80211_pool_t *pool)
+{
+    ioctl80211_pool_slab_t         *slab;
+    uint8_t                        *obj;
+    size_t                          obj_size;
+    uint32_t                        qty;
+    uint32_t                        i;
+
+    qty = pool->slab_qty ? pool->grow : pool->prealloc;
+    if (qty == 0)
+        qty = 1;
+
+    obj_size = ioctl80211_pool_obj_size(pool);
+    slab = MALLOC(sizeof(*slab) + (obj_size * qty));
+
+    if (pool->slab_qty == 0)
+    {
+        pool->next = g_ioctl80211_pools;
+        g_ioctl80211_pools = pool;
+    }
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->slab_qty++;
+    pool->obj_qty += qty;
+
+    /* Push in reverse so that objects are handed out in address order */
+    obj = (uint8_t *)(slab + 1) + (obj_size * qty);
+    for (i = 0; i < qty; i++)
+    {
+        obj -= obj_size;
+        *(void **)obj = pool->free_list;
+        pool->free_list = obj;
+    }
+
+    LOG(INFO,
+        "Pool %s grew by %u objects (%zu bytes, slabs %u, objects %u, hwm %u)",
+        pool->name,
+        qty,
+        obj_size * qty,
+        pool->slab_qty,
+        pool->obj_qty,
+        pool->hwm);
+}
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+void *ioctl80211_pool_alloc(
+        ioctl80211_pool_t          *pool)
+{
+    void                           *obj;
+
+    if (pool->free_list == NULL)
+        ioctl80211_pool_grow(pool);
+
+    obj = pool->free_list;
+    pool->free_list = *(void **)obj;
+
+    pool->used++;
+    pool->allocs++;
+    if (pool->used > pool->hwm)
+        pool->hwm = pool->used;
+
+    memset(obj, 0, pool->obj_size);
+
+    return obj;
+}
+
+void ioctl80211_pool_free(
+        ioctl80211_pool_t          *pool,
+        void                       *obj)
+{
+    if (obj == NULL)
+        return;
+
+    if (pool->used == 0)
+    {
+        LOG(ERR, "Pool %s released more objects than allocated", pool->name);
+        return;
+    }
+
+    *(void **)obj = pool->free_list;
+    pool->free_list = obj;
+    pool->used--;
+}
+
+void ioctl80211_pool_report(void)
+{
+    ioctl80211_pool_t              *pool;
+
+    for (pool = g_ioctl80211_pools; pool != NULL; pool = pool->next)
+    {
+        LOG(INFO,
+            "Pool %s: used %u/%u objects (hwm %u, slabs %u, %zu bytes)",
+            pool->name,
+            pool->used,
+            pool->obj_qty,
+            pool->hwm,
+            pool->slab_qty,
+            pool->slab_qty * sizeof(ioctl80211_pool_slab_t) +
+            pool->obj_qty * ioctl80211_pool_obj_size(pool));
+    }
+}
+
+uint64_t ioctl80211_pool_alloc_count(void)
+{
+    ioctl80211_pool_t              *pool;
+    uint64_t                        allocs = 0;
+
+    for (pool = g_ioctl80211_pools; pool != NULL; pool = pool->next)
+    {
+        allocs += pool->allocs;
+    }
+
+    return allocs;
+}
@@ -53,6 +53,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "memutil.h"
 #include "ioctl80211.h"
 #include "ioctl80211_priv.h"
+#include "ioctl80211_trace.h"
 
 
 /***************************************************************************************/
@@ -98,6 +99,21 @@ int ioctl80211_priv_arg_size(int args)
     return num * size;
 }
 
+/*
+ * ioctl80211_priv_send: Issue a private request, len being the size of
+ * the buffer u.data.pointer refers to or 0 when arguments are inline
+ */
+static int
+ioctl80211_priv_send(ioctl80211_priv_data_t *priv_data, int cmd, struct iwreq *request, size_t len)
+{
+#ifdef CONFIG_QCA_IOCTL80211_TRACE
+    return ioctl80211_trace_iw_point_send(priv_data->fd, cmd, request, len);
+#else
+    (void)len;
+    return ioctl(priv_data->fd, cmd, request);
+#endif
+}
+
 
 /***************************************************************************************/
 
@@ -167,6 +183,7 @@ ioctl80211_priv_set_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
     struct iwreq            request;
     struct iw_priv_args    *args = NULL;
     int                     subcmd = 0, offset = 0, vlen, i, j;
+    size_t                  data_len = 0;
 
     // Find command information
     for (i = 0;i < priv_data->nargs;i++) {
@@ -223,6 +240,7 @@ ioctl80211_priv_set_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
     }
 
     // Finish setting up request
+    memset(&request, 0, sizeof(request));
     STRSCPY(request.ifr_name, priv_data->ifname);
 
     request.u.data.length = nvals;
@@ -236,9 +254,10 @@ ioctl80211_priv_set_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
     else {
         request.u.data.pointer = (caddr_t)vals;
         request.u.data.flags   = subcmd;
+        data_len = vlen;
     }
 
-    if (ioctl(priv_data->fd, args->cmd, &request) < 0) {
+    if (ioctl80211_priv_send(priv_data, args->cmd, &request, data_len) < 0) {
         LOGE("%s: priv SET-INT cmd '%s' failed, errno = %d", priv_data->ifname, cmd, errno);
         return false;
     }
@@ -260,6 +279,7 @@ ioctl80211_priv_get_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
     struct iw_priv_args    *args = NULL;
     char                    buf[4096];
     int                     subcmd = 0, vlen, i, j;
+    size_t                  data_len = 0;
 
     // Find command information
     for (i = 0;i < priv_data->nargs;i++) {
@@ -315,6 +335,7 @@ ioctl80211_priv_get_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
     }
 
     // Finish setting up request
+    memset(&request, 0, sizeof(request));
     STRSCPY(request.ifr_name, priv_data->ifname);
 
     request.u.data.length = 0; // Only getting values
@@ -325,11 +346,13 @@ ioctl80211_priv_get_int(ioctl80211_priv_t priv, const char *cmd, uint32_t *vals,
         }
     }
     else {
+        memset(buf, 0, sizeof(buf));
         request.u.data.pointer = (caddr_t)buf;
         request.u.data.flags   = subcmd;
+        data_len = sizeof(buf);
     }
 
-    if (ioctl(priv_data->fd, args->cmd, &request) < 0) {
+    if (ioctl80211_priv_send(priv_data, args->cmd, &request, data_len) < 0) {
         LOGE("%s: priv GET-INT cmd '%s' failed, errno = %d", priv_data->ifname, cmd, errno);
         return false;
     }
@@ -363,6 +386,7 @@ ioctl80211_priv_set(ioctl80211_priv_t priv, const char *cmd, void *buf, int len)
     struct iwreq            request;
     struct iw_priv_args    *args = NULL;
     int                     subcmd = 0, offset = 0, i, j;
+    size_t                  data_len = 0;
 
     // Find command information
     for (i = 0;i < priv_data->nargs;i++) {
@@ -414,6 +438,7 @@ ioctl80211_priv_set(ioctl80211_priv_t priv, const char *cmd, void *buf, int len)
     }
 
     // Finish setting up request
+    memset(&request, 0, sizeof(request));
     STRSCPY(request.ifr_name, priv_data->ifname);
 
     request.u.data.length = len;
@@ -427,9 +452,10 @@ ioctl80211_priv_set(ioctl80211_priv_t priv, const char *cmd, void *buf, int len)
     else {
         request.u.data.pointer = (caddr_t)buf;
         request.u.data.flags   = subcmd;
+        data_len = len;
     }
 
-    if (ioctl(priv_data->fd, args->cmd, &request) < 0) {
+    if (ioctl80211_priv_send(priv_data, args->cmd, &request, data_len) < 0) {
         LOGE("%s: priv SET cmd '%s' failed, errno = %d", priv_data->ifname, cmd, errno);
         return false;
     }
@@ -450,7 +476,8 @@ ioctl80211_priv_get(ioctl80211_priv_t priv, const char *cmd, void *dest, int *le
     struct iwreq            request;
     struct iw_priv_args    *args = NULL;
     char                    buf[4096];
-    int                     subcmd = 0, i, j;
+    int                     subcmd = 0, vlen, i, j;
+    size_t                  data_len = 0;
 
     if (*len > (int)sizeof(buf)) {
         *len = sizeof(buf);
@@ -503,6 +530,7 @@ ioctl80211_priv_get(ioctl80211_priv_t priv, const char *cmd, void *dest, int *le
     }
 
     // Finish setting up request
+    memset(&request, 0, sizeof(request));
     STRSCPY(request.ifr_name, priv_data->ifname);
 
     request.u.data.length = 0; // Only getting values
@@ -513,11 +541,13 @@ ioctl80211_priv_get(ioctl80211_priv_t priv, const char *cmd, void *dest, int *le
         }
     }
     else {
+        memset(buf, 0, sizeof(buf));
         request.u.data.pointer = (caddr_t)buf;
         request.u.data.flags   = subcmd;
+        data_len = sizeof(buf);
     }
 
-    if (ioctl(priv_data->fd, args->cmd, &request) < 0) {
+    if (ioctl80211_priv_send(priv_data, args->cmd, &request, data_len) < 0) {
         LOGE("%s: priv GET cmd '%s' failed, errno = %d", priv_data->ifname, cmd, errno);
         return false;
     }
@@ -528,8 +558,14 @@ ioctl80211_priv_get(ioctl80211_priv_t priv, const char *cmd, void *dest, int *le
         request.u.data.length = (args->get_args & IW_PRIV_SIZE_MASK);
     }
 
-    if (request.u.data.length > 0) {
-        memcpy(dest, buf, sizeof(buf));
+    vlen = ioctl80211_priv_arg_size((args->get_args & IW_PRIV_TYPE_MASK) |
+                                    (request.u.data.length & IW_PRIV_SIZE_MASK));
+    if (vlen > *len) {
+        vlen = *len;
+    }
+
+    if (vlen > 0) {
+        memcpy(dest, buf, vlen);
     }
 
     *len = request.u.data.length;
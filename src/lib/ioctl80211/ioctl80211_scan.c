@@ -43,9 +43,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "log.h"
 #include "const.h"
+#include "util.h"
+#include "memutil.h"
+#include "ds_tree.h"
 
 #include "ioctl80211.h"
 #include "ioctl80211_scan.h"
+#include "ioctl80211_neighbor.h"
+#include "ioctl80211_survey.h"
 
 #define MODULE_ID LOG_MODULE_ID_IOCTL
 
@@ -89,11 +94,36 @@ static ioctl80211_phymodee_t g_ioctl80211_phymode_table[] =
 
 typedef struct {
     radio_entry_t                  *radio_cfg;
+    uint32_t                        chan_list[IW_MAX_FREQUENCIES];
+    uint32_t                        chan_num;
     radio_scan_type_t               scan_type;
+    int32_t                         dwell_time;
+    bool                            rescan;     /* rescanned after overflow */
     ioctl80211_scan_cb_t           *scan_cb;
     void                           *scan_ctx;
 } ioctl80211_scan_request_t;
 
+/* Every radio has its own scan request, result polling timer and
+   result storage so that scans on different radios can be outstanding
+   at the same time. A scan requested while another one is in progress
+   on the same radio is queued and started once the first one completes.
+   Only the latest queued request is kept, an older one is completed
+   with failure.
+ */
+typedef struct {
+    char                            if_name[IOCTL80211_IFNAME_LEN];
+    ioctl80211_scan_request_t       request;
+    ioctl80211_scan_request_t       pending;
+    bool                            pending_valid;
+    ev_timer                        timer;
+    int32_t                         timeout;
+    char                           *results;
+    size_t                          results_capacity;
+    size_t                          results_size;
+    uint32_t                        overflows;
+    ds_tree_node_t                  node;
+} ioctl80211_scan_radio_t;
+
 #define IOCTL80211_SCAN_RESULT_POLL_TIME       (0.2)
 /* Need t owait 20s for FULL chan results */
 #define IOCTL80211_SCAN_RESULT_POLL_TIMEOUT    100 /* 100 * 0.2 = 20 sec */
@@ -101,19 +131,13 @@ typedef struct {
 /* The iwreq has an issue with length because it is only 16-bit therefore
    max buffer size is 0xFFFF (This is enough for approx 200 neighbors,
    depending on their SSID and some other extended extra string params).
- */
-#define IOCTL80211_SCAN_MAX_RESULTS     0xFFFF
-/* This is a global storage for all scans scheduled in FIFO g_scan_ctx_list
 
-   Having one global storage without locks is only possible because of FIFO
-   is preventing multiple access. The upper layer reads and coverts data from
-   this storage.
+   Result storage starts small and grows on E2BIG up to that limit.
  */
-static char                         g_iw_scan_results[IOCTL80211_SCAN_MAX_RESULTS];
-static size_t                       g_iw_scan_results_size;
+#define IOCTL80211_SCAN_MIN_RESULTS     0x2000
+#define IOCTL80211_SCAN_MAX_RESULTS     0xFFFF
 
-static  ev_timer                    g_scan_result_timer;
-static  int32_t                     g_scan_result_timeout;
+static ds_tree_t                    g_scan_radios = DS_TREE_INIT(ds_str_cmp, ioctl80211_scan_radio_t, node);
 
 
 /******************************************************************************
@@ -145,6 +169,176 @@ ioctl_status_t  ioctl80211_phymodee_to_chanwidth(
     return IOCTL_STATUS_OK;
 }
 
+static
+ioctl80211_scan_radio_t *ioctl80211_scan_radio_get(const char *if_name)
+{
+    ioctl80211_scan_radio_t        *scan_radio;
+
+    scan_radio = ds_tree_find(&g_scan_radios, (void *)if_name);
+    if (NULL == scan_radio)
+    {
+        scan_radio = CALLOC(1, sizeof(*scan_radio));
+        STRSCPY(scan_radio->if_name, if_name);
+        ds_tree_insert(&g_scan_radios, scan_radio, scan_radio->if_name);
+    }
+
+    return scan_radio;
+}
+
+static
+ioctl_status_t ioctl80211_scan_results_grow(
+        ioctl80211_scan_radio_t    *scan_radio,
+        size_t                      required)
+{
+    size_t                          capacity;
+
+    if (scan_radio->results_capacity >= IOCTL80211_SCAN_MAX_RESULTS)
+    {
+        return IOCTL_STATUS_ERROR;
+    }
+
+    capacity = scan_radio->results_capacity * 2;
+    if (capacity < required)
+    {
+        capacity = required;
+    }
+    if (capacity < IOCTL80211_SCAN_MIN_RESULTS)
+    {
+        capacity = IOCTL80211_SCAN_MIN_RESULTS;
+    }
+    if (capacity > IOCTL80211_SCAN_MAX_RESULTS)
+    {
+        capacity = IOCTL80211_SCAN_MAX_RESULTS;
+    }
+
+    scan_radio->results = REALLOC(scan_radio->results, capacity);
+    scan_radio->results_capacity = capacity;
+
+    LOG(DEBUG,
+        "Parsing %s scan (result storage grown to %zu bytes)",
+        scan_radio->if_name,
+        scan_radio->results_capacity);
+
+    return IOCTL_STATUS_OK;
+}
+
+/* When the results of a request didn't fit into the iwreq even at its
+   limit, the driver cache is flushed before the request is rescanned.
+   The cache then only holds the requested channels. Later requests
+   start with the cache intact again.
+ */
+static
+void ioctl80211_scan_cache_flush(
+        radio_entry_t              *radio_cfg,
+        ioctl80211_scan_radio_t    *scan_radio)
+{
+#ifdef CONFIG_QCA_SCAN_CACHE_FLUSH
+    struct iwreq                    request;
+    int                             rc;
+
+    if (!scan_radio->request.rescan)
+    {
+        return;
+    }
+
+    memset (&request, 0, sizeof(request));
+    request.u.mode = IEEE80211_IOC_SCAN_FLUSH;
+    rc =
+        ioctl80211_request_send(
+                ioctl80211_fd_get(),
+                radio_cfg->if_name,
+                IEEE80211_IOCTL_SETPARAM,
+                &request);
+    if (0 > rc)
+    {
+        LOG(WARNING,
+            "Initiating %s flush neighbor scan ('%s')",
+            radio_get_name_from_type(radio_cfg->type),
+            strerror(errno));
+    }
+#endif
+}
+
+/* Starts the driver scan of the radio's current request. Also used to
+   rescan the requested channels when the results outgrew the iwreq.
+ */
+static
+ioctl_status_t ioctl80211_scan_request_start(
+        ioctl80211_scan_radio_t    *scan_radio)
+{
+    ioctl80211_scan_request_t      *request_ctx = &scan_radio->request;
+    radio_entry_t                  *radio_cfg = request_ctx->radio_cfg;
+    radio_type_t                    radio_type = radio_cfg->type;
+    radio_scan_type_t               scan_type = request_ctx->scan_type;
+    int                             rc;
+    struct iwreq                    request;
+
+    /* Scan options fine tuning iw_scan_req (channel list we are interested in)
+       QSDK driver supports changes through SIOCGIWSCAN while on
+       LSDK driver we need to use direct scan on SSID using IEEE80211_IOC_SCAN_REQ
+     */
+    struct iw_scan_req              iw_scan_options;
+    int                             iw_scan_flags = 0;
+
+    memset(&iw_scan_options, 0, sizeof(iw_scan_options));
+    memset (&request, 0, sizeof(request));
+
+    /* Flush neighbor entries before scanning if they don't fit */
+    ioctl80211_scan_cache_flush(radio_cfg, scan_radio);
+
+    /* If channels are not specified use default driver params */
+    if (request_ctx->chan_num)
+    {
+        uint32_t    chan_index;
+
+        for (chan_index = 0; chan_index < request_ctx->chan_num; chan_index++)
+        {
+            iw_scan_options.channel_list[iw_scan_options.num_channels++].m =
+                request_ctx->chan_list[chan_index];
+        }
+
+        iw_scan_options.scan_type = IW_SCAN_TYPE_PASSIVE;
+        iw_scan_options.min_channel_time = request_ctx->dwell_time;
+        iw_scan_options.max_channel_time = request_ctx->dwell_time;
+        iw_scan_flags |= IW_SCAN_THIS_FREQ;
+
+        LOG(TRACE,
+            "Initiating %s %s scan %s (chan=%d num %d time %d)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type),
+            radio_cfg->if_name,
+            iw_scan_options.channel_list[0].m,
+            iw_scan_options.num_channels,
+            iw_scan_options.min_channel_time);
+    }
+
+    request.u.data.pointer = &iw_scan_options;
+    request.u.data.length = sizeof(iw_scan_options);
+    request.u.data.flags = iw_scan_flags;
+
+    /* Initiate wireless scanning */
+    rc =
+        ioctl80211_request_send(
+                ioctl80211_fd_get(),
+                radio_cfg->if_name,
+                SIOCSIWSCAN,
+                &request);
+    if (0 > rc)
+    {
+        LOG(ERR,
+            "Initiating %s %s scan (start '%s')",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type),
+            strerror(errno));
+        return IOCTL_STATUS_ERROR;
+    }
+
+    /* Survey counters change while the radio is off channel */
+    ioctl80211_survey_snapshot_invalidate(radio_cfg);
+
+    return IOCTL_STATUS_OK;
+}
+
 static
 ioctl_status_t ioctl80211_scan_result_timer_set(
         ev_timer                   *timer,
@@ -171,15 +365,8 @@ ioctl_status_t ioctl80211_scan_extract_neighbors_from_ssids(
         uint32_t                    scan_result_qty,
         dpp_neighbor_list_t        *neighbor_list)
 {
-#define LAST_5_BYTE_EQ(bssid1, bssid2)  (strncmp(bssid1+3, bssid2+3, 14) == 0)
-#define BSSID_CMP(bssid1, bssid2)       strcmp(bssid1+8, bssid2+8)
     dpp_neighbor_record_t          *rec_new;
     uint32_t                        rec_new_count=0;
-    dpp_neighbor_record_t          *rec_cmp;
-    uint32_t                        rec_cmp_count=0;
-
-    uint32_t                        chan_index;
-    uint32_t                        chan_found = false;
 
     dpp_neighbor_record_list_t     *neighbor = NULL;
     dpp_neighbor_record_t          *neighbor_entry = NULL;
@@ -192,83 +379,25 @@ ioctl_status_t ioctl80211_scan_extract_neighbors_from_ssids(
         return IOCTL_STATUS_ERROR;
     }
 
-    /* Remove multiple SSID's per neighbor AP */
+    /* Remove duplicate entries per neighbor AP and entries that are
+       not on a scanned channel, see ioctl80211_neighbor_dedup() */
+    ioctl80211_neighbor_dedup(
+            scan_results,
+            scan_result_qty,
+            chan_list,
+            chan_num);
+
     for (   rec_new_count = 0;
             rec_new_count < scan_result_qty;
             rec_new_count++)
     {
         rec_new = &scan_results[rec_new_count];
 
-        /* Skip entries that are not seen */
         if (!rec_new->lastseen)
         {
             continue;
         }
 
-        /* Skip entries that are not on scanned channel */
-        chan_found = false;
-        for (   chan_index = 0;
-                chan_index < chan_num;
-                chan_index++)
-        {
-            if (rec_new->chan == chan_list[chan_index])
-            {
-                chan_found = true;
-                break;
-            }
-        }
-
-        if (!chan_found)
-        {
-            continue;
-        }
-
-        /* Find duplicate entries and mark them not seen */
-        for (   rec_cmp_count = rec_new_count + 1;
-                rec_cmp_count < scan_result_qty;
-                rec_cmp_count++)
-        {
-            rec_cmp = &scan_results[rec_cmp_count];
-
-            if (rec_new->chan != rec_cmp->chan)
-            {
-                continue;
-            }
-
-#if 0       /* Different vendors have different BSSID assignments,
-               some change the first and some last bytes of BSSID
-             */
-
-            /* Skip multiple SSID's on same neighbor */
-            if (LAST_5_BYTE_EQ(rec_new->bssid, rec_cmp->bssid))
-            {
-                ACLA_LOG(TRACE,
-                        "Removed multiple SSID %s (%s) == %s (%s)",
-                        rec_new->ssid,
-                        rec_new->bssid,
-                        rec_cmp->ssid,
-                        rec_cmp->bssid);
-
-                /* Send the highest BSSID (TODO: Check why?) */
-                if (BSSID_CMP(rec_new->bssid, rec_cmp->bssid) > 0)
-                {
-                    memcpy(rec_new->bssid, rec_cmp->bssid, 6);
-                }
-
-                /* Mark entry as not seen to be removed */
-                rec_cmp->lastseen = 0;
-                continue;
-            }
-#endif
-
-            /* Skip duplicate entries */
-            if (strcmp(rec_new->bssid, rec_cmp->bssid) == 0)
-            {
-                rec_cmp->lastseen = 0;
-                continue;
-            }
-        }
-
         neighbor = 
             dpp_neighbor_record_alloc();
         if (NULL == neighbor)
@@ -475,8 +604,10 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
 
     int                             scan_status = false;
 
+    ioctl80211_scan_radio_t        *scan_radio =
+        (ioctl80211_scan_radio_t *) w->data;
     ioctl80211_scan_request_t      *request_ctx =
-        (ioctl80211_scan_request_t *) w->data;
+        &scan_radio->request;
     radio_entry_t                  *radio_cfg_ctx = 
         request_ctx->radio_cfg;
     radio_type_t                    radio_type = 
@@ -489,14 +620,18 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
        We poll in steps of 250ms, max waiting time is 5s.
      */
 
-    /* Reset global storage for every scan! */
-    memset (&g_iw_scan_results, 0, sizeof(g_iw_scan_results));
-    g_iw_scan_results_size = 0;
+    /* Reset radio storage for every scan! */
+    scan_radio->results_size = 0;
+    if (NULL == scan_radio->results)
+    {
+        ioctl80211_scan_results_grow(scan_radio, IOCTL80211_SCAN_MIN_RESULTS);
+    }
 
+retry:
     /* Try to read the results */
     memset (&request, 0, sizeof(request));
-    request.u.data.pointer = g_iw_scan_results;
-    request.u.data.length = sizeof(g_iw_scan_results);
+    request.u.data.pointer = scan_radio->results;
+    request.u.data.length = scan_radio->results_capacity;
 
     rc = 
         ioctl80211_request_send(
@@ -514,7 +649,7 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
                 radio_get_name_from_type(radio_type),
                 radio_get_scan_name_from_type(scan_type));
 
-            if (--g_scan_result_timeout > 0)
+            if (--scan_radio->timeout > 0)
             {
                 goto restart_timer;
             }
@@ -526,13 +661,52 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
             goto exit;
         }
 
-        /* Scanning is finished but needs more space for results */
+        /* Scanning is finished but needs more space for results. The
+           kernel reports the length it needs if it knows it.
+         */
         if (errno == E2BIG)
         {
+            if (IOCTL_STATUS_OK ==
+                    ioctl80211_scan_results_grow(scan_radio, request.u.data.length))
+            {
+                goto retry;
+            }
+
+            scan_radio->overflows++;
+
+            /* The kernel copies nothing back on E2BIG. Flush the cache
+               and scan the requested channels once more so that at
+               least their results fit, truncating the rest. On-channel
+               requests only read the cache, there is nothing to rescan.
+             */
+            if (!request_ctx->rescan && scan_type != RADIO_SCAN_TYPE_ONCHAN)
+            {
+                LOG(WARNING,
+                    "Parsing %s %s scan (E2BIG issue, results exceed %d bytes,"
+                    " rescanning requested channels only, overflows %u)",
+                    radio_get_name_from_type(radio_type),
+                    radio_get_scan_name_from_type(scan_type),
+                    IOCTL80211_SCAN_MAX_RESULTS,
+                    scan_radio->overflows);
+
+                request_ctx->rescan = true;
+                if (IOCTL_STATUS_OK ==
+                        ioctl80211_scan_request_start(scan_radio))
+                {
+                    scan_radio->timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
+                    goto restart_timer;
+                }
+                goto exit;
+            }
+
             LOG(ERR,
-                "Parsing %s %s scan (E2BIG issue)",
+                "Parsing %s %s scan (E2BIG issue, results exceed %d bytes"
+                "%s, overflows %u)",
                 radio_get_name_from_type(radio_type),
-                radio_get_scan_name_from_type(scan_type));
+                radio_get_scan_name_from_type(scan_type),
+                IOCTL80211_SCAN_MAX_RESULTS,
+                request_ctx->rescan ? " after rescan" : "",
+                scan_radio->overflows);
             goto exit;
         }
 
@@ -547,11 +721,11 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
 
     /* Mark results scan_status */
     scan_status = true;
-    g_iw_scan_results_size = request.u.data.length;
+    scan_radio->results_size = request.u.data.length;
 
 exit:
     ioctl80211_scan_result_timer_set(w, false);
-    g_scan_result_timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
+    scan_radio->timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
 
 clean:
     /* Notify upper layer about scan status (blocking) */
@@ -560,6 +734,31 @@ clean:
         request_ctx->scan_cb(request_ctx->scan_ctx, scan_status);
     }
 
+    /* The callback may have started a new scan itself, in that case the
+       queued request stays queued behind it.
+     */
+    if (scan_radio->pending_valid && !ev_is_active(&scan_radio->timer))
+    {
+        ioctl80211_scan_request_t   pending = scan_radio->pending;
+
+        scan_radio->pending_valid = false;
+        if (IOCTL_STATUS_OK !=
+                ioctl80211_scan_channel(
+                    pending.radio_cfg,
+                    pending.chan_list,
+                    pending.chan_num,
+                    pending.scan_type,
+                    pending.dwell_time,
+                    pending.scan_cb,
+                    pending.scan_ctx))
+        {
+            if (pending.scan_cb)
+            {
+                pending.scan_cb(pending.scan_ctx, false);
+            }
+        }
+    }
+
 restart_timer:
     return;
 }
@@ -578,10 +777,60 @@ ioctl_status_t ioctl80211_scan_channel(
         ioctl80211_scan_cb_t       *scan_cb,
         void                       *scan_ctx)
 {
-    int                             rc;
-    struct iwreq                    request;
     radio_type_t                    radio_type = radio_cfg->type;
-    static ioctl80211_scan_request_t scan_request;  /* TODO unify sm_scan_request */
+    ioctl80211_scan_radio_t        *scan_radio;
+    ioctl80211_scan_request_t      *request_ctx;
+    uint32_t                        chan_index;
+
+    if (chan_num > IW_MAX_FREQUENCIES)
+    {
+        LOG(WARNING,
+            "Initiating %s %s scan (%u channels requested, scanning first %d)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type),
+            chan_num,
+            IW_MAX_FREQUENCIES);
+        chan_num = IW_MAX_FREQUENCIES;
+    }
+
+    scan_radio = ioctl80211_scan_radio_get(radio_cfg->if_name);
+    request_ctx = &scan_radio->request;
+    if (ev_is_active(&scan_radio->timer))
+    {
+        if (scan_radio->pending_valid && scan_radio->pending.scan_cb)
+        {
+            LOG(DEBUG,
+                "Initiating %s %s scan (replacing queued %s scan)",
+                radio_get_name_from_type(radio_type),
+                radio_get_scan_name_from_type(scan_type),
+                radio_get_scan_name_from_type(scan_radio->pending.scan_type));
+            scan_radio->pending.scan_cb(scan_radio->pending.scan_ctx, false);
+        }
+
+        LOG(DEBUG,
+            "Initiating %s %s scan (queued, previous scan still in progress)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type));
+        request_ctx = &scan_radio->pending;
+        scan_radio->pending_valid = true;
+    }
+
+    memset (request_ctx, 0, sizeof(*request_ctx));
+    request_ctx->radio_cfg  = radio_cfg;
+    for (chan_index = 0; chan_index < chan_num; chan_index++)
+    {
+        request_ctx->chan_list[chan_index] = chan_list[chan_index];
+    }
+    request_ctx->chan_num   = chan_num;
+    request_ctx->scan_type  = scan_type;
+    request_ctx->dwell_time = dwell_time;
+    request_ctx->scan_cb    = scan_cb;
+    request_ctx->scan_ctx   = scan_ctx;
+
+    if (request_ctx == &scan_radio->pending)
+    {
+        return IOCTL_STATUS_OK;
+    }
 
     /* Scan is composed of two parts
        - SIOCSIWSCAN : start scanning when possible
@@ -592,96 +841,19 @@ ioctl_status_t ioctl80211_scan_channel(
      */
     if (scan_type != RADIO_SCAN_TYPE_ONCHAN)
     {
-        /* Scan options fine tuning iw_scan_req (channel list we are interested in)
-           QSDK driver supports changes through SIOCGIWSCAN while on
-           LSDK driver we need to use direct scan on SSID using IEEE80211_IOC_SCAN_REQ
-         */
-        struct iw_scan_req              iw_scan_options;
-        int                             iw_scan_flags = 0;
-
-        memset(&iw_scan_options, 0, sizeof(iw_scan_options));
-#if 0
-        /* Flush neighbor entries before scanning */
-        memset (&request, 0, sizeof(request));
-        request.u.mode = IEEE80211_IOC_SCAN_FLUSH;
-        rc =
-            ioctl80211_request_send(
-                    ioctl80211_fd_get(),
-                    radio_cfg_ctx->if_name,
-                    IEEE80211_IOCTL_SETPARAM,
-                    &request);
-        if (0 > rc)
+        if (IOCTL_STATUS_OK != ioctl80211_scan_request_start(scan_radio))
         {
-            LOG (ERR,
-                    "Parsing %s flush neighbor scan",
-                    radio_get_name_from_type(radio_type));
-            return IOCTL_STATUS_ERROR;
-        }
-#endif
-
-        /* If channels are not specified use default driver params */
-        if (chan_num)
-        {
-            uint32_t    chan_index;
-
-            memset (&request, 0, sizeof(request));
-
-            for (chan_index = 0; chan_index < chan_num; chan_index++)
-            {
-                iw_scan_options.channel_list[iw_scan_options.num_channels++].m =
-                    chan_list[chan_index];
-            }
-
-            iw_scan_options.scan_type = IW_SCAN_TYPE_PASSIVE;
-            iw_scan_options.min_channel_time = dwell_time;
-            iw_scan_options.max_channel_time = dwell_time;
-            iw_scan_flags |= IW_SCAN_THIS_FREQ;
-
-           LOG(TRACE,
-                "Initiating %s %s scan %s (chan=%d num %d time %d)",
-                radio_get_name_from_type(radio_type),
-                radio_get_scan_name_from_type(scan_type),
-                radio_cfg->if_name,
-                iw_scan_options.channel_list[0].m,
-                iw_scan_options.num_channels,
-                iw_scan_options.min_channel_time);
-        }
-
-        request.u.data.pointer = &iw_scan_options;
-        request.u.data.length = sizeof(iw_scan_options);
-        request.u.data.flags = iw_scan_flags;
-
-        /* Initiate wireless scanning */
-        rc = 
-            ioctl80211_request_send(
-                    ioctl80211_fd_get(),
-                    radio_cfg->if_name,
-                    SIOCSIWSCAN,
-                    &request);
-        if (0 > rc)
-        {
-            LOG(ERR,
-                "Initiating %s %s scan (start '%s')",
-                radio_get_name_from_type(radio_type),
-                radio_get_scan_name_from_type(scan_type),
-                strerror(errno));
             return IOCTL_STATUS_ERROR;
         }
     }
 
-    memset (&scan_request, 0, sizeof(scan_request));
-    scan_request.radio_cfg  = radio_cfg;
-    scan_request.scan_type  = scan_type;
-    scan_request.scan_cb    = scan_cb;
-    scan_request.scan_ctx   = scan_ctx;
-
     /* Start result polling timer */
-    ev_init (&g_scan_result_timer, ioctl80211_scan_results_fetch);
-    g_scan_result_timer.repeat =  IOCTL80211_SCAN_RESULT_POLL_TIME;
-    g_scan_result_timer.data = &scan_request;
-    ioctl80211_scan_result_timer_set(&g_scan_result_timer, true);
+    ev_init (&scan_radio->timer, ioctl80211_scan_results_fetch);
+    scan_radio->timer.repeat =  IOCTL80211_SCAN_RESULT_POLL_TIME;
+    scan_radio->timer.data = scan_radio;
+    ioctl80211_scan_result_timer_set(&scan_radio->timer, true);
     /* Set timeout ... */
-    g_scan_result_timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
+    scan_radio->timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
 
     return IOCTL_STATUS_OK;
 }
@@ -701,26 +873,28 @@ ioctl_status_t ioctl80211_scan_results_get(
     uint32_t                        scan_result_qty = 0;
     dpp_neighbor_record_t          *scan_record = NULL;
     bool                            parse_error = false;;
+    ioctl80211_scan_radio_t        *scan_radio;
 
     if (NULL == scan_results)
     {
         return IOCTL_STATUS_ERROR;
     }
     radio_type = radio_cfg->type;
+    scan_radio = ds_tree_find(&g_scan_radios, radio_cfg->if_name);
 
     /* Driver returns buffer as event list. Traverse through it and
        parse required events.
      */
     memset (scan_records, 0, sizeof(scan_records));
-    if (g_iw_scan_results_size)
+    if ((NULL != scan_radio) && scan_radio->results_size)
     {
         struct iw_event    *iw_event;
         char               *ptr;
         uint32_t            len;
         //uint32_t            payload_len;;
 
-        ptr = g_iw_scan_results;
-        len = g_iw_scan_results_size;
+        ptr = scan_radio->results;
+        len = scan_radio->results_size;
 
         /* Traverse through results and extract iw_event TLVs */
         while (len > IW_EV_LCP_LEN) {
@@ -728,7 +902,7 @@ ioctl_status_t ioctl80211_scan_results_get(
             iw_event = (struct iw_event *) ptr;
 
             /* Malformed stream or end of buffer */
-            if (len < iw_event->len) {
+            if (len < iw_event->len || iw_event->len == 0) {
                 break;
             }
 
@@ -749,6 +923,8 @@ ioctl_status_t ioctl80211_scan_results_get(
             /* Skip entry events in case of parser error */
             if (true == parse_error)
             {
+                ptr += iw_event->len;
+                len -= iw_event->len;
                 continue;
             }
 
@@ -811,7 +987,14 @@ ioctl_status_t ioctl80211_scan_stop(
         radio_entry_t              *radio_cfg,
         radio_scan_type_t           scan_type)
 {
-    ioctl80211_scan_result_timer_set(&g_scan_result_timer, false);
+    ioctl80211_scan_radio_t        *scan_radio;
+
+    scan_radio = ds_tree_find(&g_scan_radios, radio_cfg->if_name);
+    if (NULL != scan_radio)
+    {
+        ioctl80211_scan_result_timer_set(&scan_radio->timer, false);
+        scan_radio->pending_valid = false;
+    }
 
     return IOCTL_STATUS_OK;
 }
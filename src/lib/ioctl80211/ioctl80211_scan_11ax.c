@@ -40,34 +40,69 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 #include <sys/socket.h>
 #include <linux/types.h>
+#include <inttypes.h>
 
 #include "log.h"
 #include "const.h"
+#include "kconfig.h"
+#include "ds_tree.h"
 
 #include "ioctl80211.h"
 #include "ioctl80211_scan.h"
+#include "ioctl80211_neighbor.h"
+#include "ioctl80211_survey.h"
 
 #define MODULE_ID LOG_MODULE_ID_IOCTL
 
 #define OSYNC_IOCTL_LIB 5
 #define IOCTL80211_SCAN_QUEUE_TRACE     0
-#define IOCTL80211_SCAN_MAX_RECORDS     300
-#define IOCTL80211_MAX_ESSID_QTY        8
+#define IOCTL80211_SCAN_ARENA_MIN_QTY   64
+
+#ifndef CONFIG_QCA_SCAN_MAX_NEIGHBORS
+#define CONFIG_QCA_SCAN_MAX_NEIGHBORS   2400
+#endif
 
 #define IOCTL80211_MAX_NEIGHBOR_SIZE    (256 * 1024)  /* 256k limit */
 #define IOCTL80211_DRIVER_NOISE         -95
 
 #define IOCTL80211_SCAN_MAX_RESULTS     0x40000
-/* This is a global storage for all scans scheduled in FIFO g_scan_ctx_list
-   
-   Having one global storage wthout locks is only possible because of FIFO
-   is preventing multiple access. The upper layer reads and coverts data from 
-   this storage
+
+/* Scan results are parsed straight into a per radio neighbor arena as
+   they arrive from the driver. Arenas persist across scans and only
+   grow (up to CONFIG_QCA_SCAN_MAX_NEIGHBORS records) so a steady state
+   scan does not allocate. The upper layer reads and converts data
+   from the arena of its radio.
+
+   Only the scan being fetched (g_scan_arena) is fed; scans are
+   scheduled in FIFO g_scan_ctx_list which prevents multiple access.
  */
-static const size_t                 g_iw_scan_results_capacity = IOCTL80211_SCAN_MAX_RESULTS;
+typedef struct
+{
+    char                            if_name[IOCTL80211_IFNAME_LEN];
+    radio_type_t                    radio_type;
+    dpp_neighbor_record_t          *records;
+    uint32_t                        qty;
+    uint32_t                        capacity;
+    uint32_t                        overflows;
+    uint64_t                        overflows_total;
+    char                           *carry;      /* record split across chunks */
+    size_t                          carry_len;
+    size_t                          carry_size;
+    ds_tree_node_t                  node;
+} ioctl80211_scan_arena_t;
+
+static ds_tree_t                    g_scan_arenas = DS_TREE_INIT(ds_str_cmp, ioctl80211_scan_arena_t, node);
+static ioctl80211_scan_arena_t     *g_scan_arena;
+
+static void ioctl80211_scan_arena_feed(
+        ioctl80211_scan_arena_t    *arena,
+        const char                 *data,
+        size_t                      len);
+
+#ifndef OPENSYNC_NL_SUPPORT
+/* Wireless extensions need a buffer to copy the results into */
 static char                         g_iw_scan_results[IOCTL80211_SCAN_MAX_RESULTS];
-static size_t                       g_iw_scan_results_size;
-static unsigned int                 res_len;
+#endif
 #include "osync_nl80211_11ax.h"
 
 #define IEEE80211_GET_MODE_MASK         0x03
@@ -179,15 +214,8 @@ ioctl_status_t ioctl80211_scan_extract_neighbors_from_ssids(
         uint32_t                    scan_result_qty,
         dpp_neighbor_list_t        *neighbor_list)
 {
-#define LAST_5_BYTE_EQ(bssid1, bssid2)  (strncmp(bssid1+3, bssid2+3, 14) == 0)
-#define BSSID_CMP(bssid1, bssid2)       strcmp(bssid1+8, bssid2+8)
     dpp_neighbor_record_t          *rec_new;
     uint32_t                        rec_new_count=0;
-    dpp_neighbor_record_t          *rec_cmp;
-    uint32_t                        rec_cmp_count=0;
-
-    uint32_t                        chan_index;
-    uint32_t                        chan_found = false;
 
     dpp_neighbor_record_list_t     *neighbor = NULL;
     dpp_neighbor_record_t          *neighbor_entry = NULL;
@@ -200,83 +228,25 @@ ioctl_status_t ioctl80211_scan_extract_neighbors_from_ssids(
         return IOCTL_STATUS_ERROR;
     }
 
-    /* Remove multiple SSID's per neighbor AP */
+    /* Remove duplicate entries per neighbor AP and entries that are
+       not on a scanned channel, see ioctl80211_neighbor_dedup() */
+    ioctl80211_neighbor_dedup(
+            scan_results,
+            scan_result_qty,
+            chan_list,
+            chan_num);
+
     for (   rec_new_count = 0;
             rec_new_count < scan_result_qty;
             rec_new_count++)
     {
         rec_new = &scan_results[rec_new_count];
 
-        /* Skip entries that are not seen */
         if (!rec_new->lastseen)
         {
             continue;
         }
 
-        /* Skip entries that are not on scanned channel */
-        chan_found = false;
-        for (   chan_index = 0;
-                chan_index < chan_num;
-                chan_index++)
-        {
-            if (rec_new->chan == chan_list[chan_index])
-            {
-                chan_found = true;
-                break;
-            }
-        }
-
-        if (!chan_found)
-        {
-            continue;
-        }
-
-        /* Find duplicate entries and mark them not seen */
-        for (   rec_cmp_count = rec_new_count + 1;
-                rec_cmp_count < scan_result_qty;
-                rec_cmp_count++)
-        {
-            rec_cmp = &scan_results[rec_cmp_count];
-
-            if (rec_new->chan != rec_cmp->chan)
-            {
-                continue;
-            }
-
-#if 0       /* Different vendors have different BSSID assignments,
-               some change the first and some last bytes of BSSID
-             */
-
-            /* Skip multiple SSID's on same neighbor */
-            if (LAST_5_BYTE_EQ(rec_new->bssid, rec_cmp->bssid))
-            {
-                ACLA_LOG(TRACE,
-                        "Removed multiple SSID %s (%s) == %s (%s)",
-                        rec_new->ssid,
-                        rec_new->bssid,
-                        rec_cmp->ssid,
-                        rec_cmp->bssid);
-
-                /* Send the highest BSSID (TODO: Check why?) */
-                if (BSSID_CMP(rec_new->bssid, rec_cmp->bssid) > 0)
-                {
-                    memcpy(rec_new->bssid, rec_cmp->bssid, 6);
-                }
-
-                /* Mark entry as not seen to be removed */
-                rec_cmp->lastseen = 0;
-                continue;
-            }
-#endif
-
-            /* Skip duplicate entries */
-            if (strcmp(rec_new->bssid, rec_cmp->bssid) == 0)
-            {
-                rec_cmp->lastseen = 0;
-                continue;
-            }
-        }
-
         neighbor = 
             dpp_neighbor_record_alloc();
         if (NULL == neighbor)
@@ -562,6 +532,151 @@ ioctl_status_t ioctl80211_scan_results_parse(
     return IOCTL_STATUS_OK;
 }
 
+static
+ioctl80211_scan_arena_t *ioctl80211_scan_arena_get(radio_entry_t *radio_cfg)
+{
+    ioctl80211_scan_arena_t        *arena;
+
+    arena = ds_tree_find(&g_scan_arenas, radio_cfg->if_name);
+    if (NULL == arena)
+    {
+        arena = CALLOC(1, sizeof(*arena));
+        STRSCPY(arena->if_name, radio_cfg->if_name);
+        ds_tree_insert(&g_scan_arenas, arena, arena->if_name);
+    }
+
+    arena->radio_type = radio_cfg->type;
+    arena->qty = 0;
+    arena->overflows = 0;
+    arena->carry_len = 0;
+
+    return arena;
+}
+
+static
+dpp_neighbor_record_t *ioctl80211_scan_arena_record_new(
+        ioctl80211_scan_arena_t    *arena)
+{
+    uint32_t                        capacity;
+
+    if (arena->qty == arena->capacity)
+    {
+        if (arena->capacity >= CONFIG_QCA_SCAN_MAX_NEIGHBORS)
+        {
+            arena->overflows++;
+            arena->overflows_total++;
+            return NULL;
+        }
+
+        capacity = arena->capacity ? arena->capacity * 2 : IOCTL80211_SCAN_ARENA_MIN_QTY;
+        if (capacity > CONFIG_QCA_SCAN_MAX_NEIGHBORS)
+        {
+            capacity = CONFIG_QCA_SCAN_MAX_NEIGHBORS;
+        }
+
+        arena->records = REALLOC(arena->records, capacity * sizeof(*arena->records));
+        arena->capacity = capacity;
+
+        LOG(DEBUG,
+            "Parsing %s scan (neighbor arena grown to %u records)",
+            radio_get_name_from_type(arena->radio_type),
+            arena->capacity);
+    }
+
+    return &arena->records[arena->qty];
+}
+
+/* Parses complete scan results out of the stream and returns the
+   number of bytes consumed. A trailing partial result is left over.
+ */
+static
+size_t ioctl80211_scan_arena_parse(
+        ioctl80211_scan_arena_t    *arena,
+        const char                 *ptr,
+        size_t                      len)
+{
+    const struct ieee80211req_scan_result *sr;
+    dpp_neighbor_record_t          *scan_record;
+    size_t                          consumed = 0;
+    ioctl_status_t                  status;
+
+    while (len - consumed >= sizeof(*sr))
+    {
+        /* Point to next scan result */
+        sr = (const struct ieee80211req_scan_result *) (ptr + consumed);
+
+        /* Malformed stream, drop the rest of it */
+        if (sr->isr_len == 0)
+        {
+            return len;
+        }
+
+        /* Result continues in the next chunk */
+        if (len - consumed < sr->isr_len)
+        {
+            break;
+        }
+        consumed += sr->isr_len;
+
+        scan_record = ioctl80211_scan_arena_record_new(arena);
+        if (NULL == scan_record)
+        {
+            continue;
+        }
+
+        memset (scan_record, 0, sizeof(*scan_record));
+        status =
+            ioctl80211_scan_results_parse (
+                    arena->radio_type,
+                    sr,
+                    scan_record);
+        if (IOCTL_STATUS_OK == status)
+        {
+            arena->qty++;
+        }
+    }
+
+    return consumed;
+}
+
+static void ioctl80211_scan_arena_feed(
+        ioctl80211_scan_arena_t    *arena,
+        const char                 *data,
+        size_t                      len)
+{
+    size_t                          consumed;
+
+    if (NULL == arena)
+    {
+        return;
+    }
+
+    /* Common case: chunks hold whole results, parse them in place */
+    if (0 == arena->carry_len)
+    {
+        consumed = ioctl80211_scan_arena_parse(arena, data, len);
+        data += consumed;
+        len -= consumed;
+        if (0 == len)
+        {
+            return;
+        }
+    }
+
+    /* Stash the partial result until the rest of it arrives */
+    if (arena->carry_len + len > arena->carry_size)
+    {
+        arena->carry_size = arena->carry_len + len;
+        arena->carry = REALLOC(arena->carry, arena->carry_size);
+    }
+    memcpy(arena->carry + arena->carry_len, data, len);
+    arena->carry_len += len;
+
+    consumed = ioctl80211_scan_arena_parse(arena, arena->carry, arena->carry_len);
+    memmove(arena->carry, arena->carry + consumed, arena->carry_len - consumed);
+    arena->carry_len -= consumed;
+}
+
 static
 void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
 {
@@ -583,13 +698,17 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
        We poll in steps of 250ms, max waiting time is 5s.
      */
 
-    /* Reset global storage for every scan! */
-    memset (&g_iw_scan_results, 0, sizeof(g_iw_scan_results));
-    g_iw_scan_results_size = 0;
-    res_len = 0;
+    /* Reset radio storage for every scan! */
+    g_scan_arena = ioctl80211_scan_arena_get(radio_cfg_ctx);
 
     /* Try to read the results */
     rc = osync_nl80211_scan_results_fetch(radio_cfg_ctx);
+#ifndef OPENSYNC_NL_SUPPORT
+    if (0 <= rc)
+    {
+        ioctl80211_scan_arena_feed(g_scan_arena, g_iw_scan_results, rc);
+    }
+#endif
     if (0 > rc)
     {
         /* Scanning is still in progress ... come back later */
@@ -631,10 +750,31 @@ void ioctl80211_scan_results_fetch(EV_P_ ev_timer *w, int revents)
         goto exit;
     }
 
+    if (g_scan_arena->carry_len)
+    {
+        LOG(WARNING,
+            "Parsing %s %s scan (dropped %zu bytes of truncated results)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type),
+            g_scan_arena->carry_len);
+    }
+
+    if (g_scan_arena->overflows)
+    {
+        LOG(WARNING,
+            "Parsing %s %s scan (dropped %u of %u neighbors over limit, %"PRIu64" total)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type),
+            g_scan_arena->overflows,
+            g_scan_arena->qty + g_scan_arena->overflows,
+            g_scan_arena->overflows_total);
+    }
+
     /* Mark results scan_status */
     scan_status = true;
 
 exit:
+    g_scan_arena = NULL;
     ioctl80211_scan_result_timer_set(w, false);
     g_scan_result_timeout = IOCTL80211_SCAN_RESULT_POLL_TIMEOUT;
 
@@ -795,6 +935,9 @@ ioctl_status_t ioctl80211_scan_channel(
                strerror(errno));
              return IOCTL_STATUS_ERROR;
          }
+
+        /* Survey counters change while the radio is off channel */
+        ioctl80211_survey_snapshot_invalidate(radio_cfg);
     }
 
     memset (&scan_request, 0, sizeof(scan_request));
@@ -824,10 +967,7 @@ ioctl_status_t ioctl80211_scan_results_get(
     ioctl_status_t                  rc;
     radio_type_t                    radio_type;
 
-    ioctl_status_t                  status;
-    dpp_neighbor_record_t           scan_records[IOCTL80211_SCAN_MAX_RECORDS * IOCTL80211_MAX_ESSID_QTY];
-    uint32_t                        scan_result_qty = 0;
-    dpp_neighbor_record_t          *scan_record = NULL;
+    ioctl80211_scan_arena_t        *arena;
 
     if (NULL == scan_results)
     {
@@ -835,50 +975,14 @@ ioctl_status_t ioctl80211_scan_results_get(
     }
     radio_type = radio_cfg->type;
 
-    memset (scan_records, 0, sizeof(scan_records));
-    if (g_iw_scan_results_size)
+    arena = ds_tree_find(&g_scan_arenas, radio_cfg->if_name);
+    if ((NULL == arena) || (0 == arena->qty))
     {
-        const struct ieee80211req_scan_result *sr;
-        char               *ptr;
-        uint32_t            len;
-
-        ptr = g_iw_scan_results;
-        len = g_iw_scan_results_size;
-
-        while (len >= sizeof(*sr)) {
-            /* Point to next scan result */
-            sr = (struct ieee80211req_scan_result *) ptr;
-
-            /* Malformed stream or end of buffer */
-            if (len < sr->isr_len || sr->isr_len == 0) {
-                break;
-            }
-
-            /* Point to new scan record entry. */
-            scan_record = &scan_records[scan_result_qty];
-            if (scan_result_qty >= ARRAY_SIZE(scan_records))
-            {
-                break;
-            }
-            scan_result_qty++;
-
-            status = 
-                ioctl80211_scan_results_parse (
-                        radio_type,
-                        sr,
-                        scan_record);
-            if (IOCTL_STATUS_OK != status)
-            {
-                /* Clear previous data in case of error */
-                memset (scan_record, 0, sizeof(dpp_neighbor_record_t));
-
-                /* Resent entry count */
-                scan_result_qty--;
-            }
-
-            ptr += sr->isr_len;
-            len -= sr->isr_len;
-        }
+        LOG(TRACE,
+            "Parsed %s %s scan results (no neighbors)",
+            radio_get_name_from_type(radio_type),
+            radio_get_scan_name_from_type(scan_type));
+        return IOCTL_STATUS_OK;
     }
 
     /* Remove multiple SSID's per neighbor AP and
@@ -893,8 +997,8 @@ ioctl_status_t ioctl80211_scan_results_get(
                 chan_list,
                 chan_num,
                 scan_type,
-                scan_records,
-                scan_result_qty,
+                arena->records,
+                arena->qty,
                 &scan_results->list);
     if (IOCTL_STATUS_OK != rc)
     {
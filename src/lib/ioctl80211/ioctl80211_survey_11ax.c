@@ -44,6 +44,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "log.h"
 #include "const.h"
+#include "util.h"
+#include "memutil.h"
+#include "ds_tree.h"
 
 #include "ioctl80211.h"
 #include "ioctl80211_survey.h"
@@ -57,11 +60,51 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CFG80211_GET_CHAN_SURVEY_SCAN_CHANNEL_STATS (2)
 #endif
 
+#ifndef CONFIG_QCA_STATS_POOL_SURVEYS
+#define CONFIG_QCA_STATS_POOL_SURVEYS 64
+#endif
+
+ioctl80211_pool_t                   g_ioctl80211_survey_pool =
+    IOCTL80211_POOL_INIT("survey",
+                         ioctl80211_survey_record_t,
+                         CONFIG_QCA_STATS_POOL_SURVEYS,
+                         16);
+
 uint32_t                        g_chan_idx;
 extern struct socket_context    sock_ctx;
 struct ps_uapi_ioctl            g_bss_data;
 struct ps_uapi_ioctl            g_chan_data;
 
+/* Survey tables fetched from the driver are reused by all survey and
+   capacity queries of a radio until they are older than the requested
+   age, the radio changed channel or a scan on the radio invalidates them.
+   A channel is reported at most once per fetch so consecutive survey
+   samples never cover a zero length interval.
+ */
+#define IOCTL80211_SURVEY_CHAN_MAX      256
+
+typedef struct
+{
+    struct ps_uapi_ioctl            data;
+    uint64_t                        timestamp_ms;   /* fetch time, 0 when invalid */
+    uint32_t                        chan;           /* radio channel at fetch */
+    /* Off-channel: channel number -> channels[] index + 1 */
+    uint16_t                        chan_index[IOCTL80211_SURVEY_CHAN_MAX];
+    /* Channel number -> fetch time it was last reported with */
+    uint64_t                        reported_ms[IOCTL80211_SURVEY_CHAN_MAX];
+} ioctl80211_survey_snapshot_t;
+
+typedef struct
+{
+    char                            phy_name[IOCTL80211_IFNAME_LEN];
+    ioctl80211_survey_snapshot_t    onchan;
+    ioctl80211_survey_snapshot_t    offchan;
+    ds_tree_node_t                  node;
+} ioctl80211_survey_radio_t;
+
+static ds_tree_t                    g_survey_radios =
+    DS_TREE_INIT(ds_str_cmp, ioctl80211_survey_radio_t, node);
+
 enum qca_wlan_generic_data {
     QCA_WLAN_VENDOR_ATTR_GENERIC_PARAM_INVALID = 0,
     QCA_WLAN_VENDOR_ATTR_PARAM_DATA,
@@ -265,19 +308,16 @@ void parse_channel_survey_stats_cb(struct cfg80211_data *arg)
 }
 #endif
 
-ioctl_status_t ioctl80211_survey_results_get(
-        radio_entry_t              *radio_cfg,
-        uint32_t                   *chan_list,
-        uint32_t                    chan_num,
+static ioctl_status_t
+ioctl80211_survey_fetch(
+        const radio_entry_t        *radio_cfg,
         radio_scan_type_t           scan_type,
-        ds_dlist_t                 *survey_list)
+        uint32_t                    chan,
+        struct ps_uapi_ioctl       *data)
 {
     int32_t                         rc;
-    struct ps_uapi_ioctl            data;
-    radio_type_t                    radio_type = radio_cfg->type;
-    ioctl80211_survey_record_t     *survey_record;
 
-    memset (&data, 0, sizeof(data));
+    memset (data, 0, sizeof(*data));
 
 #ifdef OPENSYNC_NL_SUPPORT
     u_int32_t                       index;
@@ -285,6 +325,8 @@ ioctl_status_t ioctl80211_survey_results_get(
     struct cfg80211_data            arg;
     u32                             cmd;
 
+    (void)chan;
+
     cmd =
         (RADIO_SCAN_TYPE_ONCHAN == scan_type) ?
         PS_UAPI_IOCTL_CMD_SURVEY_BSS :
@@ -308,31 +350,32 @@ ioctl_status_t ioctl80211_survey_results_get(
     }
 
     if (PS_UAPI_IOCTL_CMD_SURVEY_BSS == cmd) {
-        data.u.survey_bss.get.total     = g_bss_data.u.survey_bss.get.total;
-        data.u.survey_bss.get.busy      = g_bss_data.u.survey_bss.get.busy;
-        data.u.survey_bss.get.tx        = g_bss_data.u.survey_bss.get.tx;
-        data.u.survey_bss.get.rx_bss    = g_bss_data.u.survey_bss.get.rx_bss;
-        data.u.survey_bss.get.rx        = g_bss_data.u.survey_bss.get.rx;
-        data.u.survey_bss.get.busy_ext  = g_bss_data.u.survey_bss.get.busy_ext;
-        data.u.survey_bss.get.nf        = g_bss_data.u.survey_bss.get.nf;
+        data->u.survey_bss.get.total     = g_bss_data.u.survey_bss.get.total;
+        data->u.survey_bss.get.busy      = g_bss_data.u.survey_bss.get.busy;
+        data->u.survey_bss.get.tx        = g_bss_data.u.survey_bss.get.tx;
+        data->u.survey_bss.get.rx_bss    = g_bss_data.u.survey_bss.get.rx_bss;
+        data->u.survey_bss.get.rx        = g_bss_data.u.survey_bss.get.rx;
+        data->u.survey_bss.get.busy_ext  = g_bss_data.u.survey_bss.get.busy_ext;
+        data->u.survey_bss.get.nf        = g_bss_data.u.survey_bss.get.nf;
     } else {
         for (index = 0; index < g_chan_idx; index++) {
-            data.u.survey_chan.get.channels[index].freq  = g_chan_data.u.survey_chan.get.channels[index].freq;
-            data.u.survey_chan.get.channels[index].total = g_chan_data.u.survey_chan.get.channels[index].total;
-            data.u.survey_chan.get.channels[index].busy  = g_chan_data.u.survey_chan.get.channels[index].busy;
-            data.u.survey_chan.get.channels[index].tx    = g_chan_data.u.survey_chan.get.channels[index].tx;
-            data.u.survey_chan.get.channels[index].rx    = g_chan_data.u.survey_chan.get.channels[index].rx;
-            data.u.survey_chan.get.channels[index].nf    = g_chan_data.u.survey_chan.get.channels[index].nf;
+            data->u.survey_chan.get.channels[index].freq  = g_chan_data.u.survey_chan.get.channels[index].freq;
+            data->u.survey_chan.get.channels[index].total = g_chan_data.u.survey_chan.get.channels[index].total;
+            data->u.survey_chan.get.channels[index].busy  = g_chan_data.u.survey_chan.get.channels[index].busy;
+            data->u.survey_chan.get.channels[index].tx    = g_chan_data.u.survey_chan.get.channels[index].tx;
+            data->u.survey_chan.get.channels[index].rx    = g_chan_data.u.survey_chan.get.channels[index].rx;
+            data->u.survey_chan.get.channels[index].nf    = g_chan_data.u.survey_chan.get.channels[index].nf;
         }
 #ifdef CONFIG_PLATFORM_QCA_QSDK11_SUB_VER4
         g_chan_idx = 0;
 #endif
     }
 #else
+    radio_type_t                    radio_type = radio_cfg->type;
     struct iwreq                    request;
 
     memset (&request, 0, sizeof(request));
-    request.u.data.pointer = &data;
+    request.u.data.pointer = data;
     request.u.data.length = PS_UAPI_IOCTL_SIZE;
 
  /*   data.cmd =
@@ -351,7 +394,7 @@ ioctl_status_t ioctl80211_survey_results_get(
              " (Failed to set params '%s')",
              radio_get_name_from_type(radio_type),
              radio_get_scan_name_from_type(scan_type),
-             chan_list[0],
+             chan,
              strerror(errno));
         return IOCTL_STATUS_ERROR;
     }
@@ -367,12 +410,149 @@ ioctl_status_t ioctl80211_survey_results_get(
              " (Failed to get params '%s')",
              radio_get_name_from_type(radio_type),
              radio_get_scan_name_from_type(scan_type),
-             chan_list[0],
+             chan,
              strerror(errno));
         return IOCTL_STATUS_ERROR;
     }
 #endif
 
+    return IOCTL_STATUS_OK;
+}
+
+static ioctl80211_survey_radio_t *
+ioctl80211_survey_radio_get(
+        const char                 *phy_name)
+{
+    ioctl80211_survey_radio_t      *survey_radio;
+
+    survey_radio = ds_tree_find(&g_survey_radios, (void *)phy_name);
+    if (NULL == survey_radio)
+    {
+        survey_radio = CALLOC(1, sizeof(*survey_radio));
+        STRSCPY(survey_radio->phy_name, phy_name);
+        ds_tree_insert(&g_survey_radios, survey_radio, survey_radio->phy_name);
+    }
+
+    return survey_radio;
+}
+
+static void
+ioctl80211_survey_snapshot_index(
+        ioctl80211_survey_snapshot_t *snapshot)
+{
+    const struct ps_uapi_ioctl     *data = &snapshot->data;
+    uint32_t                        stats_index;
+    uint32_t                        stats_chan;
+
+    memset(snapshot->chan_index, 0, sizeof(snapshot->chan_index));
+
+    for (   stats_index = 0;
+            stats_index < ARRAY_SIZE(data->u.survey_chan.get.channels);
+            stats_index++) {
+        if (data->u.survey_chan.get.channels[stats_index].freq == 0) {
+            continue;
+        }
+
+        stats_chan =
+            radio_get_chan_from_mhz(
+                data->u.survey_chan.get.channels[stats_index].freq);
+        if (stats_chan >= IOCTL80211_SURVEY_CHAN_MAX) {
+            continue;
+        }
+
+        /* First entry of a channel wins */
+        if (snapshot->chan_index[stats_chan] == 0) {
+            snapshot->chan_index[stats_chan] = stats_index + 1;
+        }
+    }
+}
+
+static bool
+ioctl80211_survey_snapshot_reported(
+        const ioctl80211_survey_snapshot_t *snapshot,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num)
+{
+    uint32_t                        chan_index;
+
+    for (chan_index = 0; chan_index < chan_num; chan_index++) {
+        if (chan_list[chan_index] < IOCTL80211_SURVEY_CHAN_MAX &&
+            snapshot->reported_ms[chan_list[chan_index]] == snapshot->timestamp_ms) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static ioctl80211_survey_snapshot_t *
+ioctl80211_survey_snapshot_get(
+        const radio_entry_t        *radio_cfg,
+        radio_scan_type_t           scan_type,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num,
+        uint64_t                    max_age_ms)
+{
+    ioctl80211_survey_radio_t      *survey_radio;
+    ioctl80211_survey_snapshot_t   *snapshot;
+    uint64_t                        now = get_timestamp();
+    uint32_t                        chan = chan_num ? chan_list[0] : radio_cfg->chan;
+
+    survey_radio = ioctl80211_survey_radio_get(radio_cfg->phy_name);
+    snapshot = (RADIO_SCAN_TYPE_ONCHAN == scan_type) ?
+               &survey_radio->onchan :
+               &survey_radio->offchan;
+
+    if (snapshot->timestamp_ms != 0 &&
+        now - snapshot->timestamp_ms <= max_age_ms &&
+        snapshot->chan == radio_cfg->chan &&
+        !ioctl80211_survey_snapshot_reported(snapshot, chan_list, chan_num)) {
+        LOGT("Reusing %s %s survey snapshot (age %"PRIu64" ms)",
+             radio_get_name_from_type(radio_cfg->type),
+             radio_get_scan_name_from_type(scan_type),
+             now - snapshot->timestamp_ms);
+        return snapshot;
+    }
+
+    snapshot->timestamp_ms = 0;
+
+    if (ioctl80211_survey_fetch(radio_cfg, scan_type, chan, &snapshot->data) != IOCTL_STATUS_OK)
+        return NULL;
+
+    if (RADIO_SCAN_TYPE_ONCHAN != scan_type) {
+        ioctl80211_survey_snapshot_index(snapshot);
+    }
+
+    snapshot->chan = radio_cfg->chan;
+    snapshot->timestamp_ms = get_timestamp();
+
+    return snapshot;
+}
+
+ioctl_status_t ioctl80211_survey_results_get(
+        radio_entry_t              *radio_cfg,
+        uint32_t                   *chan_list,
+        uint32_t                    chan_num,
+        radio_scan_type_t           scan_type,
+        ds_dlist_t                 *survey_list)
+{
+    ioctl80211_survey_snapshot_t   *snapshot;
+    const struct ps_uapi_ioctl     *data;
+    radio_type_t                    radio_type = radio_cfg->type;
+    ioctl80211_survey_record_t     *survey_record;
+
+    snapshot =
+        ioctl80211_survey_snapshot_get(
+                radio_cfg,
+                scan_type,
+                chan_list,
+                chan_num,
+                IOCTL80211_SURVEY_SNAPSHOT_MAX_AGE);
+    if (NULL == snapshot)
+        return IOCTL_STATUS_ERROR;
+
+    data = &snapshot->data;
+
     uint32_t    chan_index = 0;
     for (chan_index = 0; chan_index < chan_num; chan_index++) {
         survey_record = 
@@ -387,15 +567,15 @@ ioctl_status_t ioctl80211_survey_results_get(
 
         if (RADIO_SCAN_TYPE_ONCHAN == scan_type) {
             survey_record->info.chan = chan_list[chan_index];
-            survey_record->info.timestamp_ms = get_timestamp();
+            survey_record->info.timestamp_ms = snapshot->timestamp_ms;
 
-            survey_record->stats.survey_bss.chan_active   = data.u.survey_bss.get.total;
-            survey_record->stats.survey_bss.chan_busy     = data.u.survey_bss.get.busy;
-            survey_record->stats.survey_bss.chan_tx       = data.u.survey_bss.get.tx;
-            survey_record->stats.survey_bss.chan_self     = data.u.survey_bss.get.rx_bss;
-            survey_record->stats.survey_bss.chan_rx       = data.u.survey_bss.get.rx;
-            survey_record->stats.survey_bss.chan_busy_ext = data.u.survey_bss.get.busy_ext;
-            survey_record->stats.survey_bss.chan_noise    = data.u.survey_bss.get.nf;
+            survey_record->stats.survey_bss.chan_active   = data->u.survey_bss.get.total;
+            survey_record->stats.survey_bss.chan_busy     = data->u.survey_bss.get.busy;
+            survey_record->stats.survey_bss.chan_tx       = data->u.survey_bss.get.tx;
+            survey_record->stats.survey_bss.chan_self     = data->u.survey_bss.get.rx_bss;
+            survey_record->stats.survey_bss.chan_rx       = data->u.survey_bss.get.rx;
+            survey_record->stats.survey_bss.chan_busy_ext = data->u.survey_bss.get.busy_ext;
+            survey_record->stats.survey_bss.chan_noise    = data->u.survey_bss.get.nf;
 
             LOGT("Fetched %s %s %u survey "
                  "{active=%"PRIu64" busy=%"PRIu64" tx=%"PRIu64" self=%"PRIu64""
@@ -412,34 +592,25 @@ ioctl_status_t ioctl80211_survey_results_get(
                  survey_record->stats.survey_bss.chan_noise);
         }
         else {
-            uint32_t    stats_chan = 0;
             uint32_t    stats_index = 0;
 
-            for (   stats_index = 0;
-                    stats_index < ARRAY_SIZE(data.u.survey_chan.get.channels);
-                    stats_index++) {
-                if (data.u.survey_chan.get.channels[stats_index].freq == 0) {
-                    continue;
-                }
-
-                stats_chan = 
-                    radio_get_chan_from_mhz(
-                        data.u.survey_chan.get.channels[stats_index].freq);
+            if (chan_list[chan_index] < IOCTL80211_SURVEY_CHAN_MAX) {
+                stats_index = snapshot->chan_index[chan_list[chan_index]];
+            }
 
-                if (chan_list[chan_index] != stats_chan) {
-                    continue;
-                }
+            if (stats_index != 0) {
+                stats_index--;
 
                 survey_record->info.chan = chan_list[chan_index];
-                survey_record->info.timestamp_ms = get_timestamp();
+                survey_record->info.timestamp_ms = snapshot->timestamp_ms;
 
-                survey_record->stats.survey_obss.chan_active  = data.u.survey_chan.get.channels[stats_index].total,
-                survey_record->stats.survey_obss.chan_busy    = data.u.survey_chan.get.channels[stats_index].busy,
-                survey_record->stats.survey_obss.chan_tx      = data.u.survey_chan.get.channels[stats_index].tx,
+                survey_record->stats.survey_obss.chan_active  = data->u.survey_chan.get.channels[stats_index].total,
+                survey_record->stats.survey_obss.chan_busy    = data->u.survey_chan.get.channels[stats_index].busy,
+                survey_record->stats.survey_obss.chan_tx      = data->u.survey_chan.get.channels[stats_index].tx,
                 survey_record->stats.survey_obss.chan_self    = 0,
-                survey_record->stats.survey_obss.chan_rx      = data.u.survey_chan.get.channels[stats_index].rx,
+                survey_record->stats.survey_obss.chan_rx      = data->u.survey_chan.get.channels[stats_index].rx,
                 survey_record->stats.survey_obss.chan_busy_ext = 0;
-                survey_record->stats.survey_obss.chan_noise   = data.u.survey_chan.get.channels[stats_index].nf;
+                survey_record->stats.survey_obss.chan_noise   = data->u.survey_chan.get.channels[stats_index].nf;
 
                 LOGT("Fetched %s %s %u survey "
                      "{active=%u busy=%u tx=%u self=%u rx=%u ext=%u nf=%d}",
@@ -453,12 +624,13 @@ ioctl_status_t ioctl80211_survey_results_get(
                      survey_record->stats.survey_obss.chan_rx,
                      survey_record->stats.survey_obss.chan_busy_ext,
                      survey_record->stats.survey_obss.chan_noise);
-                // channel found, exit loop
-                break;
             }
         }
 
         if (survey_record->info.chan != 0) {
+            if (survey_record->info.chan < IOCTL80211_SURVEY_CHAN_MAX) {
+                snapshot->reported_ms[survey_record->info.chan] = snapshot->timestamp_ms;
+            }
             ds_dlist_insert_tail(survey_list, survey_record);
         }
         else {
@@ -474,6 +646,37 @@ ioctl_status_t ioctl80211_survey_results_get(
     return IOCTL_STATUS_OK;
 }
 
+const struct ps_uapi_ioctl *ioctl80211_survey_snapshot_data_get(
+        radio_entry_t              *radio_cfg,
+        radio_scan_type_t           scan_type,
+        uint64_t                    max_age_ms)
+{
+    ioctl80211_survey_snapshot_t   *snapshot;
+
+    snapshot =
+        ioctl80211_survey_snapshot_get(
+                radio_cfg,
+                scan_type,
+                NULL,
+                0,
+                max_age_ms);
+
+    return snapshot ? &snapshot->data : NULL;
+}
+
+void ioctl80211_survey_snapshot_invalidate(
+        radio_entry_t              *radio_cfg)
+{
+    ioctl80211_survey_radio_t      *survey_radio;
+
+    survey_radio = ds_tree_find(&g_survey_radios, radio_cfg->phy_name);
+    if (NULL == survey_radio)
+        return;
+
+    survey_radio->onchan.timestamp_ms = 0;
+    survey_radio->offchan.timestamp_ms = 0;
+}
+
 ioctl_status_t ioctl80211_survey_results_convert(
         radio_entry_t              *radio_cfg,
         radio_scan_type_t           scan_type,
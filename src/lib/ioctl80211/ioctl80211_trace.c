@@ -0,0 +1,800 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Driver request trace
+ *
+ * Stats parsers depend on driver buffer layouts which are hard to
+ * reproduce off the device. When enabled, every request sent to the
+ * driver is written along with its response and timing to a bounded
+ * trace. The same trace can be served back in place of the driver
+ * to run and profile the conversion code on a host.
+ *
+ * Replies a request delivers through a callback are recorded right after
+ * the request, driver events where they were received. Replay passes
+ * both back in the same order.
+ *
+ * Tracing is single threaded like the rest of ioctl80211.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <linux/wireless.h>
+
+#include "log.h"
+#include "const.h"
+#include "util.h"
+#include "memutil.h"
+
+#include "ioctl80211.h"
+#include "ioctl80211_trace.h"
+
+#define MODULE_ID LOG_MODULE_ID_IOCTL
+
+#ifndef CONFIG_QCA_IOCTL80211_TRACE_FILE
+#define CONFIG_QCA_IOCTL80211_TRACE_FILE    "/tmp/ioctl80211.trace"
+#endif
+
+#ifndef CONFIG_QCA_IOCTL80211_TRACE_SIZE
+#define CONFIG_QCA_IOCTL80211_TRACE_SIZE    1024
+#endif
+
+#define TRACE_SEGMENT_SIZE  (CONFIG_QCA_IOCTL80211_TRACE_SIZE * 1024 / 2)
+#define TRACE_ALIGN(len)    (((len) + 7) & ~7)
+
+/* Requests carrying an iw_point, with size of a length unit */
+static const struct
+{
+    int                             command;
+    size_t                          unit;
+} g_trace_iw_point[] = {
+    { SIOCGIWPRIV,                  sizeof(struct iw_priv_args) },
+    { SIOCGIWSTATS,                 1 },
+    { SIOCGIWRANGE,                 1 },
+    { SIOCGIWSCAN,                  1 },
+    { SIOCSIWSCAN,                  1 },
+    { SIOCGIWESSID,                 1 },
+    { SIOCGIWENCODE,                1 },
+    { IEEE80211_IOCTL_STA_INFO,     1 },
+    { IEEE80211_IOCTL_STA_STATS,    1 },
+    { IEEE80211_IOCTL_GETCHANINFO,  1 },
+    { IEEE80211_IOCTL_DBGREQ,       1 },
+    { PS_UAPI_IOCTL_SET,            1 },
+    { PS_UAPI_IOCTL_GET,            1 },
+};
+
+typedef enum
+{
+    TRACE_MODE_INIT = 0,
+    TRACE_MODE_RECORD,
+    TRACE_MODE_REPLAY,
+    TRACE_MODE_OFF
+} ioctl80211_trace_mode_t;
+
+typedef struct
+{
+    int                             sock_fd;
+    int                             command;
+    struct iwreq                   *request;
+    void                           *pointer;
+} ioctl80211_trace_iwreq_t;
+
+typedef struct
+{
+    int                             sock_fd;
+    int                             command;
+    struct ifreq                   *request;
+} ioctl80211_trace_ifreq_t;
+
+static ioctl80211_trace_mode_t      g_trace_mode = TRACE_MODE_INIT;
+
+/* Recording */
+static int                          g_trace_fd = -1;
+static size_t                       g_trace_segment_len;
+static uint8_t                     *g_trace_req;
+static size_t                       g_trace_req_size;
+static bool                         g_trace_cb_active;
+static uint8_t                     *g_trace_cbs;   /* len, payload, ... */
+static size_t                       g_trace_cbs_len;
+static size_t                       g_trace_cbs_size;
+
+/* Replay */
+static uint8_t                     *g_trace_data;
+static size_t                      *g_trace_recs;  /* offsets in data */
+static size_t                       g_trace_recs_qty;
+static size_t                       g_trace_cursor;
+static size_t                       g_trace_event_cursor;
+static ioctl80211_trace_event_cb_t *g_trace_event_handler;
+
+
+
+/******************************************************************************
+ *  PROTECTED definitions
+ *****************************************************************************/
+
+static uint64_t ioctl80211_trace_time_us(void)
+{
+    struct timespec                 ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static size_t ioctl80211_trace_trim(const void *data, size_t len)
+{
+    const uint8_t                  *p = data;
+
+    while (len > 0 && p[len - 1] == 0) {
+        len--;
+    }
+
+    return len;
+}
+
+static bool ioctl80211_trace_segment_open(void)
+{
+    ioctl80211_trace_file_t         hdr;
+    char                            old[PATH_MAX];
+
+    if (g_trace_fd >= 0) {
+        close(g_trace_fd);
+        snprintf(old, sizeof(old), "%s.1", CONFIG_QCA_IOCTL80211_TRACE_FILE);
+        rename(CONFIG_QCA_IOCTL80211_TRACE_FILE, old);
+    }
+
+    g_trace_fd = open(CONFIG_QCA_IOCTL80211_TRACE_FILE,
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (g_trace_fd < 0) {
+        LOG(ERR, "Trace: failed to open %s (%s)",
+            CONFIG_QCA_IOCTL80211_TRACE_FILE, strerror(errno));
+        return false;
+    }
+
+    hdr.magic = IOCTL80211_TRACE_MAGIC;
+    hdr.version = IOCTL80211_TRACE_VERSION;
+    hdr.rec_size = sizeof(ioctl80211_trace_rec_t);
+    if (write(g_trace_fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        LOG(ERR, "Trace: failed to write %s (%s)",
+            CONFIG_QCA_IOCTL80211_TRACE_FILE, strerror(errno));
+        close(g_trace_fd);
+        g_trace_fd = -1;
+        return false;
+    }
+
+    g_trace_segment_len = sizeof(hdr);
+    return true;
+}
+
+static void ioctl80211_trace_write(
+        ioctl80211_trace_rec_t         *rec,
+        const void                     *inl_req,
+        const void                     *inl_resp,
+        const void                     *req,
+        const void                     *resp)
+{
+    static const uint8_t            pad[8];
+    struct iovec                    iov[6];
+    size_t                          len;
+
+    len = sizeof(*rec) + 2 * rec->inl_len + rec->req_len + rec->resp_len;
+    rec->rec_len = TRACE_ALIGN(len);
+
+    if (g_trace_segment_len + rec->rec_len > TRACE_SEGMENT_SIZE) {
+        if (!ioctl80211_trace_segment_open()) {
+            g_trace_mode = TRACE_MODE_OFF;
+            return;
+        }
+    }
+
+    iov[0] = (struct iovec){ rec, sizeof(*rec) };
+    iov[1] = (struct iovec){ (void *)inl_req, rec->inl_len };
+    iov[2] = (struct iovec){ (void *)inl_resp, rec->inl_len };
+    iov[3] = (struct iovec){ (void *)req, rec->req_len };
+    iov[4] = (struct iovec){ (void *)resp, rec->resp_len };
+    iov[5] = (struct iovec){ (void *)pad, rec->rec_len - len };
+
+    if (writev(g_trace_fd, iov, 6) != (ssize_t)rec->rec_len) {
+        LOG(ERR, "Trace: failed to write %s, tracing stopped (%s)",
+            CONFIG_QCA_IOCTL80211_TRACE_FILE, strerror(errno));
+        g_trace_mode = TRACE_MODE_OFF;
+        return;
+    }
+
+    g_trace_segment_len += rec->rec_len;
+}
+
+static void ioctl80211_trace_payload_write(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        const void                     *data,
+        size_t                          len)
+{
+    ioctl80211_trace_rec_t          rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.timestamp_us = ioctl80211_trace_time_us();
+    rec.kind = kind;
+    rec.cmd = cmd;
+    rec.buf_len = len;
+    rec.resp_len = len;
+    STRSCPY(rec.ifname, ifname ?: "");
+
+    ioctl80211_trace_write(&rec, NULL, NULL, NULL, data);
+}
+
+static void ioctl80211_trace_index(
+        const char                     *path,
+        size_t                          start,
+        size_t                          len)
+{
+    const ioctl80211_trace_rec_t   *rec;
+    size_t                          off;
+
+    for (off = start; off + sizeof(*rec) <= len; off += rec->rec_len) {
+        rec = (const ioctl80211_trace_rec_t *)(g_trace_data + off);
+        if (rec->rec_len < sizeof(*rec) || off + rec->rec_len > len ||
+            sizeof(*rec) + 2 * rec->inl_len + rec->req_len + rec->resp_len
+                > rec->rec_len) {
+            LOG(WARNING, "Trace: %s is truncated at offset %zu",
+                path, off - start);
+            break;
+        }
+
+        if ((g_trace_recs_qty & 255) == 0) {
+            g_trace_recs =
+                REALLOC(g_trace_recs,
+                        (g_trace_recs_qty + 256) * sizeof(*g_trace_recs));
+        }
+        g_trace_recs[g_trace_recs_qty++] = off;
+    }
+}
+
+static bool ioctl80211_trace_load_file(const char *path, size_t *len)
+{
+    ioctl80211_trace_file_t         hdr;
+    struct stat                     st;
+    size_t                          size;
+    size_t                          off;
+    int                             fd;
+    ssize_t                         rc;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(hdr)) {
+        close(fd);
+        return false;
+    }
+
+    rc = read(fd, &hdr, sizeof(hdr));
+    if (rc != sizeof(hdr) ||
+        hdr.magic != IOCTL80211_TRACE_MAGIC ||
+        hdr.version != IOCTL80211_TRACE_VERSION ||
+        hdr.rec_size != sizeof(ioctl80211_trace_rec_t)) {
+        LOG(ERR, "Trace: %s is not a compatible trace", path);
+        close(fd);
+        return false;
+    }
+
+    /* Keep records of each file 8 byte aligned */
+    *len = TRACE_ALIGN(*len);
+    size = st.st_size - sizeof(hdr);
+    g_trace_data = REALLOC(g_trace_data, *len + size);
+
+    for (off = 0; off < size; off += rc) {
+        rc = read(fd, g_trace_data + *len + off, size - off);
+        if (rc <= 0) {
+            break;
+        }
+    }
+    close(fd);
+
+    ioctl80211_trace_index(path, *len, *len + off);
+    *len += off;
+    return true;
+}
+
+static bool ioctl80211_trace_load(const char *path)
+{
+    char                            old[PATH_MAX];
+    size_t                          len = 0;
+
+    snprintf(old, sizeof(old), "%s.1", path);
+    ioctl80211_trace_load_file(old, &len);
+    if (!ioctl80211_trace_load_file(path, &len)) {
+        LOG(ERR, "Trace: failed to load %s", path);
+        return false;
+    }
+
+    LOG(NOTICE, "Trace: replaying %zu records of %s", g_trace_recs_qty, path);
+    return true;
+}
+
+static void ioctl80211_trace_init(void)
+{
+    const char                     *replay = getenv(IOCTL80211_TRACE_REPLAY_ENV);
+
+    if (replay != NULL && strlen(replay) > 0) {
+        g_trace_mode = ioctl80211_trace_load(replay) ?
+                       TRACE_MODE_REPLAY :
+                       TRACE_MODE_OFF;
+        return;
+    }
+
+    g_trace_mode = ioctl80211_trace_segment_open() ?
+                   TRACE_MODE_RECORD :
+                   TRACE_MODE_OFF;
+}
+
+static const ioctl80211_trace_rec_t *ioctl80211_trace_find(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        const void                     *inl,
+        size_t                          inl_len,
+        const void                     *req,
+        size_t                          req_len,
+        size_t                          buf_len,
+        bool                            exact)
+{
+    const ioctl80211_trace_rec_t   *rec;
+    const uint8_t                  *data;
+    size_t                          i;
+    size_t                          n;
+
+    for (n = 0; n < g_trace_recs_qty; n++) {
+        i = (g_trace_cursor + n) % g_trace_recs_qty;
+        rec = (const ioctl80211_trace_rec_t *)(g_trace_data + g_trace_recs[i]);
+
+        if (rec->kind != kind || rec->cmd != cmd || rec->inl_len != inl_len ||
+            strncmp(rec->ifname, ifname, sizeof(rec->ifname)) != 0) {
+            continue;
+        }
+
+        if (exact) {
+            data = (const uint8_t *)(rec + 1);
+            if (rec->buf_len != buf_len || rec->req_len != req_len ||
+                (inl_len > 0 && memcmp(data, inl, inl_len) != 0) ||
+                memcmp(data + 2 * inl_len, req, req_len) != 0) {
+                continue;
+            }
+        }
+
+        g_trace_cursor = i + 1;
+        return rec;
+    }
+
+    return NULL;
+}
+
+static const ioctl80211_trace_rec_t *ioctl80211_trace_rec(size_t i)
+{
+    return (const ioctl80211_trace_rec_t *)(g_trace_data + g_trace_recs[i]);
+}
+
+/* Callback and event payloads are the response buffer */
+static void *ioctl80211_trace_payload(const ioctl80211_trace_rec_t *rec)
+{
+    return (uint8_t *)(rec + 1) + 2 * rec->inl_len + rec->req_len;
+}
+
+/* Events received before record i, wrapping around with the requests */
+static void ioctl80211_trace_events_replay(size_t i)
+{
+    const ioctl80211_trace_rec_t   *rec;
+
+    while (g_trace_event_cursor != i) {
+        rec = ioctl80211_trace_rec(g_trace_event_cursor);
+        g_trace_event_cursor = (g_trace_event_cursor + 1) % g_trace_recs_qty;
+
+        if (rec->kind == IOCTL80211_TRACE_EVENT && g_trace_event_handler) {
+            g_trace_event_handler(rec->ifname, rec->cmd,
+                                  ioctl80211_trace_payload(rec), rec->resp_len);
+        }
+    }
+
+    g_trace_event_cursor = (i + 1) % g_trace_recs_qty;
+}
+
+static int ioctl80211_trace_replay(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        void                           *inl,
+        size_t                          inl_len,
+        void                           *buf,
+        size_t                          buf_len,
+        ioctl80211_trace_cb_t          *cb,
+        void                           *ctx)
+{
+    const ioctl80211_trace_rec_t   *rec;
+    const ioctl80211_trace_rec_t   *reply;
+    const uint8_t                  *data;
+    size_t                          req_len;
+
+    req_len = buf ? ioctl80211_trace_trim(buf, buf_len) : 0;
+
+    /* Same request first, e.g. STA_STATS of the same station, any
+     * request of the same command otherwise */
+    rec = ioctl80211_trace_find(kind, ifname, cmd, inl, inl_len,
+                                buf, req_len, buf_len, true);
+    if (NULL == rec) {
+        rec = ioctl80211_trace_find(kind, ifname, cmd, inl, inl_len,
+                                    buf, req_len, buf_len, false);
+    }
+    if (NULL == rec) {
+        LOG(DEBUG, "Trace: no record of %s cmd 0x%x", ifname, cmd);
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    ioctl80211_trace_events_replay(g_trace_cursor - 1);
+
+    /* Callback replies follow their request */
+    while (g_trace_cursor < g_trace_recs_qty) {
+        reply = ioctl80211_trace_rec(g_trace_cursor);
+        if (reply->kind != IOCTL80211_TRACE_CB) {
+            break;
+        }
+
+        if (cb != NULL) {
+            cb(ctx, ioctl80211_trace_payload(reply), reply->resp_len);
+        }
+        g_trace_cursor++;
+    }
+
+    data = (const uint8_t *)(rec + 1);
+    if (inl_len > 0) {
+        memcpy(inl, data + inl_len, inl_len);
+    }
+    if (buf != NULL) {
+        memset(buf, 0, buf_len);
+        memcpy(buf,
+               data + 2 * inl_len + rec->req_len,
+               rec->resp_len < buf_len ? rec->resp_len : buf_len);
+    }
+
+    errno = rec->err;
+    return rec->rc;
+}
+
+static size_t ioctl80211_trace_iw_point_unit(int command)
+{
+    size_t                          i;
+
+    for (i = 0; i < ARRAY_SIZE(g_trace_iw_point); i++) {
+        if (g_trace_iw_point[i].command == command) {
+            return g_trace_iw_point[i].unit;
+        }
+    }
+
+    return 0;
+}
+
+static int ioctl80211_trace_iwreq_call(void *ctx)
+{
+    ioctl80211_trace_iwreq_t       *iwreq = ctx;
+    int                             rc;
+    int                             err;
+
+    if (NULL == iwreq->pointer) {
+        return ioctl(iwreq->sock_fd, iwreq->command, iwreq->request);
+    }
+
+    /* Driver never changes the pointer, keep it out of the trace */
+    iwreq->request->u.data.pointer = iwreq->pointer;
+    rc = ioctl(iwreq->sock_fd, iwreq->command, iwreq->request);
+    err = errno;
+    iwreq->request->u.data.pointer = NULL;
+    errno = err;
+
+    return rc;
+}
+
+static int ioctl80211_trace_ifreq_call(void *ctx)
+{
+    ioctl80211_trace_ifreq_t       *ifreq = ctx;
+
+    return ioctl(ifreq->sock_fd, ifreq->command, ifreq->request);
+}
+
+/* Buffer u.data.pointer refers to is recorded apart from u when used */
+static int ioctl80211_trace_iwreq_send(
+        int                             sock_fd,
+        int                             command,
+        struct iwreq                   *request,
+        bool                            pointer,
+        size_t                          len)
+{
+    ioctl80211_trace_iwreq_t        iwreq;
+    int                             rc;
+    int                             err;
+
+    memset(&iwreq, 0, sizeof(iwreq));
+    iwreq.sock_fd = sock_fd;
+    iwreq.command = command;
+    iwreq.request = request;
+
+    if (pointer) {
+        iwreq.pointer = request->u.data.pointer;
+        request->u.data.pointer = NULL;
+    }
+
+    rc = ioctl80211_trace_call(
+            IOCTL80211_TRACE_IOCTL,
+            request->ifr_name,
+            command,
+            &request->u,
+            sizeof(request->u),
+            iwreq.pointer,
+            len,
+            ioctl80211_trace_iwreq_call,
+            &iwreq);
+    err = errno;
+
+    if (iwreq.pointer != NULL) {
+        request->u.data.pointer = iwreq.pointer;
+    }
+
+    errno = err;
+    return rc;
+}
+
+
+
+/******************************************************************************
+ *  PUBLIC definitions
+ *****************************************************************************/
+
+int ioctl80211_trace_call(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        void                           *inl,
+        size_t                          inl_len,
+        void                           *buf,
+        size_t                          buf_len,
+        ioctl80211_trace_call_t        *call,
+        void                           *ctx)
+{
+    return ioctl80211_trace_call_cb(kind, ifname, cmd, inl, inl_len,
+                                    buf, buf_len, call, NULL, ctx);
+}
+
+int ioctl80211_trace_call_cb(
+        ioctl80211_trace_kind_t         kind,
+        const char                     *ifname,
+        uint32_t                        cmd,
+        void                           *inl,
+        size_t                          inl_len,
+        void                           *buf,
+        size_t                          buf_len,
+        ioctl80211_trace_call_t        *call,
+        ioctl80211_trace_cb_t          *cb,
+        void                           *ctx)
+{
+    ioctl80211_trace_rec_t          rec;
+    uint8_t                         inl_req[sizeof(union iwreq_data)];
+    uint32_t                        cb_len;
+    size_t                          off;
+    int                             err;
+
+    if (TRACE_MODE_INIT == g_trace_mode) {
+        ioctl80211_trace_init();
+    }
+
+    if (TRACE_MODE_REPLAY == g_trace_mode) {
+        return ioctl80211_trace_replay(kind, ifname, cmd,
+                                       inl, inl_len, buf, buf_len, cb, ctx);
+    }
+
+    if (TRACE_MODE_RECORD != g_trace_mode || inl_len > sizeof(inl_req)) {
+        return call(ctx);
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.kind = kind;
+    rec.cmd = cmd;
+    rec.inl_len = inl_len;
+    rec.buf_len = buf ? buf_len : 0;
+    STRSCPY(rec.ifname, ifname);
+
+    if (inl_len > 0) {
+        memcpy(inl_req, inl, inl_len);
+    }
+    if (buf != NULL) {
+        rec.req_len = ioctl80211_trace_trim(buf, buf_len);
+        if (rec.req_len > g_trace_req_size) {
+            g_trace_req_size = rec.req_len;
+            g_trace_req = REALLOC(g_trace_req, g_trace_req_size);
+        }
+        memcpy(g_trace_req, buf, rec.req_len);
+    }
+
+    g_trace_cbs_len = 0;
+    g_trace_cb_active = true;
+
+    rec.timestamp_us = ioctl80211_trace_time_us();
+    rec.rc = call(ctx);
+    err = errno;
+    rec.duration_us = ioctl80211_trace_time_us() - rec.timestamp_us;
+    rec.err = rec.rc < 0 ? err : 0;
+
+    g_trace_cb_active = false;
+
+    if (buf != NULL) {
+        rec.resp_len = ioctl80211_trace_trim(buf, buf_len);
+    }
+
+    ioctl80211_trace_write(&rec, inl_req, inl, g_trace_req, buf);
+
+    for (off = 0; off < g_trace_cbs_len; off += TRACE_ALIGN(sizeof(cb_len) + cb_len)) {
+        memcpy(&cb_len, g_trace_cbs + off, sizeof(cb_len));
+        ioctl80211_trace_payload_write(IOCTL80211_TRACE_CB, ifname, cmd,
+                                       g_trace_cbs + off + sizeof(cb_len), cb_len);
+    }
+
+    errno = err;
+    return rec.rc;
+}
+
+void ioctl80211_trace_cb_record(
+        const void                     *data,
+        size_t                          len)
+{
+    uint32_t                        cb_len = len;
+    size_t                          need;
+
+    /* Replies are written once the request itself is */
+    if (!g_trace_cb_active || TRACE_MODE_RECORD != g_trace_mode) {
+        return;
+    }
+
+    need = g_trace_cbs_len + TRACE_ALIGN(sizeof(cb_len) + len);
+    if (need > g_trace_cbs_size) {
+        g_trace_cbs_size = need;
+        g_trace_cbs = REALLOC(g_trace_cbs, g_trace_cbs_size);
+    }
+
+    memcpy(g_trace_cbs + g_trace_cbs_len, &cb_len, sizeof(cb_len));
+    memcpy(g_trace_cbs + g_trace_cbs_len + sizeof(cb_len), data, len);
+    g_trace_cbs_len = need;
+}
+
+void ioctl80211_trace_event(
+        const char                     *ifname,
+        uint32_t                        cmd,
+        const void                     *data,
+        size_t                          len)
+{
+    if (TRACE_MODE_INIT == g_trace_mode) {
+        ioctl80211_trace_init();
+    }
+
+    if (TRACE_MODE_RECORD != g_trace_mode) {
+        return;
+    }
+
+    ioctl80211_trace_payload_write(IOCTL80211_TRACE_EVENT, ifname, cmd, data, len);
+}
+
+void ioctl80211_trace_event_handler_set(
+        ioctl80211_trace_event_cb_t    *handler)
+{
+    g_trace_event_handler = handler;
+}
+
+int ioctl80211_trace_request_send(
+        int                             sock_fd,
+        int                             command,
+        struct iwreq                   *request)
+{
+    size_t                          unit;
+
+    unit = ioctl80211_trace_iw_point_unit(command);
+    if (unit > 0 && request->u.data.pointer != NULL) {
+        return ioctl80211_trace_iwreq_send(sock_fd, command, request, true,
+                                           request->u.data.length * unit);
+    }
+
+    return ioctl80211_trace_iwreq_send(sock_fd, command, request, false, 0);
+}
+
+int ioctl80211_trace_iw_point_send(
+        int                             sock_fd,
+        int                             command,
+        struct iwreq                   *request,
+        size_t                          len)
+{
+    return ioctl80211_trace_iwreq_send(sock_fd, command, request,
+                                       len > 0, len);
+}
+
+int ioctl80211_trace_ifreq_send(
+        int                             sock_fd,
+        int                             command,
+        struct ifreq                   *request,
+        size_t                          len)
+{
+    ioctl80211_trace_ifreq_t        ifreq;
+
+    ifreq.sock_fd = sock_fd;
+    ifreq.command = command;
+    ifreq.request = request;
+
+    return ioctl80211_trace_call(
+            IOCTL80211_TRACE_IOCTL,
+            request->ifr_name,
+            command,
+            NULL,
+            0,
+            request->ifr_data,
+            len,
+            ioctl80211_trace_ifreq_call,
+            &ifreq);
+}
+
+void ioctl80211_trace_close(void)
+{
+    if (g_trace_fd >= 0) {
+        close(g_trace_fd);
+        g_trace_fd = -1;
+    }
+
+    FREE(g_trace_req);
+    g_trace_req = NULL;
+    g_trace_req_size = 0;
+
+    FREE(g_trace_cbs);
+    g_trace_cbs = NULL;
+    g_trace_cbs_len = 0;
+    g_trace_cbs_size = 0;
+
+    FREE(g_trace_recs);
+    g_trace_recs = NULL;
+    g_trace_recs_qty = 0;
+    g_trace_cursor = 0;
+    g_trace_event_cursor = 0;
+
+    FREE(g_trace_data);
+    g_trace_data = NULL;
+
+    g_trace_mode = TRACE_MODE_INIT;
+}
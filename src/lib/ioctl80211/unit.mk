@@ -52,6 +52,7 @@ UNIT_SRC += ioctl80211.c
 UNIT_SRC += ioctl80211_survey.c
 UNIT_SRC += ioctl80211_scan.c
 UNIT_SRC += ioctl80211_client.c
+UNIT_SRC += ioctl80211_client_delta.c
 UNIT_SRC += ioctl80211_radio.c
 UNIT_SRC += ioctl80211_device.c
 ifeq ($(CONFIG_SM_CAPACITY_QUEUE_STATS),y)
@@ -60,6 +61,16 @@ endif
 endif
 
 UNIT_SRC += ioctl80211_priv.c
+UNIT_SRC += ioctl80211_inventory.c
+UNIT_SRC += ioctl80211_linkstats.c
+UNIT_SRC += ioctl80211_neighbor.c
+UNIT_SRC += ioctl80211_nlfilter.c
+UNIT_SRC += ioctl80211_phyrate.c
+UNIT_SRC += ioctl80211_pool.c
+
+ifeq ($(CONFIG_QCA_IOCTL80211_TRACE),y)
+UNIT_SRC += ioctl80211_trace.c
+endif
 
 UNIT_CFLAGS := -I$(UNIT_PATH)/inc
 UNIT_CFLAGS += -Isrc/lib/datapipeline/inc
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Client histogram delta benchmark
+ *
+ * 256 peers with fixed synthetic rx/tx histograms, one bucket in eight
+ * changing between samples. A sweep computes the rx and tx deltas of
+ * every peer and walks the changed buckets like the record pass does.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ioctl80211_client_delta.h"
+
+#define BENCH_PEERS         256
+#define BENCH_SWEEPS        200
+
+typedef struct
+{
+    struct ps_uapi_ioctl            rx[2];
+    struct ps_uapi_ioctl            tx[2];
+} bench_peer_t;
+
+static bench_peer_t                 g_peers[BENCH_PEERS];
+static ioctl80211_client_rx_delta_t g_rx_delta;
+static ioctl80211_client_tx_delta_t g_tx_delta;
+
+static uint32_t bench_rand(void)
+{
+    static uint32_t                 x = 2463534242u;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static void bench_peers_init(void)
+{
+    bench_peer_t                   *p;
+    uint32_t                        d;
+    int                             i;
+    int                             b;
+
+    memset(g_peers, 0, sizeof(g_peers));
+
+    for (i = 0; i < BENCH_PEERS; i++)
+    {
+        p = &g_peers[i];
+        for (b = 0; b < PS_MAX_ALL; b++)
+        {
+            p->rx[0].u.peer_rx_stats.get.stats[b].num_bytes = bench_rand() & 0xffffff;
+            p->rx[0].u.peer_rx_stats.get.stats[b].num_mpdus = bench_rand() & 0xffff;
+            p->rx[0].u.peer_rx_stats.get.stats[b].num_ppdus = bench_rand() & 0xfff;
+            p->tx[0].u.peer_tx_stats.get.stats[b].success   = bench_rand() & 0xffff;
+            p->tx[0].u.peer_tx_stats.get.stats[b].attempts  =
+                p->tx[0].u.peer_tx_stats.get.stats[b].success + (bench_rand() & 0xff);
+            p->tx[0].u.peer_tx_stats.get.stats[b].ppdus     = bench_rand() & 0xfff;
+
+            p->rx[1] = p->rx[0];
+            p->tx[1] = p->tx[0];
+        }
+
+        for (b = 0; b < PS_MAX_ALL; b++)
+        {
+            if (bench_rand() % 8)
+                continue;
+
+            d = 1 + (bench_rand() & 0x3ff);
+            p->rx[1].u.peer_rx_stats.get.stats[b].num_bytes += d * 1500;
+            p->rx[1].u.peer_rx_stats.get.stats[b].num_msdus += d;
+            p->rx[1].u.peer_rx_stats.get.stats[b].num_mpdus += d;
+            p->rx[1].u.peer_rx_stats.get.stats[b].num_ppdus += 1 + d / 16;
+            p->rx[1].u.peer_rx_stats.get.stats[b].num_sgi   += d / 2;
+            p->tx[1].u.peer_tx_stats.get.stats[b].attempts  += d + d / 10;
+            p->tx[1].u.peer_tx_stats.get.stats[b].success   += d;
+            p->tx[1].u.peer_tx_stats.get.stats[b].ppdus     += 1 + d / 16;
+        }
+    }
+}
+
+static uint64_t bench_sweep(void)
+{
+    ioctl80211_phy_t                phy;
+    uint32_t                        mcs;
+    uint32_t                        nss;
+    uint32_t                        bw;
+    uint32_t                        idx;
+    uint32_t                        i;
+    uint64_t                        sum = 0;
+    int                             p;
+
+    for (p = 0; p < BENCH_PEERS; p++)
+    {
+        ioctl80211_client_rx_delta_calc(&g_peers[p].rx[1], &g_peers[p].rx[0], &g_rx_delta);
+        for (i = 0; i < g_rx_delta.active_qty; i++)
+        {
+            idx = g_rx_delta.active[i];
+            ioctl80211_client_bucket_decode(idx, &phy, &mcs, &nss, &bw);
+            sum += g_rx_delta.mpdus[idx] +
+                   (uint64_t)ioctl80211_phyrate_kbps(phy, bw, nss, mcs, IOCTL80211_GI_800) *
+                   g_rx_delta.ppdus[idx];
+        }
+
+        ioctl80211_client_tx_delta_calc(&g_peers[p].tx[1], &g_peers[p].tx[0], &g_tx_delta);
+        for (i = 0; i < g_tx_delta.active_qty; i++)
+        {
+            idx = g_tx_delta.active[i];
+            ioctl80211_client_bucket_decode(idx, &phy, &mcs, &nss, &bw);
+            sum += g_tx_delta.success[idx] +
+                   (uint64_t)ioctl80211_phyrate_kbps(phy, bw, nss, mcs, IOCTL80211_GI_800) *
+                   g_tx_delta.ppdus[idx];
+        }
+    }
+
+    return sum;
+}
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec                 ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(void)
+{
+    uint64_t                        start;
+    uint64_t                        ns;
+    uint64_t                        min_ns = UINT64_MAX;
+    uint64_t                        total_ns = 0;
+    uint64_t                        check = 0;
+    int                             i;
+
+    bench_peers_init();
+    check += bench_sweep();
+
+    for (i = 0; i < BENCH_SWEEPS; i++)
+    {
+        start = bench_now_ns();
+        check += bench_sweep();
+        ns = bench_now_ns() - start;
+
+        total_ns += ns;
+        if (ns < min_ns)
+            min_ns = ns;
+    }
+
+    printf("client_delta: %d peers, %d buckets, scratch %zu B off stack\n",
+           BENCH_PEERS, PS_MAX_ALL, sizeof(g_rx_delta) + sizeof(g_tx_delta));
+    printf("client_delta: sweep min %.1f us avg %.1f us (%.0f ns/peer) [%llx]\n",
+           min_ns / 1000.0,
+           total_ns / 1000.0 / BENCH_SWEEPS,
+           (double)min_ns / BENCH_PEERS,
+           (unsigned long long)(check & 0xffff));
+
+    return 0;
+}
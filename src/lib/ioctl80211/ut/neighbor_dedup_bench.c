@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Scan neighbor dedup benchmark
+ *
+ * 2400 records, the default per radio scan limit, over two scanned
+ * channels plus one that was not scanned, a quarter of them repeating
+ * an earlier BSSID. The hash table dedup is checked against and timed
+ * next to the pairwise strcmp() loop it replaced.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ioctl80211_neighbor.h"
+
+#define BENCH_RECORDS       2400
+#define BENCH_ROUNDS        20
+
+static dpp_neighbor_record_t        g_records[BENCH_RECORDS];
+static dpp_neighbor_record_t        g_work[BENCH_RECORDS];
+static uint32_t                     g_chan_list[] = { 36, 40 };
+
+static uint32_t bench_rand(void)
+{
+    static uint32_t                 x = 2463534242u;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static void bench_records_init(void)
+{
+    static const uint32_t           chans[] = { 36, 40, 44 };
+    dpp_neighbor_record_t          *rec;
+    uint32_t                        r;
+    int                             i;
+
+    for (i = 0; i < BENCH_RECORDS; i++)
+    {
+        rec = &g_records[i];
+
+        if (i > 0 && (bench_rand() % 4) == 0)
+        {
+            /* Repeat an earlier BSSID, on the same channel or not */
+            *rec = g_records[bench_rand() % i];
+            if (bench_rand() % 2)
+                rec->chan = chans[bench_rand() % 3];
+            continue;
+        }
+
+        r = bench_rand();
+        snprintf(rec->bssid, sizeof(rec->bssid),
+                 "%02x:%02x:%02x:%02x:%02x:%02x",
+                 0x02, 0x1a, (r >> 24) & 0xff, (r >> 16) & 0xff,
+                 (r >> 8) & 0xff, i & 0xff);
+        snprintf(rec->ssid, sizeof(rec->ssid), "ssid-%d", i);
+        rec->chan = chans[bench_rand() % 3];
+        rec->sig = 10 + bench_rand() % 60;
+        rec->lastseen = 1 + (bench_rand() % 8 != 0) * 100;
+    }
+}
+
+/* The pairwise loop the hash table replaced */
+static uint32_t bench_dedup_pairwise(
+        dpp_neighbor_record_t      *recs,
+        uint32_t                    qty,
+        const uint32_t             *chan_list,
+        uint32_t                    chan_num)
+{
+    uint32_t                        kept = 0;
+    uint32_t                        i;
+    uint32_t                        j;
+    uint32_t                        c;
+
+    for (i = 0; i < qty; i++)
+    {
+        if (!recs[i].lastseen)
+            continue;
+
+        for (c = 0; c < chan_num; c++)
+            if (recs[i].chan == chan_list[c])
+                break;
+        if (c == chan_num)
+        {
+            recs[i].lastseen = 0;
+            continue;
+        }
+
+        for (j = i + 1; j < qty; j++)
+            if (recs[i].chan == recs[j].chan &&
+                strcmp(recs[i].bssid, recs[j].bssid) == 0)
+                recs[j].lastseen = 0;
+
+        kept++;
+    }
+
+    return kept;
+}
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec                 ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(void)
+{
+    static dpp_neighbor_record_t    ref[BENCH_RECORDS];
+    uint64_t                        start;
+    uint64_t                        ns;
+    uint64_t                        hash_ns = UINT64_MAX;
+    uint64_t                        pair_ns = UINT64_MAX;
+    uint32_t                        kept_hash = 0;
+    uint32_t                        kept_pair = 0;
+    int                             i;
+
+    bench_records_init();
+
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        memcpy(g_work, g_records, sizeof(g_work));
+        start = bench_now_ns();
+        kept_hash = ioctl80211_neighbor_dedup(g_work, BENCH_RECORDS,
+                                              g_chan_list, 2);
+        ns = bench_now_ns() - start;
+        if (ns < hash_ns)
+            hash_ns = ns;
+
+        memcpy(ref, g_records, sizeof(ref));
+        start = bench_now_ns();
+        kept_pair = bench_dedup_pairwise(ref, BENCH_RECORDS, g_chan_list, 2);
+        ns = bench_now_ns() - start;
+        if (ns < pair_ns)
+            pair_ns = ns;
+    }
+
+    for (i = 0; i < BENCH_RECORDS; i++)
+    {
+        if ((g_work[i].lastseen != 0) != (ref[i].lastseen != 0))
+        {
+            printf("neighbor_dedup: record %d (%s chan %u) differs\n",
+                   i, g_records[i].bssid, g_records[i].chan);
+            return 1;
+        }
+    }
+
+    printf("neighbor_dedup: %d records, %u kept (pairwise %u)\n",
+           BENCH_RECORDS, kept_hash, kept_pair);
+    printf("neighbor_dedup: hash %.1f us, pairwise %.1f us\n",
+           hash_ns / 1000.0, pair_ns / 1000.0);
+
+    return kept_hash == kept_pair ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/*
+ * Neighbor table tests
+ *
+ * Feeds scans of two channels through ioctl80211_neighbor_report() and
+ * checks which records each report selection returns, the smoothed
+ * signal of both positive (RSSI) and negative (dBm) samples, and that
+ * neighbors missing from a single scan are not expired right away.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ioctl80211_neighbor.h"
+
+static radio_entry_t                g_radio = { RADIO_TYPE_5G, "wifi1", "wifi1", 36 };
+static uint32_t                     g_chan_list[] = { 36, 40 };
+static int                          g_tests;
+static int                          g_failed;
+
+static void neighbor_scan(
+        dpp_neighbor_list_t        *list,
+        const char                 *bssid,
+        uint32_t                    chan,
+        int32_t                     sig)
+{
+    dpp_neighbor_record_list_t     *rec = dpp_neighbor_record_alloc();
+
+    snprintf(rec->entry.bssid, sizeof(rec->entry.bssid), "%s", bssid);
+    rec->entry.chan = chan;
+    rec->entry.sig = sig;
+    rec->entry.lastseen = 1;
+    ds_dlist_insert_tail(list, rec);
+}
+
+static dpp_neighbor_record_t *neighbor_find(
+        dpp_neighbor_list_t        *list,
+        const char                 *bssid)
+{
+    dpp_neighbor_record_list_t     *rec;
+    ds_dlist_iter_t                 iter;
+
+    for (rec = ds_dlist_ifirst(&iter, list); rec; rec = ds_dlist_inext(&iter))
+        if (!strcmp(rec->entry.bssid, bssid))
+            return &rec->entry;
+
+    return NULL;
+}
+
+static int neighbor_qty(dpp_neighbor_list_t *list)
+{
+    ds_dlist_iter_t                 iter;
+    int                             qty = 0;
+
+    for (void *rec = ds_dlist_ifirst(&iter, list); rec; rec = ds_dlist_inext(&iter))
+        qty++;
+
+    return qty;
+}
+
+static void neighbor_list_free(dpp_neighbor_list_t *list)
+{
+    dpp_neighbor_record_list_t     *rec;
+
+    while ((rec = ds_dlist_remove_head(list)))
+        dpp_neighbor_record_free(rec);
+}
+
+static void neighbor_check(bool ok, const char *what)
+{
+    g_tests++;
+    if (ok)
+        return;
+
+    printf("FAIL %s\n", what);
+    g_failed++;
+}
+
+int main(void)
+{
+    dpp_neighbor_record_t          *rec;
+    dpp_neighbor_list_t             list;
+    int                             i;
+
+    ds_dlist_init(&list, dpp_neighbor_record_list_t, node);
+
+    /* First scan, everything is new */
+    neighbor_scan(&list, "02:00:00:00:00:01", 36, 40);
+    neighbor_scan(&list, "02:00:00:00:00:02", 40, -70);
+    neighbor_scan(&list, "02:00:00:00:00:03", 40, 20);
+    ioctl80211_neighbor_report(&g_radio, g_chan_list, 2, IOCTL80211_NEIGHBOR_REPORT_DELTA, &list);
+    neighbor_check(neighbor_qty(&list) == 3, "first scan reports all neighbors");
+    neighbor_list_free(&list);
+
+    /* Small moves are smoothed away, a negative signal rounds to itself */
+    neighbor_scan(&list, "02:00:00:00:00:01", 36, 42);
+    neighbor_scan(&list, "02:00:00:00:00:02", 40, -71);
+    neighbor_scan(&list, "02:00:00:00:00:03", 40, 20);
+    ioctl80211_neighbor_report(&g_radio, g_chan_list, 2, IOCTL80211_NEIGHBOR_REPORT_FULL, &list);
+    neighbor_check(neighbor_qty(&list) == 3, "full report returns unchanged neighbors");
+    rec = neighbor_find(&list, "02:00:00:00:00:01");
+    neighbor_check(rec && rec->sig == 41, "positive signal is smoothed");
+    rec = neighbor_find(&list, "02:00:00:00:00:02");
+    neighbor_check(rec && rec->sig == -70, "negative signal is smoothed");
+    neighbor_list_free(&list);
+
+    neighbor_scan(&list, "02:00:00:00:00:01", 36, 41);
+    neighbor_scan(&list, "02:00:00:00:00:02", 40, -70);
+    neighbor_scan(&list, "02:00:00:00:00:03", 40, 20);
+    ioctl80211_neighbor_report(&g_radio, g_chan_list, 2, IOCTL80211_NEIGHBOR_REPORT_DELTA, &list);
+    neighbor_check(neighbor_qty(&list) == 0, "delta report drops unchanged neighbors");
+    neighbor_list_free(&list);
+
+    /* A sustained drop eventually crosses the report threshold */
+    for (i = 0; i < 4; i++)
+    {
+        neighbor_scan(&list, "02:00:00:00:00:02", 40, -85);
+        ioctl80211_neighbor_report(&g_radio, g_chan_list, 2, IOCTL80211_NEIGHBOR_REPORT_CHANGED, &list);
+        if (neighbor_qty(&list) > 0)
+            break;
+        neighbor_list_free(&list);
+    }
+    rec = neighbor_find(&list, "02:00:00:00:00:02");
+    neighbor_check(rec && rec->sig <= -75 && rec->sig > -85, "negative signal change is reported");
+    neighbor_list_free(&list);
+
+    /* Only the new neighbor is reported, neighbors missing from this
+     * scan are not yet expired */
+    neighbor_scan(&list, "02:00:00:00:00:04", 36, 30);
+    ioctl80211_neighbor_report(&g_radio, g_chan_list, 2, IOCTL80211_NEIGHBOR_REPORT_DELTA, &list);
+    neighbor_check(neighbor_qty(&list) == 1 && neighbor_find(&list, "02:00:00:00:00:04"),
+                   "new neighbor is reported alone");
+    neighbor_list_free(&list);
+
+    printf("neighbor: %d tests, %d failed\n", g_tests, g_failed);
+    return g_failed ? 1 : 0;
+}
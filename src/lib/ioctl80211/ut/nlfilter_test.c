@@ -0,0 +1,427 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Netlink filter replay tests
+ *
+ * Runs the generated classic BPF programs over link messages and checks
+ * which of them the kernel would queue. data/nlfilter_rtnl.bin holds
+ * RTM_NEWLINK (create and change), RTM_NEWADDR and RTM_DELLINK as a
+ * kernel delivered them to an RTMGRP_LINK | RTMGRP_IPV4_IFADDR socket
+ * while a veth pair was created, changed, addressed and removed.
+ * Wireless events are built the way wext rtnetlink_ifinfo_prep() does:
+ * ifinfomsg, IFLA_IFNAME and a single iw_event in IFLA_WIRELESS. A rename
+ * is built like rtnetlink_event() reports NETDEV_CHANGENAME (no change
+ * bits), a flag change like __dev_notify_flags() does.
+ *
+ * The interpreter follows net/core/filter.c, including SKF_AD_NLATTR
+ * (nla_find() from offset A for type X) and loads past the end of the
+ * message dropping it.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/wireless.h>
+
+#include "ioctl80211_nlfilter.h"
+
+#define NLFILTER_DATA       "data/nlfilter_rtnl.bin"
+
+typedef struct
+{
+    const char                     *name;
+    const uint8_t                  *msg;
+    uint32_t                        len;
+} nlfilter_msg_t;
+
+/* As in target_qca.c and target_qca_11ax.c */
+static const ioctl80211_nlfilter_t g_target_filter = {
+    .dellink    = true,
+    .newlink    = true,
+    .iwe_cmd    = { IWEVASSOCREQIE },
+    .iwe_qty    = 1,
+    .iwe_drop   = true,
+};
+
+/* As in both bsal_qca10_2_4_csu3 variants */
+static const ioctl80211_nlfilter_t g_bsal_filter = {
+    .dellink        = true,
+    .newlink_create = true,
+    .newlink_rename = true,
+    .iwe_cmd        = { IWEVASSOCREQIE },
+    .iwe_qty        = 1,
+};
+
+static int g_failed;
+static int g_tests;
+
+static uint32_t nlfilter_nla_find(
+        const uint8_t              *msg,
+        uint32_t                    len,
+        uint32_t                    a,
+        uint32_t                    x)
+{
+    const struct nlattr            *nla;
+    uint32_t                        off = a;
+    int                             rem;
+
+    if (len < sizeof(struct nlattr) || a > len - sizeof(struct nlattr))
+        return 0;
+
+    /* nla_ok() / nla_next() */
+    rem = len - a;
+    while (rem >= (int)sizeof(*nla))
+    {
+        nla = (const struct nlattr *)(msg + off);
+        if (nla->nla_len < sizeof(*nla) || nla->nla_len > rem)
+            break;
+        if ((nla->nla_type & NLA_TYPE_MASK) == x)
+            return off;
+        rem -= NLA_ALIGN(nla->nla_len);
+        off += NLA_ALIGN(nla->nla_len);
+    }
+
+    return 0;
+}
+
+static bool nlfilter_load(
+        const uint8_t              *msg,
+        uint32_t                    len,
+        uint32_t                    off,
+        int                         size,
+        uint32_t                    x,
+        uint32_t                   *a)
+{
+    if (off == (uint32_t)(SKF_AD_OFF + SKF_AD_NLATTR) && size == BPF_W)
+    {
+        *a = nlfilter_nla_find(msg, len, *a, x);
+        return true;
+    }
+
+    switch (size)
+    {
+        case BPF_W:
+            if (off + 4 > len) return false;
+            *a = ((uint32_t)msg[off] << 24) | ((uint32_t)msg[off + 1] << 16) |
+                 ((uint32_t)msg[off + 2] << 8) | msg[off + 3];
+            return true;
+        case BPF_H:
+            if (off + 2 > len) return false;
+            *a = ((uint32_t)msg[off] << 8) | msg[off + 1];
+            return true;
+        case BPF_B:
+            if (off + 1 > len) return false;
+            *a = msg[off];
+            return true;
+    }
+
+    return false;
+}
+
+/* Returns the number of bytes the kernel would keep, 0 drops */
+static uint32_t nlfilter_run(
+        const struct sock_filter   *prog,
+        int                         prog_len,
+        const uint8_t              *msg,
+        uint32_t                    len)
+{
+    const struct sock_filter       *f;
+    uint32_t                        a = 0;
+    uint32_t                        x = 0;
+    uint32_t                        cond;
+    int                             pc;
+
+    for (pc = 0; pc < prog_len; pc++)
+    {
+        f = &prog[pc];
+        switch (BPF_CLASS(f->code))
+        {
+            case BPF_LD:
+                if (BPF_MODE(f->code) == BPF_IMM)
+                    a = f->k;
+                else if (BPF_MODE(f->code) == BPF_ABS)
+                {
+                    if (!nlfilter_load(msg, len, f->k, BPF_SIZE(f->code), x, &a))
+                        return 0;
+                }
+                else if (BPF_MODE(f->code) == BPF_IND)
+                {
+                    if (!nlfilter_load(msg, len, x + f->k, BPF_SIZE(f->code), x, &a))
+                        return 0;
+                }
+                else if (BPF_MODE(f->code) == BPF_LEN)
+                    a = len;
+                else
+                    return 0;
+                break;
+            case BPF_LDX:
+                if (BPF_MODE(f->code) == BPF_IMM)
+                    x = f->k;
+                else if (BPF_MODE(f->code) == BPF_LEN)
+                    x = len;
+                else
+                    return 0;
+                break;
+            case BPF_MISC:
+                if (BPF_MISCOP(f->code) == BPF_TAX)
+                    x = a;
+                else
+                    a = x;
+                break;
+            case BPF_JMP:
+                if (BPF_OP(f->code) == BPF_JA)
+                {
+                    pc += f->k;
+                    break;
+                }
+                switch (BPF_OP(f->code))
+                {
+                    case BPF_JEQ:  cond = a == f->k; break;
+                    case BPF_JGT:  cond = a > f->k; break;
+                    case BPF_JGE:  cond = a >= f->k; break;
+                    case BPF_JSET: cond = (a & f->k) != 0; break;
+                    default: return 0;
+                }
+                pc += cond ? f->jt : f->jf;
+                break;
+            case BPF_RET:
+                return BPF_RVAL(f->code) == BPF_A ? a : f->k;
+            default:
+                return 0;
+        }
+    }
+
+    /* Falling off the end is rejected by the kernel verifier */
+    return 0;
+}
+
+static uint32_t nlfilter_wireless_build(
+        uint8_t                    *buf,
+        uint32_t                    size,
+        uint16_t                    iwe_cmd,
+        uint16_t                    iwe_payload)
+{
+    struct nlmsghdr                *nlh;
+    struct ifinfomsg               *ifi;
+    struct rtattr                  *rta;
+    struct iw_event                *iwe;
+
+    memset(buf, 0, size);
+
+    nlh = (struct nlmsghdr *)buf;
+    nlh->nlmsg_type = RTM_NEWLINK;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(*ifi));
+
+    ifi = NLMSG_DATA(nlh);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index = 12;
+    ifi->ifi_flags = 0x1043;
+    ifi->ifi_change = 0;
+
+    rta = (struct rtattr *)(buf + NLMSG_ALIGN(nlh->nlmsg_len));
+    rta->rta_type = IFLA_IFNAME;
+    rta->rta_len = RTA_LENGTH(sizeof("ath0"));
+    memcpy(RTA_DATA(rta), "ath0", sizeof("ath0"));
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+    rta = (struct rtattr *)(buf + nlh->nlmsg_len);
+    rta->rta_type = IFLA_WIRELESS;
+    rta->rta_len = RTA_LENGTH(IW_EV_POINT_LEN + iwe_payload);
+    iwe = RTA_DATA(rta);
+    iwe->len = IW_EV_POINT_LEN + iwe_payload;
+    iwe->cmd = iwe_cmd;
+    nlh->nlmsg_len += RTA_ALIGN(rta->rta_len);
+
+    return nlh->nlmsg_len;
+}
+
+static uint32_t nlfilter_link_build(
+        uint8_t                    *buf,
+        uint32_t                    size,
+        const char                 *ifname,
+        uint32_t                    change)
+{
+    struct nlmsghdr                *nlh;
+    struct ifinfomsg               *ifi;
+    struct rtattr                  *rta;
+
+    memset(buf, 0, size);
+
+    nlh = (struct nlmsghdr *)buf;
+    nlh->nlmsg_type = RTM_NEWLINK;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(*ifi));
+
+    ifi = NLMSG_DATA(nlh);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index = 12;
+    ifi->ifi_flags = 0x1043;
+    ifi->ifi_change = change;
+
+    rta = (struct rtattr *)(buf + NLMSG_ALIGN(nlh->nlmsg_len));
+    rta->rta_type = IFLA_IFNAME;
+    rta->rta_len = RTA_LENGTH(strlen(ifname) + 1);
+    memcpy(RTA_DATA(rta), ifname, strlen(ifname) + 1);
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+    return nlh->nlmsg_len;
+}
+
+static void nlfilter_expect(
+        const char                 *filter_name,
+        const struct sock_filter   *prog,
+        int                         prog_len,
+        const nlfilter_msg_t       *m,
+        bool                        pass)
+{
+    bool                            passed;
+
+    passed = nlfilter_run(prog, prog_len, m->msg, m->len) != 0;
+    g_tests++;
+
+    if (passed != pass)
+    {
+        printf("FAIL %s filter: %s %s, expected %s\n",
+               filter_name, m->name,
+               passed ? "passed" : "dropped",
+               pass ? "pass" : "drop");
+        g_failed++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t                  rec[16384];
+    static uint8_t                  iwe_custom[256];
+    static uint8_t                  iwe_assoc[256];
+    static uint8_t                  iwe_expired[256];
+    static uint8_t                  link_rename[64];
+    static uint8_t                  link_flags[64];
+    struct sock_filter              target_prog[IOCTL80211_NLFILTER_PROG_MAX];
+    struct sock_filter              bsal_prog[IOCTL80211_NLFILTER_PROG_MAX];
+    const struct nlmsghdr          *nlh;
+    const struct ifinfomsg         *ifi;
+    nlfilter_msg_t                  msgs[20];
+    int                             msgs_qty = 0;
+    int                             target_len;
+    int                             bsal_len;
+    size_t                          len;
+    size_t                          off;
+    FILE                           *f;
+    int                             i;
+
+    f = fopen(argc > 1 ? argv[1] : NLFILTER_DATA, "rb");
+    if (!f)
+    {
+        printf("FAIL cannot open %s\n", argc > 1 ? argv[1] : NLFILTER_DATA);
+        return 1;
+    }
+    len = fread(rec, 1, sizeof(rec), f);
+    fclose(f);
+
+    for (off = 0; off + NLMSG_HDRLEN <= len; off += NLMSG_ALIGN(nlh->nlmsg_len))
+    {
+        nlh = (const struct nlmsghdr *)(rec + off);
+        if (nlh->nlmsg_len < NLMSG_HDRLEN || off + nlh->nlmsg_len > len)
+            break;
+
+        ifi = NLMSG_DATA(nlh);
+        msgs[msgs_qty].msg = rec + off;
+        msgs[msgs_qty].len = nlh->nlmsg_len;
+        switch (nlh->nlmsg_type)
+        {
+            case RTM_NEWLINK:
+                msgs[msgs_qty].name = ifi->ifi_change == 0xffffffff ?
+                                      "RTM_NEWLINK (create)" :
+                                      ifi->ifi_change == 0 ?
+                                      "RTM_NEWLINK (notify)" :
+                                      "RTM_NEWLINK (change)";
+                break;
+            case RTM_DELLINK:
+                msgs[msgs_qty].name = "RTM_DELLINK";
+                break;
+            case RTM_NEWADDR:
+                msgs[msgs_qty].name = "RTM_NEWADDR";
+                break;
+            default:
+                msgs[msgs_qty].name = "other";
+                break;
+        }
+        if (++msgs_qty >= 13)
+            break;
+    }
+
+    msgs[msgs_qty].name = "IWEVCUSTOM";
+    msgs[msgs_qty].msg = iwe_custom;
+    msgs[msgs_qty++].len = nlfilter_wireless_build(iwe_custom, sizeof(iwe_custom), IWEVCUSTOM, 32);
+    msgs[msgs_qty].name = "IWEVASSOCREQIE";
+    msgs[msgs_qty].msg = iwe_assoc;
+    msgs[msgs_qty++].len = nlfilter_wireless_build(iwe_assoc, sizeof(iwe_assoc), IWEVASSOCREQIE, 120);
+    msgs[msgs_qty].name = "IWEVEXPIRED";
+    msgs[msgs_qty].msg = iwe_expired;
+    msgs[msgs_qty++].len = nlfilter_wireless_build(iwe_expired, sizeof(iwe_expired), IWEVEXPIRED, 0);
+    msgs[msgs_qty].name = "RTM_NEWLINK (rename)";
+    msgs[msgs_qty].msg = link_rename;
+    msgs[msgs_qty++].len = nlfilter_link_build(link_rename, sizeof(link_rename), "ath01", 0);
+    msgs[msgs_qty].name = "RTM_NEWLINK (flags)";
+    msgs[msgs_qty].msg = link_flags;
+    msgs[msgs_qty++].len = nlfilter_link_build(link_flags, sizeof(link_flags), "ath0", IFF_UP);
+
+    target_len = ioctl80211_nlfilter_build(&g_target_filter, target_prog, IOCTL80211_NLFILTER_PROG_MAX);
+    bsal_len = ioctl80211_nlfilter_build(&g_bsal_filter, bsal_prog, IOCTL80211_NLFILTER_PROG_MAX);
+    if (target_len < 0 || bsal_len < 0)
+    {
+        printf("FAIL building filters (%d, %d)\n", target_len, bsal_len);
+        return 1;
+    }
+
+    for (i = 0; i < msgs_qty; i++)
+    {
+        const char *n = msgs[i].name;
+
+        /* Everything but other address families and probe requests */
+        nlfilter_expect("target", target_prog, target_len, &msgs[i],
+                        strncmp(n, "RTM_NEWADDR", 11) && strcmp(n, "IWEVASSOCREQIE"));
+
+        /* Link creation, renames, removal and management frames only */
+        nlfilter_expect("bsal", bsal_prog, bsal_len, &msgs[i],
+                        !strcmp(n, "RTM_NEWLINK (create)") ||
+                        !strcmp(n, "RTM_NEWLINK (notify)") ||
+                        !strcmp(n, "RTM_NEWLINK (rename)") ||
+                        !strcmp(n, "RTM_DELLINK") ||
+                        !strcmp(n, "IWEVASSOCREQIE"));
+    }
+
+    printf("nlfilter: %d messages, %d tests, %d failed\n", msgs_qty, g_tests, g_failed);
+    return g_failed ? 1 : 0;
+}
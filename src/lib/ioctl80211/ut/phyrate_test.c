@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Phyrate table tests
+ *
+ * Expected rates are the ones listed in the 802.11 HT, VHT and HE MCS
+ * tables, in kbps and rounded to nearest.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ioctl80211_phyrate.h"
+
+typedef struct
+{
+    ioctl80211_phy_t                phy;
+    int                             bw;
+    int                             nss;
+    int                             mcs;
+    ioctl80211_gi_t                 gi;
+    uint32_t                        kbps;
+} phyrate_test_t;
+
+static const phyrate_test_t g_phyrate_tests[] =
+{
+    /* HT */
+    { IOCTL80211_PHY_HT,  0, 1,  0, IOCTL80211_GI_800,      6500 },
+    { IOCTL80211_PHY_HT,  0, 1,  7, IOCTL80211_GI_800,     65000 },
+    { IOCTL80211_PHY_HT,  0, 1,  7, IOCTL80211_GI_400,     72222 },
+    { IOCTL80211_PHY_HT,  1, 1,  0, IOCTL80211_GI_800,     13500 },
+    { IOCTL80211_PHY_HT,  1, 2,  7, IOCTL80211_GI_400,    300000 },
+    { IOCTL80211_PHY_HT,  1, 4,  7, IOCTL80211_GI_800,    540000 },
+    /* VHT */
+    { IOCTL80211_PHY_VHT, 0, 1,  8, IOCTL80211_GI_800,     78000 },
+    { IOCTL80211_PHY_VHT, 2, 1,  9, IOCTL80211_GI_400,    433333 },
+    { IOCTL80211_PHY_VHT, 2, 2,  9, IOCTL80211_GI_800,    780000 },
+    { IOCTL80211_PHY_VHT, 3, 2,  9, IOCTL80211_GI_800,   1560000 },
+    { IOCTL80211_PHY_VHT, 3, 8,  9, IOCTL80211_GI_400,   6933333 },
+    /* HE */
+    { IOCTL80211_PHY_HE,  0, 1,  0, IOCTL80211_GI_3200,     7313 },
+    { IOCTL80211_PHY_HE,  0, 1,  0, IOCTL80211_GI_800,      8603 },
+    { IOCTL80211_PHY_HE,  0, 1, 11, IOCTL80211_GI_800,    143382 },
+    { IOCTL80211_PHY_HE,  1, 2, 11, IOCTL80211_GI_1600,   541667 },
+    { IOCTL80211_PHY_HE,  2, 1, 11, IOCTL80211_GI_800,    600490 },
+    { IOCTL80211_PHY_HE,  3, 2, 11, IOCTL80211_GI_800,   2401961 },
+    { IOCTL80211_PHY_HE,  3, 8, 11, IOCTL80211_GI_800,   9607843 },
+    /* Guard intervals a phy does not define */
+    { IOCTL80211_PHY_HE,  0, 1,  0, IOCTL80211_GI_400,         0 },
+    { IOCTL80211_PHY_VHT, 0, 1,  0, IOCTL80211_GI_1600,        0 },
+    { IOCTL80211_PHY_HT,  0, 1,  0, IOCTL80211_GI_3200,        0 },
+    /* Invalid MCS, stream and bandwidth combinations */
+    { IOCTL80211_PHY_HT,  0, 1,  8, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_HT,  1, 2,  9, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_HT,  2, 1,  7, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_HT,  0, 5,  0, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_VHT, 0, 1,  9, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_VHT, 0, 3,  9, IOCTL80211_GI_800,    260000 },
+    { IOCTL80211_PHY_VHT, 2, 3,  6, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_VHT, 2, 2,  6, IOCTL80211_GI_800,    526500 },
+    { IOCTL80211_PHY_VHT, 3, 3,  9, IOCTL80211_GI_800,         0 },
+    { IOCTL80211_PHY_VHT, 0, 1, 10, IOCTL80211_GI_800,         0 },
+    /* Out of range arguments are clamped */
+    { IOCTL80211_PHY_HT,  0, 0,  0, IOCTL80211_GI_800,      6500 },
+    { IOCTL80211_PHY_VHT, 9, 1,  9, IOCTL80211_GI_800,    780000 },
+    { IOCTL80211_PHY_HE,  2, 1, 99, IOCTL80211_GI_800,    600490 },
+    { IOCTL80211_PHY_HE, -1, 9, -1, IOCTL80211_GI_800,     68824 },
+    { IOCTL80211_PHY_QTY, 0, 1,  0, IOCTL80211_GI_800,         0 },
+};
+
+int main(void)
+{
+    const phyrate_test_t           *t;
+    uint32_t                        kbps;
+    unsigned int                    i;
+    int                             failed = 0;
+
+    for (i = 0; i < sizeof(g_phyrate_tests) / sizeof(g_phyrate_tests[0]); i++)
+    {
+        t = &g_phyrate_tests[i];
+        kbps = ioctl80211_phyrate_kbps(t->phy, t->bw, t->nss, t->mcs, t->gi);
+        if (kbps != t->kbps)
+        {
+            printf("FAIL phy %d bw %d nss %d mcs %d gi %d: %u kbps, expected %u\n",
+                   t->phy, t->bw, t->nss, t->mcs, t->gi, kbps, t->kbps);
+            failed++;
+        }
+    }
+
+    printf("phyrate: %u tests, %d failed\n", i, failed);
+    return failed ? 1 : 0;
+}
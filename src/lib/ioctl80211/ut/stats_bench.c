@@ -0,0 +1,761 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Stats fetch and conversion benchmark
+ *
+ * Runs the survey, scan, capacity and client code of the library against
+ * a synthetic driver that answers the PS UAPI and wireless extension
+ * requests from fixed tables: one 5G radio with four VAPs, 50 surveyed
+ * channels and a scan of 300 neighbor APs, every fourth of them with a
+ * second SSID. Driver counters advance on every read so each sweep
+ * converts non-zero deltas.
+ *
+ * Client conversion is swept from 1 to 512 clients, each with every
+ * MCS/NSS/BW bucket of its rx and tx histograms changing between the
+ * two samples.
+ *
+ * Time and allocations per converted record of every stage are printed
+ * and written to stats_bench.json, or the path given as argument, for
+ * comparing runs.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "util.h"
+#include "memutil.h"
+
+#include "ioctl80211.h"
+#include "ioctl80211_survey.h"
+#include "ioctl80211_scan.h"
+#include "ioctl80211_capacity.h"
+#include "ioctl80211_client.h"
+#include "ioctl80211_linkstats.h"
+#include "ioctl80211_pool.h"
+
+#define BENCH_CHANS         50
+#define BENCH_APS           300
+#define BENCH_VAPS          4
+#define BENCH_CLIENTS_MAX   512
+#define BENCH_SWEEPS        200
+#define BENCH_SCAN_STREAM   0xFFFF  /* iwreq length limit */
+#define BENCH_JSON_PATH     "stats_bench.json"
+
+/* Survey, scan, capacity and one client stage per power of two */
+#define BENCH_STAGE_MAX     16
+
+typedef struct
+{
+    char                            name[32];
+    uint64_t                      (*run)(uint32_t arg, uint32_t *qty);
+    uint32_t                        arg;
+    uint32_t                        qty;        /* records per sweep */
+    uint64_t                        min_ns;
+    uint64_t                        total_ns;
+    uint64_t                        allocs;
+    uint64_t                        pool_allocs;
+} bench_stage_t;
+
+/* Every 5 GHz 20, 40 and 80 MHz channel */
+static const uint32_t               g_chans[BENCH_CHANS] = {
+    36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116,
+    120, 124, 128, 132, 136, 140, 144, 149, 153, 157, 161, 165,
+    32, 68, 96, 169, 173, 177,
+    38, 46, 54, 62, 102, 110, 118, 126, 134, 142, 151, 159, 167, 175,
+    42, 58, 106, 122, 138
+};
+
+static radio_entry_t                g_radio = {
+    .type       = RADIO_TYPE_5G,
+    .phy_name   = "wifi1",
+    .if_name    = "home-ap-50",
+    .chan       = 36,
+};
+
+static uint64_t                     g_tick;     /* driver reads so far */
+static char                         g_scan_stream[BENCH_SCAN_STREAM];
+static size_t                       g_scan_stream_len;
+static uint32_t                     g_scan_entries;
+static ev_timer                    *g_timer;
+static uint64_t                     g_allocs;   /* heap allocations so far */
+
+static ioctl80211_survey_record_t  *g_onchan_old;
+static ioctl80211_survey_record_t  *g_offchan_old[BENCH_CHANS];
+
+static ioctl80211_client_record_t  *g_clients_old[BENCH_CLIENTS_MAX];
+static ioctl80211_client_record_t  *g_clients_new[BENCH_CLIENTS_MAX];
+
+static bench_stage_t                g_stages[BENCH_STAGE_MAX];
+static int                          g_stage_qty;
+
+/******************************************************************************
+ *  Heap accounting, linked with --wrap
+ *****************************************************************************/
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    g_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    g_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    g_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+/******************************************************************************
+ *  Synthetic driver
+ *****************************************************************************/
+
+int ioctl80211_fd_get(void)
+{
+    return -1;
+}
+
+static void bench_driver_ps_uapi(struct ps_uapi_ioctl *data)
+{
+    uint64_t                        t = ++g_tick;
+    int                             i;
+
+    switch (data->cmd)
+    {
+        case PS_UAPI_IOCTL_CMD_SURVEY_BSS:
+            data->u.survey_bss.get.freq     = 5180;
+            data->u.survey_bss.get.total    = t * 100000;
+            data->u.survey_bss.get.busy     = t * 37000;
+            data->u.survey_bss.get.tx       = t * 11000;
+            data->u.survey_bss.get.rx       = t * 21000;
+            data->u.survey_bss.get.rx_bss   = t * 9000;
+            data->u.survey_bss.get.busy_ext = t * 3000;
+            data->u.survey_bss.get.nf       = -95;
+            break;
+        case PS_UAPI_IOCTL_CMD_SURVEY_CHAN:
+            for (i = 0; i < BENCH_CHANS; i++)
+            {
+                data->u.survey_chan.get.channels[i].freq  = 5000 + 5 * g_chans[i];
+                data->u.survey_chan.get.channels[i].total = t * 50000;
+                data->u.survey_chan.get.channels[i].busy  = t * (5000 + i * 1000);
+                data->u.survey_chan.get.channels[i].tx    = t * (100 + i * 10);
+                data->u.survey_chan.get.channels[i].rx    = t * (2000 + i * 500);
+                data->u.survey_chan.get.channels[i].nf    = -95 + i % 4;
+            }
+            break;
+        case PS_UAPI_IOCTL_CMD_Q_UTIL:
+            for (i = 0; i < PS_MAX_Q_UTIL; i++)
+            {
+                data->u.q_util.get.q[i] = t * (i + 1) * 10;
+            }
+            data->u.q_util.get.cnt = t * 100;
+            break;
+        default:
+            break;
+    }
+}
+
+int ioctl80211_request_send(
+        int                     sock_fd,
+        const char             *ifname,
+        int                     command,
+        struct iwreq           *request)
+{
+    (void)sock_fd;
+    (void)ifname;
+
+    switch (command)
+    {
+        case PS_UAPI_IOCTL_SET:
+        case SIOCSIWSCAN:
+            return 0;
+        case PS_UAPI_IOCTL_GET:
+            bench_driver_ps_uapi(request->u.data.pointer);
+            return 0;
+        case SIOCGIWSCAN:
+            if (request->u.data.length < g_scan_stream_len)
+            {
+                request->u.data.length = g_scan_stream_len;
+                errno = E2BIG;
+                return -1;
+            }
+            memcpy(request->u.data.pointer, g_scan_stream, g_scan_stream_len);
+            request->u.data.length = g_scan_stream_len;
+            return 0;
+        default:
+            break;
+    }
+
+    errno = EOPNOTSUPP;
+    return -1;
+}
+
+ioctl_status_t ioctl80211_interfaces_lookup(
+        radio_type_t            type,
+        ioctl80211_interfaces_t *interfaces)
+{
+    uint32_t                        i;
+
+    interfaces->phy = CALLOC(BENCH_VAPS, sizeof(*interfaces->phy));
+    interfaces->qty = BENCH_VAPS;
+    interfaces->size = BENCH_VAPS;
+
+    for (i = 0; i < interfaces->qty; i++)
+    {
+        snprintf(interfaces->phy[i].ifname, sizeof(interfaces->phy[i].ifname),
+                 "home-ap-5%u", i);
+        interfaces->phy[i].radio_type = type;
+    }
+
+    return IOCTL_STATUS_OK;
+}
+
+void ioctl80211_interfaces_free(
+        ioctl80211_interfaces_t *interfaces)
+{
+    FREE(interfaces->phy);
+    memset(interfaces, 0, sizeof(*interfaces));
+}
+
+bool ioctl80211_linkstats_tx_bytes_get(
+        const char                     *ifname,
+        uint64_t                        max_age_ms,
+        uint64_t                       *tx_bytes)
+{
+    (void)max_age_ms;
+
+    *tx_bytes = g_tick * 1500 * (ifname[strlen(ifname) - 1] - '0' + 1);
+    return true;
+}
+
+/* Scan results as the driver streams them, one TLV event per field */
+static char *bench_scan_event(char *p, uint16_t cmd, size_t len)
+{
+    struct iw_event                *iwe = (struct iw_event *)p;
+
+    len = (len + 7) & ~7;
+    memset(p, 0, len);
+    iwe->cmd = cmd;
+    iwe->len = len;
+
+    return p + len;
+}
+
+static char *bench_scan_point(char *p, uint16_t cmd, const char *payload)
+{
+    size_t                          plen = strlen(payload);
+    uint16_t                       *hdr = (uint16_t *)(p + IW_EV_LCP_LEN);
+    char                           *end;
+
+    end = bench_scan_event(p, cmd, IW_EV_POINT_LEN + plen);
+    hdr[0] = plen;
+    memcpy(&hdr[2], payload, plen);
+
+    return end;
+}
+
+static void bench_scan_stream_init(void)
+{
+    struct iw_event                *iwe;
+    char                           *p = g_scan_stream;
+    char                            ssid[IW_ESSID_MAX_SIZE];
+    int                             i;
+    int                             s;
+
+    for (i = 0; i < BENCH_APS; i++)
+    {
+        for (s = 0; s < (i % 4 ? 1 : 2); s++)
+        {
+            iwe = (struct iw_event *)p;
+            p = bench_scan_event(p, SIOCGIWAP, IW_EV_ADDR_LEN);
+            iwe->u.ap_addr.sa_data[0] = 0x02;
+            iwe->u.ap_addr.sa_data[4] = i >> 8;
+            iwe->u.ap_addr.sa_data[5] = i & 0xff;
+
+            iwe = (struct iw_event *)p;
+            p = bench_scan_event(p, SIOCGIWFREQ, IW_EV_FREQ_LEN);
+            iwe->u.freq.m = (5000 + 5 * g_chans[i % BENCH_CHANS]) * 100000;
+            iwe->u.freq.e = 1;
+
+            snprintf(ssid, sizeof(ssid), s ? "bench-%03d-guest" : "bench-%03d", i);
+            p = bench_scan_point(p, SIOCGIWESSID, ssid);
+
+            /* Driver adds the noise floor of 161 (-95 dBm) to the RSSI */
+            iwe = (struct iw_event *)p;
+            p = bench_scan_event(p, IWEVQUAL, IW_EV_QUAL_LEN);
+            iwe->u.qual.updated = IW_QUAL_ALL_UPDATED | IW_QUAL_DBM;
+            iwe->u.qual.noise = 161;
+            iwe->u.qual.level = 161 + 10 + i % 50;
+
+            p = bench_scan_point(p, IWEVCUSTOM, i % 3 ?
+                                 "phy_mode=IEEE80211_MODE_11AC_VHT80" :
+                                 "phy_mode=IEEE80211_MODE_11NA_HT40PLUS");
+
+            g_scan_entries++;
+        }
+    }
+
+    g_scan_stream_len = p - g_scan_stream;
+}
+
+/******************************************************************************
+ *  Event loop
+ *****************************************************************************/
+
+void ev_timer_again(struct ev_loop *loop, ev_timer *w)
+{
+    (void)loop;
+
+    w->active = 1;
+    g_timer = w;
+}
+
+void ev_timer_stop(struct ev_loop *loop, ev_timer *w)
+{
+    (void)loop;
+
+    w->active = 0;
+    if (g_timer == w)
+        g_timer = NULL;
+}
+
+/* Polls until no timer is armed, the driver never reports EAGAIN */
+static void bench_loop_run(void)
+{
+    while (g_timer != NULL)
+        g_timer->cb(EV_DEFAULT, g_timer, 0);
+}
+
+/******************************************************************************
+ *  Stages
+ *****************************************************************************/
+
+static uint64_t bench_survey(uint32_t arg, uint32_t *qty)
+{
+    ds_dlist_t                      list = DS_DLIST_INIT(ioctl80211_survey_record_t, node);
+    ioctl80211_survey_record_t     *rec;
+    dpp_survey_record_t             out;
+    uint32_t                        chan = g_radio.chan;
+    uint64_t                        sum = 0;
+    uint32_t                        i;
+
+    (void)arg;
+
+    *qty = 0;
+    ioctl80211_survey_snapshot_invalidate(&g_radio);
+
+    if (IOCTL_STATUS_OK !=
+            ioctl80211_survey_results_get(&g_radio, &chan, 1, RADIO_SCAN_TYPE_ONCHAN, &list))
+        return 0;
+
+    rec = ds_dlist_remove_head(&list);
+    if (g_onchan_old != NULL)
+    {
+        memset(&out, 0, sizeof(out));
+        if (IOCTL_STATUS_OK ==
+                ioctl80211_survey_results_convert(&g_radio, RADIO_SCAN_TYPE_ONCHAN,
+                                                  rec, g_onchan_old, &out))
+        {
+            sum += out.chan_busy + out.chan_tx + out.chan_self + out.duration_ms;
+            (*qty)++;
+        }
+        ioctl80211_survey_record_free(g_onchan_old);
+    }
+    g_onchan_old = rec;
+
+    if (IOCTL_STATUS_OK !=
+            ioctl80211_survey_results_get(&g_radio, (uint32_t *)g_chans, BENCH_CHANS,
+                                          RADIO_SCAN_TYPE_OFFCHAN, &list))
+        return 0;
+
+    for (i = 0; (rec = ds_dlist_remove_head(&list)) != NULL; i++)
+    {
+        if (g_offchan_old[i] != NULL)
+        {
+            memset(&out, 0, sizeof(out));
+            if (IOCTL_STATUS_OK ==
+                    ioctl80211_survey_results_convert(&g_radio, RADIO_SCAN_TYPE_OFFCHAN,
+                                                      rec, g_offchan_old[i], &out))
+            {
+                sum += out.chan_busy + out.chan_tx + out.chan_rx + out.duration_ms;
+                (*qty)++;
+            }
+            ioctl80211_survey_record_free(g_offchan_old[i]);
+        }
+        g_offchan_old[i] = rec;
+    }
+
+    return sum;
+}
+
+static bool bench_scan_cb(void *scan_ctx, int status)
+{
+    *(int *)scan_ctx = status;
+    return true;
+}
+
+static uint64_t bench_scan(uint32_t arg, uint32_t *qty)
+{
+    dpp_neighbor_report_data_t      report;
+    dpp_neighbor_record_list_t     *neighbor;
+    uint64_t                        sum = 0;
+    int                             status = false;
+
+    (void)arg;
+
+    *qty = 0;
+    memset(&report, 0, sizeof(report));
+    ds_dlist_init(&report.list, dpp_neighbor_record_list_t, node);
+
+    if (IOCTL_STATUS_OK !=
+            ioctl80211_scan_channel(&g_radio, (uint32_t *)g_chans, BENCH_CHANS,
+                                    RADIO_SCAN_TYPE_OFFCHAN, 110, bench_scan_cb, &status))
+        return 0;
+
+    bench_loop_run();
+    if (!status)
+        return 0;
+
+    if (IOCTL_STATUS_OK !=
+            ioctl80211_scan_results_get(&g_radio, (uint32_t *)g_chans, BENCH_CHANS,
+                                        RADIO_SCAN_TYPE_OFFCHAN, &report))
+        return 0;
+
+    while ((neighbor = ds_dlist_remove_head(&report.list)) != NULL)
+    {
+        sum += neighbor->entry.chan + neighbor->entry.sig + neighbor->entry.chanwidth;
+        (*qty)++;
+        dpp_neighbor_record_free(neighbor);
+    }
+
+    return sum;
+}
+
+static uint64_t bench_capacity(uint32_t arg, uint32_t *qty)
+{
+    ioctl80211_capacity_data_t      capacity;
+    uint64_t                        sum;
+    int                             i;
+
+    (void)arg;
+
+    *qty = 0;
+    memset(&capacity, 0, sizeof(capacity));
+    ioctl80211_survey_snapshot_invalidate(&g_radio);
+
+    if (IOCTL_STATUS_OK != ioctl80211_capacity_results_get(&g_radio, &capacity))
+        return 0;
+
+    sum = capacity.bytes_tx + capacity.chan_active + capacity.chan_tx + capacity.samples;
+    for (i = 0; i < RADIO_QUEUE_MAX_QTY; i++)
+        sum += capacity.queue[i];
+
+    *qty = 1;
+    return sum;
+}
+
+/* Two samples of every client, all rx and tx buckets and every TID
+ * sojourn counter advanced in between */
+static void bench_clients_init(void)
+{
+    ioctl80211_client_record_t     *old;
+    ioctl80211_client_record_t     *new;
+    uint32_t                        d;
+    int                             i;
+    int                             b;
+
+    for (i = 0; i < BENCH_CLIENTS_MAX; i++)
+    {
+        old = ioctl80211_client_record_alloc();
+        memset(old, 0, sizeof(*old));
+        old->is_client = true;
+        old->info.type = g_radio.type;
+        old->info.mac[0] = 0x02;
+        old->info.mac[4] = i >> 8;
+        old->info.mac[5] = i & 0xff;
+        snprintf(old->info.ifname, sizeof(old->info.ifname),
+                 "home-ap-5%d", i % BENCH_VAPS);
+        old->stats.client.bytes_tx  = 1000000 * (i + 1);
+        old->stats.client.bytes_rx  = 2000000 * (i + 1);
+        old->stats.client.frames_tx = 1000 * (i + 1);
+        old->stats.client.frames_rx = 2000 * (i + 1);
+        old->stats.client.rssi      = 20 + i % 40;
+        old->stats.client.rate_tx   = 866700;
+        old->stats.client.rate_rx   = 650000;
+
+        for (b = 0; b < PS_MAX_ALL; b++)
+        {
+            old->stats_rx.u.peer_rx_stats.get.stats[b].num_bytes = (i + b) * 15000;
+            old->stats_rx.u.peer_rx_stats.get.stats[b].num_msdus = (i + b) * 10;
+            old->stats_rx.u.peer_rx_stats.get.stats[b].num_mpdus = (i + b) * 10;
+            old->stats_rx.u.peer_rx_stats.get.stats[b].num_ppdus = (i + b);
+            old->stats_rx.u.peer_rx_stats.get.stats[b].ave_rssi  = 30 + b % 20;
+            old->stats_tx.u.peer_tx_stats.get.stats[b].attempts  = (i + b) * 12;
+            old->stats_tx.u.peer_tx_stats.get.stats[b].success   = (i + b) * 10;
+            old->stats_tx.u.peer_tx_stats.get.stats[b].ppdus     = (i + b);
+        }
+
+        new = ioctl80211_client_record_alloc();
+        memcpy(new, old, sizeof(*new));
+        new->stats.client.bytes_tx  += 150000;
+        new->stats.client.bytes_rx  += 300000;
+        new->stats.client.frames_tx += 100;
+        new->stats.client.frames_rx += 200;
+
+        for (b = 0; b < PS_MAX_ALL; b++)
+        {
+            d = 1 + (i + b) % 64;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_bytes   += d * 1500;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_msdus   += d;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_mpdus   += d;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_ppdus   += 1 + d / 16;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_retries += d / 8;
+            new->stats_rx.u.peer_rx_stats.get.stats[b].num_sgi     += d / 2;
+            new->stats_tx.u.peer_tx_stats.get.stats[b].attempts    += d + d / 10;
+            new->stats_tx.u.peer_tx_stats.get.stats[b].success     += d;
+            new->stats_tx.u.peer_tx_stats.get.stats[b].ppdus       += 1 + d / 16;
+        }
+
+        for (b = 0; b < PS_MAX_TID; b++)
+        {
+            new->stats_tx.u.peer_tx_stats.get.sojourn[b].ave_sojourn_msec  = 5 + b;
+            new->stats_tx.u.peer_tx_stats.get.sojourn[b].sum_sojourn_msec  += 100 + b;
+            new->stats_tx.u.peer_tx_stats.get.sojourn[b].num_sojourn_mpdus += 20 + b;
+        }
+
+        g_clients_old[i] = old;
+        g_clients_new[i] = new;
+    }
+}
+
+static void bench_client_record_clear(dpp_client_record_t *out)
+{
+    void                           *p;
+
+    while ((p = ds_dlist_remove_head(&out->stats_rx)) != NULL)
+        free(p);
+    while ((p = ds_dlist_remove_head(&out->stats_tx)) != NULL)
+        free(p);
+    while ((p = ds_dlist_remove_head(&out->tid_record_list)) != NULL)
+        free(p);
+}
+
+static uint64_t bench_client(uint32_t clients, uint32_t *qty)
+{
+    dpp_client_record_t             out;
+    uint64_t                        sum = 0;
+    uint32_t                        i;
+
+    *qty = 0;
+    ds_dlist_init(&out.stats_rx, dpp_client_stats_rx_t, node);
+    ds_dlist_init(&out.stats_tx, dpp_client_stats_tx_t, node);
+    ds_dlist_init(&out.tid_record_list, dpp_client_tid_record_list_t, node);
+
+    for (i = 0; i < clients; i++)
+    {
+        memset(&out.stats, 0, sizeof(out.stats));
+
+        if (IOCTL_STATUS_OK !=
+                ioctl80211_client_stats_convert(&g_radio, g_clients_new[i],
+                                                g_clients_old[i], &out))
+            break;
+
+        sum += out.stats.bytes_tx + out.stats.frames_rx + out.stats.retries_tx +
+               (uint64_t)out.stats.rate_tx + (uint64_t)out.stats.rate_rx;
+        (*qty)++;
+
+        bench_client_record_clear(&out);
+    }
+
+    bench_client_record_clear(&out);
+    return sum;
+}
+
+static void bench_stage_add(
+        const char                     *name,
+        uint64_t                      (*run)(uint32_t arg, uint32_t *qty),
+        uint32_t                        arg,
+        uint32_t                        qty)
+{
+    bench_stage_t                  *stage = &g_stages[g_stage_qty++];
+
+    STRSCPY(stage->name, name);
+    stage->run = run;
+    stage->arg = arg;
+    stage->qty = qty;
+    stage->min_ns = UINT64_MAX;
+}
+
+static void bench_stages_init(void)
+{
+    char                            name[32];
+    uint32_t                        clients;
+
+    bench_stage_add("survey", bench_survey, 0, 1 + BENCH_CHANS);
+    bench_stage_add("scan", bench_scan, 0, BENCH_APS);
+    bench_stage_add("capacity", bench_capacity, 0, 1);
+
+    for (clients = 1; clients <= BENCH_CLIENTS_MAX; clients *= 2)
+    {
+        snprintf(name, sizeof(name), "client_x%u", clients);
+        bench_stage_add(name, bench_client, clients, clients);
+    }
+}
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec                 ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool bench_json_write(const char *path)
+{
+    bench_stage_t                  *stage;
+    FILE                           *f;
+    int                             i;
+
+    f = fopen(path, "w");
+    if (NULL == f)
+    {
+        fprintf(stderr, "stats: failed to write %s (%s)\n", path, strerror(errno));
+        return false;
+    }
+
+    /* Figures per converted record, ns_per_op of the fastest sweep */
+    fprintf(f, "{\n  \"sweeps\": %d,\n  \"stages\": {", BENCH_SWEEPS);
+    for (i = 0; i < g_stage_qty; i++)
+    {
+        stage = &g_stages[i];
+        fprintf(f, "%s\n    \"%s\": { \"ops\": %u, \"ns_per_op\": %.1f, "
+                "\"avg_ns_per_op\": %.1f, \"allocs_per_op\": %.2f, "
+                "\"pool_allocs_per_op\": %.2f }",
+                i ? "," : "",
+                stage->name,
+                stage->qty,
+                (double)stage->min_ns / stage->qty,
+                (double)stage->total_ns / BENCH_SWEEPS / stage->qty,
+                (double)stage->allocs / BENCH_SWEEPS / stage->qty,
+                (double)stage->pool_allocs / BENCH_SWEEPS / stage->qty);
+    }
+    fprintf(f, "\n  }\n}\n");
+
+    return fclose(f) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char                     *json_path = argc > 1 ? argv[1] : BENCH_JSON_PATH;
+    bench_stage_t                  *stage;
+    uint64_t                        start;
+    uint64_t                        allocs;
+    uint64_t                        pool_allocs;
+    uint64_t                        ns;
+    uint64_t                        sum;
+    uint32_t                        qty;
+    int                             s;
+    int                             i;
+
+    bench_scan_stream_init();
+    bench_clients_init();
+    bench_stages_init();
+
+    /* First sweep only primes the previous samples and result storage */
+    for (s = 0; s < g_stage_qty; s++)
+        g_stages[s].run(g_stages[s].arg, &qty);
+
+    for (i = 0; i < BENCH_SWEEPS; i++)
+    {
+        for (s = 0; s < g_stage_qty; s++)
+        {
+            stage = &g_stages[s];
+
+            allocs = g_allocs;
+            pool_allocs = ioctl80211_pool_alloc_count();
+            start = bench_now_ns();
+            sum = stage->run(stage->arg, &qty);
+            ns = bench_now_ns() - start;
+
+            if (qty != stage->qty)
+            {
+                fprintf(stderr, "%s: sweep %d yielded %u records, expected %u\n",
+                        stage->name, i, qty, stage->qty);
+                return 1;
+            }
+
+            /* Driver counters advance, records must carry the deltas */
+            if (sum == 0)
+            {
+                fprintf(stderr, "%s: sweep %d converted only zero deltas\n",
+                        stage->name, i);
+                return 1;
+            }
+
+            stage->allocs += g_allocs - allocs;
+            stage->pool_allocs += ioctl80211_pool_alloc_count() - pool_allocs;
+            stage->total_ns += ns;
+            if (ns < stage->min_ns)
+                stage->min_ns = ns;
+        }
+    }
+
+    printf("stats: %d survey chans, %u scan entries (%zu B) of %d APs, %d VAPs\n",
+           BENCH_CHANS, g_scan_entries, g_scan_stream_len, BENCH_APS, BENCH_VAPS);
+    for (s = 0; s < g_stage_qty; s++)
+    {
+        stage = &g_stages[s];
+        printf("stats: %-11s %3u records, sweep min %7.1f us avg %7.1f us, "
+               "%5.0f ns/record, %5.2f allocs/record\n",
+               stage->name,
+               stage->qty,
+               stage->min_ns / 1000.0,
+               stage->total_ns / 1000.0 / BENCH_SWEEPS,
+               (double)stage->min_ns / stage->qty,
+               (double)stage->allocs / BENCH_SWEEPS / stage->qty);
+    }
+
+    if (!bench_json_write(json_path))
+        return 1;
+    printf("stats: results written to %s\n", json_path);
+
+    return 0;
+}
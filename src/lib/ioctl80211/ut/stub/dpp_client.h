@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync client report types. */
+
+#ifndef DPP_CLIENT_H_STUB_INCLUDED
+#define DPP_CLIENT_H_STUB_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ds_dlist.h"
+#include "dpp_types.h"
+
+#define CLIENT_MAX_TID_RECORDS  16
+
+typedef struct
+{
+    mac_address_t                   mac;
+    ifname_t                        ifname;
+    radio_essid_t                   essid;
+    radio_type_t                    type;
+} dpp_client_info_t;
+
+typedef struct
+{
+    uint64_t                        bytes_tx;
+    uint64_t                        bytes_rx;
+    uint64_t                        frames_tx;
+    uint64_t                        frames_rx;
+    uint64_t                        retries_rx;
+    uint64_t                        retries_tx;
+    uint64_t                        errors_rx;
+    uint64_t                        errors_tx;
+    double                          rate_rx;
+    double                          rate_tx;
+    int32_t                         rssi;
+} dpp_client_stats_t;
+
+typedef struct
+{
+    uint32_t                        bw;
+    uint32_t                        nss;
+    uint32_t                        mcs;
+    uint64_t                        bytes;
+    uint64_t                        msdu;
+    uint64_t                        mpdu;
+    uint64_t                        ppdu;
+    uint64_t                        retries;
+    uint64_t                        errors;
+    int32_t                         rssi;
+    ds_dlist_node_t                 node;
+} dpp_client_stats_rx_t;
+
+typedef struct
+{
+    uint32_t                        bw;
+    uint32_t                        nss;
+    uint32_t                        mcs;
+    uint64_t                        bytes;
+    uint64_t                        msdu;
+    uint64_t                        mpdu;
+    uint64_t                        ppdu;
+    uint64_t                        retries;
+    uint64_t                        errors;
+    ds_dlist_node_t                 node;
+} dpp_client_stats_tx_t;
+
+typedef struct
+{
+    radio_queue_type_t              ac;
+    uint32_t                        tid;
+    uint64_t                        ewma_time_ms;
+    uint64_t                        sum_time_ms;
+    uint64_t                        num_msdus;
+} dpp_client_stats_tid_t;
+
+typedef struct
+{
+    dpp_client_stats_tid_t          entry[CLIENT_MAX_TID_RECORDS];
+    uint64_t                        timestamp_ms;
+    ds_dlist_node_t                 node;
+} dpp_client_tid_record_list_t;
+
+typedef struct
+{
+    dpp_client_info_t               info;
+    dpp_client_stats_t              stats;
+    ds_dlist_t                      stats_rx;
+    ds_dlist_t                      stats_tx;
+    ds_dlist_t                      tid_record_list;
+    uint32_t                        uapsd;
+    ds_dlist_node_t                 node;
+} dpp_client_record_t;
+
+static inline dpp_client_stats_rx_t *dpp_client_stats_rx_record_alloc(void)
+{
+    return calloc(1, sizeof(dpp_client_stats_rx_t));
+}
+
+static inline dpp_client_stats_tx_t *dpp_client_stats_tx_record_alloc(void)
+{
+    return calloc(1, sizeof(dpp_client_stats_tx_t));
+}
+
+static inline dpp_client_tid_record_list_t *dpp_client_tid_record_alloc(void)
+{
+    return calloc(1, sizeof(dpp_client_tid_record_list_t));
+}
+
+#endif /* DPP_CLIENT_H_STUB_INCLUDED */
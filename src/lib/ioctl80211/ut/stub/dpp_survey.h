@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync survey report types. */
+
+#ifndef DPP_SURVEY_H_STUB_INCLUDED
+#define DPP_SURVEY_H_STUB_INCLUDED
+
+#include <stdint.h>
+
+#include "ds_dlist.h"
+#include "dpp_types.h"
+
+typedef struct
+{
+    uint32_t                        chan;
+    uint64_t                        timestamp_ms;
+} dpp_survey_info_t;
+
+typedef struct
+{
+    dpp_survey_info_t               info;
+    uint32_t                        chan_busy;
+    uint32_t                        chan_busy_ext;
+    uint32_t                        chan_self;
+    uint32_t                        chan_rx;
+    uint32_t                        chan_tx;
+    int32_t                         chan_noise;
+    uint32_t                        duration_ms;
+    ds_dlist_node_t                 node;
+} dpp_survey_record_t;
+
+#endif /* DPP_SURVEY_H_STUB_INCLUDED */
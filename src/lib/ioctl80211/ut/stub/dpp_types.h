@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync dpp types the ioctl80211 headers use. */
+
+#ifndef DPP_TYPES_H_STUB_INCLUDED
+#define DPP_TYPES_H_STUB_INCLUDED
+
+#include <stdint.h>
+
+typedef char    ifname_t[32];
+typedef uint8_t mac_address_t[6];
+typedef char    radio_essid_t[36];
+
+typedef enum
+{
+    RADIO_TYPE_NONE = 0,
+    RADIO_TYPE_2G,
+    RADIO_TYPE_5G,
+    RADIO_TYPE_5GL,
+    RADIO_TYPE_5GU,
+    RADIO_TYPE_6G
+} radio_type_t;
+
+typedef enum
+{
+    RADIO_SCAN_TYPE_NONE = 0,
+    RADIO_SCAN_TYPE_FULL,
+    RADIO_SCAN_TYPE_ONCHAN,
+    RADIO_SCAN_TYPE_OFFCHAN
+} radio_scan_type_t;
+
+typedef enum
+{
+    RADIO_CHAN_WIDTH_NONE = 0,
+    RADIO_CHAN_WIDTH_20MHZ,
+    RADIO_CHAN_WIDTH_40MHZ,
+    RADIO_CHAN_WIDTH_40MHZ_ABOVE,
+    RADIO_CHAN_WIDTH_40MHZ_BELOW,
+    RADIO_CHAN_WIDTH_80MHZ,
+    RADIO_CHAN_WIDTH_160MHZ,
+    RADIO_CHAN_WIDTH_80_PLUS_80MHZ
+} radio_chanwidth_t;
+
+typedef enum
+{
+    RADIO_QUEUE_TYPE_VI = 0,
+    RADIO_QUEUE_TYPE_VO,
+    RADIO_QUEUE_TYPE_BE,
+    RADIO_QUEUE_TYPE_BK,
+    RADIO_QUEUE_TYPE_CAB,
+    RADIO_QUEUE_TYPE_BCN,
+    RADIO_QUEUE_MAX_QTY,
+    RADIO_QUEUE_TYPE_NONE = RADIO_QUEUE_MAX_QTY
+} radio_queue_type_t;
+
+typedef struct
+{
+    radio_type_t                    type;
+    ifname_t                        phy_name;
+    ifname_t                        if_name;
+    uint32_t                        chan;
+} radio_entry_t;
+
+static inline const char *radio_get_name_from_type(radio_type_t type)
+{
+    return type == RADIO_TYPE_2G ? "2.4G" : "5G";
+}
+
+static inline const char *radio_get_scan_name_from_type(radio_scan_type_t type)
+{
+    return type == RADIO_SCAN_TYPE_ONCHAN ? "on-chan" : "off-chan";
+}
+
+static inline const char *radio_get_queue_name_from_type(radio_queue_type_t type)
+{
+    return type == RADIO_QUEUE_TYPE_BE ? "BE" : "other";
+}
+
+static inline uint32_t radio_get_chan_from_mhz(uint32_t freq)
+{
+    if (freq == 2484)
+        return 14;
+    if (freq >= 2412 && freq < 2484)
+        return (freq - 2407) / 5;
+    if (freq >= 5955)
+        return (freq - 5950) / 5;
+    if (freq >= 5000)
+        return (freq - 5000) / 5;
+    return 0;
+}
+
+#endif /* DPP_TYPES_H_STUB_INCLUDED */
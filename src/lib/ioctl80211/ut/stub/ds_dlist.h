@@ -0,0 +1,126 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync ds_dlist. */
+
+#ifndef DS_DLIST_H_STUB_INCLUDED
+#define DS_DLIST_H_STUB_INCLUDED
+
+#include <stddef.h>
+
+typedef struct ds_dlist_node
+{
+    struct ds_dlist_node           *odn_next;
+    struct ds_dlist_node           *odn_prev;
+} ds_dlist_node_t;
+
+typedef struct
+{
+    ds_dlist_node_t                *od_head;
+    ds_dlist_node_t                *od_tail;
+    size_t                          od_cof;
+} ds_dlist_t;
+
+typedef struct
+{
+    ds_dlist_t                     *odi_list;
+    ds_dlist_node_t                *odi_curr;
+    ds_dlist_node_t                *odi_next;
+} ds_dlist_iter_t;
+
+#define DS_DLIST_INIT(type, elem)       { NULL, NULL, offsetof(type, elem) }
+
+#define ds_dlist_init(list, type, elem) \
+    do { *(list) = (ds_dlist_t)DS_DLIST_INIT(type, elem); } while (0)
+
+static inline void ds_dlist_insert_tail(ds_dlist_t *list, void *data)
+{
+    ds_dlist_node_t                *node = (void *)((char *)data + list->od_cof);
+
+    node->odn_next = NULL;
+    node->odn_prev = list->od_tail;
+    if (list->od_tail != NULL)
+        list->od_tail->odn_next = node;
+    else
+        list->od_head = node;
+    list->od_tail = node;
+}
+
+static inline void *ds_dlist_remove_head(ds_dlist_t *list)
+{
+    ds_dlist_node_t                *node = list->od_head;
+
+    if (node == NULL)
+        return NULL;
+
+    list->od_head = node->odn_next;
+    if (list->od_head != NULL)
+        list->od_head->odn_prev = NULL;
+    else
+        list->od_tail = NULL;
+
+    return (char *)node - list->od_cof;
+}
+
+static inline void ds_dlist_remove(ds_dlist_t *list, void *data)
+{
+    ds_dlist_node_t                *node = (void *)((char *)data + list->od_cof);
+
+    if (node->odn_prev != NULL)
+        node->odn_prev->odn_next = node->odn_next;
+    else
+        list->od_head = node->odn_next;
+
+    if (node->odn_next != NULL)
+        node->odn_next->odn_prev = node->odn_prev;
+    else
+        list->od_tail = node->odn_prev;
+}
+
+static inline void *ds_dlist_inext(ds_dlist_iter_t *iter)
+{
+    iter->odi_curr = iter->odi_next;
+    if (iter->odi_curr == NULL)
+        return NULL;
+
+    iter->odi_next = iter->odi_curr->odn_next;
+    return (char *)iter->odi_curr - iter->odi_list->od_cof;
+}
+
+static inline void *ds_dlist_ifirst(ds_dlist_iter_t *iter, ds_dlist_t *list)
+{
+    iter->odi_list = list;
+    iter->odi_next = list->od_head;
+    return ds_dlist_inext(iter);
+}
+
+static inline void ds_dlist_iremove(ds_dlist_iter_t *iter)
+{
+    ds_dlist_remove(iter->odi_list,
+                    (char *)iter->odi_curr - iter->odi_list->od_cof);
+}
+
+#endif /* DS_DLIST_H_STUB_INCLUDED */
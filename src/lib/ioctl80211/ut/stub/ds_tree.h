@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync ds_tree. A sorted singly linked list
+ * behind the same calls, enough for the handful of radios the library
+ * keeps per tree.
+ */
+
+#ifndef DS_TREE_H_STUB_INCLUDED
+#define DS_TREE_H_STUB_INCLUDED
+
+#include <stddef.h>
+#include <string.h>
+
+typedef int ds_key_cmp_t(void *a, void *b);
+
+typedef struct ds_tree_node
+{
+    struct ds_tree_node            *otn_next;
+    void                           *otn_key;
+} ds_tree_node_t;
+
+typedef struct
+{
+    ds_key_cmp_t                   *ot_cmp_fn;
+    size_t                          ot_cof;
+    ds_tree_node_t                 *ot_head;
+} ds_tree_t;
+
+#define DS_TREE_INIT(cmp, type, elem)   { (ds_key_cmp_t *)(cmp), offsetof(type, elem), NULL }
+
+typedef struct
+{
+    ds_tree_t                      *oti_tree;
+    ds_tree_node_t                **oti_pos;
+    int                             oti_removed;
+} ds_tree_iter_t;
+
+#define ds_tree_init(tree, cmp, type, elem) \
+    do { *(tree) = (ds_tree_t)DS_TREE_INIT(cmp, type, elem); } while (0)
+
+static inline int ds_str_cmp(void *a, void *b)
+{
+    return strcmp(a, b);
+}
+
+static inline void *ds_tree_find(ds_tree_t *tree, void *key)
+{
+    ds_tree_node_t                 *node;
+
+    for (node = tree->ot_head; node != NULL; node = node->otn_next)
+    {
+        if (tree->ot_cmp_fn(node->otn_key, key) == 0)
+            return (char *)node - tree->ot_cof;
+    }
+
+    return NULL;
+}
+
+static inline void ds_tree_insert(ds_tree_t *tree, void *data, void *key)
+{
+    ds_tree_node_t                 *node = (void *)((char *)data + tree->ot_cof);
+    ds_tree_node_t                **pos = &tree->ot_head;
+
+    while (*pos != NULL && tree->ot_cmp_fn((*pos)->otn_key, key) < 0)
+        pos = &(*pos)->otn_next;
+
+    node->otn_key = key;
+    node->otn_next = *pos;
+    *pos = node;
+}
+
+static inline void ds_tree_remove(ds_tree_t *tree, void *data)
+{
+    ds_tree_node_t                 *node = (void *)((char *)data + tree->ot_cof);
+    ds_tree_node_t                **pos = &tree->ot_head;
+
+    while (*pos != NULL && *pos != node)
+        pos = &(*pos)->otn_next;
+
+    if (*pos != NULL)
+        *pos = node->otn_next;
+}
+
+static inline void *ds_tree_iget(ds_tree_iter_t *iter)
+{
+    ds_tree_node_t                 *node = *iter->oti_pos;
+
+    return node != NULL ? (char *)node - iter->oti_tree->ot_cof : NULL;
+}
+
+static inline void *ds_tree_ifirst(ds_tree_iter_t *iter, ds_tree_t *tree)
+{
+    iter->oti_tree = tree;
+    iter->oti_pos = &tree->ot_head;
+    iter->oti_removed = 0;
+    return ds_tree_iget(iter);
+}
+
+static inline void *ds_tree_inext(ds_tree_iter_t *iter)
+{
+    /* After a removal the successor already sits at the position */
+    if (!iter->oti_removed)
+        iter->oti_pos = &(*iter->oti_pos)->otn_next;
+    iter->oti_removed = 0;
+    return ds_tree_iget(iter);
+}
+
+static inline void ds_tree_iremove(ds_tree_iter_t *iter)
+{
+    *iter->oti_pos = (*iter->oti_pos)->otn_next;
+    iter->oti_removed = 1;
+}
+
+#endif /* DS_TREE_H_STUB_INCLUDED */
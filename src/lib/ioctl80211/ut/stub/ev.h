@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for libev. There is no loop, the program driving the
+ * library provides the timer calls and invokes the callbacks itself.
+ */
+
+#ifndef EV_H_STUB_INCLUDED
+#define EV_H_STUB_INCLUDED
+
+struct ev_loop;
+
+#define EV_P                struct ev_loop *loop
+#define EV_P_               EV_P,
+#define EV_DEFAULT          NULL
+
+typedef struct ev_timer
+{
+    int                     active;
+    double                  repeat;
+    void                   *data;
+    void                  (*cb)(EV_P_ struct ev_timer *w, int revents);
+} ev_timer;
+
+#define ev_init(w, cb_)     do { (w)->active = 0; (w)->cb = (cb_); } while (0)
+#define ev_is_active(w)     ((w)->active)
+
+void ev_timer_again(struct ev_loop *loop, ev_timer *w);
+void ev_timer_stop(struct ev_loop *loop, ev_timer *w);
+
+#endif /* EV_H_STUB_INCLUDED */
@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the QCA driver ioctl numbers, force included where
+ * ARCH_X86 leaves the driver headers out.
+ */
+
+#ifndef IEEE80211_EXTERNAL_H_STUB_INCLUDED
+#define IEEE80211_EXTERNAL_H_STUB_INCLUDED
+
+#include <stdint.h>
+#include <linux/sockios.h>
+#include <linux/wireless.h>
+
+#define IEEE80211_IOCTL_STA_STATS       (SIOCDEVPRIVATE + 5)
+#define IEEE80211_IOCTL_STA_INFO        (SIOCDEVPRIVATE + 6)
+#define IEEE80211_IOCTL_DBGREQ          (SIOCDEVPRIVATE + 14)
+#define IEEE80211_IOCTL_GETCHANINFO     (SIOCIWFIRSTPRIV + 7)
+#define SIOCG80211STATS                 (SIOCDEVPRIVATE + 2)
+
+/* Only the fields the library reads, layouts do not follow the driver */
+struct ieee80211req_sta_info
+{
+    uint16_t                        isi_len;
+    uint8_t                         isi_macaddr[6];
+    int8_t                          isi_rssi;
+    uint8_t                         isi_uapsd;
+    uint32_t                        isi_txratekbps;
+    uint32_t                        isi_rxratekbps;
+};
+
+struct ieee80211_nodestats
+{
+    uint64_t                        ns_rx_data;
+    uint64_t                        ns_rx_bytes;
+    uint64_t                        ns_rx_retries;
+    uint64_t                        ns_rx_unauth;
+    uint64_t                        ns_rx_decap;
+    uint64_t                        ns_rx_defrag;
+    uint64_t                        ns_rx_disassoc;
+    uint64_t                        ns_rx_deauth;
+    uint64_t                        ns_rx_decryptcrc;
+    uint64_t                        ns_rx_tkipmic;
+    uint64_t                        ns_rx_ccmpmic;
+    uint64_t                        ns_rx_wpimic;
+    uint64_t                        ns_rx_tkipicv;
+    uint64_t                        ns_tx_data_success;
+    uint64_t                        ns_tx_bytes_success;
+    uint64_t                        ns_tx_discard;
+    uint64_t                        ns_is_tx_not_ok;
+    uint64_t                        ns_is_tx_nobuf;
+};
+
+struct ieee80211req_sta_stats
+{
+    union {
+        uint8_t                     macaddr[6];
+        uint64_t                    pad;
+    } is_u;
+    struct ieee80211_nodestats      is_stats;
+};
+
+struct ieee80211_stats
+{
+    uint64_t                        is_rx_tooshort;
+    uint64_t                        is_rx_decap;
+    uint64_t                        is_rx_nobuf;
+    uint64_t                        is_tx_nobuf;
+    uint64_t                        is_tx_not_ok;
+};
+
+struct ieee80211_mac_stats
+{
+    uint64_t                        ims_tx_data_packets;
+    uint64_t                        ims_tx_data_bytes;
+    uint64_t                        ims_tx_discard;
+    uint64_t                        ims_rx_data_packets;
+    uint64_t                        ims_rx_data_bytes;
+    uint64_t                        ims_rx_fcserr;
+    uint64_t                        ims_rx_wepfail;
+    uint64_t                        ims_rx_decryptcrc;
+    uint64_t                        ims_rx_tkipmic;
+    uint64_t                        ims_rx_ccmpmic;
+    uint64_t                        ims_rx_wpimic;
+    uint64_t                        ims_rx_tkipicv;
+    uint32_t                        ims_last_tx_rate;
+};
+
+#endif /* IEEE80211_EXTERNAL_H_STUB_INCLUDED */
@@ -0,0 +1,47 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Host stand-in for the OpenSync logger. */
+
+#ifndef LOG_H_STUB_INCLUDED
+#define LOG_H_STUB_INCLUDED
+
+#include <stdio.h>
+
+#define LOG(level, fmt, ...)    do { (void)sizeof(printf(fmt, ##__VA_ARGS__)); } while (0)
+#define LOGE(fmt, ...)          LOG(0, fmt, ##__VA_ARGS__)
+#define LOGW(fmt, ...)          LOG(0, fmt, ##__VA_ARGS__)
+#define LOGI(fmt, ...)          LOG(0, fmt, ##__VA_ARGS__)
+#define LOGD(fmt, ...)          LOG(0, fmt, ##__VA_ARGS__)
+#define LOGT(fmt, ...)          LOG(0, fmt, ##__VA_ARGS__)
+
+#define LOG_SEVERITY_ERR        3
+#define LOG_SEVERITY_WARN       4
+
+#define mlog(sev, mod, fmt, ...) \
+    do { (void)(sev); (void)sizeof(printf(fmt, ##__VA_ARGS__)); } while (0)
+
+#endif /* LOG_H_STUB_INCLUDED */
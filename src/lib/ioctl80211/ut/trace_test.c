@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Driver request trace tests
+ *
+ * Records a vendor command answered through a callback and driver events
+ * around it, then replays the trace and checks the callback replies and
+ * events come back whole and in the order they were received.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "ioctl80211_trace.h"
+
+#define TRACE_TEST_CMD_CB           42
+#define TRACE_TEST_CMD_ERR          43
+#define TRACE_TEST_EVENT            7
+#define TRACE_TEST_LOG_MAX          16
+
+static const uint8_t g_event_1[] = { 0x08, 0x00, 0x01, 0x00, 0xaa, 0xbb, 0x00, 0x00 };
+static const uint8_t g_event_2[] = { 0x05, 0x00, 0x02, 0x00, 0xcc, 0x00, 0x00, 0x00 };
+/* Trailing zeros are part of the payload */
+static const uint8_t g_reply_1[] = { 0x0c, 0x00, 0x03, 0x00, 1, 2, 3, 4, 5, 6, 0, 0 };
+static const uint8_t g_reply_2[] = { 0x04, 0x00, 0x04, 0x00 };
+
+static char g_log[TRACE_TEST_LOG_MAX][32];
+static int g_log_len;
+static int g_failed;
+static int g_tests;
+
+static void trace_test_log(const char *what, const void *data, size_t len,
+                           const void *expected, size_t expected_len)
+{
+    bool ok = len == expected_len && memcmp(data, expected, len) == 0;
+
+    if (g_log_len < TRACE_TEST_LOG_MAX)
+        snprintf(g_log[g_log_len++], sizeof(g_log[0]), "%s%s", what, ok ? "" : " (corrupt)");
+}
+
+static void trace_test_event(const char *ifname, uint32_t cmd, void *data, size_t len)
+{
+    if (cmd != TRACE_TEST_EVENT) {
+        trace_test_log("event ?", NULL, 0, NULL, 1);
+    } else if (!strcmp(ifname, "ath0")) {
+        trace_test_log("event 1", data, len, g_event_1, sizeof(g_event_1));
+    } else {
+        trace_test_log("event 2", data, len, g_event_2, sizeof(g_event_2));
+    }
+}
+
+static void trace_test_cb(void *ctx, void *data, size_t len)
+{
+    (void)ctx;
+
+    if (len == sizeof(g_reply_1))
+        trace_test_log("reply 1", data, len, g_reply_1, sizeof(g_reply_1));
+    else
+        trace_test_log("reply 2", data, len, g_reply_2, sizeof(g_reply_2));
+}
+
+/* Stands in for send_command() calling back with two replies */
+static int trace_test_call_cb(void *ctx)
+{
+    strcpy(ctx, "response");
+    ioctl80211_trace_cb_record(g_reply_1, sizeof(g_reply_1));
+    ioctl80211_trace_cb_record(g_reply_2, sizeof(g_reply_2));
+    return 0;
+}
+
+static int trace_test_call_err(void *ctx)
+{
+    (void)ctx;
+
+    errno = EIO;
+    return -1;
+}
+
+static int trace_test_call_driver(void *ctx)
+{
+    (void)ctx;
+
+    trace_test_log("driver called", NULL, 0, NULL, 0);
+    return 0;
+}
+
+static void trace_test_expect(const char *name, int rc, int expected_rc, ...)
+{
+    const char *expected[TRACE_TEST_LOG_MAX];
+    const char *e;
+    va_list ap;
+    int n = 0;
+    int i;
+
+    va_start(ap, expected_rc);
+    while ((e = va_arg(ap, const char *)) != NULL && n < TRACE_TEST_LOG_MAX)
+        expected[n++] = e;
+    va_end(ap);
+
+    g_tests++;
+
+    if (rc != expected_rc || n != g_log_len) {
+        printf("FAIL %s: rc %d (expected %d), %d callbacks (expected %d)\n",
+               name, rc, expected_rc, g_log_len, n);
+        for (i = 0; i < g_log_len; i++)
+            printf("    %s\n", g_log[i]);
+        g_failed++;
+    } else {
+        for (i = 0; i < n; i++) {
+            if (strcmp(g_log[i], expected[i]) != 0) {
+                printf("FAIL %s: callback %d is '%s', expected '%s'\n",
+                       name, i, g_log[i], expected[i]);
+                g_failed++;
+                break;
+            }
+        }
+    }
+
+    g_log_len = 0;
+}
+
+int main(void)
+{
+    char buf[64];
+    int rc;
+
+    unlink(CONFIG_QCA_IOCTL80211_TRACE_FILE);
+    unlink(CONFIG_QCA_IOCTL80211_TRACE_FILE ".1");
+    unsetenv(IOCTL80211_TRACE_REPLAY_ENV);
+
+    /* Record */
+    ioctl80211_trace_event("ath0", TRACE_TEST_EVENT, g_event_1, sizeof(g_event_1));
+
+    memset(buf, 0, sizeof(buf));
+    rc = ioctl80211_trace_call_cb(IOCTL80211_TRACE_NL, "ath0", TRACE_TEST_CMD_CB,
+                                  NULL, 0, buf, sizeof(buf),
+                                  trace_test_call_cb, trace_test_cb, buf);
+    trace_test_expect("record callback", rc, 0, NULL);
+
+    ioctl80211_trace_event("ath1", TRACE_TEST_EVENT, g_event_2, sizeof(g_event_2));
+
+    rc = ioctl80211_trace_call(IOCTL80211_TRACE_NL, "ath0", TRACE_TEST_CMD_ERR,
+                               NULL, 0, NULL, 0, trace_test_call_err, NULL);
+    trace_test_expect("record error", rc, -1, NULL);
+
+    ioctl80211_trace_close();
+
+    /* Replay */
+    setenv(IOCTL80211_TRACE_REPLAY_ENV, CONFIG_QCA_IOCTL80211_TRACE_FILE, 1);
+    ioctl80211_trace_event_handler_set(trace_test_event);
+
+    memset(buf, 0, sizeof(buf));
+    rc = ioctl80211_trace_call_cb(IOCTL80211_TRACE_NL, "ath0", TRACE_TEST_CMD_CB,
+                                  NULL, 0, buf, sizeof(buf),
+                                  trace_test_call_driver, trace_test_cb, NULL);
+    trace_test_expect("replay callback", rc, 0, "event 1", "reply 1", "reply 2", NULL);
+
+    g_tests++;
+    if (strcmp(buf, "response") != 0) {
+        printf("FAIL replay callback: response '%s'\n", buf);
+        g_failed++;
+    }
+
+    errno = 0;
+    rc = ioctl80211_trace_call(IOCTL80211_TRACE_NL, "ath0", TRACE_TEST_CMD_ERR,
+                               NULL, 0, NULL, 0, trace_test_call_driver, NULL);
+    trace_test_expect("replay error", rc, -1, "event 2", NULL);
+
+    g_tests++;
+    if (errno != EIO) {
+        printf("FAIL replay error: errno %d, expected %d\n", errno, EIO);
+        g_failed++;
+    }
+
+    /* Without a callback the replies are skipped, events wrap around */
+    rc = ioctl80211_trace_call(IOCTL80211_TRACE_NL, "ath0", TRACE_TEST_CMD_CB,
+                               NULL, 0, buf, sizeof(buf), trace_test_call_driver, NULL);
+    trace_test_expect("replay again", rc, 0, "event 1", NULL);
+
+    ioctl80211_trace_close();
+    unlink(CONFIG_QCA_IOCTL80211_TRACE_FILE);
+
+    printf("trace: %d tests, %d failed\n", g_tests, g_failed);
+    return g_failed ? 1 : 0;
+}
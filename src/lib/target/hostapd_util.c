@@ -25,10 +25,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
 
 #include "os.h"
 #include "log.h"
 #include "kconfig.h"
+#include "ds_tree.h"
+#include "memutil.h"
+#include "wpa_ctrl.h"
 #include "hostapd_util.h"
 
 #define MODULE_ID LOG_MODULE_ID_TARGET
@@ -39,6 +46,204 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CMD_TIMEOUT "timeout"
 #endif
 
+#define HOSTAPD_CTRL_TIMEOUT_MS 1000
+
+/* Persistent control connection to hostapd of a VAP */
+struct hostapd_ctrl {
+    char interface[32];
+    char path[64];
+    struct wpa_ctrl *ctrl;
+    ds_tree_node_t node;
+};
+
+static ds_tree_t hostapd_ctrls = DS_TREE_INIT(ds_str_cmp, struct hostapd_ctrl, node);
+
+static bool hostapd_ctrl_sockpath(const char *path, const char *interface, char *buf, size_t len)
+{
+    char parent[32] = { 0 };
+    FILE *f;
+
+    snprintf(buf, len, "/sys/class/net/%s/parent", interface);
+    if (!(f = fopen(buf, "r")))
+        return false;
+
+    if (!fgets(parent, sizeof(parent), f))
+        parent[0] = '\0';
+    fclose(f);
+
+    parent[strcspn(parent, "\n")] = '\0';
+    if (strlen(parent) == 0)
+        return false;
+
+    snprintf(buf, len, "%s/hostapd-%s/%s", path, parent, interface);
+    return true;
+}
+
+static void hostapd_ctrl_drop(struct hostapd_ctrl *c)
+{
+    if (c->ctrl)
+        wpa_ctrl_close(c->ctrl);
+    c->ctrl = NULL;
+}
+
+static bool hostapd_ctrl_open(struct hostapd_ctrl *c)
+{
+    char sockpath[256];
+
+    if (!hostapd_ctrl_sockpath(c->path, c->interface, sockpath, sizeof(sockpath)))
+        return false;
+
+    if (!(c->ctrl = wpa_ctrl_open(sockpath))) {
+        LOGD("%s: failed to open hostapd control socket %s", c->interface, sockpath);
+        return false;
+    }
+
+    return true;
+}
+
+bool hostapd_ctrl_connect(const char *path, const char *interface, bool *fresh)
+{
+    struct hostapd_ctrl *c;
+
+    *fresh = false;
+
+    if (!(c = ds_tree_find(&hostapd_ctrls, (void *)interface))) {
+        c = CALLOC(1, sizeof(*c));
+        snprintf(c->interface, sizeof(c->interface), "%s", interface);
+        ds_tree_insert(&hostapd_ctrls, c, c->interface);
+    }
+    snprintf(c->path, sizeof(c->path), "%s", path);
+
+    /* A restarted hostapd is noticed when sending to it fails */
+    if (c->ctrl)
+        return true;
+
+    if (!hostapd_ctrl_open(c))
+        return false;
+
+    *fresh = true;
+    return true;
+}
+
+/* Reads the reply to cmd, skipping unsolicited events */
+static int hostapd_ctrl_reply(struct hostapd_ctrl *c, const char *cmd, bool *ok)
+{
+    struct pollfd pfd;
+    char reply[64];
+    int len;
+
+    pfd.fd = wpa_ctrl_get_fd(c->ctrl);
+    pfd.events = POLLIN;
+
+    do {
+        if (poll(&pfd, 1, HOSTAPD_CTRL_TIMEOUT_MS) <= 0) {
+            LOGW("%s: no hostapd reply to '%s'", c->interface, cmd);
+            /* Late replies would be mistaken for next commands ones */
+            hostapd_ctrl_drop(c);
+            return -1;
+        }
+
+        if ((len = recv(pfd.fd, reply, sizeof(reply) - 1, 0)) < 0) {
+            hostapd_ctrl_drop(c);
+            return -1;
+        }
+        reply[len] = '\0';
+    } while (reply[0] == '<');
+
+    *ok = strncmp(reply, "OK", 2) == 0;
+    if (!*ok)
+        LOGD("%s: hostapd command '%s' failed: %s", c->interface, cmd, reply);
+
+    return 0;
+}
+
+int hostapd_ctrl_pipeline(const char *interface, const char *const *cmds, bool *ok, int n, bool *fresh)
+{
+    struct hostapd_ctrl *c;
+    struct pollfd pfd;
+    int sent = 0;
+    int done = 0;
+    int cnt = 0;
+    int fd;
+    int i;
+
+    *fresh = false;
+
+    if (!(c = ds_tree_find(&hostapd_ctrls, (void *)interface)) || !c->ctrl)
+        return -1;
+
+    fd = wpa_ctrl_get_fd(c->ctrl);
+
+    for (i = 0; i < n; i++)
+        ok[i] = false;
+
+    /* Commands are queued back to back, replies come in the same order */
+    while (done < n) {
+        if (sent < n) {
+            if (send(fd, cmds[sent], strlen(cmds[sent]), 0) >= 0) {
+                sent++;
+                continue;
+            }
+
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && sent == done) {
+                /* Nothing to read back yet, wait for hostapd to catch up */
+                pfd.fd = fd;
+                pfd.events = POLLOUT;
+                if (poll(&pfd, 1, HOSTAPD_CTRL_TIMEOUT_MS) > 0)
+                    continue;
+
+                LOGW("%s: hostapd doesn't take command '%s'", interface, cmds[sent]);
+                hostapd_ctrl_drop(c);
+                return -1;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                /* hostapd went away, reopen once and send everything again */
+                if (!*fresh && (errno == ECONNREFUSED || errno == ENOTCONN)) {
+                    LOGI("%s: hostapd control connection lost, reconnecting", interface);
+                    hostapd_ctrl_drop(c);
+                    if (!hostapd_ctrl_open(c))
+                        return -1;
+
+                    *fresh = true;
+                    fd = wpa_ctrl_get_fd(c->ctrl);
+                    sent = done = cnt = 0;
+                    continue;
+                }
+
+                LOGW("%s: failed to send hostapd command '%s': %d (%s)",
+                     interface, cmds[sent], errno, strerror(errno));
+                hostapd_ctrl_drop(c);
+                return -1;
+            }
+        }
+
+        /* Oldest reply, when the socket queue is full this makes room */
+        if (hostapd_ctrl_reply(c, cmds[done], &ok[done]) < 0)
+            return -1;
+        if (ok[done])
+            cnt++;
+        done++;
+    }
+
+    return cnt;
+}
+
+void hostapd_ctrl_close(const char *interface)
+{
+    struct hostapd_ctrl *c;
+    ds_tree_iter_t iter;
+
+    for (c = ds_tree_ifirst(&iter, &hostapd_ctrls); c; c = ds_tree_inext(&iter)) {
+        if (interface && strcmp(c->interface, interface) != 0)
+            continue;
+
+        ds_tree_iremove(&iter);
+        hostapd_ctrl_drop(c);
+        FREE(c);
+    }
+}
+
 bool hostapd_client_disconnect(const char *path, const char *interface,
                                const char *disc_type, const char *mac_str, uint8_t reason)
 {
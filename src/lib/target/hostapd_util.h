@@ -39,6 +39,19 @@ bool hostapd_rrm_set_neighbor(const char *path, const char *interface, const cha
 bool hostapd_rrm_remove_neighbor(const char *path, const char *interface, const char *bssid);
 bool hostapd_remove_station(const char *path, const char *interface, const char *mac_str);
 
+/* Persistent control connection per VAP. fresh is set when the connection
+ * was (re)opened, i.e. hostapd state may not match what was sent before.
+ */
+bool hostapd_ctrl_connect(const char *path, const char *interface, bool *fresh);
+/* Sends commands ahead of reading replies, as many as the socket queue
+ * takes, returns number of OK replies or -1 if the connection broke (it is
+ * closed then). If hostapd can't be reached the connection is reopened
+ * once, all commands are sent again and fresh is set.
+ */
+int hostapd_ctrl_pipeline(const char *interface, const char *const *cmds, bool *ok, int n, bool *fresh);
+/* NULL closes all */
+void hostapd_ctrl_close(const char *interface);
+
 bool hostapd_dpp_stop(const char *path, const char *interface, const char *command, const char *conf_num, int timeout_seconds);
 bool hostapd_dpp_add(const char *path, const char *interface, const char *command, const char *value, const char *curve, int timeout_seconds);
 bool hostapd_dpp_auth_init(const char *path, const char *interface, const char *configurator_conf_role, const char *configurator_conf_ssid_hex, const char *configurator_conf_psk_hex, int bi_id, int timeout_seconds);
@@ -46,6 +46,7 @@ endif
 UNIT_SRC_TOP += $(UNIT_SRC_PLATFORM)/target_init.c
 UNIT_SRC_TOP += $(UNIT_SRC_PLATFORM)/target_switch.c
 UNIT_SRC_TOP += $(UNIT_SRC_PLATFORM)/hostapd_util.c
+UNIT_SRC_TOP += $(UNIT_SRC_PLATFORM)/qca_healthcheck.c
 UNIT_SRC_TOP += $(OVERRIDE_DIR)/ssdk_util.c
 
 
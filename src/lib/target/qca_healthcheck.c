@@ -0,0 +1,376 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * This replaces the fork-heavy healthcheck.bss.d/qca.sh. The original
+ * script ran `iwconfig` 3 times and `exttool` twice per vap on every
+ * health check period. Here everything except the DFS channel state
+ * is read with a single netlink request and a couple of ioctls. The
+ * DFS channel state is only consulted when the bss already failed
+ * other checks as it only serves as an excuse for a down bss.
+ *
+ * CAC state is tracked by the target driver event listener which
+ * marks the radio in /tmp while CAC runs.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/wireless.h>
+
+#include "log.h"
+#include "util.h"
+#include "kconfig.h"
+#include "qca_healthcheck.h"
+
+#define MODULE_ID LOG_MODULE_ID_TARGET
+
+#ifdef CONFIG_PLATFORM_QCA_QSDK11_SUB_VER4
+#define QCA_HC_CHAN_STR "chan"
+#define QCA_HC_CHAN_NOL_STR "DFS_NOL"
+#else
+#define QCA_HC_CHAN_STR ""
+#define QCA_HC_CHAN_NOL_STR "NOP_STARTED"
+#endif
+
+#define QCA_HC_CAC_PATH "/tmp/.%s.cac.started"
+/* Weather radar channels take the longest CAC (10 min). A mark older
+ * than that was left behind by a listener that missed the end event.
+ */
+#define QCA_HC_CAC_MAX_SEC (10 * 60 + 30)
+
+static int qca_hc_ioctl_fd = -1;
+static int qca_hc_nl_fd = -1;
+
+static int
+qca_hc_freq_to_chan(int mhz)
+{
+    if (mhz < 2412)
+        return 0;
+    if (mhz == 2484)
+        return 14;
+    if (mhz < 5000)
+        return 1 + ((mhz - 2412) / 5);
+    if (mhz < 5935)
+        return (mhz - 5000) / 5;
+    if (mhz == 5935)
+        return 2;
+    if (mhz > 5950 && mhz <= 7115)
+        return (mhz - 5950) / 5;
+    return 0;
+}
+
+static int
+qca_hc_ioctl_fd_get(void)
+{
+    if (qca_hc_ioctl_fd < 0)
+        qca_hc_ioctl_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    return qca_hc_ioctl_fd;
+}
+
+static int
+qca_hc_nl_fd_get(void)
+{
+    struct timeval tv = { .tv_sec = 1 };
+
+    if (qca_hc_nl_fd >= 0)
+        return qca_hc_nl_fd;
+
+    qca_hc_nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (qca_hc_nl_fd >= 0)
+        setsockopt(qca_hc_nl_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return qca_hc_nl_fd;
+}
+
+static bool
+qca_hc_cac_started(const char *phy)
+{
+    struct stat st;
+
+    if (stat(strfmta(QCA_HC_CAC_PATH, phy), &st) != 0)
+        return false;
+
+    return time(NULL) - st.st_mtime <= QCA_HC_CAC_MAX_SEC;
+}
+
+static bool
+qca_hc_link_is_up(const char *vif, bool *up)
+{
+    struct {
+        struct nlmsghdr hdr;
+        struct ifinfomsg ifm;
+        char attr[RTA_SPACE(IFNAMSIZ)];
+    } req;
+    const struct ifinfomsg *ifm;
+    const struct nlmsghdr *hdr;
+    struct rtattr *rta;
+    char buf[4096];
+    static unsigned int seq;
+    bool found = false;
+    int len;
+    int fd;
+
+    if (strlen(vif) >= IFNAMSIZ)
+        return false;
+
+    memset(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifm));
+    req.hdr.nlmsg_type = RTM_GETLINK;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST;
+    req.hdr.nlmsg_seq = ++seq;
+    req.ifm.ifi_family = AF_UNSPEC;
+
+    rta = (void *)&req + NLMSG_ALIGN(req.hdr.nlmsg_len);
+    rta->rta_type = IFLA_IFNAME;
+    rta->rta_len = RTA_LENGTH(strlen(vif) + 1);
+    memcpy(RTA_DATA(rta), vif, strlen(vif) + 1);
+    req.hdr.nlmsg_len = NLMSG_ALIGN(req.hdr.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+    fd = qca_hc_nl_fd_get();
+    if (fd < 0)
+        return false;
+
+    if (send(fd, &req, req.hdr.nlmsg_len, 0) < 0) {
+        LOGD("%s: failed to request link: %d (%s)", vif, errno, strerror(errno));
+        return false;
+    }
+
+again:
+    len = recv(fd, buf, sizeof(buf), 0);
+
+    for (hdr = (void *)buf; len > 0 && NLMSG_OK(hdr, (unsigned int)len); hdr = NLMSG_NEXT(hdr, len)) {
+        /* Reply to an earlier request that timed out */
+        if (hdr->nlmsg_seq != seq)
+            goto again;
+        if (hdr->nlmsg_type == NLMSG_ERROR)
+            break;
+        if (hdr->nlmsg_type != RTM_NEWLINK)
+            continue;
+
+        ifm = NLMSG_DATA(hdr);
+        *up = (ifm->ifi_flags & IFF_UP) != 0;
+        found = true;
+        break;
+    }
+
+    return found;
+}
+
+static bool
+qca_hc_iw_get(int fd, const char *vif, int cmd, struct iwreq *wrq)
+{
+    memset(wrq, 0, sizeof(*wrq));
+    STRSCPY(wrq->ifr_name, vif);
+    return ioctl(fd, cmd, wrq) == 0;
+}
+
+static int
+qca_hc_iw_get_chan(int fd, const char *vif)
+{
+    struct iwreq wrq;
+    long long mhz;
+    int e;
+
+    if (!qca_hc_iw_get(fd, vif, SIOCGIWFREQ, &wrq))
+        return 0;
+
+    /* Drivers can report either channel number (e == 0,
+     * small m) or the frequency in Hz as m * 10^e.
+     */
+    if (wrq.u.freq.e == 0 && wrq.u.freq.m < 1000)
+        return wrq.u.freq.m;
+
+    mhz = wrq.u.freq.m;
+    for (e = wrq.u.freq.e; e > 0; e--)
+        mhz *= 10;
+
+    return qca_hc_freq_to_chan(mhz / 1000000);
+}
+
+static void
+qca_hc_dfs_get(const char *vif, int *chan_cnt, int *nol_cnt)
+{
+    const char *line;
+    char *buf;
+
+    *chan_cnt = 0;
+    *nol_cnt = 0;
+
+#ifdef CONFIG_PLATFORM_QCA_QSDK11_SUB_VER4
+    buf = strexa("exttool", "--list_chan_state", "--interface", vif);
+#else
+    buf = strexa("exttool", "--list", "--interface", vif);
+#endif
+    if (!buf)
+        return;
+
+    while ((line = strsep(&buf, "\r\n"))) {
+        if (strlen(line) == 0 || !strstr(line, QCA_HC_CHAN_STR))
+            continue;
+        (*chan_cnt)++;
+        if (strstr(line, QCA_HC_CHAN_NOL_STR))
+            (*nol_cnt)++;
+    }
+}
+
+bool
+qca_hc_vif_check(const char *vif, struct qca_hc_result *res)
+{
+    static const unsigned char zero[6] = {};
+    static const unsigned char bcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    static const unsigned char hack[6] = { 0x44, 0x44, 0x44, 0x44, 0x44, 0x44 };
+    struct iwreq wrq;
+    const char *phy;
+    bool up;
+    int fd;
+
+    memset(res, 0, sizeof(*res));
+
+    fd = qca_hc_ioctl_fd_get();
+    if (fd < 0) {
+        LOGW("%s: failed to open ioctl socket: %d (%s)", vif, errno, strerror(errno));
+        return false;
+    }
+
+    /* Possibly handled by a different driver */
+    if (!qca_hc_iw_get(fd, vif, SIOCGIWNAME, &wrq)) {
+        res->reasons |= QCA_HC_REASON_NOT_WIRELESS;
+        res->healthy = true;
+        return true;
+    }
+
+    phy = strchomp(file_geta(strfmta("/sys/class/net/%s/parent", vif)), "\r\n ");
+    if (phy && strlen(phy) > 0)
+        STRSCPY_WARN(res->phy, phy);
+    else
+        res->reasons |= QCA_HC_REASON_NO_PARENT;
+
+    /* Not beaconing until CAC completes */
+    if (strlen(res->phy) > 0 && qca_hc_cac_started(res->phy)) {
+        res->reasons |= QCA_HC_REASON_CAC;
+        res->healthy = true;
+        return true;
+    }
+
+    if (qca_hc_link_is_up(vif, &up) && !up)
+        res->reasons |= QCA_HC_REASON_LINK_DOWN;
+
+    if (!qca_hc_iw_get(fd, vif, SIOCGIWAP, &wrq)) {
+        res->reasons |= QCA_HC_REASON_NO_AP;
+    } else {
+        memcpy(res->bssid, wrq.u.ap_addr.sa_data, sizeof(res->bssid));
+        if (!memcmp(res->bssid, zero, sizeof(zero)))
+            res->reasons |= QCA_HC_REASON_NULL_AP;
+        else if (!memcmp(res->bssid, bcast, sizeof(bcast)) ||
+                 !memcmp(res->bssid, hack, sizeof(hack)))
+            res->reasons |= QCA_HC_REASON_NO_AP;
+    }
+
+    res->channel = qca_hc_iw_get_chan(fd, vif);
+    if (res->channel <= 0)
+        res->reasons |= QCA_HC_REASON_NO_CHANNEL;
+
+    res->healthy = (res->reasons == 0);
+    if (res->healthy)
+        return true;
+
+    qca_hc_dfs_get(vif, &res->chan_cnt, &res->nol_cnt);
+    if (res->chan_cnt > 0 && res->chan_cnt == res->nol_cnt) {
+        res->reasons |= QCA_HC_REASON_OUT_OF_CHANNELS;
+        res->healthy = true;
+    }
+
+    LOGD("%s: healthcheck: healthy=%d reasons=0x%x chan=%d dfs=%d/%d",
+         vif, res->healthy, res->reasons, res->channel,
+         res->nol_cnt, res->chan_cnt);
+
+    return true;
+}
+
+const char *
+qca_hc_reason_str(enum qca_hc_reason reason)
+{
+    switch (reason) {
+        case QCA_HC_REASON_NOT_WIRELESS:
+            return "not a wireless interface";
+        case QCA_HC_REASON_NO_PARENT:
+            return "failed to find parent radio";
+        case QCA_HC_REASON_LINK_DOWN:
+            return "bss is not up";
+        case QCA_HC_REASON_NO_AP:
+            return "bss is not associated: no ap";
+        case QCA_HC_REASON_NULL_AP:
+            return "bss is not associated: null ap";
+        case QCA_HC_REASON_NO_CHANNEL:
+            return "bss is not on a valid channel";
+        case QCA_HC_REASON_OUT_OF_CHANNELS:
+            return "all channels happen to be dfs in this regdomain and all are unavailable";
+        case QCA_HC_REASON_CAC:
+            return "radio is running cac";
+    }
+    return "unknown";
+}
+
+void
+qca_hc_close(void)
+{
+    if (qca_hc_ioctl_fd >= 0)
+        close(qca_hc_ioctl_fd);
+    if (qca_hc_nl_fd >= 0)
+        close(qca_hc_nl_fd);
+    qca_hc_ioctl_fd = -1;
+    qca_hc_nl_fd = -1;
+}
+
+void
+qca_hc_cac_set(const char *phy, bool started)
+{
+    const char *path = strfmta(QCA_HC_CAC_PATH, phy);
+    FILE *f;
+
+    if (!started) {
+        if (unlink(path) != 0 && errno != ENOENT)
+            LOGW("%s: failed to remove %s: %d (%s)", phy, path, errno, strerror(errno));
+        return;
+    }
+
+    f = fopen(path, "w");
+    if (!f) {
+        LOGW("%s: failed to create %s: %d (%s)", phy, path, errno, strerror(errno));
+        return;
+    }
+    fclose(f);
+}
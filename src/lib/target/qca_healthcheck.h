@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef QCA_HEALTHCHECK_H_INCLUDED
+#define QCA_HEALTHCHECK_H_INCLUDED
+
+#include <stdbool.h>
+
+/*
+ * In-process equivalent of healthcheck.bss.d/qca.sh
+ *
+ * A bss is considered healthy when its netdev is up, it reports a
+ * non-zero bssid and its radio sits on a valid channel. A bss that
+ * isn't healthy is still accepted if its radio ran out of usable
+ * channels due to DFS NOL, same as the original script did. A radio
+ * running CAC doesn't beacon yet, its bsses are skipped.
+ *
+ * Sockets are opened on first use and kept until qca_hc_close() so
+ * that checking many bsses costs no more than a few ioctls each.
+ */
+
+enum qca_hc_reason {
+    QCA_HC_REASON_NOT_WIRELESS      = (1 << 0),
+    QCA_HC_REASON_NO_PARENT         = (1 << 1),
+    QCA_HC_REASON_LINK_DOWN         = (1 << 2),
+    QCA_HC_REASON_NO_AP             = (1 << 3),
+    QCA_HC_REASON_NULL_AP           = (1 << 4),
+    QCA_HC_REASON_NO_CHANNEL        = (1 << 5),
+    QCA_HC_REASON_OUT_OF_CHANNELS   = (1 << 6),
+    QCA_HC_REASON_CAC               = (1 << 7),
+};
+
+struct qca_hc_result {
+    bool healthy;
+    unsigned int reasons; /* enum qca_hc_reason bitmask */
+    char phy[32];
+    unsigned char bssid[6];
+    int channel;
+    int chan_cnt;
+    int nol_cnt;
+};
+
+bool qca_hc_vif_check(const char *vif, struct qca_hc_result *res);
+const char *qca_hc_reason_str(enum qca_hc_reason reason);
+void qca_hc_close(void);
+
+/* Called from the driver event listener on CAC start and end. The
+ * state is kept in a /tmp file so that the helper process sees it.
+ */
+void qca_hc_cac_set(const char *phy, bool started);
+
+#endif /* QCA_HEALTHCHECK_H_INCLUDED */
@@ -282,6 +282,40 @@ bool target_stats_scan_get(radio_entry_t *radio_cfg,
     return true;
 }
 
+/* Same as target_stats_scan_get() but the results are kept in a per
+ * radio neighbor table and only the requested report is returned.
+ */
+bool target_stats_scan_delta_get(radio_entry_t *radio_cfg,
+                                 uint32_t *chan_list,
+                                 uint32_t chan_num,
+                                 radio_scan_type_t scan_type,
+                                 uint32_t report,
+                                 dpp_neighbor_report_data_t *scan_results)
+{
+    ioctl_status_t rc;
+
+    if (!target_stats_scan_get(radio_cfg,
+                               chan_list,
+                               chan_num,
+                               scan_type,
+                               scan_results))
+    {
+        return false;
+    }
+
+    rc = ioctl80211_neighbor_report(radio_cfg,
+                                    chan_list,
+                                    chan_num,
+                                    report,
+                                    &scan_results->list);
+    if (IOCTL_STATUS_OK != rc)
+    {
+        return false;
+    }
+
+    return true;
+}
+
 
 /******************************************************************************
  *  DEVICE definitions
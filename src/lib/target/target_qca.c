@@ -89,6 +89,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ovsdb_cache.h"
 
 #include "qca_bsal.h"
+#include "qca_healthcheck.h"
+#include "ioctl80211_nlfilter.h"
+#include "ioctl80211_priv.h"
 
 #include <linux/un.h>
 #include <opensync-ctrl.h>
@@ -163,7 +166,8 @@ static int g_num_vconfs;
 
 #define D(name, fallback) ((name ## _exists) ? (name) : (fallback))
 #define A(size) alloca(size), size
-#define F(fmt, ...) ({ char *__p = alloca(4096); memset(__p, 0, 4096); snprintf(__p, 4095, fmt, ##__VA_ARGS__); __p; })
+#define F(fmt, ...) util_fmt(fmt, ##__VA_ARGS__)
+#define F_SCOPE() size_t __fmt_mark __attribute__((cleanup(util_fmt_scope_leave))) = util_fmt_scope_enter()
 #define E(prog, ...) forkexec(prog, (const char *[]){ prog, __VA_ARGS__, NULL }, NULL, NULL, 0)
 #define R(...) file_geta(__VA_ARGS__)
 #define runcmd(...) readcmd(0, 0, 0, ## __VA_ARGS__)
@@ -176,6 +180,94 @@ static int g_num_vconfs;
             err || strcmp(str, buf); \
         })
 
+/* Scratch arena backing F(). Strings are bumped with their exact size
+ * and released when the enclosing F_SCOPE() returns. The outermost
+ * scope, placed at the top of ev callbacks and target API entries,
+ * starts with an empty arena. Outside of any scope, or once the arena
+ * is exhausted, F() falls back to an exact-size alloca() in the frame
+ * of its caller.
+ */
+#define UTIL_FMT_ARENA_SIZE 8192
+
+static char g_fmt_arena[UTIL_FMT_ARENA_SIZE];
+static size_t g_fmt_arena_used;
+static size_t g_fmt_arena_hwm;
+static int g_fmt_arena_depth;
+
+static size_t
+util_fmt_scope_enter(void)
+{
+    /* Outermost scope, i.e. an ev callback or a target API entry */
+    if (g_fmt_arena_depth++ == 0)
+        g_fmt_arena_used = 0;
+    return g_fmt_arena_used;
+}
+
+static void
+util_fmt_scope_leave(size_t *mark)
+{
+    WARN_ON(*mark > g_fmt_arena_used);
+    g_fmt_arena_used = *mark;
+    g_fmt_arena_depth--;
+}
+
+/* Returns NULL if the string did not fit, *len is then its length or
+ * -1 when nothing was formatted */
+static char * __attribute__((format(printf, 2, 3)))
+util_fmt_arena_printf(int *len, const char *fmt, ...)
+{
+    size_t left = sizeof(g_fmt_arena) - g_fmt_arena_used;
+    char *p = g_fmt_arena + g_fmt_arena_used;
+    va_list ap;
+    int n;
+
+    *len = -1;
+    if (g_fmt_arena_depth == 0)
+        return NULL;
+
+    va_start(ap, fmt);
+    n = vsnprintf(p, left, fmt, ap);
+    va_end(ap);
+
+    if (WARN_ON(n < 0 || (size_t)n >= left)) {
+        *len = n;
+        return NULL;
+    }
+
+    g_fmt_arena_used += n + 1;
+    if (g_fmt_arena_used > g_fmt_arena_hwm) {
+        g_fmt_arena_hwm = g_fmt_arena_used;
+        LOGT("%s: high water mark %zu/%zu bytes",
+             __func__, g_fmt_arena_hwm, sizeof(g_fmt_arena));
+    }
+
+    return p;
+}
+
+/* Always inlined so that the fallback buffer outlives this function
+ * like strfmta() does. Arguments are evaluated once, as parameters,
+ * and forwarded to both attempts with __builtin_va_arg_pack().
+ */
+static inline char * __attribute__((always_inline, format(printf, 1, 2)))
+util_fmt(const char *fmt, ...)
+{
+    char *p;
+    int n;
+
+    p = util_fmt_arena_printf(&n, fmt, __builtin_va_arg_pack());
+    if (p)
+        return p;
+
+    if (n < 0)
+        n = snprintf(NULL, 0, fmt, __builtin_va_arg_pack());
+    if (n < 0)
+        n = 0;
+
+    p = alloca(n + 1);
+    snprintf(p, n + 1, fmt, __builtin_va_arg_pack());
+    return p;
+}
+
 void
 rtrimnl(char *str)
 {
@@ -1129,6 +1221,7 @@ util_cb_arm(EV_P_ struct util_cb *cb, int seconds)
 static void
 util_cb_timer_cb(EV_P_ ev_timer *arg, int revents)
 {
+    F_SCOPE();
     struct util_cb *cb = container_of(arg, struct util_cb, timer);
     bool more = util_cb_work(cb, UTIL_CB_SPLIT);
     if (more == true) util_cb_arm(EV_A_ cb, UTIL_CB_DELAY_AGAIN_SEC);
@@ -1697,6 +1790,90 @@ util_iwpriv_setmac(const char *vif, const char *want)
     FREE(q);
 }
 
+/* Last known driver state of vif iwpriv knobs. Filled from the driver
+ * the first time a transaction touches a knob and kept in sync with
+ * what the transactions write, so repeated config passes don't have to
+ * read every knob back. Any write that bypasses the transaction drops
+ * the vif's entry.
+ */
+#define UTIL_VIF_KNOB_STR_LEN 32
+#define UTIL_VIF_SHADOW_MAX 48
+
+struct util_vif_shadow_knob {
+    const char *get;
+    int v;
+    char s[UTIL_VIF_KNOB_STR_LEN];
+};
+
+struct util_vif_shadow {
+    char vif[32];
+    ioctl80211_priv_t priv;
+    struct util_vif_shadow_knob knobs[UTIL_VIF_SHADOW_MAX];
+    int num;
+    ds_tree_node_t node;
+};
+
+static ds_tree_t g_util_vif_shadows = DS_TREE_INIT(ds_str_cmp, struct util_vif_shadow, node);
+
+static struct util_vif_shadow *
+util_vif_shadow_get(const char *vif)
+{
+    struct util_vif_shadow *sh;
+
+    if ((sh = ds_tree_find(&g_util_vif_shadows, vif)))
+        return sh;
+
+    sh = CALLOC(1, sizeof(*sh));
+    STRSCPY_WARN(sh->vif, vif);
+    ds_tree_insert(&g_util_vif_shadows, sh, sh->vif);
+    return sh;
+}
+
+static void
+util_vif_shadow_drop(const char *vif)
+{
+    struct util_vif_shadow *sh;
+
+    if (!(sh = ds_tree_find(&g_util_vif_shadows, vif)))
+        return;
+
+    ds_tree_remove(&g_util_vif_shadows, sh);
+    if (sh->priv)
+        ioctl80211_priv_free(sh->priv);
+    FREE(sh);
+}
+
+static struct util_vif_shadow_knob *
+util_vif_shadow_knob(struct util_vif_shadow *sh, const char *get)
+{
+    int i;
+
+    for (i = 0; i < sh->num; i++)
+        if (!strcmp(sh->knobs[i].get, get))
+            return &sh->knobs[i];
+
+    return NULL;
+}
+
+static void
+util_vif_shadow_store(struct util_vif_shadow *sh,
+                      const char *get,
+                      int v,
+                      const char *s)
+{
+    struct util_vif_shadow_knob *k;
+
+    if (!(k = util_vif_shadow_knob(sh, get))) {
+        if (sh->num >= UTIL_VIF_SHADOW_MAX)
+            return;
+        k = &sh->knobs[sh->num++];
+        k->get = get;
+    }
+
+    k->v = v;
+    STRSCPY_WARN(k->s, s ?: "");
+}
+
 static int
 util_iwpriv_set_int_lazy(const char *device_ifname,
                          const char *iwpriv_get,
@@ -1720,6 +1897,7 @@ util_iwpriv_set_int_lazy(const char *device_ifname,
     }
 
     LOGI("%s: setting '%s' = %d", device_ifname, iwpriv_set, v);
+    util_vif_shadow_drop(device_ifname);
     return util_iwpriv_set_int(device_ifname, iwpriv_set, v);
 }
 
@@ -1745,6 +1923,7 @@ util_iwpriv_set_str_lazy(const char *device_ifname,
         return 0;
 
     LOGI("%s: setting '%s' = '%s'", device_ifname, iwpriv_set, v);
+    util_vif_shadow_drop(device_ifname);
     if (WARN(-1 == util_exec_simple("iwpriv", device_ifname, iwpriv_set, v),
              "%s: failed to set iwpriv '%s': %d (%s)",
              device_ifname, iwpriv_get, errno, strerror(errno)))
@@ -1753,6 +1932,272 @@ util_iwpriv_set_str_lazy(const char *device_ifname,
     return 1;
 }
 
+/* VIF config transaction. iwpriv knobs are collected while walking
+ * the config and flushed in one go through the driver's private
+ * ioctls instead of forking iwpriv twice per knob. Current values come
+ * from the vif shadow so each knob is read from the driver at most
+ * once. If a write fails the knobs already written are restored to
+ * their previous values.
+ */
+#define UTIL_VIF_TXN_MAX 32
+
+struct util_vif_txn_param {
+    const char *get;
+    const char *set;
+    bool is_str;
+    int v;
+    char s[UTIL_VIF_KNOB_STR_LEN];
+    int old_v;
+    char old_s[UTIL_VIF_KNOB_STR_LEN];
+    bool known;
+};
+
+struct util_vif_txn {
+    const char *vif;
+    struct util_vif_txn_param params[UTIL_VIF_TXN_MAX];
+    int num;
+    struct timespec started;
+};
+
+static int g_util_vif_txn_fd = -1;
+
+static void
+util_vif_txn_begin(struct util_vif_txn *txn, const char *vif)
+{
+    memset(txn, 0, sizeof(*txn));
+    txn->vif = vif;
+    clock_gettime(CLOCK_MONOTONIC, &txn->started);
+}
+
+static struct util_vif_txn_param *
+util_vif_txn_param(struct util_vif_txn *txn,
+                   const char *iwpriv_get,
+                   const char *iwpriv_set)
+{
+    int i;
+
+    /* Later writes to the same knob supersede earlier ones */
+    for (i = 0; i < txn->num; i++)
+        if (!strcmp(txn->params[i].set, iwpriv_set))
+            return &txn->params[i];
+
+    if (WARN_ON(txn->num >= UTIL_VIF_TXN_MAX))
+        return NULL;
+
+    txn->params[txn->num].get = iwpriv_get;
+    txn->params[txn->num].set = iwpriv_set;
+    return &txn->params[txn->num++];
+}
+
+static void
+util_vif_txn_set_int(struct util_vif_txn *txn,
+                     const char *iwpriv_get,
+                     const char *iwpriv_set,
+                     int v)
+{
+    struct util_vif_txn_param *p;
+
+    if (!(p = util_vif_txn_param(txn, iwpriv_get, iwpriv_set))) {
+        util_iwpriv_set_int_lazy(txn->vif, iwpriv_get, iwpriv_set, v);
+        return;
+    }
+
+    p->is_str = false;
+    p->v = v;
+}
+
+static void
+util_vif_txn_set_str(struct util_vif_txn *txn,
+                     const char *iwpriv_get,
+                     const char *iwpriv_set,
+                     const char *v)
+{
+    struct util_vif_txn_param *p;
+
+    if (WARN_ON(strlen(v) >= UTIL_VIF_KNOB_STR_LEN) ||
+        !(p = util_vif_txn_param(txn, iwpriv_get, iwpriv_set))) {
+        util_iwpriv_set_str_lazy(txn->vif, iwpriv_get, iwpriv_set, v);
+        return;
+    }
+
+    p->is_str = true;
+    STRSCPY_WARN(p->s, v);
+}
+
+static bool
+util_vif_txn_read(const char *vif,
+                  ioctl80211_priv_t priv,
+                  struct util_vif_txn_param *p)
+{
+    char buf[64];
+    uint32_t o;
+    char *s;
+    int len;
+
+    if (!priv && !p->is_str)
+        return util_iwpriv_get_int(vif, p->get, &p->old_v);
+
+    if (!priv) {
+        if (util_exec_read(rtrimnl, buf, sizeof(buf), "iwpriv", vif, p->get) < 0)
+            return false;
+        if (!(s = strchr(buf, ':')))
+            return false;
+        STRSCPY_WARN(p->old_s, s + 1);
+        return true;
+    }
+
+    if (!p->is_str) {
+        len = 1;
+        if (!ioctl80211_priv_get_int(priv, p->get, &o, &len))
+            return false;
+        p->old_v = o;
+        return true;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    len = sizeof(buf) - 1;
+    if (!ioctl80211_priv_get(priv, p->get, buf, &len))
+        return false;
+    rtrimws(buf);
+    STRSCPY_WARN(p->old_s, buf);
+    return true;
+}
+
+static bool
+util_vif_txn_write(const char *vif,
+                   ioctl80211_priv_t priv,
+                   const struct util_vif_txn_param *p,
+                   int v,
+                   const char *s)
+{
+    uint32_t o;
+
+    if (!priv && !p->is_str)
+        return util_iwpriv_set_int(vif, p->set, v) == 0;
+
+    if (!priv)
+        return util_exec_simple("iwpriv", vif, p->set, s) == 0;
+
+    if (!p->is_str) {
+        o = v;
+        return ioctl80211_priv_set_int(priv, p->set, &o, 1);
+    }
+
+    return ioctl80211_priv_set(priv, p->set, (void *)s, strlen(s) + 1);
+}
+
+static bool
+util_vif_txn_changed(const struct util_vif_txn_param *p)
+{
+    return p->is_str ? strcmp(p->s, p->old_s) != 0 : p->v != p->old_v;
+}
+
+static int
+util_vif_txn_commit(struct util_vif_txn *txn)
+{
+    struct util_vif_txn_param *p;
+    struct util_vif_shadow_knob *k;
+    struct util_vif_shadow *sh;
+    struct timespec now;
+    int written[UTIL_VIF_TXN_MAX];
+    int nwritten = 0;
+    int skipped = 0;
+    int failed = 0;
+    int reads = 0;
+    int pass;
+    int i;
+
+    if (txn->num == 0)
+        return 0;
+
+    sh = util_vif_shadow_get(txn->vif);
+    if (!sh->priv) {
+        if (g_util_vif_txn_fd < 0)
+            g_util_vif_txn_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (g_util_vif_txn_fd >= 0)
+            sh->priv = ioctl80211_priv_init(txn->vif, g_util_vif_txn_fd);
+    }
+
+    for (i = 0; i < txn->num; i++) {
+        p = &txn->params[i];
+
+        if ((k = util_vif_shadow_knob(sh, p->get))) {
+            p->old_v = k->v;
+            STRSCPY_WARN(p->old_s, k->s);
+            p->known = true;
+            continue;
+        }
+
+        reads++;
+        if (!util_vif_txn_read(txn->vif, sh->priv, p)) {
+            LOGW("%s: failed to get iwpriv '%s'", txn->vif, p->get);
+            failed++;
+            continue;
+        }
+
+        p->known = true;
+        util_vif_shadow_store(sh, p->get, p->old_v, p->old_s);
+    }
+
+    /* Mode changes make the driver re-derive rate related knobs so
+     * string knobs go in before the integer ones.
+     */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < txn->num; i++) {
+            p = &txn->params[i];
+
+            if (p->is_str != (pass == 0) || !p->known)
+                continue;
+
+            if (!util_vif_txn_changed(p)) {
+                LOGT("%s: not setting '%s', already at desired value",
+                     txn->vif, p->set);
+                skipped++;
+                continue;
+            }
+
+            if (p->is_str)
+                LOGI("%s: setting '%s' = '%s'", txn->vif, p->set, p->s);
+            else
+                LOGI("%s: setting '%s' = %d", txn->vif, p->set, p->v);
+
+            if (!util_vif_txn_write(txn->vif, sh->priv, p, p->v, p->s)) {
+                LOGW("%s: failed to set iwpriv '%s'", txn->vif, p->set);
+                failed++;
+                goto rollback;
+            }
+
+            written[nwritten++] = i;
+            util_vif_shadow_store(sh, p->get, p->v, p->s);
+        }
+    }
+
+    goto out;
+
+rollback:
+    while (nwritten > 0) {
+        p = &txn->params[written[--nwritten]];
+        LOGI("%s: restoring '%s'", txn->vif, p->set);
+        if (!util_vif_txn_write(txn->vif, sh->priv, p, p->old_v, p->old_s))
+            LOGW("%s: failed to restore iwpriv '%s'", txn->vif, p->set);
+    }
+
+    /* Driver state is uncertain now, re-read it next time */
+    util_vif_shadow_drop(txn->vif);
+    sh = NULL;
+
+out:
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    LOGI("%s: %s %d params (%d unchanged, %d failed, %d read) in %ld ms",
+         txn->vif, sh ? "applied" : "rolled back",
+         sh ? txn->num - skipped - failed : txn->num, skipped, failed, reads,
+         (long)((now.tv_sec - txn->started.tv_sec) * 1000 +
+                (now.tv_nsec - txn->started.tv_nsec) / 1000000));
+
+    txn->num = 0;
+    return failed ? -1 : 0;
+}
+
 static bool
 util_iwpriv_get_bcn_int(const char *phy, int *v)
 {
@@ -2052,6 +2497,7 @@ util_thermal_phy_timer_cb(struct ev_loop *loop,
                           ev_timer *timer,
                           int revents)
 {
+    F_SCOPE();
     struct util_thermal *t;
     int temp;
     int err;
@@ -2597,6 +3043,17 @@ util_csa_war_update_rconf_channel(const char *phy, int chan)
 static int util_nl_fd = -1;
 static ev_io util_nl_io;
 
+/* Any link change may need rediscovery, except Probe Requests, see
+ * util_nl_parse(). These are the bulk of the traffic with WPS enabled.
+ */
+static const ioctl80211_nlfilter_t util_nl_filter = {
+    .dellink    = true,
+    .newlink    = true,
+    .iwe_cmd    = { IWEVASSOCREQIE },
+    .iwe_qty    = 1,
+    .iwe_drop   = true,
+};
+
 static void
 util_nl_listen_stop(void)
 {
@@ -2788,9 +3245,14 @@ util_nl_parse_iwevcustom(const char *ifname,
         case IEEE80211_EV_CHANNEL_LIST_UPDATED:
             return util_nl_parse_iwevcustom_channel_list_updated(ifname, data, iwp->length);
         case IEEE80211_EV_RADAR_DETECT:
+            qca_hc_cac_set(ifname, false);
             return util_nl_parse_iwevcustom_radar_detected(ifname, data, iwp->length);
         case IEEE80211_EV_CAC_START:
+            qca_hc_cac_set(ifname, true);
+            break;
         case IEEE80211_EV_CAC_COMPLETED:
+            qca_hc_cac_set(ifname, false);
+            break;
         case IEEE80211_EV_NOP_START:
         case IEEE80211_EV_NOP_FINISHED:
             break;
@@ -2800,6 +3262,7 @@ util_nl_parse_iwevcustom(const char *ifname,
 static void
 util_nl_parse(const void *buf, unsigned int len)
 {
+    F_SCOPE();
     const struct iw_event *iwe;
     const struct nlmsghdr *hdr;
     const struct rtattr *attr;
@@ -2861,6 +3324,7 @@ util_nl_listen_cb(struct ev_loop *loop,
                   ev_io *watcher,
                   int revents)
 {
+    F_SCOPE();
     char buf[32768];
     int max = 256;
     int len;
@@ -2937,6 +3401,8 @@ util_nl_listen_start(void)
              __func__, v, errno, strerror(errno));
     }
 
+    ioctl80211_nlfilter_attach(fd, &util_nl_filter, __func__);
+
     util_nl_fd = fd;
     ev_io_init(&util_nl_io, util_nl_listen_cb, fd, EV_READ);
     ev_io_start(target_mainloop, &util_nl_io);
@@ -3330,6 +3796,7 @@ util_radio_country_get(const char *phy, char *country, int country_len)
 
 bool target_radio_state_get(char *phy, struct schema_Wifi_Radio_State *rstate)
 {
+    F_SCOPE();
     const struct wiphy_info *wiphy_info;
     const struct util_thermal *t;
     const struct kvstore *kv;
@@ -3588,6 +4055,7 @@ bool
 target_radio_config_set2(const struct schema_Wifi_Radio_Config *rconf,
                          const struct schema_Wifi_Radio_Config_flags *changed)
 {
+    F_SCOPE();
     const char *phy = rconf->if_name;
     const char *vif;
 
@@ -3985,18 +4453,24 @@ target_vif_config_set2(const struct schema_Wifi_VIF_Config *vconf,
                        const struct schema_Wifi_VIF_Config_flags *changed,
                        int num_cconfs)
 {
+    F_SCOPE();
     const char *phy = rconf->if_name;
     const char *vif = vconf->if_name;
+    const char *policy_min_hw_mode = NULL;
+    struct util_vif_txn txn;
     const char *p;
     char macaddr[6];
     char mode[32];
     int v;
 
+    util_vif_txn_begin(&txn, vif);
+
     if (!rconf ||
         changed->enabled ||
         changed->mode ||
         changed->vif_radio_idx) {
         qca_ctrl_destroy(vif);
+        util_vif_shadow_drop(vif);
 
         if (access(F("/sys/class/net/%s", vif), X_OK) == 0) {
             LOGI("%s: deleting netdev", vif);
@@ -4058,47 +4532,47 @@ target_vif_config_set2(const struct schema_Wifi_VIF_Config *vconf,
                      vif, POLICY_RTS_THR, errno, strerror(errno));
         }
 
-        util_iwpriv_set_str_lazy(vif, "getdbgLVL", "dbgLVL", "0x0");
-        util_iwpriv_set_int_lazy(vif, "get_powersave", "powersave", 0);
-        util_iwpriv_set_int_lazy(vif, "get_uapsd", "uapsd", 0);
-        util_iwpriv_set_int_lazy(vif, "get_shortgi", "shortgi", 1);
-        util_iwpriv_set_int_lazy(vif, "get_doth", "doth", 1);
-        util_iwpriv_set_int_lazy(vif, "get_csa2g", "csa2g", 1);
-        util_iwpriv_set_int_lazy(vif,
-                                 "get_cwmenable",
-                                 "cwmenable",
-                                 util_policy_get_cwm_enable(phy));
-        util_iwpriv_set_int_lazy(vif,
-                                 "g_disablecoext",
-                                 "disablecoext",
-                                 util_policy_get_disable_coext(vif));
-        util_iwpriv_set_int_lazy(vif,
-                                 "gcsadeauth",
-                                 "scsadeauth",
-                                 util_policy_get_csa_deauth(vif, rconf->freq_band));
+        util_vif_txn_set_int(&txn, "getdbgLVL", "dbgLVL", 0);
+        util_vif_txn_set_int(&txn, "get_powersave", "powersave", 0);
+        util_vif_txn_set_int(&txn, "get_uapsd", "uapsd", 0);
+        util_vif_txn_set_int(&txn, "get_shortgi", "shortgi", 1);
+        util_vif_txn_set_int(&txn, "get_doth", "doth", 1);
+        util_vif_txn_set_int(&txn, "get_csa2g", "csa2g", 1);
+        util_vif_txn_set_int(&txn,
+                             "get_cwmenable",
+                             "cwmenable",
+                             util_policy_get_cwm_enable(phy));
+        util_vif_txn_set_int(&txn,
+                             "g_disablecoext",
+                             "disablecoext",
+                             util_policy_get_disable_coext(vif));
+        util_vif_txn_set_int(&txn,
+                             "gcsadeauth",
+                             "scsadeauth",
+                             util_policy_get_csa_deauth(vif, rconf->freq_band));
 
         if (util_policy_get_csa_interop(vif)) {
-            util_iwpriv_set_int_lazy(vif, "gcsainteropphy", "scsainteropphy", 1);
-            util_iwpriv_set_int_lazy(vif, "gcsainteropauth", "scsainteropauth", 1);
+            util_vif_txn_set_int(&txn, "gcsainteropphy", "scsainteropphy", 1);
+            util_vif_txn_set_int(&txn, "gcsainteropauth", "scsainteropauth", 1);
         }
 
         if ((p = SCHEMA_KEY_VAL(rconf->hw_config, "cwm_extbusythres")))
-            util_iwpriv_set_int_lazy(vif,
-                                     "g_extbusythres",
-                                     "extbusythres",
-                                     atoi(p));
+            util_vif_txn_set_int(&txn,
+                                 "g_extbusythres",
+                                 "extbusythres",
+                                 atoi(p));
 
         if (rconf->bcn_int_exists)
-            util_iwpriv_set_int_lazy(vif,
-                                     "get_bintval",
-                                     "bintval",
-                                     rconf->bcn_int);
+            util_vif_txn_set_int(&txn,
+                                 "get_bintval",
+                                 "bintval",
+                                 rconf->bcn_int);
 
         if (rconf->thermal_shutdown_exists)
-            util_iwpriv_set_int_lazy(vif,
-                                     "get_therm_shut",
-                                     "therm_shutdown",
-                                     rconf->thermal_shutdown);
+            util_vif_txn_set_int(&txn,
+                                 "get_therm_shut",
+                                 "therm_shutdown",
+                                 rconf->thermal_shutdown);
 
         if (rconf->hw_mode_exists &&
             rconf->ht_mode_exists &&
@@ -4107,54 +4581,59 @@ target_vif_config_set2(const struct schema_Wifi_VIF_Config *vconf,
                                       rconf->freq_band,
                                       mode,
                                       sizeof(mode)))
-            util_iwpriv_set_str_lazy(vif, "get_mode", "mode", mode);
+            util_vif_txn_set_str(&txn, "get_mode", "mode", mode);
 
         if (!strcmp(vconf->mode, "ap"))
             if (!vconf->min_hw_mode_exists)
-                if ((p = util_policy_get_min_hw_mode(vif)))
-                    util_vif_min_hw_mode_set(vif, p);
+                policy_min_hw_mode = util_policy_get_min_hw_mode(vif);
     }
 
     if (vconf->ssid_broadcast_exists)
-        util_iwpriv_set_int_lazy(vif, "get_hide_ssid", "hide_ssid",
-                                 !strcmp("enabled", D(vconf->ssid_broadcast, "enabled")) ? 0 : 1);
+        util_vif_txn_set_int(&txn, "get_hide_ssid", "hide_ssid",
+                             !strcmp("enabled", D(vconf->ssid_broadcast, "enabled")) ? 0 : 1);
 
     if (changed->dynamic_beacon)
-        util_iwpriv_set_int_lazy(vif, "g_dynamicbeacon", "dynamicbeacon", D(vconf->dynamic_beacon, 0));
+        util_vif_txn_set_int(&txn, "g_dynamicbeacon", "dynamicbeacon", D(vconf->dynamic_beacon, 0));
 
     if (changed->mcast2ucast)
-        util_iwpriv_set_int_lazy(vif, "g_mcastenhance", "mcastenhance", D(vconf->mcast2ucast, 0) ? 2 : 0);
+        util_vif_txn_set_int(&txn, "g_mcastenhance", "mcastenhance", D(vconf->mcast2ucast, 0) ? 2 : 0);
 
     if (changed->ap_bridge)
-        util_iwpriv_set_int_lazy(vif, "get_ap_bridge", "ap_bridge", D(vconf->ap_bridge, 0));
+        util_vif_txn_set_int(&txn, "get_ap_bridge", "ap_bridge", D(vconf->ap_bridge, 0));
 
     if (changed->uapsd_enable)
-        util_iwpriv_set_int_lazy(vif, "get_uapsd", "uapsd", D(vconf->uapsd_enable, 0));
+        util_vif_txn_set_int(&txn, "get_uapsd", "uapsd", D(vconf->uapsd_enable, 0));
 
     if (changed->vif_dbg_lvl)
-        util_iwpriv_set_int_lazy(vif, "getdbgLVL", "dbgLVL", D(vconf->vif_dbg_lvl, 0));
+        util_vif_txn_set_int(&txn, "getdbgLVL", "dbgLVL", D(vconf->vif_dbg_lvl, 0));
 
     if (changed->rrm)
-        util_iwpriv_set_int_lazy(vif, "get_rrm", "rrm", D(vconf->rrm, 0));
+        util_vif_txn_set_int(&txn, "get_rrm", "rrm", D(vconf->rrm, 0));
+
+    if (changed->mac_list_type)
+        if (vconf->mac_list_type_exists && util_vif_mac_list_str2int(vconf->mac_list_type, &v))
+            util_vif_txn_set_int(&txn, "get_maccmd", "maccmd", v);
+
+    if (changed->dpp_cc)
+        util_vif_txn_set_int(&txn, "gdppcc", "sdppcc", vconf->dpp_cc);
+
+    util_vif_txn_commit(&txn);
+
+    /* pure* knobs depend on the mode committed above */
+    if (policy_min_hw_mode)
+        util_vif_min_hw_mode_set(vif, policy_min_hw_mode);
 
     if (rconf->tx_power_exists)
         WARN_ON(!strexa("iwconfig", vif, "txpower", strfmta("%d", rconf->tx_power)));
 
     util_vif_config_athnewind(phy);
 
-    if (changed->mac_list_type)
-        if (vconf->mac_list_type_exists && util_vif_mac_list_str2int(vconf->mac_list_type, &v))
-            util_iwpriv_set_int_lazy(vif, "get_maccmd", "maccmd", v);
-
     if (changed->mac_list)
         util_iwpriv_setmac(vif, util_vif_get_vconf_maclist(vconf, A(4096)));
 
     if (changed->mac_list_type || changed->mac_list)
         util_vif_acl_enforce(phy, vif, vconf);
 
-    if (changed->dpp_cc)
-        util_iwpriv_set_int_lazy(vif, "gdppcc", "sdppcc", vconf->dpp_cc);
-
     if (!strcmp(vconf->mode, "ap"))
         if (changed->min_hw_mode)
             util_vif_min_hw_mode_set(vif, vconf->min_hw_mode);
@@ -4176,6 +4655,7 @@ done:
 
 bool target_vif_state_get(char *vif, struct schema_Wifi_VIF_State *vstate)
 {
+    F_SCOPE();
     struct hapd *hapd = hapd_lookup(vif);
     struct wpas *wpas = wpas_lookup(vif);
     const char *r;
@@ -4385,6 +4865,7 @@ target_radio_init_discover_phy(void)
 static void
 target_radio_init_discover(EV_P_ ev_async *async, int events)
 {
+    F_SCOPE();
     char *ifnames = strexa("iwconfig");
     char *line;
     char *ifname;
@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ioctl80211_device.h"
 #include "ioctl80211_capacity.h"
 #include "ioctl80211_radio.h"
+#include "ioctl80211_neighbor.h"
 
 extern struct ev_loop *target_mainloop;
 
@@ -40,4 +41,18 @@ typedef ioctl80211_client_record_t target_client_record_t;
 typedef ioctl80211_survey_record_t target_survey_record_t;
 typedef ioctl80211_capacity_data_t target_capacity_data_t;
 
+/* Neighbor reports of target_stats_scan_delta_get() */
+#define TARGET_SCAN_REPORT_NEW      IOCTL80211_NEIGHBOR_REPORT_NEW
+#define TARGET_SCAN_REPORT_CHANGED  IOCTL80211_NEIGHBOR_REPORT_CHANGED
+#define TARGET_SCAN_REPORT_EXPIRED  IOCTL80211_NEIGHBOR_REPORT_EXPIRED
+#define TARGET_SCAN_REPORT_FULL     IOCTL80211_NEIGHBOR_REPORT_FULL
+#define TARGET_SCAN_REPORT_DELTA    IOCTL80211_NEIGHBOR_REPORT_DELTA
+
+bool target_stats_scan_delta_get(radio_entry_t *radio_cfg,
+                                 uint32_t *chan_list,
+                                 uint32_t chan_num,
+                                 radio_scan_type_t scan_type,
+                                 uint32_t report,
+                                 dpp_neighbor_report_data_t *scan_results);
+
 #endif /* TARGET_QCA_H_INCLUDED */
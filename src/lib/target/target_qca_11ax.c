@@ -91,6 +91,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ovsdb_cache.h"
 
 #include "qca_bsal.h"
+#include "qca_healthcheck.h"
+#include "ioctl80211_nlfilter.h"
 
 #include <linux/un.h>
 #include <opensync-ctrl.h>
@@ -164,7 +166,8 @@ static int g_num_vconfs;
 
 #define D(name, fallback) ((name ## _exists) ? (name) : (fallback))
 #define A(size) alloca(size), size
-#define F(fmt, ...) ({ char *__p = alloca(4096); memset(__p, 0, 4096); snprintf(__p, 4095, fmt, ##__VA_ARGS__); __p; })
+#define F(fmt, ...) util_fmt(fmt, ##__VA_ARGS__)
+#define F_SCOPE() size_t __fmt_mark __attribute__((cleanup(util_fmt_scope_leave))) = util_fmt_scope_enter()
 #define E(prog, ...) forkexec(prog, (const char *[]){ prog, __VA_ARGS__, NULL }, NULL, NULL, 0)
 #define R(...) file_geta(__VA_ARGS__)
 #define runcmd(...) readcmd(0, 0, 0, ## __VA_ARGS__)
@@ -177,6 +180,94 @@ static int g_num_vconfs;
             err || strcmp(str, buf); \
         })
 
+/* Scratch arena backing F(). Strings are bumped with their exact size
+ * and released when the enclosing F_SCOPE() returns. The outermost
+ * scope, placed at the top of ev callbacks and target API entries,
+ * starts with an empty arena. Outside of any scope, or once the arena
+ * is exhausted, F() falls back to an exact-size alloca() in the frame
+ * of its caller.
+ */
+#define UTIL_FMT_ARENA_SIZE 8192
+
+static char g_fmt_arena[UTIL_FMT_ARENA_SIZE];
+static size_t g_fmt_arena_used;
+static size_t g_fmt_arena_hwm;
+static int g_fmt_arena_depth;
+
+static size_t
+util_fmt_scope_enter(void)
+{
+    /* Outermost scope, i.e. an ev callback or a target API entry */
+    if (g_fmt_arena_depth++ == 0)
+        g_fmt_arena_used = 0;
+    return g_fmt_arena_used;
+}
+
+static void
+util_fmt_scope_leave(size_t *mark)
+{
+    WARN_ON(*mark > g_fmt_arena_used);
+    g_fmt_arena_used = *mark;
+    g_fmt_arena_depth--;
+}
+
+/* Returns NULL if the string did not fit, *len is then its length or
+ * -1 when nothing was formatted */
+static char * __attribute__((format(printf, 2, 3)))
+util_fmt_arena_printf(int *len, const char *fmt, ...)
+{
+    size_t left = sizeof(g_fmt_arena) - g_fmt_arena_used;
+    char *p = g_fmt_arena + g_fmt_arena_used;
+    va_list ap;
+    int n;
+
+    *len = -1;
+    if (g_fmt_arena_depth == 0)
+        return NULL;
+
+    va_start(ap, fmt);
+    n = vsnprintf(p, left, fmt, ap);
+    va_end(ap);
+
+    if (WARN_ON(n < 0 || (size_t)n >= left)) {
+        *len = n;
+        return NULL;
+    }
+
+    g_fmt_arena_used += n + 1;
+    if (g_fmt_arena_used > g_fmt_arena_hwm) {
+        g_fmt_arena_hwm = g_fmt_arena_used;
+        LOGT("%s: high water mark %zu/%zu bytes",
+             __func__, g_fmt_arena_hwm, sizeof(g_fmt_arena));
+    }
+
+    return p;
+}
+
+/* Always inlined so that the fallback buffer outlives this function
+ * like strfmta() does. Arguments are evaluated once, as parameters,
+ * and forwarded to both attempts with __builtin_va_arg_pack().
+ */
+static inline char * __attribute__((always_inline, format(printf, 1, 2)))
+util_fmt(const char *fmt, ...)
+{
+    char *p;
+    int n;
+
+    p = util_fmt_arena_printf(&n, fmt, __builtin_va_arg_pack());
+    if (p)
+        return p;
+
+    if (n < 0)
+        n = snprintf(NULL, 0, fmt, __builtin_va_arg_pack());
+    if (n < 0)
+        n = 0;
+
+    p = alloca(n + 1);
+    snprintf(p, n + 1, fmt, __builtin_va_arg_pack());
+    return p;
+}
+
 #include "target_osync_11ax.h"
 
 void
@@ -1194,6 +1285,7 @@ util_cb_arm(EV_P_ struct util_cb *cb, int seconds)
 static void
 util_cb_timer_cb(EV_P_ ev_timer *arg, int revents)
 {
+    F_SCOPE();
     struct util_cb *cb = container_of(arg, struct util_cb, timer);
     bool more = util_cb_work(cb, UTIL_CB_SPLIT);
     if (more == true) util_cb_arm(EV_A_ cb, UTIL_CB_DELAY_AGAIN_SEC);
@@ -1990,6 +2082,7 @@ util_thermal_phy_timer_cb(struct ev_loop *loop,
                           ev_timer *timer,
                           int revents)
 {
+    F_SCOPE();
     struct util_thermal *t;
     int temp;
     int err;
@@ -2560,6 +2653,17 @@ util_csa_war_update_rconf_channel(const char *phy, int chan)
 static int util_nl_fd = -1;
 static ev_io util_nl_io;
 
+/* Any link change may need rediscovery, except Probe Requests, see
+ * util_nl_parse(). These are the bulk of the traffic with WPS enabled.
+ */
+static const ioctl80211_nlfilter_t util_nl_filter = {
+    .dellink    = true,
+    .newlink    = true,
+    .iwe_cmd    = { IWEVASSOCREQIE },
+    .iwe_qty    = 1,
+    .iwe_drop   = true,
+};
+
 static void
 util_nl_listen_stop(void)
 {
@@ -2761,10 +2865,13 @@ util_nl_parse_iwevcustom(const char *ifname,
         case IEEE80211_EV_CSA_RX:
             return util_nl_parse_iwevcustom_csa_rx(ifname, data, iwp->length);
         case IEEE80211_EV_RADAR_DETECTED:
+            qca_hc_cac_set(ifname, false);
             return util_nl_parse_iwevcustom_radar_detected(ifname, data, iwp->length);
-        case IEEE80211_EV_CHANNEL_LIST_UPDATED:
         case IEEE80211_EV_CAC_STARTED:
         case IEEE80211_EV_CAC_COMPLETED:
+            qca_hc_cac_set(ifname, iwp->flags == IEEE80211_EV_CAC_STARTED);
+            return util_nl_parse_iwevcustom_channel_state_changed(ifname, data, iwp->length);
+        case IEEE80211_EV_CHANNEL_LIST_UPDATED:
         case IEEE80211_EV_NOL_STARTED:
         case IEEE80211_EV_NOL_FINISHED:
             return util_nl_parse_iwevcustom_channel_state_changed(ifname, data, iwp->length);
@@ -2777,6 +2884,7 @@ util_nl_parse_iwevcustom(const char *ifname,
 static void
 util_nl_parse(const void *buf, unsigned int len)
 {
+    F_SCOPE();
     const struct iw_event *iwe;
     const struct nlmsghdr *hdr;
     const struct rtattr *attr;
@@ -2842,6 +2950,7 @@ util_nl_listen_cb(struct ev_loop *loop,
                   ev_io *watcher,
                   int revents)
 {
+    F_SCOPE();
     char buf[32768];
     int len;
     int max = 256;
@@ -2918,6 +3027,8 @@ util_nl_listen_start(void)
              __func__, v, errno, strerror(errno));
     }
 
+    ioctl80211_nlfilter_attach(fd, &util_nl_filter, __func__);
+
     util_nl_fd = fd;
     ev_io_init(&util_nl_io, util_nl_listen_cb, fd, EV_READ);
     ev_io_start(target_mainloop, &util_nl_io);
@@ -3373,6 +3484,7 @@ util_radio_get_nol(const char *phy)
 
 bool target_radio_state_get(char *phy, struct schema_Wifi_Radio_State *rstate)
 {
+    F_SCOPE();
     const struct wiphy_info *wiphy_info;
     const struct util_thermal *t;
     const struct kvstore *kv;
@@ -3663,6 +3775,7 @@ bool
 target_radio_config_set2(const struct schema_Wifi_Radio_Config *rconf,
                          const struct schema_Wifi_Radio_Config_flags *changed)
 {
+    F_SCOPE();
     const char *phy = rconf->if_name;
     const char *vif;
 
@@ -4098,6 +4211,7 @@ target_vif_config_set2(const struct schema_Wifi_VIF_Config *vconf,
                        const struct schema_Wifi_VIF_Config_flags *changed,
                        int num_cconfs)
 {
+    F_SCOPE();
     const char *phy = rconf->if_name;
     const char *vif = vconf->if_name;
     const char *p;
@@ -4318,6 +4432,7 @@ done:
 
 bool target_vif_state_get(char *vif, struct schema_Wifi_VIF_State *vstate)
 {
+    F_SCOPE();
     struct hapd *hapd = hapd_lookup(vif);
     struct wpas *wpas = wpas_lookup(vif);
     const char *r;
@@ -4535,6 +4650,7 @@ free:
 static void
 target_radio_init_discover(EV_P_ ev_async *async, int events)
 {
+    F_SCOPE();
     char *ifnames = strexa("iwconfig");
     char *line;
     char *ifname;
@@ -0,0 +1,300 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Collect OL radio firmware stats (txrx_fw_stats) for logpull.
+ *
+ * Firmware stats are requested through the wireless private ioctl and
+ * the driver prints them into the kernel log. Instead of sleeping a
+ * fixed amount of time and flushing the log with `dmesg -c` the output
+ * is followed through /dev/kmsg, starting at the current end of the
+ * log, until it goes quiet. The kernel log is left intact.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <sys/socket.h>
+
+#include "log.h"
+#include "util.h"
+#include "ioctl80211_priv.h"
+
+#define MODULE_ID LOG_MODULE_ID_MAIN
+
+#define QCA_FWSTATS_RADIO_MAX   8
+
+#ifndef CONFIG_QCA_FWSTATS_IDLE_MSEC
+#define CONFIG_QCA_FWSTATS_IDLE_MSEC    200     /* kmsg considered drained */
+#endif
+
+#ifndef CONFIG_QCA_FWSTATS_MAX_MSEC
+#define CONFIG_QCA_FWSTATS_MAX_MSEC     1000    /* upper bound per request */
+#endif
+
+static int g_fwstats_idle_msec = CONFIG_QCA_FWSTATS_IDLE_MSEC;
+static int g_fwstats_max_msec = CONFIG_QCA_FWSTATS_MAX_MSEC;
+
+/* FIXME: wave2 hw / 10.4 supports more, e.g. for fetch requests/peer flow control */
+static const uint32_t g_fwstats_args[] = { 1, 2, 3, 5, 6, 7, 8 };
+
+struct qca_fwstats_radio {
+    char phy[32];
+    char vif[32];
+};
+
+static int64_t
+qca_fwstats_msec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool
+qca_fwstats_read_line(const char *path, char *buf, size_t len)
+{
+    FILE *f;
+    bool ok;
+
+    if (!(f = fopen(path, "r")))
+        return false;
+
+    ok = fgets(buf, len, f) != NULL;
+    fclose(f);
+    if (!ok)
+        return false;
+
+    buf[strcspn(buf, "\r\n ")] = 0;
+    return strlen(buf) > 0;
+}
+
+/*
+ * txrx_fw_stats is reachable via vap netdevs, not radio netdevs, even
+ * though stats are radio-wise. Pick the first vap of each radio.
+ */
+static int
+qca_fwstats_radios_get(struct qca_fwstats_radio *radios, int max)
+{
+    struct dirent *d;
+    char path[128];
+    char phy[32];
+    DIR *dir;
+    int n = 0;
+    int i;
+
+    if (!(dir = opendir("/sys/class/net")))
+        return 0;
+
+    while ((d = readdir(dir))) {
+        if (d->d_name[0] == '.')
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/class/net/%s/parent", d->d_name);
+        if (!qca_fwstats_read_line(path, phy, sizeof(phy)))
+            continue;
+
+        for (i = 0; i < n; i++)
+            if (!strcmp(radios[i].phy, phy))
+                break;
+
+        if (i < n || n == max)
+            continue;
+
+        STRSCPY_WARN(radios[n].phy, phy);
+        STRSCPY_WARN(radios[n].vif, d->d_name);
+        n++;
+    }
+
+    closedir(dir);
+    return n;
+}
+
+static int
+qca_fwstats_kmsg_open(void)
+{
+    int fd;
+
+    fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Failed to open /dev/kmsg: %d (%s)", errno, strerror(errno));
+        return -1;
+    }
+
+    /* Only follow what gets logged from now on */
+    lseek(fd, 0, SEEK_END);
+    return fd;
+}
+
+/*
+ * Print kernel log records until there were no new records for the
+ * idle time (-i), or the max time (-t) elapsed. Each record
+ * is "<prio>,<seq>,<usec>,<flags>;<message>\n" optionally followed by
+ * dictionary lines which are skipped. Sequence numbers are tracked to
+ * report records that got overwritten before they could be read.
+ */
+static void
+qca_fwstats_kmsg_drain(int fd, uint64_t *seq)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int64_t deadline = qca_fwstats_msec() + g_fwstats_max_msec;
+    char buf[8192];
+    uint64_t s;
+    char *msg;
+    char *eol;
+    ssize_t n;
+
+    while (qca_fwstats_msec() < deadline) {
+        n = read(fd, buf, sizeof(buf) - 1);
+        if (n < 0) {
+            if (errno == EPIPE) {
+                /* Ring buffer overrun, next read resumes at oldest record */
+                continue;
+            }
+            if (errno != EAGAIN)
+                break;
+            if (poll(&pfd, 1, g_fwstats_idle_msec) <= 0)
+                break;
+            continue;
+        }
+
+        buf[n] = 0;
+        if (sscanf(buf, "%*u,%" SCNu64 ",", &s) != 1)
+            continue;
+        if (!(msg = strchr(buf, ';')))
+            continue;
+        msg++;
+        if ((eol = strchr(msg, '\n')))
+            *eol = 0;
+
+        if (*seq && s > *seq + 1)
+            printf("[kmsg: %" PRIu64 " records lost]\n", s - *seq - 1);
+        *seq = s;
+
+        printf("%s\n", msg);
+    }
+
+    fflush(stdout);
+}
+
+static void
+qca_fwstats_radio_collect(const struct qca_fwstats_radio *radio, int kfd, int sfd, uint64_t *seq)
+{
+    ioctl80211_priv_t priv;
+    uint32_t arg;
+    size_t i;
+
+    if (!(priv = ioctl80211_priv_init(radio->vif, sfd)))
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(g_fwstats_args); i++) {
+        arg = g_fwstats_args[i];
+        printf("### %s (%s): txrx_fw_stats %u\n", radio->phy, radio->vif, arg);
+
+        if (!ioctl80211_priv_set_int(priv, "txrx_fw_stats", &arg, 1)) {
+            printf("[request failed]\n");
+            continue;
+        }
+
+        qca_fwstats_kmsg_drain(kfd, seq);
+    }
+
+    ioctl80211_priv_free(priv);
+}
+
+int main(int argc, char **argv)
+{
+    struct qca_fwstats_radio radios[QCA_FWSTATS_RADIO_MAX];
+    uint64_t seq = 0;
+    int64_t started;
+    int kfd;
+    int sfd;
+    int opt;
+    int n;
+    int i;
+
+    /* Firmware of some radios answers slower than the default idle time,
+     * its output would then be attributed to the next request */
+    while ((opt = getopt(argc, argv, "i:t:")) != -1) {
+        switch (opt) {
+            case 'i':
+                g_fwstats_idle_msec = atoi(optarg);
+                break;
+            case 't':
+                g_fwstats_max_msec = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-i idle_msec] [-t max_msec]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (g_fwstats_idle_msec <= 0 || g_fwstats_max_msec < g_fwstats_idle_msec) {
+        fprintf(stderr, "Invalid idle %d ms / max %d ms\n",
+                g_fwstats_idle_msec, g_fwstats_max_msec);
+        return 1;
+    }
+
+    n = qca_fwstats_radios_get(radios, ARRAY_SIZE(radios));
+    if (n == 0)
+        return 0;
+
+    if ((kfd = qca_fwstats_kmsg_open()) < 0)
+        return 1;
+
+    sfd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sfd < 0) {
+        LOGE("Failed to open ioctl socket: %d (%s)", errno, strerror(errno));
+        close(kfd);
+        return 1;
+    }
+
+    /* Radios are walked one by one on purpose. The kernel log is a single
+     * stream and the firmware stats dumps do not carry the radio name so
+     * requesting them concurrently would make the output unattributable.
+     */
+    started = qca_fwstats_msec();
+    for (i = 0; i < n; i++)
+        qca_fwstats_radio_collect(&radios[i], kfd, sfd, &seq);
+
+    printf("### collected %d radio(s) in %" PRId64 " ms\n", n, qca_fwstats_msec() - started);
+
+    close(sfd);
+    close(kfd);
+    return 0;
+}
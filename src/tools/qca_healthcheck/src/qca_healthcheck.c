@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2015, Plume Design Inc. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. Neither the name of the Plume Design Inc. nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL Plume Design Inc. BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "qca_healthcheck.h"
+
+int main(int argc, char **argv)
+{
+    struct qca_hc_result res;
+    unsigned int reason;
+    int rc = 0;
+    int i;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <vif> [<vif>...]\n", argv[0]);
+        return 2;
+    }
+
+    /* All vifs are checked over the same sockets */
+    for (i = 1; i < argc; i++) {
+        if (!qca_hc_vif_check(argv[i], &res)) {
+            rc = 1;
+            continue;
+        }
+
+        /* Possibly handled by a different driver */
+        if (res.reasons & QCA_HC_REASON_NOT_WIRELESS)
+            continue;
+
+        for (reason = 1; reason <= QCA_HC_REASON_CAC; reason <<= 1)
+            if (res.reasons & reason)
+                printf("%s(%s): %s\n", argv[i], res.phy, qca_hc_reason_str(reason));
+
+        if (!res.healthy)
+            rc = 1;
+    }
+
+    qca_hc_close();
+    return rc;
+}